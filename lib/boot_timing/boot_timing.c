@@ -0,0 +1,53 @@
+/**
+ * @file boot_timing.c
+ * @brief Chronométrage des étapes du démarrage.
+ *
+ * Les étapes sont marquées depuis plusieurs tâches (app_main, tâche de publication,
+ * boucle d'événements du Wi-Fi et du client MQTT) : chaque horodatage n'est écrit
+ * qu'une fois, un mot de 64 bits par étape, sans verrou.
+ */
+
+#include <stdio.h>          // Pour snprintf
+#include "boot_timing.h"    // Header du module
+#include "esp_timer.h"      // Temps depuis le démarrage
+#include "esp_system.h"     // Pour esp_reset_reason
+
+static const char *const mark_keys[BOOT_MARK_COUNT] = { // Clés JSON des étapes
+    "app", "nvs", "wifi", "cnt", "assoc", "ip", "mqtt", "pub",
+};
+
+static int64_t mark_us[BOOT_MARK_COUNT]; // Horodatage de chaque étape (0 = non atteinte)
+static volatile uint32_t boot_flags;     // Options du démarrage rapide utilisées
+
+void boot_timing_mark(boot_mark_t mark)
+{
+    if (mark < BOOT_MARK_COUNT && mark_us[mark] == 0) // Premier passage seulement
+    {
+        mark_us[mark] = esp_timer_get_time();
+    }
+}
+
+void boot_timing_set_flag(boot_flag_t flag)
+{
+    boot_flags |= flag;
+}
+
+uint32_t boot_timing_ms(boot_mark_t mark)
+{
+    return (mark < BOOT_MARK_COUNT) ? (uint32_t)(mark_us[mark] / 1000) : 0;
+}
+
+int boot_timing_format(char *buf, size_t len)
+{
+    int n = snprintf(buf, len, "{\"reset\":%d,\"flags\":%lu",
+                     (int)esp_reset_reason(), (unsigned long)boot_flags);
+    for (int i = 0; i < BOOT_MARK_COUNT && n > 0 && (size_t)n < len; i++)
+    {
+        n += snprintf(buf + n, len - n, ",\"%s\":%lu", mark_keys[i], (unsigned long)boot_timing_ms(i));
+    }
+    if (n > 0 && (size_t)n < len)
+    {
+        n += snprintf(buf + n, len - n, "}");
+    }
+    return n;
+}
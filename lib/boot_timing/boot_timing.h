@@ -0,0 +1,79 @@
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+/**
+ * @file boot_timing.h
+ * @brief Chronométrage des étapes du démarrage, jusqu'à la première publication.
+ *
+ * Chaque étape est horodatée (esp_timer, µs depuis le démarrage de l'application)
+ * la première fois qu'elle est atteinte ; les passages suivants sont ignorés
+ * (reconnexions). Le détail est journalisé et publié une fois sur
+ * "energie/<DEVICE_NAME>/boot" après la première publication des compteurs.
+ *
+ * Usage typique :
+ * 1. boot_timing_mark(BOOT_MARK_xxx) à chaque étape
+ * 2. boot_timing_format(buf, len) pour obtenir le détail en JSON
+ */
+
+#include <stddef.h>   // Pour size_t
+#include <stdint.h>   // Pour uint32_t
+#include <stdbool.h>  // Pour bool
+
+/**
+ * @brief Étapes chronométrées, dans l'ordre attendu.
+ */
+typedef enum {
+    BOOT_MARK_APP_MAIN = 0,   ///< Entrée dans app_main
+    BOOT_MARK_NVS,            ///< Paramètres chargés depuis la NVS
+    BOOT_MARK_WIFI_START,     ///< Wi-Fi démarré (esp_wifi_start)
+    BOOT_MARK_COUNTERS,       ///< Compteurs restaurés depuis le journal
+    BOOT_MARK_WIFI_ASSOC,     ///< Station associée à l'AP
+    BOOT_MARK_GOT_IP,         ///< Adresse IP obtenue (DHCP ou statique)
+    BOOT_MARK_MQTT,           ///< Connecté au broker
+    BOOT_MARK_FIRST_PUBLISH,  ///< Première publication des compteurs
+    BOOT_MARK_COUNT
+} boot_mark_t;
+
+/**
+ * @brief Options du chemin de démarrage rapide effectivement utilisées.
+ */
+typedef enum {
+    BOOT_FLAG_CACHED_AP = 1 << 0, ///< Première connexion ciblée sur le canal / BSSID mémorisés
+    BOOT_FLAG_STATIC_IP = 1 << 1, ///< Adresse IP statique (pas de DHCP)
+} boot_flag_t;
+
+/**
+ * @brief Horodate une étape du démarrage (premier passage seulement).
+ *
+ * @param mark Étape atteinte
+ */
+void boot_timing_mark(boot_mark_t mark);
+
+/**
+ * @brief Signale une option du démarrage rapide.
+ *
+ * @param flag Option utilisée
+ */
+void boot_timing_set_flag(boot_flag_t flag);
+
+/**
+ * @brief Temps écoulé jusqu'à une étape.
+ *
+ * @param mark Étape
+ * @return Millisecondes depuis le démarrage de l'application, 0 si l'étape n'est pas atteinte
+ */
+uint32_t boot_timing_ms(boot_mark_t mark);
+
+/**
+ * @brief Écrit le détail du démarrage en JSON.
+ *
+ * Ex : {"reset":3,"flags":3,"app":312,"nvs":330,"wifi":352,"cnt":410,"assoc":498,"ip":505,"mqtt":560,"pub":570}
+ * (millisecondes, 0 pour une étape non atteinte).
+ *
+ * @param buf Buffer de destination
+ * @param len Taille du buffer
+ * @return Longueur écrite (comme snprintf)
+ */
+int boot_timing_format(char *buf, size_t len);
+
+#endif // BOOT_TIMING_H
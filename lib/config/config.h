@@ -9,7 +9,7 @@
  *  - Paramètres Wi-Fi
  *  - Constantes pour MQTT et timing
  *  - Paramètres de debounce pour les entrées de compteur
- *  - Définition des GPIO utilisés pour les compteurs
+ *  - Table des compteurs (GPIO, constante, anti-rebond, nom), chargée depuis la NVS
  *
  * Usage :
  *  - Inclus dans tous les modules qui ont besoin de ces constantes
@@ -19,13 +19,35 @@
 #define DEVICE_NAME "ESP32_Counter" // Nom de l'appareil pour identification MQTT ou logs
 #include "driver/gpio.h" // Inclusion des fonctions de gestion des GPIO fournies par ESP-IDF
 
+// --------------------- Section journalisation ---------------------
+// Les profils de platformio.ini fixent aussi LOG_LOCAL_LEVEL : les messages plus détaillés ne sont pas compilés.
+#ifndef APP_LOG_LEVEL
+#define APP_LOG_LEVEL ESP_LOG_INFO // Niveau de log de toutes les étiquettes au démarrage (esp_log_level_set)
+#endif
+
 // --------------------- Section Wi-Fi ---------------------
 #define WIFI_CONNECTED_BIT BIT0    // Bit utilisé dans le EventGroup pour signaler la connexion Wi-Fi
+#define WIFI_BACKOFF_MIN_MS 1000         // Délai avant la première nouvelle tentative après une déconnexion
+#define WIFI_BACKOFF_MAX_MS (2 * 60 * 1000) // Délai maximal entre deux tentatives (2 minutes)
+#define WIFI_FAST_RECONNECT_TRIES 2      // Tentatives ciblées sur le BSSID / canal mémorisés avant un balayage complet
+#define SNTP_SERVER "pool.ntp.org"       // Serveur de temps (horodatage des messages, intervalles d'énergie)
 
 // --------------------- Section Wi-Fi CONFIG ---------------------
 #define AP_SSID "COUNTER_CONFIG"
 //#define AP_PASS "123456789"
 
+// --------------------- Section interface web ---------------------
+#ifndef WEBUI_STA
+#define WEBUI_STA 1               // 1 = tableau de bord en lecture seule aussi en mode normal (station)
+#endif
+#define WEBUI_JSON_MAX  6144      // Taille max d'une réponse JSON (MAX_CHANNELS compteurs)
+#define WEBUI_POST_MAX  6144      // Taille max du corps de POST /api/config
+#define WEBUI_CACHE_MAX_AGE_S 3600 // Durée de cache de la page ; ensuite revalidée par ETag (304)
+#define WEBUI_STREAM_PERIOD_MS  250  // Période des trames du suivi en direct (/ws)
+#define WEBUI_STREAM_MAX_CLIENTS 4    // Clients WebSocket simultanés (sockets httpd : 7 au total)
+#define WEBUI_STREAM_FRAME_MAX  2048  // Taille max d'une trame ; au-delà, les compteurs restants passent à la suivante
+#define WEBUI_STREAM_PRIORITY   2     // Priorité de la tâche de diffusion, sous la publication et les commandes
+
 // Section MQTT dans config.h
 //#define MQTT_BROKER_URI  "mqtt://192.168.1.10"  // Adresse du broker MQTT
 //#define MQTT_USERNAME    "user"                 // Nom d'utilisateur MQTT
@@ -36,29 +58,273 @@
 
 // GPIO du bouton BOOT (ESP32 DevKit = GPIO0)
 #define BOOT_BUTTON_GPIO GPIO_NUM_0
+#define BOOT_BUTTON_POLL_MS 100 // Suivi du bouton BOOT pendant un appui (au repos, réveil par interruption)
 // --------------------- Section timing et debounce ---------------------
-#define DEBOUNCE_US 20000               // Durée de l'anti-rebond pour les entrées GPIO (20 ms)
+#define DEBOUNCE_US 20000               // Durée de l'anti-rebond par défaut des entrées GPIO (20 ms), réglable par compteur
 #define MQTT_PUBLISH_PERIOD_MS (5 * 60 * 1000)  // Période de publication MQTT en millisecondes (5 minutes)
 
+// --------------------- Section ordonnanceur de publication ---------------------
+#define PUBLISH_DEFAULT_DELTA      10   // Publication dès qu'un compteur a avancé de 10 impulsions (0 = désactivé)
+#define PUBLISH_DEFAULT_MIN_S      10   // Intervalle minimal entre deux publications d'un compteur (s)
+#define PUBLISH_DEFAULT_MAX_S      (MQTT_PUBLISH_PERIOD_MS / 1000) // Publication au moins toutes les 5 minutes (0 = jamais)
+#define PUBLISH_DEFAULT_DEADBAND_W 0    // Bande morte de puissance en W déclenchant une publication (0 = désactivée)
+#define PUBLISH_POWER_RECHECK_MS   1000 // Période de réévaluation de la puissance quand une bande morte est active
+
+/**
+ * @brief Règles de publication d'un compteur (page de configuration, NVS).
+ */
+typedef struct {
+    uint32_t delta;      ///< Nombre d'impulsions déclenchant une publication (0 = désactivé)
+    uint32_t min_s;      ///< Intervalle minimal entre deux publications (s)
+    uint32_t max_s;      ///< Intervalle maximal sans publication (s, 0 = aucun)
+    uint32_t deadband_w; ///< Écart de puissance déclenchant une publication (W, 0 = désactivé)
+} publish_cfg_t;
+
+// --------------------- Section file d'attente hors ligne ---------------------
+#define OUTBOX_MIN_PERIOD_S      60    // Au plus un relevé mis en attente par minute pendant une coupure
+#define OUTBOX_DRAIN_BATCH       20    // Relevés publiés par lot à la reconnexion
+#define OUTBOX_DRAIN_INTERVAL_MS 1000  // Pause entre deux lots (débit max : OUTBOX_DRAIN_BATCH messages/s)
+#define OUTBOX_MAX_INFLIGHT      4096  // Octets en attente d'accusé dans le client MQTT au-delà desquels le vidage attend
+#define OUTBOX_ACK_TIMEOUT_MS    10000 // Délai max d'acquittement d'un lot avant abandon (renvoyé à la connexion suivante)
+#define OUTBOX_DRAIN_PRIORITY    3     // Priorité de la tâche de vidage, sous le comptage (10) et la publication (5)
+
+// --------------------- Section intervalles d'énergie ---------------------
+// Relevés des compteurs aux bornes des intervalles (heure UTC, SNTP) dans la partition "history".
+#ifndef HISTORY_ENABLE
+#define HISTORY_ENABLE 1          // 1 = intervalles de 15 min en flash, publiés à leur clôture et consultables
+#endif
+#define HISTORY_PERIOD_S   900    // Intervalle enregistré en flash (15 min), diviseur de 3600
+#define HISTORY_MINUTES    60     // Intervalles de 1 min gardés en RAM (dernière heure)
+#define HISTORY_QUERY_MAX  96     // Intervalles au plus par réponse (suite demandée à partir de "next")
+#define HISTORY_JSON_MAX   4096   // Taille max d'une réponse publiée sur MQTT
+#define HISTORY_PRIORITY   3      // Priorité de la tâche des relevés, sous la publication et les commandes
+
+// --------------------- Section mise à jour à distance ---------------------
+// Image téléchargée en HTTPS dans la partition OTA inactive (commande ota), validée au démarrage suivant.
+#ifndef OTA_ENABLE
+#define OTA_ENABLE 1              // 1 = commande ota et validation des nouvelles images (partitions ota_0 / ota_1)
+#endif
+#ifndef OTA_URL_PREFIX
+#define OTA_URL_PREFIX       ""    // Préfixe imposé aux URL ("https://hôte/chemin/", hôte fermé par '/') ; vide = commande ota refusée
+#endif
+#define OTA_URL_MAX          200   // Longueur max de l'URL de l'image
+#define OTA_HTTP_TIMEOUT_MS  10000 // Délai max de réponse du serveur
+#define OTA_BUFFER_SIZE      1024  // Bloc reçu puis écrit en flash à chaque tour (l'image n'est jamais en RAM)
+#define OTA_HEALTH_MIN_S     90    // Fonctionnement minimal avant validation (période de battement + WDT_TIMEOUT_S)
+#define OTA_HEALTH_TIMEOUT_S 300   // Sans broker au bout de 5 minutes : retour à l'image précédente
+#define OTA_PRIORITY         2     // Priorité des tâches de mise à jour, sous la publication et les commandes
+
+// --------------------- Section commandes MQTT ---------------------
+#define MQTT_CMD_QUEUE    8   // Commandes en attente d'exécution (au-delà, ignorées)
+#define MQTT_CMD_MAX_LEN  224 // Longueur max d'une commande (ota <url> compris)
+#define MQTT_CMD_PRIORITY 4   // Priorité de la tâche des commandes, sous la publication (5)
+
+// --------------------- Section publication MQTT groupée ---------------------
+#define MQTT_BATCH_OFF  0   // Un message par compteur sur energie/<nom> (mode historique)
+#define MQTT_BATCH_JSON 1   // Un seul message JSON par cycle sur energie/<DEVICE_NAME>/state
+#define MQTT_BATCH_CBOR 2   // Un seul message CBOR par cycle sur energie/<DEVICE_NAME>/state/cbor
+
+#ifndef MQTT_BATCH_DEFAULT
+#define MQTT_BATCH_DEFAULT MQTT_BATCH_OFF // Mode utilisé tant qu'aucun choix n'est enregistré en NVS
+#endif
+
+// --------------------- Section basse consommation ---------------------
+// Light sleep automatique (tickless idle) entre les publications ; nécessite CONFIG_PM_ENABLE et
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE dans sdkconfig. Le comptage continue grâce au réveil GPIO.
+#ifndef LOW_POWER
+#define LOW_POWER 0                // 1 = mode basse consommation
+#endif
+#define LOW_POWER_MAX_FREQ_MHZ 160 // Fréquence CPU pendant les traitements
+#define LOW_POWER_MIN_FREQ_MHZ 40  // Fréquence CPU au repos (XTAL)
+#define WIFI_LISTEN_INTERVAL   3   // Modem sleep : réveil radio toutes les 3 balises (DTIM) hors publication
+
+// --------------------- Section répartition sur les cœurs ---------------------
+// Le comptage est isolé sur CORE_PULSE, loin de la pile réseau (Wi-Fi, LwIP, client MQTT) épinglée
+// sur CORE_NET par sdkconfig. Une interruption est servie par le cœur qui l'alloue : app_main, qui
+// configure les entrées, tourne sur CORE_PULSE (CONFIG_ESP_MAIN_TASK_AFFINITY_CPU1), de même que
+// l'ISR esp_timer qui exécute la validation anti-rebond (CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1).
+//
+//   Cœur       Tâche / ISR                                 Priorité
+//   CORE_PULSE ISR GPIO, PCNT, gptimer, esp_timer          -
+//              task_counter (sauvegarde du journal)        10
+//              pulse_sampler, pulse_exp                    10
+//   CORE_NET   wifi, esp_timer, tcpip, mqtt_task (ESP-IDF) 23, 22, 18, 5
+//              watchdog (superviseur des battements)       11
+//              task_mqtt (publication)                     5
+//              mqtt_cmd, task_boot_button, outbox_drain    4, 4, 3
+//              webui_ws, httpd, diag                       2, 5, 1
+#define CORE_NET   0   // Pile réseau et tâches qui publient
+#define CORE_PULSE 1   // Acquisition, anti-rebond et comptage
+
+// --------------------- Section moteur de comptage ---------------------
+#define PULSE_BACKEND_ISR  0   // ISR GPIO par front + esp_timer de validation (moteur historique)
+#define PULSE_BACKEND_PCNT 1   // Périphérique PCNT matériel, filtre plafonné à PCNT_GLITCH_NS : sorties électroniques sans rebond seulement
+#define PULSE_BACKEND_SAMPLER 2 // Échantillonnage périodique des registres GPIO (gptimer) et anti-rebond bit à bit
+
+#define PULSE_VALIDATE_LEVEL 0 // Front montant puis niveau relu après l'anti-rebond (comportement historique)
+#define PULSE_VALIDATE_WIDTH 1 // Deux fronts horodatés : largeur, écart et cadence vérifiés par impulsion (sorties S0)
+
+#ifndef PULSE_VALIDATE
+#define PULSE_VALIDATE PULSE_VALIDATE_LEVEL // Validation des impulsions du moteur ISR (surchargeable via -DPULSE_VALIDATE=...)
+#endif
+
+#ifndef PULSE_BACKEND
+#if LOW_POWER || PULSE_VALIDATE == PULSE_VALIDATE_WIDTH
+#define PULSE_BACKEND PULSE_BACKEND_ISR  // Light sleep (verrou APB du PCNT et du gptimer) ou validation par largeur : fronts GPIO
+#else
+#define PULSE_BACKEND PULSE_BACKEND_SAMPLER // Anti-rebond complet sans interruption par front (surchargeable via -DPULSE_BACKEND=...)
+#endif
+#endif
+
+#if PULSE_VALIDATE == PULSE_VALIDATE_WIDTH && PULSE_BACKEND != PULSE_BACKEND_ISR
+#error "PULSE_VALIDATE_WIDTH horodate les fronts dans l'ISR GPIO : moteur PULSE_BACKEND_ISR requis"
+#endif
+
+#define PULSE_DIP_MAX_US    2000  // PULSE_VALIDATE_WIDTH : creux plus court (borné à l'anti-rebond) = rebond, l'impulsion continue
+#ifndef PULSE_WIDTH_MAX_US
+#define PULSE_WIDTH_MAX_US  1000000 // PULSE_VALIDATE_WIDTH : impulsion plus longue rejetée (S0 : 30 à 100 ms usuels)
+#endif
+#ifndef PULSE_MAX_POWER_W
+#define PULSE_MAX_POWER_W   50000 // PULSE_VALIDATE_WIDTH : cadence au-delà de cette puissance rejetée (0 = sans limite)
+#endif
+
+#define PCNT_GLITCH_NS      12000 // Largeur max des glitchs filtrés par le PCNT en ns (ESP32 : 1023 cycles APB max, soit ~12,7 µs)
+#define PCNT_HIGH_LIMIT     30000 // Limite haute du compteur matériel 16 bits, au-delà le driver accumule en logiciel
+#define PCNT_POLL_PERIOD_MS 100   // Période de lecture des accumulateurs PCNT en millisecondes
+#define PULSE_BULK_SAMPLES  4     // Échantillons identiques consécutifs validant un changement (compteur vertical 2 bits)
+#define PULSE_SAMPLER_MIN_PERIOD_US 250 // Période minimale de l'échantillonneur (anti-rebond / PULSE_BULK_SAMPLES, 4 kHz au plus)
+
+// --------------------- Section instrumentation du comptage ---------------------
+// Aucun log par impulsion : en production le chemin de comptage n'écrit rien sur l'UART.
+#ifndef PULSE_STATS
+#define PULSE_STATS 0             // 1 = statistiques par compteur (fronts, impulsions, rebonds, pertes, latence max)
+#endif
+#if PULSE_STATS
+#define PULSE_STATS_ENTRY_MAX 178 // Entrée la plus longue du rapport : nom de 31 caractères, sept compteurs de 10 chiffres
+#define PULSE_STATS_JSON_MAX (48 + MAX_CHANNELS * PULSE_STATS_ENTRY_MAX) // Rapport complet des MAX_CHANNELS compteurs
+#else
+#define PULSE_STATS_JSON_MAX 32   // {"enabled":false}
+#endif
+
+// --------------------- Section diagnostic ---------------------
+// Pile, CPU et mémoire par tâche sur energie/<DEVICE_NAME>/diag ; le détail par tâche nécessite
+// CONFIG_FREERTOS_USE_TRACE_FACILITY (et CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS pour le CPU).
+#ifndef DIAG_PERIOD_S
+#define DIAG_PERIOD_S  300        // Période de publication du diagnostic en secondes (0 = désactivé)
+#endif
+#define DIAG_MAX_TASKS 24         // Tâches relevées au plus (au-delà, le détail par tâche est omis)
+#define DIAG_JSON_MAX  1536       // Taille max du message de diagnostic
+#define DIAG_PRIORITY  1          // Priorité de la tâche de diagnostic, juste au-dessus de l'idle
+
+// --------------------- Section surveillance des tâches ---------------------
+// Le superviseur n'alimente le task watchdog (TWDT) que si chaque tâche critique a donné signe de vie
+// dans sa période ; une tâche bloquée plus de WDT_TIMEOUT_S au-delà redémarre l'appareil.
+#define WDT_TIMEOUT_S         10     // Délai du TWDT sans alimentation avant panic et redémarrage
+#define WDT_CHECK_MS          2000   // Période de contrôle des battements par le superviseur
+#define WDT_MAX_HEARTBEATS    8      // Tâches surveillées au plus
+#define WDT_PRIORITY          11     // Au-dessus du comptage (10) : pas affamé par les tâches qu'il surveille
+#define WDT_SAVER_PERIOD_MS   60000  // Battement de task_counter (réveillée à mi-période sans demande)
+#define WDT_PUBLISH_PERIOD_MS 60000  // Battement de task_mqtt (publish_sched_wait limité à mi-période)
+
+// --------------------- Section banc de débit sur cible ---------------------
+// Générateur RMT rebouclé sur les entrées de comptage : firmware de banc, pas de production.
+#ifndef PULSE_SELFTEST
+#define PULSE_SELFTEST 0          // 1 = balayage en fréquence au démarrage et rapport sur energie/<DEVICE_NAME>/selftest
+#endif
+#if PULSE_BACKEND == PULSE_BACKEND_PCNT
+#define SELFTEST_DEBOUNCE_US  12  // Anti-rebond imposé aux compteurs pendant le banc : filtre PCNT maximal (au-delà, moteur ISR)
+#else
+#define SELFTEST_DEBOUNCE_US  50  // Anti-rebond imposé aux compteurs pendant le banc (RAM seulement)
+#endif
+#define SELFTEST_FREQS_HZ     { 100, 200, 500, 1000, 2000, 3000, 5000 } // Paliers du balayage
+#define SELFTEST_BOUNCES      3   // Rebonds par front montant du profil rebondissant
+#define SELFTEST_BOUNCE_US    10  // Durée de chaque demi-alternance de rebond
+#define SELFTEST_STEP_MS      1000 // Durée d'émission d'un palier
+#define SELFTEST_SETTLE_MS    300 // Attente après émission (anti-rebond, lecture PCNT toutes les PCNT_POLL_PERIOD_MS)
+#define SELFTEST_IDLE_CAL_MS  1000 // Mesure de référence des cœurs au repos
+#define SELFTEST_MAX_CHANNELS 8   // Canaux RMT de l'ESP32 : au plus 8 compteurs générés à la fois
+#define SELFTEST_MAX_SYMBOLS  4096 // Taille du train d'un palier (symboles RMT de 4 octets)
+#define SELFTEST_RMT_INTR_PRIORITY 3 // Recharge du générateur prioritaire sur les ISR de comptage (niveau 1)
+#define SELFTEST_MQTT_WAIT_S  30  // Attente max de la connexion MQTT avant le balayage
+#define SELFTEST_JSON_MAX     4096 // Taille max du rapport JSON du banc
+#define SELFTEST_JITTER_HZ    200 // Palier de la mesure de gigue, au repos puis sous charge réseau (tous les compteurs)
+#define SELFTEST_NET_PORT     9   // Port UDP "discard" des datagrammes de charge réseau (diffusion)
+#define SELFTEST_NET_PAYLOAD  1400 // Taille des datagrammes de charge réseau (octets)
+#define SELFTEST_NET_PRIORITY 5   // Tâche de charge réseau : au niveau de task_mqtt, sur CORE_NET
+
+// --------------------- Section expandeur d'entrées (MCP23017) ---------------------
+// Compteurs supplémentaires sur des MCP23017 I2C (16 entrées chacun), sorties INT reliées sur une seule ligne.
+// Dans la table des compteurs, l'entrée n des expandeurs (0 = GPA0 du premier) a pour GPIO PULSE_EXP_PIN_BASE + n.
+#ifndef PULSE_EXPANDER
+#define PULSE_EXPANDER 0          // 1 = lecture des compteurs câblés sur les expandeurs
+#endif
+#define PULSE_EXP_COUNT      2            // Nombre d'expandeurs (adresses PULSE_EXP_ADDR, PULSE_EXP_ADDR + 1...)
+#define PULSE_EXP_ADDR       0x20         // Adresse I2C du premier expandeur (A2..A0 à la masse)
+#define PULSE_EXP_PIN_BASE   64           // « GPIO » de la première entrée des expandeurs dans la table des compteurs
+#define PULSE_EXP_I2C_PORT   0            // Contrôleur I2C utilisé
+#define PULSE_EXP_SDA        GPIO_NUM_25  // Ligne SDA du bus I2C
+#define PULSE_EXP_SCL        GPIO_NUM_26  // Ligne SCL du bus I2C
+#define PULSE_EXP_INT        GPIO_NUM_27  // Ligne INT commune (drain ouvert, active à l'état bas)
+#define PULSE_EXP_I2C_HZ     400000       // Fréquence du bus I2C
+
+// --------------------- Section coupure d'alimentation ---------------------
+// Sortie "power good" d'un superviseur (ou comparateur) placé en amont de la capacité de réserve :
+// à la coupure, les compteurs sont écrits en une fois dans la partition "pfail", effacée d'avance.
+#ifndef POWER_FAIL
+#define POWER_FAIL 0              // 1 = sauvegarde d'urgence sur coupure d'alimentation
+#endif
+#ifndef POWER_FAIL_GPIO
+#define POWER_FAIL_GPIO         GPIO_NUM_34 // Entrée seule, sans pull interne : sortie push-pull du superviseur
+#endif
+#ifndef POWER_FAIL_ACTIVE_LEVEL
+#define POWER_FAIL_ACTIVE_LEVEL 0   // Niveau de l'entrée pendant une coupure
+#endif
+#define POWER_FAIL_LOCK_MS      2   // Attente max de la fin d'un ajout au journal avant l'écriture d'urgence
+#define POWER_FAIL_REARM_MS     1000 // Alimentation revenue depuis ce délai : coupure brève, sauvegarde réarmée
+#define POWER_FAIL_PRIORITY     24  // Priorité de la tâche d'urgence (configMAX_PRIORITIES - 1)
+
 // --------------------- Section compteurs ---------------------
-#define NB_COUNTERS 5   // Nombre de compteurs d'impulsions
-// Tableau contenant les GPIO utilisés pour chaque compteur
-// Chaque index correspond à un compteur physique
-static const gpio_num_t pulse_pins[NB_COUNTERS] = {
-    GPIO_NUM_18, // Compteur 0 sur GPIO 18
-    GPIO_NUM_19, // Compteur 1 sur GPIO 19
-    GPIO_NUM_23, // Compteur 2 sur GPIO 23
-    GPIO_NUM_21, // Compteur 3 sur GPIO 21
-    GPIO_NUM_22  // Compteur 4 sur GPIO 22
-};
+#ifndef MAX_CHANNELS
+#define MAX_CHANNELS 32      // Nombre maximal de compteurs (capacité des tableaux) ; le nombre actif se règle dans la page de configuration
+#endif
+#define DEFAULT_CHANNEL_COUNT 5 // Nombre de compteurs actifs d'un appareil neuf
+#define PULSES_PER_KWH  1000 // Constante par défaut des compteurs (impulsions par kWh, 1000 = 1 Wh par impulsion), réglable par compteur
+#define POWER_RING_SIZE 64   // Nombre d'impulsions horodatées conservées par compteur pour le calcul de puissance
+#if POWER_FAIL
+#define COUNTER_SAVE_WH 1000 // Sauvegarde d'urgence à la coupure : le journal ne sert plus qu'aux redémarrages sans coupure
+#else
+#define COUNTER_SAVE_WH 100  // Sauvegarde dans le journal dès qu'un compteur a cumulé 100 Wh depuis le dernier instantané (converti en impulsions par compteur)
+#endif
+#define COUNTER_SAVE_MIN_S 30 // Écart minimal entre deux instantanés : les demandes plus rapprochées sont regroupées
+#if COUNTER_SAVE_MIN_S * 1000 > WDT_SAVER_PERIOD_MS / 2
+#error "COUNTER_SAVE_MIN_S doit laisser task_counter battre dans WDT_SAVER_PERIOD_MS"
+#endif
+#define DEFAULT_PULSE_PINS { GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_23, GPIO_NUM_21, GPIO_NUM_22 } // GPIO des compteurs 0 à 4 d'un appareil neuf
+
+/**
+ * @brief Description d'un compteur (table des compteurs, page de configuration, NVS).
+ */
+typedef struct {
+    int8_t pin;              ///< GPIO d'entrée des impulsions (-1 = non câblé)
+    uint32_t ppkwh;          ///< Impulsions par kWh du compteur
+    uint32_t debounce_us;    ///< Durée de l'anti-rebond (µs)
+    char name[32];           ///< Nom MQTT du compteur
+} channel_cfg_t;
 
 extern uint8_t global_mode_config; // Mode de configuration (0 = normal, 1 = AP)
-extern uint32_t counters[NB_COUNTERS]; // Tableau global des compteurs d'impulsions, accessible depuis tous les modules pour lecture/écriture des valeurs de comptage
-extern char mqtt_names[NB_COUNTERS][32]; // taille adaptée à tes noms
+extern uint8_t channel_count; // Nombre de compteurs actifs (1..MAX_CHANNELS)
+extern uint8_t channel_count_next; // Nombre de compteurs au prochain démarrage (enregistré par storage_save_config)
+extern channel_cfg_t channels[MAX_CHANNELS]; // Table des compteurs : seuls les channel_count premiers sont utilisés
 extern char wifi_ssid[32]; // SSID Wi-Fi, accessible globalement pour la configuration et la connexion
 extern char wifi_pass[64]; // Mot de passe Wi-Fi, accessible globalement pour la configuration et la connexion
+extern char wifi_ip[16];   // Adresse IP statique (vide = DHCP)
+extern char wifi_gw[16];   // Passerelle de l'adresse IP statique
+extern char wifi_mask[16]; // Masque de sous-réseau de l'adresse IP statique
+extern char wifi_dns[16];  // Serveur DNS de l'adresse IP statique (passerelle si vide)
 extern char mqtt_Server[64]; // URI du broker MQTT, accessible globalement pour la configuration et la connexion
 extern char mqtt_user[32]; // Nom d'utilisateur MQTT, accessible globalement pour la configuration et la connexion
 extern char mqtt_pass[32]; // Mot de passe MQTT, accessible globalement pour la configuration et la connexion
 extern char mqtt_port[8]; // Port du server MQTT, accessible globalement pour la configuration et la connexion
+extern publish_cfg_t publish_cfg[MAX_CHANNELS]; // Règles de publication de chaque compteur
+extern uint8_t mqtt_batch_mode; // Mode de publication des compteurs (MQTT_BATCH_OFF, MQTT_BATCH_JSON, MQTT_BATCH_CBOR)
 #endif // CONFIG_H
@@ -0,0 +1,174 @@
+/**
+ * @file counter_store.c
+ * @brief Compteurs d'impulsions sans verrou : incrément atomique + lecture par seqlock.
+ *
+ * L'incrément est un simple atomic_fetch_add 32 bits sur le cumul : plusieurs incréments
+ * concurrents (tâche esp_timer, ISR) ne se perdent jamais et n'ont pas besoin d'être ordonnés
+ * entre eux. Le Xtensa n'a pas d'opération atomique 64 bits : la valeur d'un compteur est
+ * base (64 bits, écrivains seulement) + cumul (32 bits, atomique).
+ *
+ * Le numéro de séquence protège la base : l'écrivain le passe à une valeur impaire, écrit, puis
+ * le repasse à une valeur paire. Un lecteur recommence sa copie si la séquence était impaire ou
+ * a changé entre le début et la fin de la lecture ; une base lue en deux moitiés pendant une
+ * écriture n'est donc jamais retenue. Les écrivains sont sérialisés entre eux par une courte
+ * section critique, qui n'est jamais prise par l'incrément.
+ *
+ * Le cumul est vidé dans la base (repli) par l'incrément qui lui fait franchir 2^31 : il ne
+ * déborde jamais, et le repli n'a lieu qu'une fois tous les 2^31 impulsions d'un compteur.
+ * Le repli échange le cumul contre zéro sous le seqlock : une impulsion comptée pendant le
+ * repli s'ajoute au nouveau cumul et n'est pas perdue.
+ */
+
+#include <stdatomic.h>              // Opérations atomiques C11
+#include <string.h>                 // memcpy
+#include "freertos/FreeRTOS.h"      // Pour portMUX_TYPE et les sections critiques
+#include "esp_attr.h"               // Attribut IRAM_ATTR
+#include "counter_store.h"          // Header du module
+
+#define COUNTER_FOLD_AT 0x80000000u // Cumul à partir duquel il est replié dans la base
+
+static uint64_t base[MAX_CHANNELS];            // Valeurs au dernier repli (écrivains seulement, lues sous le seqlock)
+static _Atomic uint32_t delta[MAX_CHANNELS];   // Impulsions depuis le dernier repli
+static _Atomic uint32_t seq;                   // Numéro de séquence du seqlock (impair = écriture en cours)
+static portMUX_TYPE writer_lock = portMUX_INITIALIZER_UNLOCKED; // Sérialise les écrivains, jamais pris par l'incrément seul
+
+/**
+ * @brief Ouvre une écriture (séquence impaire). Utilisable en ISR (repli).
+ */
+static inline __attribute__((always_inline)) void writer_begin(void)
+{
+    portENTER_CRITICAL_SAFE(&writer_lock);                                // Un seul écrivain à la fois
+    atomic_fetch_add_explicit(&seq, 1, memory_order_relaxed);             // Séquence impaire : écriture en cours
+    atomic_thread_fence(memory_order_release);                            // La séquence est visible avant les valeurs
+}
+
+/**
+ * @brief Ferme une écriture (séquence paire).
+ */
+static inline __attribute__((always_inline)) void writer_end(void)
+{
+    atomic_fetch_add_explicit(&seq, 1, memory_order_release);             // Séquence paire : les valeurs sont visibles avant
+    portEXIT_CRITICAL_SAFE(&writer_lock);                                 // Libère les autres écrivains
+}
+
+/**
+ * @brief Vide le cumul d'un compteur dans sa base.
+ */
+static void IRAM_ATTR fold(int idx)
+{
+    writer_begin();
+    base[idx] += atomic_exchange_explicit(&delta[idx], 0, memory_order_relaxed); // Les incréments suivants repartent de zéro
+    writer_end();
+}
+
+/**
+ * @brief Ajoute n impulsions au compteur idx (une seule opération atomique).
+ */
+uint32_t IRAM_ATTR counter_store_add(int idx, uint32_t n)
+{
+    uint32_t old = atomic_fetch_add_explicit(&delta[idx], n, memory_order_relaxed); // Incrément atomique, sans verrou
+    if (old < COUNTER_FOLD_AT && old + n >= COUNTER_FOLD_AT) fold(idx); // Un seul incrément franchit le seuil
+    return old + n;
+}
+
+/**
+ * @brief Lit la valeur courante d'un compteur (côté lecteur du seqlock).
+ */
+uint64_t IRAM_ATTR counter_store_get(int idx)
+{
+    uint32_t begin, end;
+    uint64_t value;
+
+    do {
+        begin = atomic_load_explicit(&seq, memory_order_acquire);
+        value = base[idx] + atomic_load_explicit(&delta[idx], memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&seq, memory_order_relaxed);
+    } while ((begin & 1U) || begin != end);
+    return value;
+}
+
+/**
+ * @brief Copie cohérente de tous les compteurs (côté lecteur du seqlock).
+ */
+void counter_store_snapshot(uint64_t out[MAX_CHANNELS])
+{
+    uint32_t begin, end; // Numéros de séquence lus avant et après la copie
+
+    do {
+        begin = atomic_load_explicit(&seq, memory_order_acquire); // Séquence avant la copie
+        for (int i = 0; i < channel_count; i++)                  // Copie de chaque compteur actif
+        {
+            out[i] = base[i] + atomic_load_explicit(&delta[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);                // Les lectures précèdent la relecture de la séquence
+        end = atomic_load_explicit(&seq, memory_order_relaxed);   // Séquence après la copie
+    } while ((begin & 1U) || begin != end);                       // Écriture en cours ou survenue pendant la copie : on recommence
+}
+
+/**
+ * @brief Force la valeur d'un compteur.
+ */
+void counter_store_set(int idx, uint64_t value)
+{
+    writer_begin();
+    atomic_store_explicit(&delta[idx], 0, memory_order_relaxed); // Nouvelle valeur, sans cumul
+    base[idx] = value;
+    writer_end();
+}
+
+/**
+ * @brief Décale la base d'un compteur, sans toucher au cumul.
+ */
+void counter_store_adjust(int idx, uint64_t diff)
+{
+    writer_begin();
+    base[idx] += diff;
+    writer_end();
+}
+
+/**
+ * @brief Force la valeur de tous les compteurs en une seule écriture.
+ */
+void counter_store_set_all(const uint64_t in[MAX_CHANNELS])
+{
+    writer_begin();
+    for (int i = 0; i < channel_count; i++)                            // Nouvelles valeurs des compteurs actifs
+    {
+        atomic_store_explicit(&delta[i], 0, memory_order_relaxed);
+        base[i] = in[i];
+    }
+    writer_end();
+}
+
+uint64_t counter_store_mwh(int idx, uint64_t pulses)
+{
+    uint32_t ppkwh = channels[idx].ppkwh ? channels[idx].ppkwh : PULSES_PER_KWH; // Constante du compteur (jamais nulle)
+    // kWh entiers puis reste : pulses * 10^6 déborderait au-delà de 1,8·10^13 impulsions
+    return pulses / ppkwh * 1000000 + pulses % ppkwh * 1000000 / ppkwh;
+}
+
+void counter_pack48(void *dst, const uint64_t *values, int count)
+{
+    uint8_t *p = dst;
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t lo = (uint32_t)values[i];
+        uint16_t hi = (uint16_t)(values[i] >> 32);
+        memcpy(p + 4 * i, &lo, sizeof(lo));             // Poids faibles de toutes les valeurs
+        memcpy(p + 4 * count + 2 * i, &hi, sizeof(hi)); // Puis les 16 bits suivants
+    }
+}
+
+void counter_unpack48(uint64_t *values, const void *src, int count)
+{
+    const uint8_t *p = src;
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t lo;
+        uint16_t hi;
+        memcpy(&lo, p + 4 * i, sizeof(lo));
+        memcpy(&hi, p + 4 * count + 2 * i, sizeof(hi));
+        values[i] = (uint64_t)hi << 32 | lo;
+    }
+}
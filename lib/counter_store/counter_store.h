@@ -0,0 +1,121 @@
+#ifndef COUNTER_STORE_H
+#define COUNTER_STORE_H
+
+/**
+ * @file counter_store.h
+ * @brief Stockage sans verrou des compteurs d'impulsions (64 bits).
+ *
+ * Ce module remplace l'ancien tableau global counters[] protégé par counter_mutex :
+ * - L'incrément (chemin chaud du comptage) est une seule opération atomique 32 bits,
+ *   il ne prend jamais de verrou et ne peut pas être retardé par un lecteur
+ * - Les lecteurs (sauvegarde NVS, publication MQTT, page web) obtiennent une
+ *   copie cohérente de tous les compteurs via un seqlock, puis font leurs
+ *   entrées/sorties (flash, réseau) sur cette copie, sans rien verrouiller
+ * - Les écritures absolues (chargement au boot, formulaire de configuration)
+ *   sont rares : elles passent par le côté écrivain du seqlock
+ *
+ * Un compteur vaut base + cumul : la base 64 bits n'est modifiée que par les écrivains,
+ * le cumul 32 bits reçoit les incréments. Le cœur 32 bits n'a pas d'accès atomique à
+ * 64 bits : une lecture de la base n'est valable que sous le seqlock, qui la recommence
+ * si un écrivain est passé.
+ *
+ * Les enregistrements en flash gardent 48 bits par compteur (counter_pack48) : 2^48
+ * impulsions font plus de 8000 ans de comptage continu à 1 kHz.
+ *
+ * Usage typique :
+ * 1. counter_store_add(idx, n) depuis le moteur de comptage
+ * 2. counter_store_snapshot(values) avant de sauvegarder ou publier
+ */
+
+#include <stdint.h>  // Pour uint32_t, uint64_t
+#include <stddef.h>  // Pour size_t
+#include "config.h"  // Pour MAX_CHANNELS, channel_count
+
+#define COUNTER_PACK48_SIZE(count) ((size_t)(count) * 6) // Octets de count valeurs de 48 bits
+#define COUNTER_MAX ((1ULL << 48) - 1)                   // Plus grande valeur enregistrée en flash
+
+/**
+ * @brief Ajoute n impulsions au compteur idx.
+ *
+ * Une seule opération atomique, utilisable depuis n'importe quel contexte
+ * (tâche, callback esp_timer, ISR). Placée en IRAM. Le cumul est replié dans
+ * la base (section critique courte) une fois tous les 2^31 impulsions.
+ *
+ * @param idx Index du compteur (0..channel_count-1)
+ * @param n   Nombre d'impulsions à ajouter
+ * @return Cumul 32 bits du compteur après l'ajout (repère des seuils de sauvegarde,
+ *         sans rapport avec la valeur absolue)
+ */
+uint32_t counter_store_add(int idx, uint32_t n);
+
+/**
+ * @brief Lit la valeur courante d'un compteur.
+ *
+ * @param idx Index du compteur (0..channel_count-1)
+ * @return Valeur du compteur
+ */
+uint64_t counter_store_get(int idx);
+
+/**
+ * @brief Copie de manière cohérente l'ensemble des compteurs.
+ *
+ * La copie ne peut pas mélanger des valeurs d'avant et d'après une écriture
+ * absolue (counter_store_set / counter_store_set_all). Ne bloque jamais
+ * le chemin d'incrément.
+ *
+ * @param out Tableau de MAX_CHANNELS valeurs, dont les channel_count premières sont remplies
+ */
+void counter_store_snapshot(uint64_t out[MAX_CHANNELS]);
+
+/**
+ * @brief Force la valeur d'un compteur.
+ *
+ * @param idx   Index du compteur (0..channel_count-1)
+ * @param value Nouvelle valeur
+ */
+void counter_store_set(int idx, uint64_t value);
+
+/**
+ * @brief Ajoute diff (modulo 2^64) à la base d'un compteur (formulaire, commande distante).
+ *
+ * Contrairement à counter_store_set, une impulsion comptée pendant le recalage
+ * n'est pas perdue.
+ *
+ * @param idx  Index du compteur (0..channel_count-1)
+ * @param diff Écart à ajouter (valeur cible - counter_store_get(idx))
+ */
+void counter_store_adjust(int idx, uint64_t diff);
+
+/**
+ * @brief Force la valeur de tous les compteurs en une seule écriture cohérente.
+ *
+ * @param values Tableau de MAX_CHANNELS valeurs, dont les channel_count premières sont utilisées
+ */
+void counter_store_set_all(const uint64_t values[MAX_CHANNELS]);
+
+/**
+ * @brief Convertit des impulsions du compteur idx en énergie (mWh), sans débordement.
+ *
+ * Utilise la constante du compteur (channels[idx].ppkwh) ; le résultat est tronqué au mWh.
+ * À formater en Wh avec "%llu.%03u" (mwh / 1000, mwh % 1000).
+ *
+ * @param idx    Index du compteur
+ * @param pulses Nombre d'impulsions
+ * @return Énergie en mWh
+ */
+uint64_t counter_store_mwh(int idx, uint64_t pulses);
+
+/**
+ * @brief Écrit count valeurs sur 48 bits (format des enregistrements en flash).
+ *
+ * Les 32 bits de poids faible de chaque valeur, puis les 16 bits suivants :
+ * COUNTER_PACK48_SIZE(count) octets, sans contrainte d'alignement.
+ */
+void counter_pack48(void *dst, const uint64_t *values, int count);
+
+/**
+ * @brief Relit count valeurs écrites par counter_pack48().
+ */
+void counter_unpack48(uint64_t *values, const void *src, int count);
+
+#endif // COUNTER_STORE_H
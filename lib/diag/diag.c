@@ -0,0 +1,231 @@
+/**
+ * @file diag.c
+ * @brief Relevé et publication du diagnostic de l'appareil.
+ *
+ * Les parts du CPU sont calculées sur la période écoulée depuis le relevé précédent :
+ * les compteurs de temps d'exécution de chaque tâche (ulRunTimeCounter, en µs avec
+ * CONFIG_FREERTOS_RUN_TIME_STATS_USING_ESP_TIMER) sont mémorisés par numéro de tâche
+ * et comparés au relevé suivant. Les différences non signées restent exactes après un
+ * débordement des compteurs 32 bits (71 minutes), tant que la période est plus courte.
+ *
+ * L'ESP-IDF n'expose pas la profondeur de la file des esp_timer : une sonde à échéance
+ * immédiate, servie par la tâche esp_timer, mesure le retard réel de son traitement.
+ */
+
+#include "config.h"                 // DIAG_*
+#include "diag.h"                   // Header du module
+
+#if DIAG_PERIOD_S > 0
+
+#include <stdarg.h>                 // va_list
+#include <stdio.h>                  // vsnprintf
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // État des tâches, notifications
+#include "esp_heap_caps.h"          // Tas libre, minimum et plus grand bloc
+#include "esp_timer.h"              // Temps depuis le démarrage, sonde
+#include "esp_wifi.h"               // Niveau du point d'accès
+#include "esp_system.h"             // Cause du dernier redémarrage
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "watchdog.h"               // Tâche en cause d'un redémarrage par le superviseur
+#include "mqtt.h"                   // Publication du message
+
+#define DIAG_PROBE_TIMEOUT_MS 1000  // Au-delà, la sonde esp_timer est déclarée non servie
+
+static const char *TAG = "DIAG";           // Identifiant de log du module
+
+static TaskHandle_t diag_task;             // Tâche réveillée par la sonde
+static esp_timer_handle_t probe;           // Sonde de la tâche esp_timer
+static volatile int64_t probe_fired;       // Heure de traitement de la sonde (µs)
+static char json[DIAG_JSON_MAX];           // Message en construction
+static size_t json_len;
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+static TaskStatus_t tasks[DIAG_MAX_TASKS]; // Relevé courant
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static struct {
+    UBaseType_t number;                    // xTaskNumber, unique pendant la vie de la tâche
+    uint32_t runtime;                      // ulRunTimeCounter au relevé précédent
+} prev[DIAG_MAX_TASKS];
+static int prev_count;
+static uint32_t prev_total;                // Temps total au relevé précédent
+#endif
+#endif
+
+/**
+ * @brief Ajoute du texte formaté au message (tronqué, jamais débordé).
+ */
+static void put(const char *fmt, ...)
+{
+    if (json_len >= sizeof(json)) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(json + json_len, sizeof(json) - json_len, fmt, ap);
+    va_end(ap);
+    if (n > 0) json_len += (size_t)n;
+}
+
+/**
+ * @brief Rappel de la sonde, exécuté par la tâche esp_timer.
+ */
+static void probe_cb(void *arg)
+{
+    probe_fired = esp_timer_get_time();
+    xTaskNotifyGive(diag_task);
+}
+
+/**
+ * @brief Retard de traitement d'un esp_timer à échéance immédiate (µs, -1 si non servi).
+ */
+static int32_t probe_latency(void)
+{
+    ulTaskNotifyTake(pdTRUE, 0);           // Aucune notification en retard
+    int64_t armed = esp_timer_get_time();
+    if (esp_timer_start_once(probe, 0) != ESP_OK) return -1;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DIAG_PROBE_TIMEOUT_MS)) == 0)
+    {
+        esp_timer_stop(probe);
+        return -1;
+    }
+    return (int32_t)(probe_fired - armed);
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+/**
+ * @brief Écrit une part du CPU en % avec une décimale.
+ */
+static void put_pct(uint32_t part, uint32_t total)
+{
+    uint32_t pm = total ? (uint32_t)((uint64_t)part * 1000 / total) : 0; // Pour mille
+    if (pm > 1000) pm = 1000;
+    put("%u.%u", (unsigned)(pm / 10), (unsigned)(pm % 10));
+}
+
+/**
+ * @brief Écrit la charge des cœurs et le détail par tâche.
+ */
+static void put_tasks(void)
+{
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(tasks, DIAG_MAX_TASKS, &total);
+    if (n == 0)                            // Plus de DIAG_MAX_TASKS tâches : détail omis
+    {
+        ESP_LOGW(TAG, "Plus de %d tâches, détail omis", DIAG_MAX_TASKS);
+        return;
+    }
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    uint32_t delta[DIAG_MAX_TASKS];        // Temps d'exécution de chaque tâche sur la période
+    for (UBaseType_t t = 0; t < n; t++)
+    {
+        delta[t] = tasks[t].ulRunTimeCounter; // Tâche nouvelle : depuis sa création
+        for (int p = 0; p < prev_count; p++)
+        {
+            if (prev[p].number == tasks[t].xTaskNumber)
+            {
+                delta[t] = tasks[t].ulRunTimeCounter - prev[p].runtime;
+                break;
+            }
+        }
+    }
+    uint32_t elapsed = total - prev_total; // Durée de la période, par cœur
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(c);
+        for (UBaseType_t t = 0; t < n; t++)
+        {
+            if (tasks[t].xHandle != idle) continue;
+            uint32_t idle_time = delta[t] < elapsed ? delta[t] : elapsed;
+            put(",\"load%d\":", c);
+            put_pct(elapsed - idle_time, elapsed);
+        }
+    }
+#endif
+
+    put(",\"tasks\":{");
+    for (UBaseType_t t = 0; t < n; t++)
+    {
+        put("%s\"%s\":[%u", t ? "," : "", tasks[t].pcTaskName, (unsigned)tasks[t].usStackHighWaterMark);
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        put(",");
+        put_pct(delta[t], elapsed);
+#endif
+        put("]");
+    }
+    put("}");
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    for (UBaseType_t t = 0; t < n; t++)    // Référence de la période suivante
+    {
+        prev[t].number = tasks[t].xTaskNumber;
+        prev[t].runtime = tasks[t].ulRunTimeCounter;
+    }
+    prev_count = (int)n;
+    prev_total = total;
+#endif
+}
+#endif
+
+/**
+ * @brief Construit le message de diagnostic dans json.
+ */
+static void build(void)
+{
+    wifi_ap_record_t ap;
+    int rssi = (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) ? ap.rssi : 0;
+
+    json_len = 0;
+    put("{\"up\":%lu,\"heap\":%u,\"heap_min\":%u,\"heap_blk\":%u,\"rssi\":%d,\"tlat\":%ld",
+        (unsigned long)(esp_timer_get_time() / 1000000),
+        (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+        (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+        rssi, (long)probe_latency());
+    put(",\"rst\":%d", (int)esp_reset_reason());
+    const char *miss = watchdog_last_miss();
+    if (miss) put(",\"wdt\":\"%s\"", miss);
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    put_tasks();
+#endif
+    put("}");
+}
+
+/**
+ * @brief Tâche diag : un relevé toutes les DIAG_PERIOD_S secondes.
+ *
+ * Le relevé est fait même sans broker, pour que les parts du CPU publiées
+ * couvrent toujours une seule période.
+ */
+static void task_diag(void *pv)
+{
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(DIAG_PERIOD_S * 1000));
+        build();
+        if (json_len >= sizeof(json))      // Tronqué : JSON invalide, non publié
+        {
+            ESP_LOGW(TAG, "Diagnostic tronqué (DIAG_JSON_MAX = %d)", DIAG_JSON_MAX);
+            continue;
+        }
+        if (mqtt_is_connected()) mqtt_publish_diag(json);
+    }
+}
+
+void diag_start(void)
+{
+    const esp_timer_create_args_t args = {
+        .callback = probe_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "diag_probe",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &probe));
+    xTaskCreatePinnedToCore(task_diag, "diag", 3072, NULL, DIAG_PRIORITY, &diag_task, CORE_NET);
+}
+
+#else // DIAG_PERIOD_S == 0
+
+void diag_start(void)
+{
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef DIAG_H
+#define DIAG_H
+
+/**
+ * @file diag.h
+ * @brief Diagnostic périodique de l'appareil : pile, CPU et mémoire, publié sur MQTT.
+ *
+ * Toutes les DIAG_PERIOD_S secondes, un message JSON compact est publié sur
+ * energie/<DEVICE_NAME>/diag (si le broker est joignable) :
+ *
+ *   {"up":86400,"heap":123456,"heap_min":98304,"heap_blk":65536,"rssi":-61,"tlat":42,"rst":6,
+ *    "wdt":"task_mqtt","load0":3.1,"load1":0.4,"tasks":{"task_counter":[1234,0.8],"task_mqtt":[2048,0.3],...}}
+ *
+ * - up       : secondes depuis le démarrage
+ * - heap     : tas libre en octets ; heap_min : minimum atteint depuis le démarrage ;
+ *              heap_blk : plus grand bloc allouable (fragmentation)
+ * - rssi     : niveau du point d'accès en dBm
+ * - tlat     : retard en µs d'un esp_timer sonde sur son échéance, reflet de la file de la
+ *              tâche esp_timer (-1 si la sonde n'a pas été servie en une seconde)
+ * - rst      : cause du dernier redémarrage (esp_reset_reason_t, 6 = task watchdog) ;
+ *              wdt : tâche sans battement qui l'a provoqué (watchdog.h), absent sinon
+ * - loadN    : charge du cœur N en % sur la période (100 - part de sa tâche idle)
+ * - tasks    : par tâche, pile jamais utilisée (octets) et temps CPU en % d'un cœur sur la période
+ *
+ * Le détail par tâche nécessite CONFIG_FREERTOS_USE_TRACE_FACILITY ; la charge et la part du CPU
+ * nécessitent en plus CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS. Les champs indisponibles sont omis.
+ *
+ * Les champs heap, heap_min, heap_blk, rssi, up et loadN sont annoncés à Home Assistant
+ * (catégorie « diagnostic ») par la découverte (mqtt_payload).
+ *
+ * Avec DIAG_PERIOD_S à 0, diag_start() est sans effet.
+ */
+
+/**
+ * @brief Démarre la tâche de diagnostic.
+ *
+ * À appeler après mqtt_init().
+ */
+void diag_start(void);
+
+#endif // DIAG_H
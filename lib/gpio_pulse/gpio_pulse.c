@@ -4,161 +4,252 @@
  *
  * Ce module gère la configuration des GPIO en entrée interruption (front montant),
  * lance un timer logiciel pour valider la stabilité du niveau (débouncing) et incrémente
- * un compteur si le signal est toujours HIGH après la temporisation. Les impulsions validées
- * sont ensuite envoyées vers une tâche de debug via une file.
+ * un compteur (counter_store) si le signal est toujours HIGH après la temporisation. Le chemin de comptage
+ * n'écrit aucun log : avec PULSE_STATS, il alimente seulement des statistiques par compteur (pulse_stats.h).
+ *
+ * Trois moteurs de comptage sont disponibles (voir PULSE_BACKEND dans config.h) :
+ *  - SAMPLER : un gptimer lit les registres d'entrée et débounce toutes les pins en une passe (pulse_sampler.c),
+ *              moteur par défaut
+ *  - PCNT    : comptage et filtrage matériels, lecture périodique des accumulateurs (pulse_pcnt.c) ; filtre
+ *              plafonné à PCNT_GLITCH_NS, à choisir pour des sorties électroniques sans rebond
+ *  - ISR     : interruption par front + timer de validation, utilisé aussi en repli
+ *              pour les pins que le PCNT ou l'échantillonneur ne peuvent pas servir ; avec
+ *              PULSE_VALIDATE_WIDTH, interruption sur les deux fronts et validation par largeur, sans timer
+ * Les compteurs câblés sur des expandeurs MCP23017 (PULSE_EXPANDER) sont servis par
+ * pulse_expander.c, qui débounce toutes leurs entrées en une passe (pulse_bulk.c).
  *
  * Architecture :
- *  GPIO ISR → Timer debounce → Validation → File → Tâche debug
+ *  GPIO ISR → Timer debounce → Validation → counter_store
+ *  GPIO ISR (deux fronts) → Largeur, écart, cadence → counter_store (PULSE_VALIDATE_WIDTH)
+ *  GPIO → PCNT → Timer de lecture → Validation → counter_store
+ *  GPIO → gptimer → Anti-rebond bit à bit → Tâche de report → Validation → counter_store
+ *  MCP23017 → INT → Tâche d'échantillonnage → Anti-rebond bit à bit → Validation → counter_store
  */
 
+#include <stdatomic.h>              // Impulsions non sauvegardées, sans verrou
 #include "freertos/FreeRTOS.h"      // API FreeRTOS
-#include "freertos/queue.h"         // Gestion des files (queues)
 #include "esp_log.h"                // Système de logs ESP-IDF
 #include "driver/gpio.h"            // Driver GPIO ESP-IDF
 #include "gpio_pulse.h"             // Header du module
 #include "esp_timer.h"              // Timer haute résolution (µs)
 #include "esp_attr.h"               // Attribut IRAM_ATTR pour ISR
-#include "config.h"                 // Configuration globale (pins, NB_COUNTERS, DEBOUNCE_US)
+#include "hal/gpio_ll.h"            // Changement du type d'interruption depuis une ISR
+#include "config.h"                 // Configuration globale (table des compteurs, PULSE_BACKEND)
 #include "nvs_flash.h"       // Fonctions NVS pour initialiser la mémoire flash
 #include "nvs.h"             // Fonctions NVS pour lire/écrire des valeurs
+#include "pulse_backend.h"   // Point d'entrée commun des impulsions validées
+#include "pulse_pcnt.h"      // Moteur de comptage PCNT
+#include "pulse_sampler.h"   // Moteur de comptage par échantillonnage gptimer
+#include "pulse_expander.h"  // Moteur de comptage sur expandeurs MCP23017
+#include "pulse_stats.h"     // Statistiques du chemin de comptage (PULSE_STATS)
+#include "counter_store.h"   // Stockage sans verrou des compteurs
+#include "power_meter.h"     // Horodatage des impulsions pour le calcul de puissance
+#include "publish_sched.h"   // Réveil de la tâche de publication
+#include "storage.h"         // Réveil de la tâche de sauvegarde
 
-volatile uint32_t isr_count = 0;    // Compteur debug du nombre d'interruptions reçues
 static const char *TAG = "GPIO_PULSE"; // Identifiant de log du module
-static QueueHandle_t pulse_queue;   // Queue pour transmettre les index validés à la task debug
-uint32_t counters[NB_COUNTERS] = {0}; // Tableau global des compteurs d’impulsions
-static pulse_ctx_t pulse_ctx[NB_COUNTERS]; // Contexte associé à chaque GPIO (index + timer)
+static pulse_ctx_t pulse_ctx[MAX_CHANNELS]; // Contexte associé à chaque GPIO (index + timer)
+static TaskHandle_t boot_button_task;       // Tâche du bouton BOOT, réveillée par son interruption
+static uint32_t save_step[MAX_CHANNELS];    // COUNTER_SAVE_WH en impulsions de chaque compteur (au moins 1)
+static _Atomic uint32_t unsaved[MAX_CHANNELS]; // Impulsions depuis le dernier instantané (remises à zéro par gpio_pulse_mark_saved)
 
 
+bool gpio_pulse_pin_valid(int pin)
+{
+    return GPIO_IS_VALID_GPIO(pin) || pulse_expander_pin(pin); // GPIO de l'ESP32 ou entrée d'expandeur
+}
+
+/**
+ * @brief ISR du bouton BOOT (niveau bas) : réveille la tâche du bouton.
+ *
+ * L'interruption de niveau se redéclencherait tant que le bouton est appuyé :
+ * elle est désactivée ici et réarmée par la tâche au relâchement.
+ *
+ * @param arg Non utilisé
+ */
+static void IRAM_ATTR boot_button_isr(void *arg)
+{
+    gpio_ll_set_intr_type(&GPIO, BOOT_BUTTON_GPIO, GPIO_INTR_DISABLE); // Désarmée jusqu'au relâchement
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(boot_button_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
 /**
  * @brief Tâche FreeRTOS pour gérer le bouton de démarrage (BOOT).
  *
  * Cette tâche configure un GPIO en entrée interruption et détecte les appuis longs sur ce bouton.
  * Si l'appui est prolongé, elle active le mode de configuration et redémarre le système.
+ * Au repos, la tâche dort jusqu'à l'interruption du bouton (pas de scrutation, compatible
+ * avec le light sleep) ; le niveau n'est suivi que pendant un appui.
  *
  * @param pv Paramètre non utilisé
  */
 void task_boot_button(void *pv)
 {
+    boot_button_task = xTaskGetCurrentTaskHandle(); // Tâche réveillée par l'ISR du bouton
+
     gpio_config_t io_conf = {
         .pin_bit_mask = 1ULL << BOOT_BUTTON_GPIO, // Masque pour le GPIO du bouton
         .mode = GPIO_MODE_INPUT, // Configure en entrée
         .pull_up_en = GPIO_PULLUP_ENABLE, // Active la résistance de pull-up interne
         .pull_down_en = GPIO_PULLDOWN_DISABLE, // Désactive la résistance de pull-down
-        .intr_type = GPIO_INTR_DISABLE // Pas d'interruption nécessaire pour ce bouton
-    }; // Configure le GPIO du bouton en entrée avec pull-up et sans interruption
+        .intr_type = GPIO_INTR_LOW_LEVEL // Interruption sur appui (niveau bas), aussi source de réveil
+    }; // Configure le GPIO du bouton en entrée avec pull-up et interruption de niveau
 
     gpio_config(&io_conf); // Applique la configuration du GPIO
-
-    int64_t press_start_time = 0; // Variable pour stocker le temps de début d'appui sur le bouton
-    bool pressed = false; // Indique si le bouton est actuellement considéré comme appuyé
-    bool reboot_triggered = false; // Indique si le reboot a déjà été déclenché pour éviter les redémarrages multiples
+    esp_err_t ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM); // Déjà installé si des compteurs sont servis par ISR
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGE(TAG, "Service ISR indisponible : %s", esp_err_to_name(ret));
+    }
+    gpio_isr_handler_add(BOOT_BUTTON_GPIO, boot_button_isr, NULL);
+#if LOW_POWER
+    gpio_wakeup_enable(BOOT_BUTTON_GPIO, GPIO_INTR_LOW_LEVEL); // Un appui réveille le CPU du light sleep
+#endif
 
     ESP_LOGI(TAG, "Boot button task started"); // Log de démarrage de la tâche
 
     while (1)
     {
-        int level = gpio_get_level(BOOT_BUTTON_GPIO); // Lit le niveau du GPIO du bouton (0 = appuyé, 1 = relâché)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Attend un appui
 
-        if (level == 0) // Bouton appuyé (LOW) // Logique inverse à cause du pull-up
+        int64_t press_start_time = esp_timer_get_time(); // Enregistre le temps de début d'appui en microsecondes
+        if (gpio_get_level(BOOT_BUTTON_GPIO) == 0) // Appui confirmé (pas un rebond au relâchement)
         {
-            if (!pressed) // Si ce n'était pas déjà considéré comme appuyé, on enregistre le temps de début d'appui
-            {
-                pressed = true; // Marque le bouton comme appuyé
-                press_start_time = esp_timer_get_time(); // Enregistre le temps actuel en microsecondes
-                reboot_triggered = false; // Reset du flag de reboot pour permettre un nouveau reboot si le bouton est maintenu à nouveau
-                ESP_LOGI(TAG, "BOOT pressed"); // Log de détection d'appui sur le bouton
-            }
-            else if (!reboot_triggered) // Si le bouton est toujours considéré comme appuyé et que le reboot n'a pas encore été déclenché, on vérifie la durée d'appui
+            ESP_LOGI(TAG, "BOOT pressed"); // Log de détection d'appui sur le bouton
+        }
+
+        while (gpio_get_level(BOOT_BUTTON_GPIO) == 0) // Bouton appuyé (LOW) // Logique inverse à cause du pull-up
+        {
+            int64_t elapsed_ms = (esp_timer_get_time() - press_start_time) / 1000; // Calcule le temps écoulé en millisecondes
+
+            if (elapsed_ms >= BOOT_LONG_PRESS_TIME_MS) // Si le temps d'appui dépasse le seuil défini pour un appui long, on déclenche le reboot
             {
-                int64_t now = esp_timer_get_time(); // Obtient le temps actuel en microsecondes
-                int64_t elapsed_ms = (now - press_start_time) / 1000; // Calcule le temps écoulé en millisecondes
-
-                if (elapsed_ms >= BOOT_LONG_PRESS_TIME_MS) // Si le temps d'appui dépasse le seuil défini pour un appui long, on déclenche le reboot
-                {
-                    reboot_triggered = true; // Marque le reboot comme déclenché pour éviter les redémarrages multiples
-
-                    ESP_LOGW(TAG, "BOOT LONG PRESS detected -> REBOOT"); // Log de détection d'un appui long sur le bouton
-                    nvs_handle_t handle; // Handle pour accéder à la NVS de configuration
-                    esp_err_t ret = nvs_open("config", NVS_READWRITE, &handle); // Ouvre la NVS "config" en mode lecture/écriture
-                    if (ret == ESP_OK) { // Si l'ouverture réussit, on écrit le flag de mode configuration dans la NVS pour indiquer au système de démarrer en mode configuration après le reboot
-                        uint8_t flag = 1; // 1 = mode configuration activé
-                        ret = nvs_set_u8(handle, "config_mode", flag); // Tente d'écrire le flag de mode configuration dans la NVS
-                        nvs_commit(handle); // Commite les modifications pour s'assurer que la valeur est bien sauvegardée
-                        nvs_close(handle); // Ferme la NVS après écriture
-                        ESP_LOGI(TAG, "Config mode flag saved to NVS"); // Log de succès de sauvegarde du flag de mode configuration
-                    } else { // Si l'ouverture échoue, on log une erreur
-                        ESP_LOGE(TAG, "Impossible d'ouvrir NVS pour flag config mode"); // Log d'erreur
-                    }
-                    vTaskDelay(pdMS_TO_TICKS(200));  // petit délai pour flush logs
-                    while(gpio_get_level(BOOT_BUTTON_GPIO)==0){} // Attente que le bouton soit relâché pour éviter de redémarrer en boucle si le bouton est maintenu
-                    esp_restart();                   // 🔥 reboot propre ESP32
+                ESP_LOGW(TAG, "BOOT LONG PRESS detected -> REBOOT"); // Log de détection d'un appui long sur le bouton
+                nvs_handle_t handle; // Handle pour accéder à la NVS de configuration
+                ret = nvs_open("config", NVS_READWRITE, &handle); // Ouvre la NVS "config" en mode lecture/écriture
+                if (ret == ESP_OK) { // Si l'ouverture réussit, on écrit le flag de mode configuration dans la NVS pour indiquer au système de démarrer en mode configuration après le reboot
+                    uint8_t flag = 1; // 1 = mode configuration activé
+                    ret = nvs_set_u8(handle, "config_mode", flag); // Tente d'écrire le flag de mode configuration dans la NVS
+                    nvs_commit(handle); // Commite les modifications pour s'assurer que la valeur est bien sauvegardée
+                    nvs_close(handle); // Ferme la NVS après écriture
+                    ESP_LOGI(TAG, "Config mode flag saved to NVS"); // Log de succès de sauvegarde du flag de mode configuration
+                } else { // Si l'ouverture échoue, on log une erreur
+                    ESP_LOGE(TAG, "Impossible d'ouvrir NVS pour flag config mode"); // Log d'erreur
                 }
+                vTaskDelay(pdMS_TO_TICKS(200));  // petit délai pour flush logs
+                while(gpio_get_level(BOOT_BUTTON_GPIO)==0){} // Attente que le bouton soit relâché pour éviter de redémarrer en boucle si le bouton est maintenu
+                esp_restart();                   // 🔥 reboot propre ESP32
             }
-        }
-        else // Bouton relâché (HIGH)
-        {
-            pressed = false;  // Reset si relâché
+
+            vTaskDelay(pdMS_TO_TICKS(BOOT_BUTTON_POLL_MS)); // Suivi de l'appui en cours
         }
 
-        vTaskDelay(pdMS_TO_TICKS(2000)); // polling léger + anti-rebond
+        gpio_set_intr_type(BOOT_BUTTON_GPIO, GPIO_INTR_LOW_LEVEL); // Bouton relâché : réarme l'interruption
     }
 }
 
 /**
- * @brief Callback du timer de débouncing.
+ * @brief Chemin commun de pulse_count_validated() et pulse_count_validated_isr().
+ *
+ * @param woken NULL en contexte tâche ; sinon, reçoit le besoin de changement de tâche de l'ISR
+ */
+static inline __attribute__((always_inline)) void count_validated(int idx, uint32_t n, int64_t t_us, BaseType_t *woken)
+{
+    counter_store_add(idx, n);              // Incrémente le compteur correspondant (atomique)
+    power_meter_record(idx, n, t_us);       // Horodatage sans verrou pour le calcul de puissance
+    if (woken) publish_sched_notify_from_isr(idx, woken); // Réveille l'ordonnanceur de publication
+    else publish_sched_notify(idx);
+    uint32_t since = atomic_fetch_add_explicit(&unsaved[idx], n, memory_order_relaxed) + n;
+    if (since >= save_step[idx] && since % save_step[idx] < n) // COUNTER_SAVE_WH de plus depuis le dernier instantané (division 32 bits matérielle)
+    {
+        if (woken) storage_request_save_from_isr(woken); // Réveille la tâche de sauvegarde
+        else storage_request_save();
+    }
+
+    PULSE_STAT_ADD(idx, accepted, n);       // Impulsions validées (sans effet si PULSE_STATS vaut 0)
+    PULSE_STAT_LATENCY(idx, (uint32_t)(esp_timer_get_time() - t_us)); // Délai front → prise en compte
+}
+
+/**
+ * @brief Comptabilise des impulsions validées par l'un des moteurs de comptage.
  *
- * Cette fonction est appelée après une temporisation définie (DEBOUNCE_US) suite à un front montant détecté sur un GPIO.
- * Elle vérifie que le signal reste HIGH et, si c'est le cas, incrémente le compteur correspondant et envoie l'index
- * vers la tâche de debug.
+ * Incrémente le compteur correspondant (une seule opération atomique, sans
+ * verrou), horodate les impulsions pour le calcul de puissance, réveille
+ * l'ordonnanceur de publication, demande une sauvegarde à chaque multiple de
+ * COUNTER_SAVE_WH franchi et, avec PULSE_STATS, met à jour les statistiques.
+ *
+ * @param idx  Index du compteur
+ * @param n    Nombre d'impulsions validées
+ * @param t_us Horodatage des impulsions
+ */
+void pulse_count_validated(int idx, uint32_t n, int64_t t_us)
+{
+    count_validated(idx, n, t_us, NULL);
+}
+
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+/**
+ * @brief Variante ISR de pulse_count_validated() (timer de debounce en ESP_TIMER_ISR).
+ */
+void IRAM_ATTR pulse_count_validated_isr(int idx, uint32_t n, int64_t t_us)
+{
+    BaseType_t woken = pdFALSE;
+    count_validated(idx, n, t_us, &woken);
+    if (woken == pdTRUE) esp_timer_isr_dispatch_need_yield(); // Changement de tâche en sortie d'ISR du timer
+}
+#endif
+
+#if PULSE_VALIDATE == PULSE_VALIDATE_LEVEL
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+/**
+ * @brief Callback du timer de débouncing, exécuté dans l'ISR de l'esp_timer.
+ *
+ * Même rôle que verify_stability_callback() : avec CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1,
+ * la validation est servie sur le cœur du comptage, sans passer par la tâche esp_timer
+ * (cœur réseau, partagée avec tous les autres timers).
  *
  * @param arg Pointeur vers la structure pulse_ctx_t associée au GPIO concerné
  */
-static void verify_stability_callback(void *arg)
+static void IRAM_ATTR verify_stability_isr(void *arg)
 {
     pulse_ctx_t *ctx = (pulse_ctx_t *)arg;  // Récupère le contexte du GPIO concerné
 
-    ESP_LOGI(TAG, "Pulse debounce timer expired for GPIO %d (compteur %d)", ctx->gpio, ctx->idx); // Log expiration timer
-
-    if (gpio_get_level(ctx->gpio) == 1)     // Vérifie que le niveau est toujours HIGH
+    if (gpio_ll_get_level(&GPIO, ctx->gpio) == 1) // Niveau toujours HIGH (lecture directe, en IRAM)
     {
-        counters[ctx->idx]++;               // Incrémente le compteur correspondant
-
-        int idx = ctx->idx;                 // Copie locale de l’index
-
-        xQueueSend(pulse_queue, &idx, 0);   // Envoie l’index vers la task debug (contexte non ISR)
+        pulse_count_validated_isr(ctx->idx, 1, ctx->edge_us);
     }
 }
-
+#else
 /**
- * @brief Tâche FreeRTOS pour afficher les impulsions validées.
+ * @brief Callback du timer de débouncing.
  *
- * Cette tâche attend en permanence des index provenant d'une file et affiche la valeur du compteur associé.
+ * Cette fonction est appelée après la temporisation anti-rebond du compteur (channels[idx].debounce_us) suite à un front montant détecté sur un GPIO.
+ * Elle vérifie que le signal reste HIGH et, si c'est le cas, incrémente le compteur correspondant.
+ * Aucun log ici : ce callback s'exécute à chaque impulsion, rebonds compris.
  *
- * @param pv Paramètre non utilisé
+ * @param arg Pointeur vers la structure pulse_ctx_t associée au GPIO concerné
  */
-static void pulse_debug_task(void *pv)
+static void verify_stability_callback(void *arg)
 {
-    int idx;                                        // Variable pour stocker l’index reçu
-
-    ESP_LOGI(TAG, "Pulse debug task started");      // Log démarrage tâche
+    pulse_ctx_t *ctx = (pulse_ctx_t *)arg;  // Récupère le contexte du GPIO concerné
 
-    while (1)                                       // Boucle infinie
+    if (gpio_get_level(ctx->gpio) == 1)     // Vérifie que le niveau est toujours HIGH
     {
-        if (xQueueReceive(pulse_queue, &idx, portMAX_DELAY)) // Attend un index depuis la queue
-        {
-            ESP_LOGI(TAG,
-                     "Pulse valide sur compteur %d -> valeur = %lu",
-                     idx,
-                     counters[idx]);               // Affiche compteur mis à jour
-        }
+        pulse_count_validated(ctx->idx, 1, ctx->edge_us); // Comptabilise l'impulsion, horodatée au front montant
     }
 }
+#endif
 
 /**
  * @brief ISR déclenchée sur front montant GPIO.
  *
  * Cette interruption :
- *  - Compte le nombre total d’interruptions reçues (debug)
+ *  - Avec LOW_POWER, alterne le niveau attendu et ignore les fronts descendants
+ *  - Compte le front (PULSE_STATS)
+ *  - Mémorise l'heure du front pour horodater l'impulsion
  *  - Stoppe le timer si déjà actif
  *  - Relance un timer de validation (debounce)
  *
@@ -166,72 +257,271 @@ static void pulse_debug_task(void *pv)
  */
 static void IRAM_ATTR pulse_isr(void *arg)
 {
-    isr_count++;                                   // Incrémente compteur ISR global (debug)
-
     pulse_ctx_t *ctx = (pulse_ctx_t *)arg;         // Récupère le contexte du GPIO
 
+#if LOW_POWER
+    bool rising = ctx->armed_high;                 // Niveau haut atteint : front montant
+    ctx->armed_high = !rising;                     // Attend désormais le niveau opposé
+    gpio_ll_set_intr_type(&GPIO, ctx->gpio, rising ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    if (!rising) return;                           // Front descendant : rien à valider
+#endif
+
+    PULSE_STAT_ADD(ctx->idx, edges, 1);            // Front brut, rebonds compris
+
+    ctx->edge_us = esp_timer_get_time();           // Heure du front (le dernier rebond précède la validation)
+
     esp_timer_stop(ctx->verify_timer);             // Stoppe le timer si déjà lancé
 
-    esp_timer_start_once(ctx->verify_timer, DEBOUNCE_US); // Lance le timer debounce
+    if (esp_timer_start_once(ctx->verify_timer, ctx->debounce_us) != ESP_OK) // Lance le timer debounce du compteur
+    {
+        PULSE_STAT_ADD(ctx->idx, dropped, 1);      // Validation impossible : front perdu
+    }
 }
 
+#else // PULSE_VALIDATE_WIDTH
+
 /**
- * @brief Initialise les GPIO, timers et interruptions.
+ * @brief ISR déclenchée sur chaque front GPIO (PULSE_VALIDATE_WIDTH).
  *
- * Cette fonction :
- *  - Configure chaque GPIO en entrée interruption
- *  - Crée un timer de validation par GPIO
- *  - Attache une ISR à chaque pin
- *  - Crée une tâche de debug unique
+ * Coût constant par front, sans timer : l'impulsion est jugée à son front descendant.
+ *  - Front montant après un creux de moins de dip_us : rebond, l'impulsion en cours continue
+ *  - Autre front montant : nouvelle impulsion ; la précédente, restée trop courte, est rejetée
+ *  - Front descendant : impulsion d'au moins debounce_us jugée sur sa largeur (PULSE_WIDTH_MAX_US),
+ *    son écart à la dernière impulsion comptée et sa cadence (min_period_us), puis comptée ou rejetée
+ * Plus courte que debounce_us, l'impulsion reste en attente : un rebond peut encore la prolonger.
+ *
+ * @param arg Pointeur vers la structure pulse_ctx_t du GPIO concerné
  */
-void gpio_init_pulses(void)
+static void IRAM_ATTR pulse_width_isr(void *arg)
 {
-    esp_log_level_set("*", ESP_LOG_INFO);          // Force le niveau de log global à INFO
+    pulse_ctx_t *ctx = (pulse_ctx_t *)arg;         // Récupère le contexte du GPIO
+    int64_t t = esp_timer_get_time();              // Heure du front
+
+#if LOW_POWER
+    bool high = ctx->armed_high;                   // Niveau atteint
+    ctx->armed_high = !high;                       // Attend désormais le niveau opposé
+    gpio_ll_set_intr_type(&GPIO, ctx->gpio, high ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+#else
+    bool high = gpio_ll_get_level(&GPIO, ctx->gpio); // Sens du front (interruption sur les deux fronts)
+#endif
+    if (high == ctx->high) return;                 // Aller-retour plus bref que l'ISR : niveau inchangé
+    ctx->high = high;
+
+    if (high)
+    {
+        PULSE_STAT_ADD(ctx->idx, edges, 1);        // Front brut, rebonds compris
+        if (t - ctx->fall_us < ctx->dip_us) return; // Creux bref : rebond, même impulsion
+        if (!ctx->decided) PULSE_STAT_ADD(ctx->idx, width, 1); // Impulsion précédente trop courte
+        ctx->rise_us = t;
+        ctx->decided = false;
+        return;
+    }
 
-    ESP_LOGE(TAG, "GPIO pulse init Start");        // Log début initialisation
+    ctx->fall_us = t;
+    if (ctx->decided)                              // Rebond après une impulsion déjà jugée
+    {
+        if (ctx->last_us == ctx->rise_us) ctx->end_us = t; // Impulsion comptée : sa fin recule
+        return;
+    }
+    int64_t width = t - ctx->rise_us;
+    if (width < ctx->debounce_us) return;          // Trop courte pour l'instant
+    ctx->decided = true;
+    if (width > PULSE_WIDTH_MAX_US)
+    {
+        PULSE_STAT_ADD(ctx->idx, width, 1);        // Entrée restée haute : pas une impulsion S0
+        return;
+    }
+    if (ctx->rise_us - ctx->end_us < ctx->debounce_us || ctx->rise_us - ctx->last_us < ctx->min_period_us)
+    {
+        PULSE_STAT_ADD(ctx->idx, rate, 1);         // Trop proche de la précédente : cadence impossible
+        return;
+    }
+    ctx->last_us = ctx->rise_us;
+    ctx->end_us = t;
+
+    BaseType_t woken = pdFALSE;
+    count_validated(ctx->idx, 1, ctx->rise_us, &woken); // Impulsion horodatée à son front montant
+    portYIELD_FROM_ISR(woken);
+}
+#endif
+
+/**
+ * @brief Configure un compteur sur le moteur ISR + timer de validation.
+ *
+ * Installe le service ISR au premier appel, configure la pin en entrée
+ * interruption sur front montant et crée son timer de validation. Avec
+ * PULSE_VALIDATE_WIDTH, l'interruption porte sur les deux fronts et aucun
+ * timer n'est créé : les limites du compteur sont calculées ici.
+ *
+ * @param i Index du compteur
+ */
+static void pulse_isr_add(int i)
+{
+    static bool isr_service_installed = false;     // Service ISR installé à la demande
+
+    if (!isr_service_installed)                    // Premier compteur servi par ISR
+    {
+        gpio_install_isr_service(ESP_INTR_FLAG_IRAM); // Installe le service ISR en IRAM
+        isr_service_installed = true;
+    }
 
     gpio_config_t io_conf = {                      // Structure de configuration GPIO
+        .pin_bit_mask = 1ULL << pulse_ctx[i].gpio, // Sélectionne la pin courante
         .mode = GPIO_MODE_INPUT,                   // Configure en entrée
         .pull_up_en = GPIO_PULLUP_DISABLE,         // Pull-up interne désactivé
         .pull_down_en = GPIO_PULLDOWN_DISABLE,     // Pull-down interne désactivé
         .intr_type = GPIO_INTR_POSEDGE             // Interruption sur front montant
     };
+#if PULSE_VALIDATE == PULSE_VALIDATE_WIDTH
+    io_conf.intr_type = GPIO_INTR_ANYEDGE;         // Les deux fronts sont horodatés
+#endif
+#if LOW_POWER
+    io_conf.intr_type = GPIO_INTR_DISABLE;         // Niveau de départ lu avant d'armer l'interruption
+    gpio_config(&io_conf);
+    pulse_ctx[i].armed_high = (gpio_get_level(pulse_ctx[i].gpio) == 0); // Entrée basse : attend le prochain front montant
+    io_conf.intr_type = pulse_ctx[i].armed_high ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL; // Seuls les niveaux réveillent du light sleep
+#endif
+
+    gpio_config(&io_conf);                         // Applique configuration GPIO
+#if LOW_POWER
+    gpio_wakeup_enable(pulse_ctx[i].gpio, io_conf.intr_type); // Source de réveil du light sleep
+#endif
+
+#if PULSE_VALIDATE == PULSE_VALIDATE_WIDTH
+    pulse_ctx_t *ctx = &pulse_ctx[i];
+    uint32_t ppkwh = channels[i].ppkwh ? channels[i].ppkwh : PULSES_PER_KWH;
+    ctx->high = (gpio_get_level(ctx->gpio) == 1);
+    ctx->decided = true;                           // Impulsion déjà commencée au démarrage : ignorée
+    ctx->rise_us = ctx->fall_us = ctx->last_us = ctx->end_us = INT64_MIN / 2; // Aucun front encore vu
+    ctx->dip_us = (ctx->debounce_us < PULSE_DIP_MAX_US) ? ctx->debounce_us : PULSE_DIP_MAX_US;
+    ctx->min_period_us = PULSE_MAX_POWER_W ? (uint32_t)(3600000000000ULL / ((uint64_t)ppkwh * PULSE_MAX_POWER_W)) : 0;
+
+    gpio_isr_handler_add(ctx->gpio, pulse_width_isr, ctx); // Attache ISR à la pin
+#else
+    const esp_timer_create_args_t timer_args =     // Structure config timer
+    {
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+        .callback = &verify_stability_isr,         // Validation dans l'ISR de l'esp_timer
+        .dispatch_method = ESP_TIMER_ISR,
+#else
+        .callback = &verify_stability_callback,    // Callback à exécuter
+#endif
+        .arg = &pulse_ctx[i],                      // Argument passé au callback
+        .name = "pulseVerify"                      // Nom debug timer
+    };
 
-    pulse_queue = xQueueCreate(10, sizeof(int));   // Création queue de taille 10
+    esp_timer_create(&timer_args, &pulse_ctx[i].verify_timer); // Création timer
 
-    gpio_install_isr_service(ESP_INTR_FLAG_IRAM);  // Installe le service ISR en IRAM
+    gpio_isr_handler_add(pulse_ctx[i].gpio,        // Attache ISR à la pin
+                         pulse_isr,
+                         &pulse_ctx[i]);
+#endif
+}
 
-    for (int i = 0; i < NB_COUNTERS; i++)          // Boucle sur tous les compteurs
+void gpio_pulse_mark_saved(void)
+{
+    for (int i = 0; i < MAX_CHANNELS; i++)
     {
-        io_conf.pin_bit_mask = 1ULL << pulse_pins[i]; // Sélectionne la pin courante
+        atomic_store_explicit(&unsaved[i], 0, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Initialise les GPIO, timers et interruptions.
+ *
+ * Cette fonction :
+ *  - Parcourt les channel_count compteurs actifs de la table (les GPIO non câblés sont ignorés)
+ *  - Attribue si possible une unité PCNT (moteur PCNT) ou une place dans l'échantillonneur (moteur SAMPLER) à chaque compteur
+ *  - Sinon configure le GPIO en entrée interruption avec un timer de validation
+ *  - Démarre la lecture périodique des accumulateurs PCNT ou le gptimer d'échantillonnage
+ */
+void gpio_init_pulses(void)
+{
+    ESP_LOGI(TAG, "GPIO pulse init Start");        // Log début initialisation
 
-        gpio_config(&io_conf);                     // Applique configuration GPIO
+#if PULSE_BACKEND == PULSE_BACKEND_PCNT
+    int pcnt_too_slow = 0;                         // Compteurs dont l'anti-rebond dépasse le filtre PCNT (moteur ISR)
+#elif PULSE_BACKEND == PULSE_BACKEND_SAMPLER
+    bool sampled[MAX_CHANNELS] = { false };        // Compteurs confiés à l'échantillonneur (repli ISR si le gptimer échoue)
+#endif
 
+    for (int i = 0; i < MAX_CHANNELS; i++)         // Toute la table : jamais de division par zéro dans le chemin de comptage
+    {
+        uint32_t ppkwh = channels[i].ppkwh ? channels[i].ppkwh : PULSES_PER_KWH;
+        save_step[i] = (uint32_t)((uint64_t)ppkwh * COUNTER_SAVE_WH / 1000); // Même énergie entre deux sauvegardes pour tous les compteurs
+        if (save_step[i] == 0) save_step[i] = 1;
+    }
+
+    for (int i = 0; i < channel_count; i++)        // Boucle sur les compteurs actifs
+    {
         pulse_ctx[i].idx = i;                      // Associe index compteur
 
-        pulse_ctx[i].gpio = pulse_pins[i];         // Associe numéro GPIO
+        pulse_ctx[i].gpio = channels[i].pin;       // Associe numéro GPIO
 
-        const esp_timer_create_args_t timer_args = // Structure config timer
+        pulse_ctx[i].debounce_us = channels[i].debounce_us; // Anti-rebond propre au compteur
+
+        if (channels[i].pin < 0 || !gpio_pulse_pin_valid(channels[i].pin)) // Compteur non câblé ou GPIO inexistant
         {
-            .callback = &verify_stability_callback, // Callback à exécuter
-            .arg = &pulse_ctx[i],                   // Argument passé au callback
-            .name = "pulseVerify"                   // Nom debug timer
-        };
+            ESP_LOGW(TAG, "Compteur %d : GPIO %d invalide, compteur ignoré", i, channels[i].pin);
+            continue;
+        }
 
-        esp_timer_create(&timer_args, &pulse_ctx[i].verify_timer); // Création timer
+#if PULSE_EXPANDER
+        if (pulse_expander_pin(channels[i].pin))   // Entrée d'un expandeur MCP23017
+        {
+            if (pulse_expander_add(i, channels[i].pin) != ESP_OK)
+            {
+                ESP_LOGW(TAG, "Compteur %d : entrée d'expandeur %d indisponible", i, channels[i].pin - PULSE_EXP_PIN_BASE);
+            }
+            continue;
+        }
+#endif
 
-        gpio_isr_handler_add(pulse_pins[i],        // Attache ISR à la pin
-                             pulse_isr,
-                             &pulse_ctx[i]);
+#if PULSE_BACKEND == PULSE_BACKEND_PCNT
+        // Le filtre matériel est plafonné (PCNT_GLITCH_NS) : un anti-rebond plus long n'est assuré que par le moteur ISR
+        if ((uint64_t)channels[i].debounce_us * 1000 > PCNT_GLITCH_NS)
+        {
+            pcnt_too_slow++;
+        }
+        else if (pulse_pcnt_add(i, pulse_ctx[i].gpio, channels[i].debounce_us * 1000) == ESP_OK) // Compteur servi par le matériel
+        {
+            gpio_set_pull_mode(pulse_ctx[i].gpio, GPIO_FLOATING); // Même câblage que le moteur ISR : pas de pull interne
+            continue;
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Compteur %d : repli sur le moteur ISR", i); // Pin non servie par le PCNT
+        }
+#elif PULSE_BACKEND == PULSE_BACKEND_SAMPLER
+        if (pulse_sampler_add(i, pulse_ctx[i].gpio) == ESP_OK) // Pin lue par l'échantillonneur
+        {
+            sampled[i] = true;
+            continue;
+        }
+        ESP_LOGW(TAG, "Compteur %d : repli sur le moteur ISR", i); // Pin déjà échantillonnée pour un autre compteur
+#endif
+        pulse_isr_add(i);                          // Moteur ISR + timer de validation
     }
 
-    xTaskCreate(                                   // Création tâche debug unique
-        pulse_debug_task,
-        "pulse_debug_task",
-        4096,
-        NULL,
-        5,
-        NULL);
+#if PULSE_BACKEND == PULSE_BACKEND_PCNT
+    if (pcnt_too_slow > 0)                         // Un seul avertissement pour tous les compteurs concernés
+    {
+        ESP_LOGW(TAG, "%d compteur(s) avec un anti-rebond au-delà du filtre PCNT (%d ns) : moteur ISR",
+                 pcnt_too_slow, PCNT_GLITCH_NS);
+    }
+    pulse_pcnt_start();                            // Lecture périodique des accumulateurs PCNT
+#elif PULSE_BACKEND == PULSE_BACKEND_SAMPLER
+    if (pulse_sampler_start() != ESP_OK)           // gptimer indisponible : les compteurs échantillonnés passent sur le moteur ISR
+    {
+        for (int i = 0; i < channel_count; i++)
+        {
+            if (sampled[i]) pulse_isr_add(i);
+        }
+    }
+#endif
+#if PULSE_EXPANDER
+    pulse_expander_start();                        // Tâche d'échantillonnage des expandeurs
+#endif
 
     ESP_LOGI(TAG, "GPIO pulse init OK");           // Log fin initialisation
 }
@@ -9,41 +9,68 @@
  * - Configure les GPIO utilisés pour les compteurs d'énergie
  * - Gère les ISR déclenchées sur front montant
  * - Utilise un système de validation différée via esp_timer pour vérifier la stabilité du signal
- * - Fournit un tableau global `counters[]` contenant les valeurs actuelles
+ * - Alimente le module counter_store qui contient les valeurs actuelles
+ *
+ * Trois moteurs de comptage sont sélectionnables via PULSE_BACKEND (config.h) :
+ * - PULSE_BACKEND_PCNT : chaque compteur utilise une unité PCNT ; le filtrage
+ *   anti-glitch et le comptage sont matériels, le logiciel lit périodiquement
+ *   les accumulateurs (PCNT_POLL_PERIOD_MS). Les pins que le PCNT ne peut pas
+ *   servir (unités épuisées...) et les compteurs dont l'anti-rebond dépasse le
+ *   filtre matériel (PCNT_GLITCH_NS) basculent automatiquement sur le moteur ISR.
+ * - PULSE_BACKEND_SAMPLER : un gptimer lit les registres d'entrée GPIO à période fixe
+ *   (anti-rebond le plus long / PULSE_BULK_SAMPLES) et débounce toutes les pins en une
+ *   passe (compteur vertical) : coût constant, sans interruption par front ni timer par compteur.
+ * - PULSE_BACKEND_ISR : moteur historique décrit ci-dessous, pour toutes les pins.
+ *
+ * Avec LOW_POWER, le moteur ISR utilise des interruptions de niveau, alternées à chaque
+ * changement : seules elles réveillent le CPU du light sleep (gpio_wakeup_enable).
+ *
+ * Avec PULSE_EXPANDER, les compteurs dont le GPIO vaut PULSE_EXP_PIN_BASE + n sont lus sur
+ * l'entrée n des expandeurs MCP23017, quel que soit le moteur choisi.
  *
  * Ce module n’utilise PAS de filtrage classique par “temps minimal entre pulses”.
  * Au lieu de cela, chaque impulsion est validée uniquement si le niveau du GPIO
- * reste stable HAUT pendant DEBOUNCE_US microsecondes après un front montant.
+ * reste stable HAUT pendant la durée d'anti-rebond du compteur (channels[i].debounce_us)
+ * après un front montant.
+ *
+ * Avec PULSE_VALIDATE_WIDTH (sorties S0), le moteur ISR horodate les deux fronts de chaque
+ * impulsion, sans timer : une impulsion est comptée à son front descendant si elle a duré
+ * entre debounce_us et PULSE_WIDTH_MAX_US, si elle commence au moins debounce_us après la fin
+ * de la dernière impulsion comptée (les parasites rejetés ne comptent pas), et si sa cadence correspond à moins de PULSE_MAX_POWER_W (ppkwh du compteur).
+ * Un creux de moins de PULSE_DIP_MAX_US est un rebond : l'impulsion continue.
  *
  * Usage typique :
  * 1. Appeler gpio_init_pulses() au démarrage de l'application
- * 2. Lire les valeurs des compteurs via le tableau counters[]
+ * 2. Lire les valeurs des compteurs via counter_store_get() / counter_store_snapshot()
  */
 
 #include <stdint.h>     // Pour uint32_t
+#include <stdbool.h>    // Pour bool
 #include "esp_timer.h"  // Pour les timers de validation différée
-#include "config.h"     // Pour les définitions de configuration (pins, NB_COUNTERS, DEBOUNCE_US)
-// ---------------------------------------------------------------------------
-// Nombre de compteurs utilisés
-// ---------------------------------------------------------------------------
-//#define NB_COUNTERS 5
-
-// ---------------------------------------------------------------------------
-// Tableau global des compteurs
-// Mis à jour par les callbacks de validation (timers)
-// ---------------------------------------------------------------------------
-extern uint32_t counters[NB_COUNTERS];
+#include "config.h"     // Pour la table des compteurs (channel_count, channels)
 
 void task_boot_button(void *pv);
 
+/**
+ * @brief Indique si un GPIO peut servir d'entrée de compteur (GPIO de l'ESP32 ou entrée d'expandeur).
+ *
+ * @param pin GPIO du compteur (channels[i].pin)
+ * @return true si le GPIO existe
+ */
+bool gpio_pulse_pin_valid(int pin);
+
 /**
  * @brief Structure de contexte pour chaque canal d'impulsion.
  *
  * Pour chaque GPIO gérant un compteur, un contexte associe :
- * - idx : l’index du compteur (0..NB_COUNTERS-1)
+ * - idx : l’index du compteur (0..channel_count-1)
  * - gpio : le numéro du GPIO utilisé
  * - verify_timer : timer asynchrone utilisé pour vérifier que
  *                  le signal est resté stable après un front montant
+ * - debounce_us : durée de l'anti-rebond du compteur
+ * - edge_us : heure du dernier front montant, qui horodate l'impulsion validée
+ * - armed_high : LOW_POWER, niveau attendu par l'interruption de niveau (true = prochain front montant)
+ * - PULSE_VALIDATE_WIDTH : fronts de l'impulsion en cours et limites du compteur (largeur, écart, cadence)
  *
  * Cette structure permet de passer au timer toutes les informations
  * nécessaires pour valider ou rejeter une impulsion.
@@ -52,20 +79,36 @@ typedef struct {
     int idx;                       ///< Index du compteur
     int gpio;                      ///< Numéro du GPIO associé
     esp_timer_handle_t verify_timer;  ///< Timer de validation du niveau stable
+    uint32_t debounce_us;          ///< Durée de l'anti-rebond (µs)
+    volatile int64_t edge_us;      ///< Heure du dernier front montant (esp_timer_get_time())
+    bool armed_high;               ///< LOW_POWER : interruption armée sur le niveau haut
+#if PULSE_VALIDATE == PULSE_VALIDATE_WIDTH
+    int64_t rise_us;               ///< Front montant de l'impulsion en cours (rebonds fusionnés)
+    int64_t fall_us;               ///< Dernier front descendant
+    int64_t last_us;               ///< Front montant de la dernière impulsion comptée
+    int64_t end_us;                ///< Front descendant de la dernière impulsion comptée (rebonds compris)
+    uint32_t dip_us;               ///< Creux plus court : rebond (min(PULSE_DIP_MAX_US, debounce_us))
+    uint32_t min_period_us;        ///< Période minimale plausible (PULSE_MAX_POWER_W, 0 = sans limite)
+    bool high;                     ///< Dernier niveau vu par l'ISR
+    bool decided;                  ///< Impulsion en cours déjà comptée ou rejetée
+#endif
 } pulse_ctx_t;
 
 /**
  * @brief Initialise les GPIO pour les compteurs d'impulsions et configure les ISR.
  *
  * Cette fonction :
+ * - Attribue une unité PCNT (PULSE_BACKEND_PCNT) ou une place dans l'échantillonneur
+ *   (PULSE_BACKEND_SAMPLER) à chaque compteur, les étapes suivantes ne concernent alors
+ *   que les pins en repli ISR
  * - Configure chaque GPIO comme entrée avec pull-up
  * - Configure les interruptions sur front montant (GPIO_INTR_POSEDGE)
  * - Installe le service ISR (gpio_install_isr_service)
  * - Crée pour chaque entrée un timer esp_timer utilisé pour vérifier la stabilité du signal
  * - Les ISR ne valident plus directement les impulsions :
  *      → Elles ne font qu'enregistrer l'heure du front montant et démarrer un timer
- * - Lorsqu'un timer expire (DEBOUNCE_US µs plus tard), le niveau du GPIO est relu :
- *      → Si toujours HAUT → l'impulsion est validée → counters[idx]++
+ * - Lorsqu'un timer expire (debounce_us µs plus tard), le niveau du GPIO est relu :
+ *      → Si toujours HAUT → l'impulsion est validée → counter_store_add(idx, 1)
  *      → Sinon → rebond / glitch → impulsion ignorée
  *
  * Ce système rend la détection :
@@ -75,4 +118,14 @@ typedef struct {
  */
 void gpio_init_pulses(void);
 
+/**
+ * @brief Signale qu'un instantané de tous les compteurs va être écrit.
+ *
+ * À appeler par la tâche de sauvegarde juste avant counter_store_snapshot() : l'énergie
+ * comptée depuis le dernier instantané repart de zéro pour tous les compteurs. Une demande
+ * de sauvegarde n'est émise que lorsqu'un compteur a cumulé COUNTER_SAVE_WH depuis, ce qui
+ * regroupe les franchissements de tous les compteurs en un seul enregistrement.
+ */
+void gpio_pulse_mark_saved(void);
+
 #endif // GPIO_PULSE_H
\ No newline at end of file
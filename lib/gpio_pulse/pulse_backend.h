@@ -0,0 +1,38 @@
+#ifndef PULSE_BACKEND_H
+#define PULSE_BACKEND_H
+
+/**
+ * @file pulse_backend.h
+ * @brief Point d'entrée commun des moteurs de comptage (ISR, PCNT).
+ *
+ * Chaque moteur signale ici les impulsions qu'il a validées ; c'est le seul
+ * endroit qui met à jour les compteurs (counter_store) et les statistiques (PULSE_STATS).
+ *
+ * Ce header est interne au module gpio_pulse.
+ */
+
+#include <stdint.h> // Pour uint32_t, int64_t
+
+/**
+ * @brief Comptabilise n impulsions validées sur le compteur idx.
+ *
+ * Appelée depuis un contexte tâche (tâche esp_timer pour le callback de debounce
+ * et la lecture périodique du PCNT, tâche de l'échantillonneur ou des expandeurs),
+ * jamais depuis une ISR : voir pulse_count_validated_isr().
+ *
+ * @param idx  Index du compteur (0..channel_count-1)
+ * @param n    Nombre d'impulsions à ajouter
+ * @param t_us Horodatage des impulsions (esp_timer_get_time()), utilisé pour le calcul de puissance
+ */
+void pulse_count_validated(int idx, uint32_t n, int64_t t_us);
+
+/**
+ * @brief Variante de pulse_count_validated() pour une ISR.
+ *
+ * Utilisée par le timer de debounce du moteur ISR quand l'esp_timer peut servir ses
+ * rappels en interruption (CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD) ; demande
+ * elle-même le changement de tâche en sortie d'ISR.
+ */
+void pulse_count_validated_isr(int idx, uint32_t n, int64_t t_us);
+
+#endif // PULSE_BACKEND_H
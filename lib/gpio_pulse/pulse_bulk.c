@@ -0,0 +1,38 @@
+/**
+ * @file pulse_bulk.c
+ * @brief Compteur vertical : anti-rebond de 32 entrées par quelques opérations logiques.
+ *
+ * Pour chaque bit i, (ct1, ct0) forme un compteur 2 bits qui décompte de 3 à 0 tant que l'entrée
+ * diffère de son état validé, et revient à 3 dès qu'elle lui est de nouveau égale. Au quatrième
+ * échantillon différent consécutif, le compteur reboucle : l'état validé bascule.
+ *
+ *   changed = state ^ sample      entrées différentes de l'état validé
+ *   ct0     = ~(ct0 & changed)    comptage (ou remise à 1 si inchangé)
+ *   ct1     = ct0 ^ (ct1 & changed)
+ *   toggle  = changed & ct0 & ct1 rebouclage : changement validé
+ *   state  ^= toggle
+ *   rising  = state & toggle      fronts montants validés
+ */
+
+#include "esp_attr.h"               // Attribut IRAM_ATTR
+#include "config.h"                 // PULSE_BULK_SAMPLES
+#include "pulse_bulk.h"             // Header du module
+
+_Static_assert(PULSE_BULK_SAMPLES == 4, "Le compteur vertical 2 bits valide un changement en 4 échantillons");
+
+void pulse_bulk_init(pulse_bulk_t *db, uint32_t sample)
+{
+    db->state = sample;             // Niveaux de départ considérés comme stables
+    db->ct0 = 0xFFFFFFFF;           // Compteurs à 3
+    db->ct1 = 0xFFFFFFFF;
+}
+
+uint32_t IRAM_ATTR pulse_bulk_step(pulse_bulk_t *db, uint32_t sample)
+{
+    uint32_t changed = db->state ^ sample;          // Entrées différentes de l'état validé
+    db->ct0 = ~(db->ct0 & changed);                 // Décompte, ou remise à 3 des entrées inchangées
+    db->ct1 = db->ct0 ^ (db->ct1 & changed);
+    uint32_t toggle = changed & db->ct0 & db->ct1;  // Compteurs rebouclés : changement validé
+    db->state ^= toggle;                            // Nouveaux niveaux validés
+    return db->state & toggle;                      // Fronts montants
+}
@@ -0,0 +1,60 @@
+#ifndef PULSE_BULK_H
+#define PULSE_BULK_H
+
+/**
+ * @file pulse_bulk.h
+ * @brief Anti-rebond bit à bit de toutes les entrées d'un mot d'échantillon en une passe.
+ *
+ * Les moteurs qui lisent plusieurs entrées à la fois (expandeur I2C, lecture d'un port GPIO)
+ * échantillonnent un mot de 32 bits, un bit par entrée. L'anti-rebond est un compteur vertical :
+ * chaque bit possède un compteur 2 bits réparti sur deux mots (ct0, ct1), et une seule suite
+ * d'opérations logiques met à jour les 32 compteurs. Un changement n'est validé qu'après
+ * PULSE_BULK_SAMPLES (4) échantillons consécutifs différents de l'état validé ; le coût par
+ * échantillon est constant, quel que soit le nombre d'entrées ou d'impulsions.
+ *
+ * Ce header est interne au module gpio_pulse.
+ */
+
+#include <stdint.h>  // Pour uint32_t
+
+/**
+ * @brief État de l'anti-rebond de 32 entrées.
+ */
+typedef struct {
+    uint32_t state;  ///< Niveaux validés (bit i = entrée i)
+    uint32_t ct0;    ///< Bit de poids faible des compteurs
+    uint32_t ct1;    ///< Bit de poids fort des compteurs
+} pulse_bulk_t;
+
+/**
+ * @brief Initialise l'anti-rebond sur un premier échantillon (aucun front au démarrage).
+ *
+ * @param db     Anti-rebond
+ * @param sample Niveaux lus au démarrage
+ */
+void pulse_bulk_init(pulse_bulk_t *db, uint32_t sample);
+
+/**
+ * @brief Ajoute un échantillon et retourne les fronts montants validés.
+ *
+ * Placée en IRAM, utilisable depuis une ISR.
+ *
+ * @param db     Anti-rebond
+ * @param sample Niveaux lus (bit i = entrée i)
+ * @return Entrées passées de 0 à 1 à cet échantillon (bit i = entrée i)
+ */
+uint32_t pulse_bulk_step(pulse_bulk_t *db, uint32_t sample);
+
+/**
+ * @brief Indique si des entrées sont en cours de validation (niveau lu différent du niveau validé).
+ *
+ * @param db     Anti-rebond
+ * @param sample Dernier échantillon
+ * @return Masque des entrées instables
+ */
+static inline uint32_t pulse_bulk_unstable(const pulse_bulk_t *db, uint32_t sample)
+{
+    return db->state ^ sample;
+}
+
+#endif // PULSE_BULK_H
@@ -0,0 +1,295 @@
+/**
+ * @file pulse_expander.c
+ * @brief Comptage d'impulsions sur expandeurs MCP23017, anti-rebond bit à bit sur toutes les entrées.
+ *
+ * Les MCP23017 sont configurés en entrées, interruption sur changement, sorties INTA/INTB
+ * reliées (MIRROR) et en drain ouvert (ODR) : tous les expandeurs partagent une seule ligne INT.
+ *
+ * Fonctionnement :
+ *  - Au repos, aucune lecture : la tâche dort jusqu'à l'interruption de la ligne INT
+ *  - Sur interruption, la tâche lit les registres GPIO de tous les expandeurs (ce qui libère INT)
+ *    et passe le mot de 32 bits au compteur vertical (pulse_bulk)
+ *  - Tant qu'une entrée est instable, un esp_timer relance une lecture toutes les
+ *    sample_us ; quand tout est stable, la tâche se rendort
+ *
+ * La période d'échantillonnage vaut le plus long anti-rebond des compteurs de l'expandeur
+ * divisé par PULSE_BULK_SAMPLES : l'anti-rebond est commun à toutes les entrées de l'expandeur.
+ *
+ * Architecture :
+ *  MCP23017 → ligne INT → ISR → Tâche d'échantillonnage (I2C) → pulse_bulk → Validation → counter_store
+ */
+
+#include "config.h"                 // Configuration globale (PULSE_EXPANDER, PULSE_EXP_*)
+
+#if PULSE_EXPANDER
+
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche d'échantillonnage et notifications
+#include "driver/gpio.h"            // Ligne INT
+#include "driver/i2c_master.h"      // Bus I2C des expandeurs
+#include "esp_timer.h"              // Relance des lectures pendant l'anti-rebond
+#include "esp_attr.h"               // Attribut IRAM_ATTR pour l'ISR
+#include "hal/gpio_ll.h"            // Désarmement de la ligne INT depuis l'ISR (LOW_POWER)
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "pulse_expander.h"         // Header du module
+#include "pulse_bulk.h"             // Anti-rebond bit à bit
+#include "pulse_backend.h"          // Point d'entrée commun des impulsions validées
+#include "pulse_stats.h"            // Statistiques du chemin de comptage (PULSE_STATS)
+
+#define MCP_IODIRA   0x00           // Direction des ports (1 = entrée)
+#define MCP_GPINTENA 0x04           // Interruption sur changement, par entrée
+#define MCP_INTCONA  0x08           // 0 = interruption sur tout changement
+#define MCP_IOCON    0x0A           // Configuration (IOCON.BANK = 0 : registres A/B entrelacés)
+#define MCP_GPIOA    0x12           // Niveaux des entrées (lecture = acquittement de l'interruption)
+#define MCP_IOCON_MIRROR 0x40       // INTA et INTB reliées
+#define MCP_IOCON_ODR    0x04       // Sortie INT en drain ouvert (ligne partagée)
+#define MCP_I2C_TIMEOUT_MS 10       // Délai max d'une transaction I2C
+
+static const char *TAG = "PULSE_EXP"; // Identifiant de log du module
+
+static i2c_master_bus_handle_t bus;                    // Bus I2C des expandeurs
+static i2c_master_dev_handle_t devs[PULSE_EXP_COUNT];  // Un handle par expandeur
+static int8_t bit_channel[16 * PULSE_EXP_COUNT];       // Compteur associé à chaque entrée (-1 = aucune)
+static uint32_t used_mask;                             // Entrées associées à un compteur
+static uint32_t sample_us;                             // Période d'échantillonnage pendant l'anti-rebond
+static pulse_bulk_t debounce;                          // Anti-rebond de toutes les entrées
+static TaskHandle_t sampler_task;                      // Tâche d'échantillonnage
+static esp_timer_handle_t sample_timer;                // Relance des lectures tant qu'une entrée est instable
+static volatile bool sampling;                         // Vrai pendant une séquence d'anti-rebond
+
+_Static_assert(16 * PULSE_EXP_COUNT <= 32, "Les entrées des expandeurs doivent tenir dans un mot de 32 bits");
+
+/**
+ * @brief Écrit un registre 8 bits sur les deux ports d'un expandeur (A puis B).
+ */
+static esp_err_t mcp_write_pair(i2c_master_dev_handle_t dev, uint8_t reg, uint16_t value)
+{
+    uint8_t buf[3] = { reg, (uint8_t)value, (uint8_t)(value >> 8) }; // Adresse auto-incrémentée (SEQOP = 0)
+    return i2c_master_transmit(dev, buf, sizeof(buf), MCP_I2C_TIMEOUT_MS);
+}
+
+/**
+ * @brief Lit les 16 entrées de tous les expandeurs.
+ *
+ * @param out Mot d'échantillon (bit 16 * d + n = entrée n de l'expandeur d)
+ * @return ESP_OK ou l'erreur I2C du premier expandeur qui ne répond pas
+ */
+static esp_err_t read_inputs(uint32_t *out)
+{
+    uint32_t sample = 0;
+    for (int d = 0; d < PULSE_EXP_COUNT; d++)
+    {
+        uint8_t reg = MCP_GPIOA;
+        uint8_t val[2];                                  // GPIOA puis GPIOB
+        esp_err_t ret = i2c_master_transmit_receive(devs[d], &reg, 1, val, sizeof(val), MCP_I2C_TIMEOUT_MS);
+        if (ret != ESP_OK) return ret;
+        sample |= (uint32_t)(val[0] | (val[1] << 8)) << (16 * d);
+    }
+    *out = sample;
+    return ESP_OK;
+}
+
+/**
+ * @brief Initialise le bus I2C et configure les expandeurs en entrées.
+ */
+static esp_err_t expander_init(void)
+{
+    i2c_master_bus_config_t bus_config = {
+        .i2c_port = PULSE_EXP_I2C_PORT,  // Contrôleur I2C
+        .sda_io_num = PULSE_EXP_SDA,     // Ligne SDA
+        .scl_io_num = PULSE_EXP_SCL,     // Ligne SCL
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,          // Filtre des parasites sur le bus
+        .flags.enable_internal_pullup = 1, // Appoint des résistances de tirage externes
+    };
+    esp_err_t ret = i2c_new_master_bus(&bus_config, &bus);
+    if (ret != ESP_OK) return ret;
+
+    for (int d = 0; d < PULSE_EXP_COUNT && ret == ESP_OK; d++)
+    {
+        i2c_device_config_t dev_config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = PULSE_EXP_ADDR + d, // Adresses consécutives (broches A2..A0)
+            .scl_speed_hz = PULSE_EXP_I2C_HZ,
+        };
+        ret = i2c_master_bus_add_device(bus, &dev_config, &devs[d]);
+        if (ret == ESP_OK)
+        {
+            uint8_t iocon[2] = { MCP_IOCON, MCP_IOCON_MIRROR | MCP_IOCON_ODR }; // Une seule ligne INT partagée
+            ret = i2c_master_transmit(devs[d], iocon, sizeof(iocon), MCP_I2C_TIMEOUT_MS);
+        }
+        if (ret == ESP_OK) ret = mcp_write_pair(devs[d], MCP_IODIRA, 0xFFFF);   // Toutes les broches en entrée
+        if (ret == ESP_OK) ret = mcp_write_pair(devs[d], MCP_INTCONA, 0x0000);  // Interruption sur tout changement
+        if (ret == ESP_OK) ret = mcp_write_pair(devs[d], MCP_GPINTENA, 0x0000); // Activée au démarrage du moteur
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Expandeur 0x%02x injoignable : %s", PULSE_EXP_ADDR + d, esp_err_to_name(ret));
+        }
+    }
+
+    for (int b = 0; b < 16 * PULSE_EXP_COUNT; b++)
+    {
+        bit_channel[b] = -1;                             // Aucune entrée associée
+    }
+    return ret;
+}
+
+esp_err_t pulse_expander_add(int idx, int pin)
+{
+    static esp_err_t init_ret = ESP_ERR_INVALID_STATE;  // Résultat de l'initialisation (faite au premier appel)
+    static bool initialized = false;
+
+    if (!initialized)
+    {
+        init_ret = expander_init();
+        initialized = true;
+    }
+    if (init_ret != ESP_OK)                              // Bus ou expandeur absent
+    {
+        return init_ret;
+    }
+
+    int bit = pin - PULSE_EXP_PIN_BASE;                  // Entrée dans le mot d'échantillon
+    if (!pulse_expander_pin(pin) || bit_channel[bit] >= 0) // Hors plage ou déjà utilisée
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bit_channel[bit] = idx;
+    used_mask |= 1UL << bit;
+    uint32_t period = channels[idx].debounce_us / PULSE_BULK_SAMPLES; // Période nécessaire pour cet anti-rebond
+    if (period > sample_us) sample_us = period;          // Le plus long anti-rebond l'emporte
+
+    ESP_LOGI(TAG, "Compteur %d sur l'entrée %d de l'expandeur 0x%02x", idx, bit % 16, PULSE_EXP_ADDR + bit / 16);
+    return ESP_OK;
+}
+
+/**
+ * @brief ISR de la ligne INT : réveille la tâche si aucune séquence d'anti-rebond n'est en cours.
+ *
+ * Pendant une séquence, l'interruption est ignorée : INT reste basse jusqu'à la prochaine
+ * lecture et ne produit plus de front. La tâche relit donc INT en fin de séquence.
+ */
+static void IRAM_ATTR expander_isr(void *arg)
+{
+#if LOW_POWER
+    gpio_ll_set_intr_type(&GPIO, PULSE_EXP_INT, GPIO_INTR_DISABLE); // Niveau bas maintenu jusqu'à la lecture : réarmée par la tâche
+#endif
+    if (sampling) return;                                // Les lectures périodiques suivent déjà l'entrée
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(sampler_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief Callback du timer d'échantillonnage : demande une nouvelle lecture.
+ */
+static void sample_timer_callback(void *arg)
+{
+    xTaskNotifyGive(sampler_task);
+}
+
+/**
+ * @brief Tâche d'échantillonnage : lecture des expandeurs, anti-rebond et comptage.
+ *
+ * @param pv Non utilisé
+ */
+static void expander_task(void *pv)
+{
+    uint32_t sample = 0;                                 // Dernier mot lu
+    read_inputs(&sample);                                // Niveaux de départ (et acquittement de INT)
+    pulse_bulk_init(&debounce, sample);
+#if PULSE_STATS
+    uint32_t prev = sample;                              // Lecture précédente, pour compter les fronts bruts
+#endif
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);         // Interruption ou échéance du timer
+
+        esp_err_t ret = read_inputs(&sample);            // Lecture de toutes les entrées (acquitte INT)
+#if LOW_POWER
+        gpio_set_intr_type(PULSE_EXP_INT, GPIO_INTR_LOW_LEVEL); // INT acquittée : réarmement
+#endif
+        if (ret != ESP_OK)                               // Bus perturbé : nouvel essai à la prochaine période
+        {
+            sampling = true;
+            esp_timer_start_once(sample_timer, sample_us);
+            continue;
+        }
+
+#if PULSE_STATS
+        for (uint32_t raw = sample & ~prev & used_mask; raw != 0; raw &= raw - 1) // Fronts montants bruts, rebonds compris
+        {
+            PULSE_STAT_ADD(bit_channel[__builtin_ctz(raw)], edges, 1);
+        }
+        prev = sample;
+#endif
+        uint32_t rising = pulse_bulk_step(&debounce, sample) & used_mask; // Fronts montants validés
+        int64_t edge_us = esp_timer_get_time() - (int64_t)(PULSE_BULK_SAMPLES - 1) * sample_us; // Heure approximative du front
+        while (rising != 0)
+        {
+            int bit = __builtin_ctz(rising);             // Entrée de plus faible rang
+            rising &= rising - 1;
+            pulse_count_validated(bit_channel[bit], 1, edge_us);
+        }
+
+        sampling = (pulse_bulk_unstable(&debounce, sample) & used_mask) != 0; // Entrées encore en cours de validation
+        if (sampling)
+        {
+            esp_timer_start_once(sample_timer, sample_us);
+        }
+        else if (gpio_get_level(PULSE_EXP_INT) == 0)   // Changement survenu depuis la lecture, ISR ignorée : INT restera basse
+        {
+            xTaskNotifyGive(sampler_task);               // Nouvelle lecture (acquitte INT, réarme l'interruption de niveau)
+        }
+    }
+}
+
+void pulse_expander_start(void)
+{
+    if (used_mask == 0)                                  // Aucun compteur sur les expandeurs
+    {
+        return;
+    }
+    if (sample_us < 1000) sample_us = 1000;              // Au moins une lecture I2C complète par période
+
+    for (int d = 0; d < PULSE_EXP_COUNT; d++)            // Interruptions des seules entrées utilisées
+    {
+        mcp_write_pair(devs[d], MCP_GPINTENA, (uint16_t)(used_mask >> (16 * d)));
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &sample_timer_callback,              // Relance d'une lecture
+        .arg = NULL,
+        .name = "expSample"                              // Nom debug timer
+    };
+    esp_timer_create(&timer_args, &sample_timer);
+
+    xTaskCreatePinnedToCore(expander_task, "pulse_exp", 3072, NULL, 10, &sampler_task, CORE_PULSE); // Même priorité et même cœur que le comptage
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << PULSE_EXP_INT,           // Ligne INT commune
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,                // Drain ouvert : tirage au niveau haut
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = LOW_POWER ? GPIO_INTR_LOW_LEVEL     // Seul un niveau réveille du light sleep
+                               : GPIO_INTR_NEGEDGE       // INT active à l'état bas
+    };
+    gpio_config(&io_conf);
+#if LOW_POWER
+    gpio_wakeup_enable(PULSE_EXP_INT, GPIO_INTR_LOW_LEVEL);
+#endif
+    esp_err_t ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM); // Déjà installé si des compteurs sont servis par ISR
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGE(TAG, "Service ISR indisponible : %s", esp_err_to_name(ret));
+        return;
+    }
+    gpio_isr_handler_add(PULSE_EXP_INT, expander_isr, NULL);
+
+    ESP_LOGI(TAG, "Expandeurs actifs, échantillonnage %lu us pendant l'anti-rebond", (unsigned long)sample_us);
+}
+
+#endif // PULSE_EXPANDER
@@ -0,0 +1,51 @@
+#ifndef PULSE_EXPANDER_H
+#define PULSE_EXPANDER_H
+
+/**
+ * @file pulse_expander.h
+ * @brief Moteur de comptage sur expandeurs d'entrées MCP23017 (I2C, une seule ligne INT).
+ *
+ * Au-delà des 8 unités PCNT, les compteurs peuvent être câblés sur des MCP23017 :
+ * - PULSE_EXP_COUNT expandeurs de 16 entrées partagent le bus I2C et une ligne INT en drain ouvert
+ * - Un changement sur une entrée tire la ligne INT : une seule ISR réveille la tâche d'échantillonnage
+ * - La tâche lit toutes les entrées d'un coup et applique l'anti-rebond bit à bit (pulse_bulk)
+ *   tant qu'une entrée est instable, puis se rendort jusqu'à la prochaine interruption
+ *
+ * Ce header est interne au module gpio_pulse.
+ */
+
+#include <stdbool.h>     // Pour bool
+#include "esp_err.h"     // Pour esp_err_t
+#include "config.h"      // Pour PULSE_EXPANDER, PULSE_EXP_*
+
+/**
+ * @brief Indique si un « GPIO » de la table des compteurs désigne une entrée d'expandeur.
+ *
+ * @param pin GPIO du compteur (channels[i].pin)
+ * @return true si PULSE_EXP_PIN_BASE <= pin < PULSE_EXP_PIN_BASE + 16 * PULSE_EXP_COUNT
+ */
+static inline bool pulse_expander_pin(int pin)
+{
+    return PULSE_EXPANDER && pin >= PULSE_EXP_PIN_BASE && pin < PULSE_EXP_PIN_BASE + 16 * PULSE_EXP_COUNT;
+}
+
+/**
+ * @brief Associe le compteur idx à une entrée d'expandeur.
+ *
+ * Le bus et les expandeurs sont initialisés au premier appel.
+ *
+ * @param idx Index du compteur (0..channel_count-1)
+ * @param pin GPIO du compteur (PULSE_EXP_PIN_BASE + numéro d'entrée)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si l'entrée est déjà utilisée ou hors plage,
+ *         ou l'erreur I2C si les expandeurs ne répondent pas
+ */
+esp_err_t pulse_expander_add(int idx, int pin);
+
+/**
+ * @brief Démarre la tâche d'échantillonnage et l'interruption de la ligne INT.
+ *
+ * Ne fait rien si aucun compteur n'a été associé à un expandeur.
+ */
+void pulse_expander_start(void);
+
+#endif // PULSE_EXPANDER_H
@@ -0,0 +1,153 @@
+/**
+ * @file pulse_pcnt.c
+ * @brief Comptage d'impulsions par le périphérique PCNT (Pulse Counter) de l'ESP32.
+ *
+ * Chaque compteur dispose de sa propre unité PCNT configurée pour incrémenter sur front montant.
+ * Le filtre anti-glitch matériel rejette les impulsions plus courtes que l'anti-rebond du compteur
+ * (plafonné à PCNT_GLITCH_NS par le périphérique), ce qui
+ * évite de réveiller le CPU sur les parasites des lignes S0 bruitées.
+ *
+ * Le logiciel ne fait plus que lire les accumulateurs à intervalle régulier :
+ * le driver compense le débordement du compteur 16 bits (watch point sur PCNT_HIGH_LIMIT +
+ * accum_count), et le delta depuis la lecture précédente est reporté dans les compteurs.
+ *
+ * Architecture :
+ *  GPIO → PCNT (filtre + comptage matériel) → Timer de lecture → Validation → counter_store
+ */
+
+#include "config.h"                 // Configuration globale (PULSE_BACKEND, PCNT_*)
+
+#if PULSE_BACKEND == PULSE_BACKEND_PCNT
+
+#include "driver/pulse_cnt.h"       // Driver PCNT ESP-IDF
+#include "esp_timer.h"              // Timer de lecture périodique des accumulateurs
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "pulse_pcnt.h"             // Header du moteur PCNT
+#include "pulse_backend.h"          // Point d'entrée commun des impulsions validées
+#include "pulse_stats.h"            // Statistiques du chemin de comptage (PULSE_STATS)
+
+static const char *TAG = "PULSE_PCNT"; // Identifiant de log du module
+
+/**
+ * @brief Contexte d'un compteur servi par le PCNT.
+ */
+typedef struct {
+    int idx;                        ///< Index du compteur associé
+    pcnt_unit_handle_t unit;        ///< Unité PCNT attribuée
+    int last_count;                 ///< Valeur de l'accumulateur lors de la dernière lecture
+} pcnt_ctx_t;
+
+static pcnt_ctx_t pcnt_ctx[MAX_CHANNELS];   // Contextes des compteurs servis par le PCNT
+static int pcnt_nb = 0;                    // Nombre de compteurs servis par le PCNT
+static esp_timer_handle_t poll_timer;      // Timer de lecture périodique
+
+/**
+ * @brief Lit les accumulateurs PCNT et reporte les nouvelles impulsions.
+ *
+ * Le delta est calculé en arithmétique non signée pour rester correct si
+ * l'accumulateur du driver reboucle.
+ *
+ * @param arg Non utilisé
+ */
+static void pcnt_poll_callback(void *arg)
+{
+    int64_t now = esp_timer_get_time();    // Horodatage commun de la lecture
+    for (int i = 0; i < pcnt_nb; i++)      // Parcourt les compteurs servis par le PCNT
+    {
+        int count = 0;                     // Valeur courante de l'accumulateur
+        if (pcnt_unit_get_count(pcnt_ctx[i].unit, &count) != ESP_OK) // Lecture accumulateur (matériel + débordements)
+        {
+            continue;                      // Lecture impossible : on réessaiera au prochain tick
+        }
+
+        uint32_t delta = (uint32_t)count - (uint32_t)pcnt_ctx[i].last_count; // Impulsions depuis la dernière lecture
+        pcnt_ctx[i].last_count = count;    // Mémorise la valeur lue
+
+        if (delta != 0)                    // Nouvelles impulsions validées par le matériel
+        {
+            PULSE_STAT_ADD(pcnt_ctx[i].idx, edges, delta); // Les rebonds filtrés par le matériel ne sont pas visibles
+            pulse_count_validated(pcnt_ctx[i].idx, delta, now);
+        }
+    }
+}
+
+/**
+ * @brief Attribue une unité PCNT au compteur idx.
+ *
+ * Configure l'unité (limites, accumulation), le filtre anti-glitch (s'il est demandé) et un canal
+ * comptant les fronts montants du GPIO. En cas d'échec, les ressources déjà
+ * allouées sont libérées et l'erreur est retournée.
+ */
+esp_err_t pulse_pcnt_add(int idx, gpio_num_t gpio, uint32_t glitch_ns)
+{
+    pcnt_unit_config_t unit_config = {
+        .low_limit = -1,                   // Le driver impose une limite basse négative (jamais atteinte : on ne décompte pas)
+        .high_limit = PCNT_HIGH_LIMIT,     // Limite haute du compteur matériel
+        .flags.accum_count = 1,            // Le driver accumule la valeur à chaque débordement
+    };
+    pcnt_unit_handle_t unit = NULL;        // Handle de l'unité allouée
+    pcnt_channel_handle_t chan = NULL;     // Handle du canal alloué
+
+    esp_err_t ret = pcnt_new_unit(&unit_config, &unit); // Alloue une unité PCNT libre
+    if (ret != ESP_OK)                     // Plus d'unité disponible (8 sur ESP32)
+    {
+        ESP_LOGW(TAG, "Pas d'unité PCNT pour le compteur %d (GPIO %d) : %s", idx, gpio, esp_err_to_name(ret));
+        return ret;
+    }
+
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = glitch_ns,        // Impulsions plus courtes ignorées par le matériel
+    };
+    pcnt_chan_config_t chan_config = {
+        .edge_gpio_num = gpio,             // Le GPIO compteur pilote les fronts
+        .level_gpio_num = -1,              // Pas de signal de contrôle
+    };
+
+    if (glitch_ns > 0) ret = pcnt_unit_set_glitch_filter(unit, &filter_config); // Active le filtre anti-glitch
+    if (ret == ESP_OK) ret = pcnt_new_channel(unit, &chan_config, &chan); // Crée le canal sur le GPIO
+    if (ret == ESP_OK) ret = pcnt_channel_set_edge_action(chan,
+                                                          PCNT_CHANNEL_EDGE_ACTION_INCREASE, // Front montant : +1
+                                                          PCNT_CHANNEL_EDGE_ACTION_HOLD);    // Front descendant : ignoré
+    if (ret == ESP_OK) ret = pcnt_unit_add_watch_point(unit, PCNT_HIGH_LIMIT); // Nécessaire à la compensation du débordement
+    if (ret == ESP_OK) ret = pcnt_unit_enable(unit);       // Active l'unité
+    if (ret == ESP_OK) ret = pcnt_unit_clear_count(unit);  // Remet le compteur matériel à zéro
+    if (ret == ESP_OK) ret = pcnt_unit_start(unit);        // Démarre le comptage
+
+    if (ret != ESP_OK)                     // Échec de configuration : libère l'unité pour le repli ISR
+    {
+        ESP_LOGW(TAG, "Configuration PCNT impossible pour le compteur %d (GPIO %d) : %s", idx, gpio, esp_err_to_name(ret));
+        if (chan) pcnt_del_channel(chan);  // Libère le canal s'il a été créé
+        pcnt_del_unit(unit);               // Libère l'unité
+        return ret;
+    }
+
+    pcnt_ctx[pcnt_nb].idx = idx;           // Associe l'index compteur
+    pcnt_ctx[pcnt_nb].unit = unit;         // Associe l'unité PCNT
+    pcnt_ctx[pcnt_nb].last_count = 0;      // Accumulateur remis à zéro
+    pcnt_nb++;                             // Un compteur de plus servi par le PCNT
+
+    ESP_LOGI(TAG, "Compteur %d (GPIO %d) servi par le PCNT", idx, gpio);
+    return ESP_OK;
+}
+
+/**
+ * @brief Démarre le timer de lecture périodique des accumulateurs PCNT.
+ */
+void pulse_pcnt_start(void)
+{
+    if (pcnt_nb == 0)                      // Aucun compteur servi par le PCNT
+    {
+        return;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &pcnt_poll_callback,   // Lecture des accumulateurs
+        .arg = NULL,                       // Pas d'argument
+        .name = "pcntPoll"                 // Nom debug timer
+    };
+
+    esp_timer_create(&timer_args, &poll_timer); // Création timer
+    esp_timer_start_periodic(poll_timer, PCNT_POLL_PERIOD_MS * 1000ULL); // Lecture toutes les PCNT_POLL_PERIOD_MS
+}
+
+#endif // PULSE_BACKEND == PULSE_BACKEND_PCNT
@@ -0,0 +1,39 @@
+#ifndef PULSE_PCNT_H
+#define PULSE_PCNT_H
+
+/**
+ * @file pulse_pcnt.h
+ * @brief Moteur de comptage basé sur le périphérique PCNT de l'ESP32.
+ *
+ * Chaque compteur est servi par une unité PCNT (un canal par unité) :
+ * - Le filtre anti-glitch matériel élimine les parasites courts sans réveiller le CPU
+ * - Le matériel compte les fronts montants, le driver gère le débordement (accum_count)
+ * - Un timer périodique lit les accumulateurs et reporte les deltas dans les compteurs
+ *
+ * Ce header est interne au module gpio_pulse.
+ */
+
+#include <stdint.h>      // Pour uint32_t
+#include "esp_err.h"     // Pour esp_err_t
+#include "driver/gpio.h" // Pour gpio_num_t
+
+/**
+ * @brief Attribue une unité PCNT au compteur idx sur le GPIO indiqué.
+ *
+ * @param idx  Index du compteur (0..channel_count-1)
+ * @param gpio      GPIO d'entrée des impulsions
+ * @param glitch_ns Durée du filtre anti-glitch (ns, au plus PCNT_GLITCH_NS ; 0 = sans filtre)
+ * @return ESP_OK si le compteur est servi par le PCNT,
+ *         sinon un code d'erreur (plus d'unité libre, GPIO non supporté...) :
+ *         l'appelant doit alors se replier sur le moteur ISR pour cette pin.
+ */
+esp_err_t pulse_pcnt_add(int idx, gpio_num_t gpio, uint32_t glitch_ns);
+
+/**
+ * @brief Démarre la lecture périodique des accumulateurs PCNT.
+ *
+ * Ne fait rien si aucun compteur n'a été attribué au PCNT.
+ */
+void pulse_pcnt_start(void);
+
+#endif // PULSE_PCNT_H
@@ -0,0 +1,218 @@
+/**
+ * @file pulse_sampler.c
+ * @brief Échantillonnage des registres GPIO par gptimer et anti-rebond bit à bit de toutes les pins.
+ *
+ * À chaque alarme du gptimer, l'ISR lit GPIO_IN_REG (GPIO 0 à 31) et GPIO_IN1_REG (GPIO 32 à 39)
+ * et passe chaque mot à un compteur vertical (pulse_bulk) : un changement est validé après
+ * PULSE_BULK_SAMPLES échantillons identiques. Les fronts montants des pins utilisées
+ * incrémentent un compteur d'impulsions en attente par compteur, et une tâche unique les
+ * reporte (pulse_count_validated) hors interruption.
+ *
+ * La période vaut le plus long anti-rebond des compteurs échantillonnés divisé par
+ * PULSE_BULK_SAMPLES (5 ms pour 20 ms, soit 200 Hz ; 1 kHz pour 4 ms), au moins
+ * PULSE_SAMPLER_MIN_PERIOD_US.
+ *
+ * L'ISR ne touche que la RAM interne et des fonctions en IRAM ; avec
+ * CONFIG_GPTIMER_ISR_IRAM_SAFE, elle continue pendant les écritures flash.
+ *
+ * Architecture :
+ *  GPIO → gptimer (lecture des registres) → pulse_bulk → Impulsions en attente → Tâche de report → counter_store
+ */
+
+#include "config.h"                 // Configuration globale (PULSE_BACKEND, PULSE_SAMPLER_*)
+
+#if PULSE_BACKEND == PULSE_BACKEND_SAMPLER
+
+#include <stdatomic.h>              // Opérations atomiques C11
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche de report et notifications
+#include "driver/gptimer.h"         // Timer matériel d'échantillonnage
+#include "soc/gpio_reg.h"           // GPIO_IN_REG, GPIO_IN1_REG
+#include "soc/soc.h"                // REG_READ
+#include "esp_timer.h"              // Horodatage des impulsions
+#include "esp_attr.h"               // Attribut IRAM_ATTR pour l'ISR
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "pulse_sampler.h"          // Header du module
+#include "pulse_bulk.h"             // Anti-rebond bit à bit
+#include "pulse_backend.h"          // Point d'entrée commun des impulsions validées
+#include "pulse_stats.h"            // Statistiques du chemin de comptage (PULSE_STATS)
+
+#define SAMPLER_NB_PINS 40          // GPIO 0 à 39 de l'ESP32
+
+static const char *TAG = "PULSE_SAMPLER"; // Identifiant de log du module
+
+static int8_t pin_channel[SAMPLER_NB_PINS];            // Compteur associé à chaque pin (-1 = aucune)
+static bool pin_map_ready = false;                     // pin_channel initialisé
+static uint32_t mask_lo, mask_hi;                      // Pins échantillonnées (GPIO 0-31, GPIO 32-39)
+static uint32_t period_us;                             // Période d'échantillonnage
+static pulse_bulk_t db_lo, db_hi;                      // Anti-rebond des deux registres d'entrée
+static _Atomic uint32_t pending[MAX_CHANNELS];         // Impulsions validées en attente de report
+static _Atomic uint32_t pending_mask;                  // Compteurs ayant des impulsions en attente
+static TaskHandle_t report_task;                       // Tâche de report
+#if PULSE_STATS
+static uint32_t raw_lo, raw_hi;                        // Échantillon précédent, pour compter les fronts bruts
+#endif
+
+_Static_assert(MAX_CHANNELS <= 32, "Les compteurs en attente de report doivent tenir dans un masque de 32 bits");
+
+esp_err_t pulse_sampler_add(int idx, gpio_num_t gpio)
+{
+    if (!pin_map_ready)                                // Premier compteur : table des pins vide
+    {
+        for (int p = 0; p < SAMPLER_NB_PINS; p++) pin_channel[p] = -1;
+        pin_map_ready = true;
+    }
+    if (gpio < 0 || gpio >= SAMPLER_NB_PINS || pin_channel[gpio] >= 0) // Pin hors registre ou déjà échantillonnée
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << gpio,                  // Pin du compteur
+        .mode = GPIO_MODE_INPUT,                       // Entrée
+        .pull_up_en = GPIO_PULLUP_DISABLE,             // Même câblage que le moteur ISR : pas de pull interne
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE                 // Aucune interruption : lecture périodique
+    };
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret != ESP_OK) return ret;
+
+    pin_channel[gpio] = idx;
+    if (gpio < 32) mask_lo |= 1UL << gpio;
+    else           mask_hi |= 1UL << (gpio - 32);
+
+    uint32_t period = channels[idx].debounce_us / PULSE_BULK_SAMPLES; // Période nécessaire pour cet anti-rebond
+    if (period > period_us) period_us = period;        // Le plus long anti-rebond l'emporte
+    return ESP_OK;
+}
+
+/**
+ * @brief Note les fronts validés d'un registre dans les impulsions en attente.
+ *
+ * @param rising Fronts montants validés (bit b = pin base + b)
+ * @param base   Numéro de la première pin du registre
+ * @return Masque des compteurs concernés
+ */
+static inline uint32_t IRAM_ATTR note_edges(uint32_t rising, int base)
+{
+    uint32_t chans = 0;
+    while (rising != 0)
+    {
+        int c = pin_channel[base + __builtin_ctz(rising)]; // Compteur de la pin de plus faible rang
+        rising &= rising - 1;
+        atomic_fetch_add_explicit(&pending[c], 1, memory_order_relaxed);
+        chans |= 1UL << c;
+    }
+    return chans;
+}
+
+/**
+ * @brief ISR du gptimer : un échantillon de toutes les pins.
+ *
+ * @return true si la tâche de report a été réveillée et doit être ordonnancée
+ */
+static bool IRAM_ATTR sampler_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *ctx)
+{
+    uint32_t in_lo = REG_READ(GPIO_IN_REG);            // GPIO 0 à 31
+    uint32_t in_hi = REG_READ(GPIO_IN1_REG) & 0xFF;    // GPIO 32 à 39
+#if PULSE_STATS
+    for (uint32_t raw = in_lo & ~raw_lo & mask_lo; raw != 0; raw &= raw - 1) // Fronts montants bruts, rebonds compris
+    {
+        PULSE_STAT_ADD(pin_channel[__builtin_ctz(raw)], edges, 1);
+    }
+    for (uint32_t raw = in_hi & ~raw_hi & mask_hi; raw != 0; raw &= raw - 1)
+    {
+        PULSE_STAT_ADD(pin_channel[32 + __builtin_ctz(raw)], edges, 1);
+    }
+    raw_lo = in_lo;
+    raw_hi = in_hi;
+#endif
+    uint32_t r_lo = pulse_bulk_step(&db_lo, in_lo) & mask_lo;
+    uint32_t r_hi = pulse_bulk_step(&db_hi, in_hi) & mask_hi;
+    if ((r_lo | r_hi) == 0)                            // Cas courant : aucun front validé
+    {
+        return false;
+    }
+
+    uint32_t chans = note_edges(r_lo, 0) | note_edges(r_hi, 32);
+    atomic_fetch_or_explicit(&pending_mask, chans, memory_order_release); // Publie les compteurs concernés
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(report_task, &woken);
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief Tâche de report : transmet les impulsions en attente au point d'entrée commun.
+ *
+ * @param pv Non utilisé
+ */
+static void report_task_fn(void *pv)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);       // Réveil par l'ISR
+
+        uint32_t chans = atomic_exchange_explicit(&pending_mask, 0, memory_order_acquire);
+        int64_t edge_us = esp_timer_get_time() - (int64_t)(PULSE_BULK_SAMPLES - 1) * period_us; // Heure approximative du front
+        while (chans != 0)
+        {
+            int c = __builtin_ctz(chans);
+            chans &= chans - 1;
+            uint32_t n = atomic_exchange_explicit(&pending[c], 0, memory_order_relaxed); // Impulsions depuis le dernier report
+            if (n != 0)
+            {
+                pulse_count_validated(c, n, edge_us);
+            }
+        }
+    }
+}
+
+esp_err_t pulse_sampler_start(void)
+{
+    if ((mask_lo | mask_hi) == 0)                      // Aucun compteur échantillonné
+    {
+        return ESP_OK;
+    }
+    if (period_us < PULSE_SAMPLER_MIN_PERIOD_US) period_us = PULSE_SAMPLER_MIN_PERIOD_US;
+
+    pulse_bulk_init(&db_lo, REG_READ(GPIO_IN_REG));    // Niveaux de départ : aucun front au démarrage
+    pulse_bulk_init(&db_hi, REG_READ(GPIO_IN1_REG) & 0xFF);
+#if PULSE_STATS
+    raw_lo = db_lo.state;
+    raw_hi = db_hi.state;
+#endif
+
+    xTaskCreatePinnedToCore(report_task_fn, "pulse_sampler", 3072, NULL, 10, &report_task, CORE_PULSE); // Même priorité et même cœur que le comptage
+
+    gptimer_handle_t timer = NULL;
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,                      // 1 tick = 1 µs
+    };
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = sampler_isr,                       // Un échantillon par alarme
+    };
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = period_us,                      // Période d'échantillonnage
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = 1,               // Alarme périodique
+    };
+
+    esp_err_t ret = gptimer_new_timer(&timer_config, &timer);
+    if (ret == ESP_OK) ret = gptimer_register_event_callbacks(timer, &cbs, NULL);
+    if (ret == ESP_OK) ret = gptimer_set_alarm_action(timer, &alarm_config);
+    if (ret == ESP_OK) ret = gptimer_enable(timer);
+    if (ret == ESP_OK) ret = gptimer_start(timer);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "gptimer indisponible : %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Échantillonnage toutes les %lu us", (unsigned long)period_us);
+    return ESP_OK;
+}
+
+#endif // PULSE_BACKEND == PULSE_BACKEND_SAMPLER
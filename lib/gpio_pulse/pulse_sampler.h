@@ -0,0 +1,40 @@
+#ifndef PULSE_SAMPLER_H
+#define PULSE_SAMPLER_H
+
+/**
+ * @file pulse_sampler.h
+ * @brief Moteur de comptage par échantillonnage périodique des registres d'entrée GPIO.
+ *
+ * Un seul gptimer lit les registres GPIO_IN / GPIO_IN1 à intervalle fixe et applique
+ * l'anti-rebond bit à bit (pulse_bulk) à toutes les pins en une passe :
+ * - Coût constant par échantillon, quel que soit le nombre de compteurs ou la fréquence des impulsions
+ * - Aucune interruption par front, aucun timer par compteur
+ * - Les fronts validés sont reportés par une tâche unique, réveillée seulement s'il y en a
+ *
+ * Ce header est interne au module gpio_pulse.
+ */
+
+#include "esp_err.h"     // Pour esp_err_t
+#include "driver/gpio.h" // Pour gpio_num_t
+
+/**
+ * @brief Ajoute le compteur idx à l'échantillonneur.
+ *
+ * Configure la pin en entrée (sans interruption) ; la période d'échantillonnage
+ * suit le plus long anti-rebond des compteurs ajoutés.
+ *
+ * @param idx  Index du compteur (0..channel_count-1)
+ * @param gpio GPIO d'entrée des impulsions
+ * @return ESP_OK, ESP_ERR_INVALID_ARG si la pin est déjà utilisée par un autre compteur
+ */
+esp_err_t pulse_sampler_add(int idx, gpio_num_t gpio);
+
+/**
+ * @brief Démarre le gptimer d'échantillonnage et la tâche de report des impulsions.
+ *
+ * @return ESP_OK (ou si aucun compteur n'a été ajouté), sinon l'erreur du gptimer :
+ *         l'appelant doit alors se replier sur le moteur ISR pour ces compteurs.
+ */
+esp_err_t pulse_sampler_start(void);
+
+#endif // PULSE_SAMPLER_H
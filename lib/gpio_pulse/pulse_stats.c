@@ -0,0 +1,61 @@
+/**
+ * @file pulse_stats.c
+ * @brief Rapport JSON des statistiques du chemin de comptage.
+ *
+ * Les compteurs sont incrémentés par les moteurs (macros PULSE_STAT_*) ; ce module
+ * ne fait que les définir et les mettre en forme à la demande.
+ */
+
+#include <stdio.h>                  // snprintf
+#include <stdbool.h>                // Rapport tronqué
+#include "pulse_stats.h"            // Header du module
+
+#if PULSE_STATS
+pulse_stats_t pulse_stats[MAX_CHANNELS]; // Statistiques par compteur
+#endif
+
+size_t pulse_stats_json(char *buf, size_t len)
+{
+    if (len == 0) return 0;
+
+#if PULSE_STATS
+    static const char tail_cut[] = "],\"truncated\":true}"; // Fin d'un rapport tronqué, toujours réservée
+    size_t n = snprintf(buf, len, "{\"enabled\":true,\"c\":[");
+    bool cut = false;
+    for (int i = 0; i < channel_count; i++)
+    {
+        uint32_t edges = atomic_load_explicit(&pulse_stats[i].edges, memory_order_relaxed);
+        uint32_t ok = atomic_load_explicit(&pulse_stats[i].accepted, memory_order_relaxed);
+        uint32_t drop = atomic_load_explicit(&pulse_stats[i].dropped, memory_order_relaxed);
+        uint32_t width = atomic_load_explicit(&pulse_stats[i].width, memory_order_relaxed);
+        uint32_t rate = atomic_load_explicit(&pulse_stats[i].rate, memory_order_relaxed);
+        uint32_t lat = atomic_load_explicit(&pulse_stats[i].max_latency_us, memory_order_relaxed);
+        uint32_t judged = ok + drop + width + rate;   // Impulsions comptées, perdues ou rejetées
+        uint32_t glitch = (edges > judged) ? edges - judged : 0; // Autres fronts : rebonds
+
+        size_t room = (n + sizeof(tail_cut) < len) ? len - n - sizeof(tail_cut) : 0; // Place hors fin de rapport tronqué
+        if (room == 0)
+        {
+            cut = true;
+            break;
+        }
+        size_t e = snprintf(buf + n, room,
+                            "%s{\"name\":\"%s\",\"edges\":%lu,\"ok\":%lu,\"glitch\":%lu,\"drop\":%lu,"
+                            "\"width\":%lu,\"rate\":%lu,\"lat_max_us\":%lu}",
+                            (i > 0) ? "," : "", channels[i].name,
+                            (unsigned long)edges, (unsigned long)ok, (unsigned long)glitch,
+                            (unsigned long)drop, (unsigned long)width, (unsigned long)rate, (unsigned long)lat);
+        if (e >= room)                               // Entrée incomplète : retirée, le rapport reste du JSON valide
+        {
+            cut = true;
+            break;
+        }
+        n += e;
+    }
+    if (n + sizeof(tail_cut) <= len) n += snprintf(buf + n, len - n, "%s", cut ? tail_cut : "]}");
+#else
+    size_t n = snprintf(buf, len, "{\"enabled\":false}");
+#endif
+
+    return (n < len) ? n : len - 1;                // Buffer trop petit pour l'en-tête et la fin de rapport : coupé
+}
@@ -0,0 +1,90 @@
+#ifndef PULSE_STATS_H
+#define PULSE_STATS_H
+
+/**
+ * @file pulse_stats.h
+ * @brief Statistiques du chemin de comptage, activées à la compilation (PULSE_STATS).
+ *
+ * Pour chaque compteur, les moteurs alimentent quelques compteurs atomiques, sans log ni verrou :
+ * - edges    : fronts montants bruts observés (ISR, échantillon, lecture d'expandeur, PCNT)
+ * - accepted : impulsions validées et comptabilisées
+ * - dropped  : fronts perdus faute de pouvoir lancer leur validation (timer indisponible)
+ * - width    : PULSE_VALIDATE_WIDTH, impulsions rejetées pour leur largeur (trop courte ou trop longue)
+ * - rate     : PULSE_VALIDATE_WIDTH, impulsions rejetées pour leur cadence (écart trop court, puissance impossible)
+ * - max_latency_us : délai maximal entre le front et sa prise en compte (anti-rebond compris)
+ *
+ * Les rebonds rejetés se déduisent : edges - accepted - dropped - width - rate.
+ *
+ * Avec PULSE_STATS à 0, les macros PULSE_STAT_* ne génèrent aucun code et le rapport
+ * se réduit à {"enabled":false}.
+ *
+ * Le rapport est publié à la demande sur energie/<DEVICE_NAME>/stats (message sur
+ * energie/<DEVICE_NAME>/stats/get) et servi par la page de configuration sur /stats.
+ */
+
+#include <stddef.h>     // Pour size_t
+#include <stdint.h>     // Pour uint32_t
+#include "config.h"     // Pour PULSE_STATS, MAX_CHANNELS
+
+#if PULSE_STATS
+
+#include <stdatomic.h>  // Compteurs atomiques C11
+
+/**
+ * @brief Statistiques d'un compteur.
+ */
+typedef struct {
+    _Atomic uint32_t edges;          ///< Fronts montants bruts observés
+    _Atomic uint32_t accepted;       ///< Impulsions validées
+    _Atomic uint32_t dropped;        ///< Fronts perdus
+    _Atomic uint32_t width;          ///< Impulsions de largeur rejetée (PULSE_VALIDATE_WIDTH)
+    _Atomic uint32_t rate;           ///< Impulsions de cadence rejetée (PULSE_VALIDATE_WIDTH)
+    _Atomic uint32_t max_latency_us; ///< Délai max front → validation (µs)
+} pulse_stats_t;
+
+extern pulse_stats_t pulse_stats[MAX_CHANNELS]; // Statistiques par compteur
+
+#define PULSE_STAT_ADD(idx, field, n) \
+    atomic_fetch_add_explicit(&pulse_stats[(idx)].field, (n), memory_order_relaxed)
+
+/**
+ * @brief Retient le plus grand délai front → validation du compteur idx.
+ *
+ * Toujours développée sur place : appelée depuis les ISR en IRAM, une copie en flash
+ * planterait pendant une écriture flash (cache désactivé).
+ *
+ * @param idx Index du compteur
+ * @param us  Délai mesuré (µs)
+ */
+static inline __attribute__((always_inline)) void pulse_stats_latency(int idx, uint32_t us)
+{
+    uint32_t cur = atomic_load_explicit(&pulse_stats[idx].max_latency_us, memory_order_relaxed);
+    while (us > cur && !atomic_compare_exchange_weak_explicit(&pulse_stats[idx].max_latency_us, &cur, us,
+                                                              memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+#define PULSE_STAT_LATENCY(idx, us) pulse_stats_latency((idx), (us))
+
+#else
+
+#define PULSE_STAT_ADD(idx, field, n) ((void)0)
+#define PULSE_STAT_LATENCY(idx, us)   ((void)0)
+
+#endif // PULSE_STATS
+
+/**
+ * @brief Écrit le rapport JSON des statistiques des compteurs actifs.
+ *
+ * Format : {"enabled":true,"c":[{"name":"...","edges":N,"ok":N,"glitch":N,"drop":N,"width":N,"rate":N,"lat_max_us":N},...]}
+ * Si le buffer ne contient pas tous les compteurs, seules les entrées complètes sont écrites et le
+ * rapport se termine par ],"truncated":true} : il reste du JSON valide.
+ *
+ * @param buf Buffer de sortie (PULSE_STATS_JSON_MAX octets suffisent pour tous les compteurs)
+ * @param len Taille du buffer
+ * @return Longueur écrite (sans le zéro final), tronquée à len - 1
+ */
+size_t pulse_stats_json(char *buf, size_t len);
+
+#endif // PULSE_STATS_H
@@ -0,0 +1,510 @@
+/**
+ * @file history.c
+ * @brief Relevés des compteurs aux bornes des intervalles, journal "history" et requêtes de plage.
+ *
+ * Le journal contient des relevés (heure de la borne, valeurs brutes des compteurs), pas des
+ * écarts : un intervalle est la différence entre un relevé et le précédent. Après un redémarrage,
+ * le premier relevé se compare au dernier écrit avant la coupure et l'intervalle couvre la coupure.
+ * Seuls les 32 bits de poids faible des compteurs sont relevés : un intervalle reste exact tant
+ * qu'il compte moins de 2^32 impulsions.
+ *
+ * Un recalage (history_adjust_counter) ajoute un relevé marqué HISTORY_FLAG_REBASE, à la même
+ * heure que le dernier relevé et avec la base du compteur décalée de l'écart : il remplace la base
+ * sans produire d'intervalle. Les relevés de la dernière heure en RAM sont décalés de la même façon.
+ *
+ * La taille des slots est la plus petite puissance de 2 contenant un relevé des channel_count
+ * compteurs actifs (64 octets pour 5 compteurs, environ 2900 relevés soit un mois de 15 min) ;
+ * comme pour l'outbox, une autre taille efface le journal.
+ */
+
+#include "config.h"                 // HISTORY_*, table des compteurs
+#include "history.h"                // Header du module
+#include "counter_store.h"          // Relevé et recalage des compteurs
+
+#if HISTORY_ENABLE
+
+#include <stdio.h>                  // snprintf
+#include <stdlib.h>                 // malloc
+#include <string.h>                 // memcpy, memset
+#include <stdbool.h>                // bool
+#include <stddef.h>                 // offsetof
+#include <time.h>                   // Heure Unix
+#include <sys/time.h>               // gettimeofday : attente de la minute ronde
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche des relevés
+#include "freertos/semphr.h"        // Mutex du journal et des relevés en RAM
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "nvs.h"                    // Taille des slots du journal
+#include "esp_partition.h"          // Effacement du journal au changement de format
+#include "journal.h"                // Journal circulaire en flash
+#include "mqtt.h"                   // Publication des intervalles clos
+
+#define HISTORY_VALID_TIME      1600000000 // En dessous, l'horloge n'a pas été mise à l'heure
+#define HISTORY_JOURNAL_HDR_SIZE 12        // En-tête d'un enregistrement du journal
+#define HISTORY_FLAG_REBASE     0x01       // Nouvelle base après un recalage, pas d'intervalle
+#define HISTORY_SAMPLE_MARGIN_MS 20        // Réveil juste après la minute ronde
+
+static const char *TAG = "HISTORY";        // Identifiant de log du module
+
+/**
+ * @brief Relevé tel qu'écrit dans le journal "history".
+ */
+typedef struct {
+    uint32_t ts;                    ///< Heure Unix de la borne
+    uint8_t count;                  ///< Nombre de compteurs du relevé
+    uint8_t flags;                  ///< HISTORY_FLAG_*
+    uint16_t reserved;              ///< Alignement
+    uint32_t values[MAX_CHANNELS];  ///< Valeurs des compteurs (seules les count premières sont écrites)
+} history_record_t;
+
+/**
+ * @brief Parcours des intervalles du journal, du plus ancien au plus récent.
+ */
+typedef struct {
+    uint32_t slot;                  ///< Curseur de lecture dans le journal
+    uint32_t next_seq;              ///< Prochaine séquence à lire
+    bool have_prev;                 ///< prev contient un relevé
+    history_record_t prev;          ///< Base de l'intervalle suivant
+} history_reader_t;
+
+/**
+ * @brief Réponse JSON en cours d'écriture.
+ */
+typedef struct {
+    char *buf;                      ///< Buffer de sortie
+    size_t size;                    ///< Taille du buffer
+    size_t len;                     ///< Longueur écrite
+    uint32_t rows;                  ///< Lignes écrites
+    uint32_t next;                  ///< Début de la première ligne non rendue (0 = aucune)
+} history_writer_t;
+
+static journal_t hist_journal;             // Relevés de 15 min
+static SemaphoreHandle_t hist_mutex;       // Sérialise relevés, recalages et requêtes
+static history_record_t last;              // Dernier relevé du journal (base de l'intervalle en cours, ts = 0 si aucun)
+static uint32_t hour_start;                // Début de l'heure en cours (0 = aucun relevé)
+static uint32_t hour_acc[MAX_CHANNELS];    // Impulsions des intervalles clos de l'heure en cours
+static uint32_t min_ts[HISTORY_MINUTES];   // Relevés de la dernière heure, en anneau
+static uint32_t *min_val;                  // HISTORY_MINUTES × channel_count valeurs
+static uint32_t min_head;                  // Relevés de 1 min écrits depuis le démarrage
+static char range_json[HISTORY_JSON_MAX];  // Réponse aux requêtes MQTT, hors pile
+
+/**
+ * @brief Taille d'un relevé de count compteurs, tel qu'écrit dans le journal.
+ */
+static size_t record_len(uint32_t count)
+{
+    return offsetof(history_record_t, values) + count * sizeof(uint32_t);
+}
+
+/**
+ * @brief Plus petite taille de slot (puissance de 2) contenant un relevé des compteurs actifs.
+ */
+static uint32_t slot_size_for_channels(void)
+{
+    uint32_t need = HISTORY_JOURNAL_HDR_SIZE + record_len(channel_count);
+    uint32_t size = 32;
+    while (size < need) size <<= 1;
+    return size;
+}
+
+/**
+ * @brief Lit l'intervalle suivant du journal.
+ *
+ * @param delta Impulsions de chaque compteur sur l'intervalle (sortie, MAX_CHANNELS valeurs)
+ * @return false une fois le relevé le plus récent dépassé
+ */
+static bool read_interval(history_reader_t *r, uint32_t *start, uint32_t *dur, uint32_t delta[MAX_CHANNELS])
+{
+    history_record_t rec;
+    while (1)
+    {
+        size_t len = sizeof(rec);
+        uint32_t seq;
+        if (journal_read_next(&hist_journal, &r->slot, r->next_seq, &rec, &len, &seq) != ESP_OK) return false;
+        r->next_seq = seq + 1;
+        if (rec.count > MAX_CHANNELS || len != record_len(rec.count)) continue; // Format inattendu : relevé ignoré
+
+        bool interval = r->have_prev && !(rec.flags & HISTORY_FLAG_REBASE) && rec.ts > r->prev.ts;
+        if (interval)
+        {
+            uint32_t n = rec.count < r->prev.count ? rec.count : r->prev.count;
+            memset(delta, 0, MAX_CHANNELS * sizeof(delta[0]));
+            for (uint32_t i = 0; i < n; i++) delta[i] = rec.values[i] - r->prev.values[i]; // Exact modulo 2^32
+            *start = r->prev.ts;
+            *dur = rec.ts - r->prev.ts;
+        }
+        r->prev = rec;
+        r->have_prev = true;
+        if (interval) return true;
+    }
+}
+
+/**
+ * @brief Premier parcours du journal : dernier relevé et cumul de l'heure en cours.
+ */
+static void load_state(void)
+{
+    history_reader_t r = { .slot = hist_journal.next_slot, .next_seq = 1 }; // Les slots suivant le plus récent sont les plus anciens
+    uint32_t start, dur, delta[MAX_CHANNELS];
+
+    while (read_interval(&r, &start, &dur, delta))
+    {
+        if (hour_start == 0) hour_start = start;
+        for (int i = 0; i < MAX_CHANNELS; i++) hour_acc[i] += delta[i];
+        if ((start + dur) % 3600 == 0)     // Heure close par ce relevé
+        {
+            hour_start = start + dur;
+            memset(hour_acc, 0, sizeof(hour_acc));
+        }
+    }
+    if (r.have_prev)
+    {
+        last = r.prev;
+        if (hour_start == 0) hour_start = last.ts; // Un seul relevé
+    }
+}
+
+/**
+ * @brief Ajoute un relevé de base décalée (recalage) : fin de l'intervalle sans impulsion.
+ */
+static void write_rebase(void)
+{
+    history_record_t rec = last;
+    rec.flags = HISTORY_FLAG_REBASE;
+    esp_err_t ret = journal_append(&hist_journal, &rec, record_len(rec.count));
+    if (ret != ESP_OK) ESP_LOGE(TAG, "Nouvelle base non enregistrée : %s", esp_err_to_name(ret));
+}
+
+/**
+ * @brief Copie les 32 bits de poids faible des compteurs.
+ *
+ * Les intervalles sont des écarts entre relevés : modulo 2^32, ils restent exacts.
+ */
+static void snapshot_low(uint32_t values[MAX_CHANNELS])
+{
+    uint64_t full[MAX_CHANNELS];
+    counter_store_snapshot(full);
+    for (int i = 0; i < channel_count; i++) values[i] = (uint32_t)full[i];
+}
+
+/**
+ * @brief Publie un intervalle clos sur HISTORY_TOPIC.
+ *
+ * @param res_min Résolution nominale en minutes
+ */
+static void publish_interval(uint32_t start, uint32_t dur, uint32_t res_min, const uint32_t delta[MAX_CHANNELS])
+{
+    char payload[64 + MAX_CHANNELS * 32];  // En-tête + "wh" et "n" de chaque compteur
+    int len = snprintf(payload, sizeof(payload), "{\"ts\":%lu,\"dur\":%lu,\"res\":%lu,\"wh\":[",
+                       (unsigned long)start, (unsigned long)dur, (unsigned long)res_min);
+    for (int i = 0; i < channel_count; i++)
+    {
+        uint64_t mwh = counter_store_mwh(i, delta[i]);
+        len += snprintf(payload + len, sizeof(payload) - len, "%s%llu.%03u", i ? "," : "",
+                        (unsigned long long)(mwh / 1000), (unsigned)(mwh % 1000));
+    }
+    len += snprintf(payload + len, sizeof(payload) - len, "],\"n\":[");
+    for (int i = 0; i < channel_count; i++)
+    {
+        len += snprintf(payload + len, sizeof(payload) - len, "%s%lu", i ? "," : "", (unsigned long)delta[i]);
+    }
+    snprintf(payload + len, sizeof(payload) - len, "]}");
+    mqtt_publish(HISTORY_TOPIC, payload); // QoS 1
+}
+
+/**
+ * @brief Relève les compteurs à la minute ronde boundary.
+ *
+ * Aux bornes de HISTORY_PERIOD_S, le relevé est écrit dans le journal et l'intervalle de
+ * 15 min clos (puis l'heure close, aux heures rondes) est publié si le broker est joignable.
+ */
+static void sample(uint32_t boundary)
+{
+    uint32_t values[MAX_CHANNELS];
+    uint32_t q_start = 0, q_dur = 0, q_delta[MAX_CHANNELS];  // Intervalle de 15 min clos
+    uint32_t h_start = 0, h_dur = 0, h_delta[MAX_CHANNELS];  // Heure close
+
+    xSemaphoreTake(hist_mutex, portMAX_DELAY);
+    snapshot_low(values);                  // Sous le mutex : aucun recalage entre relevé et base
+    if (min_head > 0 && boundary <= min_ts[(min_head - 1) % HISTORY_MINUTES]) // Horloge reculée
+    {
+        xSemaphoreGive(hist_mutex);
+        return;
+    }
+    uint32_t k = min_head % HISTORY_MINUTES;
+    min_ts[k] = boundary;
+    if (min_val) memcpy(&min_val[k * channel_count], values, channel_count * sizeof(values[0]));
+    min_head++;
+
+    if (boundary % HISTORY_PERIOD_S == 0 && boundary > last.ts)
+    {
+        history_record_t rec = { .ts = boundary, .count = channel_count };
+        memcpy(rec.values, values, channel_count * sizeof(values[0]));
+        esp_err_t ret = journal_append(&hist_journal, &rec, record_len(channel_count)); // Une programmation de page
+        if (ret != ESP_OK)                 // Intervalle prolongé jusqu'au relevé suivant
+        {
+            ESP_LOGE(TAG, "Relevé non enregistré : %s", esp_err_to_name(ret));
+        }
+        else
+        {
+            if (last.ts != 0)
+            {
+                uint32_t n = last.count < rec.count ? last.count : rec.count;
+                memset(q_delta, 0, sizeof(q_delta));
+                for (uint32_t i = 0; i < n; i++) q_delta[i] = rec.values[i] - last.values[i];
+                for (int i = 0; i < MAX_CHANNELS; i++) hour_acc[i] += q_delta[i];
+                q_start = last.ts;
+                q_dur = boundary - last.ts;
+            }
+            if (hour_start == 0) hour_start = boundary;
+            if (boundary % 3600 == 0)
+            {
+                if (hour_start < boundary)
+                {
+                    memcpy(h_delta, hour_acc, sizeof(h_delta));
+                    h_start = hour_start;
+                    h_dur = boundary - hour_start;
+                }
+                hour_start = boundary;
+                memset(hour_acc, 0, sizeof(hour_acc));
+            }
+            last = rec;
+        }
+    }
+    xSemaphoreGive(hist_mutex);
+
+    if (!mqtt_is_connected()) return;      // Intervalles consultables plus tard par requête de plage
+    if (q_dur) publish_interval(q_start, q_dur, HISTORY_PERIOD_S / 60, q_delta);
+    if (h_dur) publish_interval(h_start, h_dur, 60, h_delta);
+}
+
+/**
+ * @brief Tâche des relevés : réveil à chaque minute ronde, une fois l'horloge à l'heure.
+ */
+static void task_history(void *pv)
+{
+    while (1)
+    {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        if (tv.tv_sec < HISTORY_VALID_TIME) // SNTP pas encore synchronisé
+        {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+        uint32_t wait_ms = (uint32_t)(60 - tv.tv_sec % 60) * 1000 - (uint32_t)(tv.tv_usec / 1000) + HISTORY_SAMPLE_MARGIN_MS;
+        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+        time_t now = time(NULL);
+        sample((uint32_t)((now + 30) / 60 * 60)); // Minute ronde la plus proche (corrections SNTP)
+    }
+}
+
+void history_init(void)
+{
+    uint32_t slot_size = slot_size_for_channels();
+    uint32_t stored_size = 0;              // Absente : partition jamais utilisée par ce module
+
+    nvs_handle_t handle;
+    if (nvs_open("history", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        nvs_get_u32(handle, "slot", &stored_size);
+        if (stored_size != slot_size)      // Nombre de compteurs modifié ou première utilisation
+        {
+            const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                   ESP_PARTITION_SUBTYPE_ANY, "history");
+            if (part != NULL && esp_partition_erase_range(part, 0, part->size) == ESP_OK)
+            {
+                ESP_LOGW(TAG, "Slots de %lu o au lieu de %lu o : journal effacé",
+                         (unsigned long)slot_size, (unsigned long)stored_size);
+                nvs_set_u32(handle, "slot", slot_size);
+                nvs_commit(handle);
+            }
+        }
+        nvs_close(handle);
+    }
+
+    if (journal_open(&hist_journal, "history", slot_size) != ESP_OK) // Partition absente : module inactif
+    {
+        ESP_LOGW(TAG, "Intervalles d'énergie désactivés");
+        return;
+    }
+    load_state();
+
+    if (last.ts != 0)                      // Compteur revenu sous son dernier relevé : impulsions perdues depuis la dernière sauvegarde
+    {
+        uint32_t values[MAX_CHANNELS];
+        snapshot_low(values);
+        bool rebase = false;
+        for (int i = 0; i < last.count && i < channel_count; i++)
+        {
+            if ((int32_t)(values[i] - last.values[i]) < 0)
+            {
+                ESP_LOGW(TAG, "Compteur %d : %lu sous le dernier relevé (%lu), nouvelle base",
+                         i, (unsigned long)values[i], (unsigned long)last.values[i]);
+                last.values[i] = values[i];
+                rebase = true;
+            }
+        }
+        if (rebase) write_rebase();
+    }
+
+    min_val = malloc(HISTORY_MINUTES * channel_count * sizeof(uint32_t)); // NULL : intervalles de 1 min indisponibles
+    hist_mutex = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(task_history, "history", 4096, NULL, HISTORY_PRIORITY, NULL, CORE_NET);
+    ESP_LOGI(TAG, "Dernier relevé %lu", (unsigned long)last.ts);
+}
+
+void history_adjust_counter(int idx, uint64_t diff)
+{
+    if (hist_mutex == NULL)                // Module inactif : recalage seul
+    {
+        counter_store_adjust(idx, diff);
+        return;
+    }
+
+    xSemaphoreTake(hist_mutex, portMAX_DELAY);
+    counter_store_adjust(idx, diff);       // Sous le mutex : aucun relevé entre le recalage et la base
+    uint32_t n = min_head < HISTORY_MINUTES ? min_head : HISTORY_MINUTES;
+    for (uint32_t k = 0; min_val && k < n; k++) min_val[k * channel_count + idx] += (uint32_t)diff; // Écarts entre relevés inchangés
+    if (last.ts != 0 && idx < last.count)
+    {
+        last.values[idx] += (uint32_t)diff;
+        write_rebase();
+    }
+    xSemaphoreGive(hist_mutex);
+}
+
+/**
+ * @brief Ajoute une ligne [début, durée, impulsions...] si elle tient dans le buffer.
+ *
+ * @return false quand la réponse est complète (HISTORY_QUERY_MAX lignes ou buffer plein)
+ */
+static bool put_row(history_writer_t *w, uint32_t start, uint32_t dur, const uint32_t delta[MAX_CHANNELS])
+{
+    char row[32 + MAX_CHANNELS * 11];      // Ligne complète, copiée seulement si elle tient
+    int len = snprintf(row, sizeof(row), "%s[%lu,%lu", w->rows ? "," : "", (unsigned long)start, (unsigned long)dur);
+    for (int i = 0; i < channel_count; i++)
+    {
+        len += snprintf(row + len, sizeof(row) - len, ",%lu", (unsigned long)delta[i]);
+    }
+    len += snprintf(row + len, sizeof(row) - len, "]");
+
+    if (w->rows >= HISTORY_QUERY_MAX || w->len + (size_t)len + 24 >= w->size) // 24 : fin du document
+    {
+        w->next = start;
+        return false;
+    }
+    memcpy(w->buf + w->len, row, (size_t)len);
+    w->len += (size_t)len;
+    w->rows++;
+    return true;
+}
+
+/**
+ * @brief Lignes de 1 min, depuis les relevés en RAM.
+ */
+static void query_minutes(history_writer_t *w, uint32_t from, uint32_t to)
+{
+    uint32_t delta[MAX_CHANNELS] = { 0 };
+    uint32_t first = min_head > HISTORY_MINUTES ? min_head - HISTORY_MINUTES : 0;
+
+    for (uint32_t k = first + 1; min_val && k < min_head; k++)
+    {
+        uint32_t a = (k - 1) % HISTORY_MINUTES, b = k % HISTORY_MINUTES;
+        if (min_ts[a] < from) continue;
+        if (min_ts[a] >= to) break;
+        for (int i = 0; i < channel_count; i++) delta[i] = min_val[b * channel_count + i] - min_val[a * channel_count + i];
+        if (!put_row(w, min_ts[a], min_ts[b] - min_ts[a], delta)) break;
+    }
+}
+
+/**
+ * @brief Lignes de 15 min ou de 1 h, depuis le journal.
+ *
+ * Une heure regroupe les intervalles qui commencent dans cette heure ; un intervalle qui
+ * couvre une coupure prolonge l'heure où il commence.
+ */
+static void query_journal(history_writer_t *w, uint32_t res_min, uint32_t from, uint32_t to)
+{
+    history_reader_t r = { .slot = hist_journal.next_slot, .next_seq = 1 };
+    uint32_t start, dur, delta[MAX_CHANNELS];
+    uint32_t g_start = 0, g_end = 0, g_acc[MAX_CHANNELS]; // Heure en cours de regroupement (g_end = 0 : aucune)
+
+    while (read_interval(&r, &start, &dur, delta))
+    {
+        if (res_min == 60)
+        {
+            if (g_end != 0 && start / 3600 != g_start / 3600) // Heure suivante : la précédente est complète
+            {
+                if (g_start >= from && !put_row(w, g_start, g_end - g_start, g_acc)) return;
+                g_end = 0;
+            }
+            if (start >= to) return;
+            if (g_end == 0)
+            {
+                g_start = start;
+                memset(g_acc, 0, sizeof(g_acc));
+            }
+            for (int i = 0; i < MAX_CHANNELS; i++) g_acc[i] += delta[i];
+            g_end = start + dur;
+            continue;
+        }
+        if (start >= to) return;
+        if (start >= from && !put_row(w, start, dur, delta)) return;
+    }
+    if (g_end != 0 && g_start >= from) put_row(w, g_start, g_end - g_start, g_acc); // Heure en cours, partielle
+}
+
+size_t history_query(uint32_t res_min, uint32_t from, uint32_t to, char *buf, size_t size)
+{
+    if (hist_mutex == NULL || (res_min != 1 && res_min != HISTORY_PERIOD_S / 60 && res_min != 60)) return 0;
+
+    history_writer_t w = { buf, size, 0, 0, 0 };
+    w.len = snprintf(buf, size, "{\"res\":%lu,\"ppkwh\":[", (unsigned long)res_min);
+    for (int i = 0; i < channel_count && w.len < size; i++)
+    {
+        w.len += snprintf(buf + w.len, size - w.len, "%s%lu", i ? "," : "",
+                          (unsigned long)(channels[i].ppkwh ? channels[i].ppkwh : PULSES_PER_KWH));
+    }
+    if (w.len < size) w.len += snprintf(buf + w.len, size - w.len, "],\"rows\":[");
+    if (w.len >= size) return 0;
+
+    xSemaphoreTake(hist_mutex, portMAX_DELAY);
+    if (res_min == 1) query_minutes(&w, from, to);
+    else query_journal(&w, res_min, from, to);
+    xSemaphoreGive(hist_mutex);
+
+    w.len += snprintf(buf + w.len, size - w.len, "],\"next\":%lu}", (unsigned long)w.next); // Place réservée par put_row
+    return w.len;
+}
+
+const char *history_publish_range(uint32_t res_min, uint32_t from, uint32_t to)
+{
+    if (hist_mutex == NULL) return "intervalles inactifs";
+    if (history_query(res_min, from, to, range_json, sizeof(range_json)) == 0) return "résolution : 1, 15 ou 60";
+    mqtt_publish(HISTORY_RANGE_TOPIC, range_json);
+    return NULL;
+}
+
+#else // HISTORY_ENABLE == 0
+
+void history_init(void)
+{
+}
+
+void history_adjust_counter(int idx, uint64_t diff)
+{
+    counter_store_adjust(idx, diff);
+}
+
+size_t history_query(uint32_t res_min, uint32_t from, uint32_t to, char *buf, size_t size)
+{
+    return 0;
+}
+
+const char *history_publish_range(uint32_t res_min, uint32_t from, uint32_t to)
+{
+    return "intervalles inactifs";
+}
+
+#endif // HISTORY_ENABLE
@@ -0,0 +1,85 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/**
+ * @file history.h
+ * @brief Intervalles d'énergie alignés sur l'heure UTC : 1 min, 15 min et 1 h.
+ *
+ * Une tâche relève les compteurs à chaque minute ronde, une fois l'horloge mise à l'heure
+ * par SNTP :
+ * - les relevés de la dernière heure sont gardés en RAM (intervalles de 1 min) ;
+ * - aux bornes de HISTORY_PERIOD_S (15 min), le relevé est ajouté à un journal circulaire
+ *   (partition "history", lib/journal) qui survit aux redémarrages ;
+ * - l'intervalle de 15 min qui se ferme est publié sur energie/<DEVICE_NAME>/history,
+ *   suivi de l'heure qui se ferme aux heures rondes.
+ *
+ * Un intervalle est la différence entre deux relevés consécutifs : il est exact quels que
+ * soient les intermédiaires, et un intervalle qui couvre une coupure de l'appareil ou du
+ * Wi-Fi s'étend simplement jusqu'au relevé suivant ("dur" plus long que la résolution).
+ *
+ * Message publié (Wh avec 3 décimales, impulsions exactes), "res" en minutes :
+ *
+ *   {"ts":1739999700,"dur":900,"res":15,"wh":[12.500,0.000],"n":[25,0]}
+ *
+ * Consultation d'une plage : commande MQTT "history <1|15|60> <de> [<à>]" (réponse sur
+ * energie/<DEVICE_NAME>/history/range) ou GET /api/history?res=15&from=..&to=.. :
+ *
+ *   {"res":15,"ppkwh":[2000,1000],"rows":[[1739999700,900,25,0],...],"next":0}
+ *
+ * Chaque ligne donne le début, la durée et les impulsions de chaque compteur ; "next" est
+ * le début de la première ligne non rendue (HISTORY_QUERY_MAX), 0 si la plage est complète.
+ *
+ * Si le nombre de compteurs change, la taille des enregistrements change et le journal est effacé.
+ * Avec HISTORY_ENABLE à 0, le module est inactif et history_adjust_counter() recale seulement le compteur.
+ *
+ * Usage typique :
+ * 1. history_init() après storage_load_counters()
+ * 2. history_adjust_counter() à la place de counter_store_adjust() pour un recalage
+ */
+
+#include <stdint.h>     // Pour uint32_t, uint64_t
+#include <stddef.h>     // Pour size_t
+#include "config.h"     // Pour DEVICE_NAME, MAX_CHANNELS
+
+#define HISTORY_TOPIC       "energie/" DEVICE_NAME "/history" // Intervalles clos (QoS 1)
+#define HISTORY_RANGE_TOPIC HISTORY_TOPIC "/range"            // Réponses aux requêtes de plage
+
+/**
+ * @brief Ouvre le journal des intervalles et démarre la tâche des relevés.
+ *
+ * Les compteurs doivent être restaurés : un compteur revenu sous son dernier relevé
+ * (impulsions perdues depuis la dernière sauvegarde) repart de sa valeur restaurée.
+ */
+void history_init(void);
+
+/**
+ * @brief Ajoute diff (modulo 2^64) au compteur idx sans l'attribuer à un intervalle.
+ *
+ * Le recalage et la nouvelle base du compteur sont enregistrés ensemble : l'intervalle en
+ * cours ne compte que les impulsions réelles.
+ *
+ * @param idx  Index du compteur (0..channel_count-1)
+ * @param diff Écart à ajouter
+ */
+void history_adjust_counter(int idx, uint64_t diff);
+
+/**
+ * @brief Écrit en JSON les intervalles commençant dans [from, to).
+ *
+ * @param res_min Résolution : 1 (RAM, dernière heure), 15 ou 60 minutes
+ * @param from    Début de la plage (heure Unix)
+ * @param to      Fin de la plage (heure Unix, exclue)
+ * @param buf     Buffer de sortie
+ * @param size    Taille du buffer
+ * @return Longueur écrite, 0 si la résolution est invalide ou le module inactif
+ */
+size_t history_query(uint32_t res_min, uint32_t from, uint32_t to, char *buf, size_t size);
+
+/**
+ * @brief Publie la réponse de history_query() sur HISTORY_RANGE_TOPIC.
+ *
+ * @return NULL, ou la raison de l'échec (réponse de la commande MQTT)
+ */
+const char *history_publish_range(uint32_t res_min, uint32_t from, uint32_t to);
+
+#endif // HISTORY_H
@@ -0,0 +1,246 @@
+/**
+ * @file journal.c
+ * @brief Journal circulaire en flash : ajout seul, CRC32, récupération du dernier état au démarrage.
+ *
+ * Format d'un slot :
+ *   [journal_hdr_t (12 octets)][contenu (len octets)][0xFF jusqu'à la fin du slot]
+ *
+ * Le CRC couvre la séquence, la longueur et le contenu. Un slot effacé (0xFF) ou dont le CRC
+ * ne correspond pas (écriture interrompue par une coupure) est ignoré.
+ *
+ * Les slots sont écrits dans l'ordre ; quand le journal entre dans un nouveau secteur, celui-ci
+ * est effacé, ce qui supprime les enregistrements les plus anciens. Si le slot suivant n'est pas
+ * vierge au redémarrage (ajout interrompu), le journal repart au début du secteur suivant.
+ */
+
+#include <string.h>                 // Pour memset, memcpy
+#include "journal.h"                // Header du module
+#include "esp_rom_crc.h"            // CRC32 en ROM
+#include "esp_log.h"                // Fonctions ESP_LOG pour debug
+
+#define JOURNAL_MAGIC 0x4A52        // Marqueur d'un slot écrit ("JR")
+
+/**
+ * @brief En-tête d'un enregistrement du journal.
+ */
+typedef struct {
+    uint16_t magic;                 ///< JOURNAL_MAGIC
+    uint16_t len;                   ///< Taille du contenu en octets
+    uint32_t seq;                   ///< Numéro de séquence croissant (1 = premier enregistrement)
+    uint32_t crc;                   ///< CRC32 de seq, len et du contenu
+} journal_hdr_t;
+
+static const char *TAG = "JOURNAL"; // Tag pour les logs du module journal
+
+/**
+ * @brief Calcule le CRC d'un enregistrement.
+ */
+static uint32_t record_crc(const journal_hdr_t *hdr, const uint8_t *payload)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr->seq, sizeof(hdr->seq)); // Séquence
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)&hdr->len, sizeof(hdr->len));       // Longueur
+    return esp_rom_crc32_le(crc, payload, hdr->len);                                  // Contenu
+}
+
+/**
+ * @brief Lit un slot complet et vérifie sa validité.
+ *
+ * @param j    Journal
+ * @param slot Index du slot
+ * @param buf  Buffer de JOURNAL_PAGE_SIZE octets recevant le slot
+ * @return true si le slot contient un enregistrement valide
+ */
+static bool read_slot(const journal_t *j, uint32_t slot, uint8_t *buf)
+{
+    if (esp_partition_read(j->part, slot * j->slot_size, buf, j->slot_size) != ESP_OK) // Lecture du slot
+    {
+        return false;
+    }
+
+    const journal_hdr_t *hdr = (const journal_hdr_t *)buf; // En-tête en début de slot
+    if (hdr->magic != JOURNAL_MAGIC || hdr->len > j->slot_size - sizeof(journal_hdr_t)) // Slot vierge ou corrompu
+    {
+        return false;
+    }
+
+    return record_crc(hdr, buf + sizeof(journal_hdr_t)) == hdr->crc; // Enregistrement complet ?
+}
+
+/**
+ * @brief Indique si un slot est vierge (entièrement à 0xFF).
+ */
+static bool slot_is_blank(const journal_t *j, uint32_t slot)
+{
+    uint32_t buf[JOURNAL_PAGE_SIZE / sizeof(uint32_t)]; // Contenu du slot
+    if (esp_partition_read(j->part, slot * j->slot_size, buf, j->slot_size) != ESP_OK)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < j->slot_size / sizeof(uint32_t); i++)
+    {
+        if (buf[i] != 0xFFFFFFFF) return false; // Octet déjà programmé
+    }
+    return true;
+}
+
+esp_err_t journal_open(journal_t *j, const char *label, uint32_t slot_size)
+{
+    memset(j, 0, sizeof(*j)); // Journal vide par défaut
+
+    if (slot_size < 32 || slot_size > JOURNAL_PAGE_SIZE || (slot_size & (slot_size - 1)) != 0) // Un slot ne doit jamais chevaucher deux pages
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    j->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label); // Recherche de la partition par label
+    if (j->part == NULL)
+    {
+        ESP_LOGE(TAG, "Partition '%s' introuvable", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    j->slot_size = slot_size;                 // Taille des slots
+    j->nb_slots = j->part->size / slot_size;  // Nombre de slots disponibles
+
+    // --- Recherche du dernier enregistrement valide ---
+    uint8_t buf[JOURNAL_PAGE_SIZE];           // Contenu d'un slot
+    for (uint32_t slot = 0; slot < j->nb_slots; slot++)
+    {
+        if (read_slot(j, slot, buf))          // Enregistrement valide
+        {
+            uint32_t seq = ((const journal_hdr_t *)buf)->seq;
+            if (seq > j->last_seq)            // Plus récent que le meilleur trouvé
+            {
+                j->last_seq = seq;
+                j->last_slot = slot;
+            }
+        }
+    }
+
+    j->next_slot = (j->last_seq == 0) ? 0 : (j->last_slot + 1) % j->nb_slots; // Ajout après le plus récent
+
+    ESP_LOGI(TAG, "Journal '%s' : %lu slots de %lu o, dernière séquence %lu",
+             label, (unsigned long)j->nb_slots, (unsigned long)slot_size, (unsigned long)j->last_seq);
+    return ESP_OK;
+}
+
+esp_err_t journal_read_latest(journal_t *j, void *out, size_t *len)
+{
+    if (j->part == NULL || j->last_seq == 0)  // Journal absent ou vide
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t buf[JOURNAL_PAGE_SIZE];           // Contenu du slot
+    if (!read_slot(j, j->last_slot, buf))     // Relit et revérifie l'enregistrement
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    const journal_hdr_t *hdr = (const journal_hdr_t *)buf;
+    if (hdr->len > *len)                      // Buffer de l'appelant trop petit
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memcpy(out, buf + sizeof(journal_hdr_t), hdr->len); // Copie du contenu
+    *len = hdr->len;
+    return ESP_OK;
+}
+
+esp_err_t journal_read_next(journal_t *j, uint32_t *slot, uint32_t min_seq,
+                            void *out, size_t *len, uint32_t *seq)
+{
+    if (j->part == NULL || j->last_seq == 0 || min_seq > j->last_seq) // Rien à lire
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t buf[JOURNAL_PAGE_SIZE];           // Contenu d'un slot
+    uint32_t s = *slot % j->nb_slots;         // Slot de départ
+    for (uint32_t i = 0; i < j->nb_slots; i++, s = (s + 1) % j->nb_slots) // Au plus un tour complet
+    {
+        if (read_slot(j, s, buf))             // Enregistrement valide
+        {
+            const journal_hdr_t *hdr = (const journal_hdr_t *)buf;
+            if (hdr->seq >= min_seq)          // Premier enregistrement assez récent
+            {
+                if (hdr->len > *len)          // Buffer de l'appelant trop petit
+                {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+                memcpy(out, buf + sizeof(journal_hdr_t), hdr->len); // Copie du contenu
+                *len = hdr->len;
+                *seq = hdr->seq;
+                *slot = (s + 1) % j->nb_slots; // Reprise au slot suivant
+                return ESP_OK;
+            }
+        }
+        if (s == j->last_slot)                // Enregistrement le plus récent dépassé
+        {
+            break;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+size_t journal_max_payload(const journal_t *j)
+{
+    return j->slot_size - sizeof(journal_hdr_t);
+}
+
+esp_err_t journal_append(journal_t *j, const void *data, size_t len)
+{
+    if (j->part == NULL)                           // Journal non ouvert
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len > journal_max_payload(j))              // Contenu trop grand pour un slot
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t slots_per_sector = JOURNAL_SECTOR_SIZE / j->slot_size; // Slots par secteur effaçable
+    uint32_t slot = j->next_slot;                  // Slot cible
+    esp_err_t ret;
+
+    if (slot % slots_per_sector != 0 && !slot_is_blank(j, slot)) // Ajout précédent interrompu : on passe au secteur suivant
+    {
+        ESP_LOGW(TAG, "Slot %lu non vierge, passage au secteur suivant", (unsigned long)slot);
+        slot = ((slot / slots_per_sector + 1) * slots_per_sector) % j->nb_slots;
+    }
+
+    if (slot % slots_per_sector == 0)              // Entrée dans un nouveau secteur : effacement
+    {
+        ret = esp_partition_erase_range(j->part, slot * j->slot_size, JOURNAL_SECTOR_SIZE);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Effacement secteur impossible : %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    uint8_t buf[JOURNAL_PAGE_SIZE];                // Slot à écrire
+    journal_hdr_t *hdr = (journal_hdr_t *)buf;
+    hdr->magic = JOURNAL_MAGIC;                    // Marqueur de slot écrit
+    hdr->len = (uint16_t)len;                      // Taille du contenu
+    hdr->seq = j->last_seq + 1;                    // Séquence suivante
+    memcpy(buf + sizeof(journal_hdr_t), data, len); // Contenu
+    hdr->crc = record_crc(hdr, buf + sizeof(journal_hdr_t)); // CRC de l'enregistrement
+
+    size_t wlen = (sizeof(journal_hdr_t) + len + 3) & ~(size_t)3; // Écriture arrondie au mot de 32 bits
+    memset(buf + sizeof(journal_hdr_t) + len, 0xFF, wlen - sizeof(journal_hdr_t) - len); // Bourrage laissé vierge
+
+    ret = esp_partition_write(j->part, slot * j->slot_size, buf, wlen); // Une seule programmation de page
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Écriture slot %lu impossible : %s", (unsigned long)slot, esp_err_to_name(ret));
+        j->next_slot = (slot + 1) % j->nb_slots;   // Ne réécrit pas un slot potentiellement entamé
+        return ret;
+    }
+
+    j->last_seq = hdr->seq;                        // Nouvel enregistrement le plus récent
+    j->last_slot = slot;
+    j->next_slot = (slot + 1) % j->nb_slots;       // Prochain ajout
+    return ESP_OK;
+}
@@ -0,0 +1,109 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+/**
+ * @file journal.h
+ * @brief Journal circulaire en flash, en ajout seul, protégé par CRC.
+ *
+ * Une partition de données est découpée en emplacements (slots) de taille fixe.
+ * Chaque ajout écrit un enregistrement complet dans le slot suivant :
+ * - Un ajout = une seule programmation de page flash (slot ≤ 256 octets, aligné)
+ * - Un secteur de 4 Ko n'est effacé qu'au moment où le journal y entre,
+ *   l'usure est donc répartie uniformément sur toute la partition
+ * - Chaque enregistrement porte un numéro de séquence croissant et un CRC32 :
+ *   au démarrage, le plus récent enregistrement valide est retrouvé, un ajout
+ *   interrompu par une coupure est simplement ignoré
+ *
+ * Le contenu des enregistrements est opaque pour ce module.
+ *
+ * Usage typique :
+ * 1. journal_open(&j, "journal", 256) au démarrage
+ * 2. journal_read_latest(&j, buf, &len) pour récupérer le dernier état
+ * 3. journal_append(&j, data, len) à chaque sauvegarde
+ * 4. journal_read_next() pour relire les enregistrements dans l'ordre (file d'attente)
+ */
+
+#include <stdint.h>          // Pour uint32_t
+#include <stddef.h>          // Pour size_t
+#include "esp_err.h"         // Pour esp_err_t
+#include "esp_partition.h"   // Pour esp_partition_t
+
+#define JOURNAL_SECTOR_SIZE 4096   // Taille d'un secteur effaçable de la flash
+#define JOURNAL_PAGE_SIZE   256    // Taille d'une page programmable de la flash
+
+/**
+ * @brief État d'un journal ouvert.
+ */
+typedef struct {
+    const esp_partition_t *part;   ///< Partition support du journal
+    uint32_t slot_size;            ///< Taille d'un slot en octets (diviseur de JOURNAL_PAGE_SIZE)
+    uint32_t nb_slots;             ///< Nombre de slots dans la partition
+    uint32_t next_slot;            ///< Slot du prochain ajout
+    uint32_t last_slot;            ///< Slot du dernier enregistrement valide
+    uint32_t last_seq;             ///< Séquence du dernier enregistrement valide (0 = journal vide)
+} journal_t;
+
+/**
+ * @brief Ouvre un journal et retrouve son dernier enregistrement valide.
+ *
+ * @param j         Journal à initialiser
+ * @param label     Label de la partition dans partitions.csv
+ * @param slot_size Taille d'un slot en octets (puissance de 2, de 32 à JOURNAL_PAGE_SIZE)
+ * @return ESP_OK, ESP_ERR_NOT_FOUND si la partition n'existe pas,
+ *         ESP_ERR_INVALID_ARG si slot_size est invalide
+ */
+esp_err_t journal_open(journal_t *j, const char *label, uint32_t slot_size);
+
+/**
+ * @brief Lit le contenu du dernier enregistrement valide.
+ *
+ * @param j   Journal ouvert
+ * @param buf Buffer de destination
+ * @param len Entrée : taille du buffer ; sortie : taille du contenu lu
+ * @return ESP_OK, ESP_ERR_NOT_FOUND si le journal est vide,
+ *         ESP_ERR_INVALID_SIZE si le buffer est trop petit
+ */
+esp_err_t journal_read_latest(journal_t *j, void *buf, size_t *len);
+
+/**
+ * @brief Lit, dans l'ordre d'écriture, le premier enregistrement de séquence >= min_seq.
+ *
+ * Parcourt les slots à partir de *slot jusqu'au plus récent enregistrement. Pour lire
+ * le journal du plus ancien au plus récent, partir de j->next_slot (les slots suivant
+ * le plus récent contiennent les enregistrements les plus anciens) puis rappeler la
+ * fonction avec min_seq = *seq + 1.
+ *
+ * @param j       Journal ouvert
+ * @param slot    Entrée : slot de départ ; sortie : slot suivant l'enregistrement lu
+ * @param min_seq Plus petite séquence acceptée
+ * @param buf     Buffer de destination
+ * @param len     Entrée : taille du buffer ; sortie : taille du contenu lu
+ * @param seq     Séquence de l'enregistrement lu
+ * @return ESP_OK, ESP_ERR_NOT_FOUND si aucun enregistrement ne convient,
+ *         ESP_ERR_INVALID_SIZE si le buffer est trop petit
+ */
+esp_err_t journal_read_next(journal_t *j, uint32_t *slot, uint32_t min_seq,
+                            void *buf, size_t *len, uint32_t *seq);
+
+/**
+ * @brief Ajoute un enregistrement à la suite du journal.
+ *
+ * Efface le secteur suivant si nécessaire, puis écrit l'enregistrement
+ * en une seule opération.
+ *
+ * @param j    Journal ouvert
+ * @param data Contenu à enregistrer
+ * @param len  Taille du contenu (au plus journal_max_payload())
+ * @return ESP_OK ou le code d'erreur flash
+ */
+esp_err_t journal_append(journal_t *j, const void *data, size_t len);
+
+/**
+ * @brief Taille maximale du contenu d'un enregistrement pour ce journal.
+ *
+ * @param j Journal ouvert
+ * @return Nombre d'octets utilisables par slot
+ */
+size_t journal_max_payload(const journal_t *j);
+
+#endif // JOURNAL_H
@@ -0,0 +1,75 @@
+/**
+ * @file lowpower.c
+ * @brief Light sleep automatique (tickless idle) et modem sleep Wi-Fi entre les publications.
+ *
+ * Le light sleep n'est possible que si aucune tâche ni aucun périphérique ne tient de verrou
+ * de gestion d'énergie : les moteurs de comptage PCNT et SAMPLER en tiennent un (APB)
+ * tant qu'ils tournent, d'où le moteur ISR par défaut en LOW_POWER (config.h).
+ */
+
+#include "config.h"                 // LOW_POWER, LOW_POWER_*
+#include "lowpower.h"               // Header du module
+
+#if LOW_POWER
+
+#include "sdkconfig.h"              // CONFIG_PM_ENABLE, CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#include "esp_pm.h"                 // Gestionnaire d'énergie et verrous
+#include "esp_sleep.h"              // Réveil par GPIO
+#include "esp_wifi.h"               // Modem sleep
+#include "esp_log.h"                // Système de logs ESP-IDF
+
+#if !CONFIG_PM_ENABLE || !CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#error "LOW_POWER nécessite CONFIG_PM_ENABLE et CONFIG_FREERTOS_USE_TICKLESS_IDLE (menuconfig)"
+#endif
+
+#if PULSE_BACKEND != PULSE_BACKEND_ISR
+#warning "LOW_POWER : le moteur PCNT / SAMPLER tient un verrou APB, le light sleep ne sera jamais atteint"
+#endif
+
+static const char *TAG = "LOWPOWER";       // Identifiant de log du module
+static esp_pm_lock_handle_t publish_lock;  // Tenu pendant une fenêtre de publication
+
+void lowpower_init(void)
+{
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = LOW_POWER_MAX_FREQ_MHZ,    // Fréquence pendant les traitements
+        .min_freq_mhz = LOW_POWER_MIN_FREQ_MHZ,    // Fréquence au repos
+        .light_sleep_enable = true,                // Light sleep dès que le CPU est inactif
+    };
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Gestion d'énergie indisponible : %s", esp_err_to_name(ret));
+        return;
+    }
+    esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "publish", &publish_lock);
+    esp_sleep_enable_gpio_wakeup();                // Les entrées configurées par gpio_wakeup_enable réveillent le CPU
+
+    ESP_LOGI(TAG, "Light sleep automatique actif (%d-%d MHz)", LOW_POWER_MIN_FREQ_MHZ, LOW_POWER_MAX_FREQ_MHZ);
+}
+
+void lowpower_wifi_started(void)
+{
+    esp_wifi_set_ps(WIFI_PS_MAX_MODEM);            // Radio réveillée toutes les WIFI_LISTEN_INTERVAL balises
+}
+
+void lowpower_publish_begin(void)
+{
+    if (publish_lock != NULL) esp_pm_lock_acquire(publish_lock);
+    esp_wifi_set_ps(WIFI_PS_MIN_MODEM);            // Réveil à chaque DTIM : accusés MQTT sans attendre
+}
+
+void lowpower_publish_end(void)
+{
+    esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+    if (publish_lock != NULL) esp_pm_lock_release(publish_lock);
+}
+
+#else
+
+void lowpower_init(void) {}
+void lowpower_wifi_started(void) {}
+void lowpower_publish_begin(void) {}
+void lowpower_publish_end(void) {}
+
+#endif // LOW_POWER
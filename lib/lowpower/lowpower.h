@@ -0,0 +1,47 @@
+#ifndef LOWPOWER_H
+#define LOWPOWER_H
+
+/**
+ * @file lowpower.h
+ * @brief Mode basse consommation : light sleep automatique et modem sleep entre les publications.
+ *
+ * Avec LOW_POWER (config.h), le gestionnaire d'énergie ESP-IDF est configuré pour
+ * entrer en light sleep dès que FreeRTOS n'a rien à exécuter (tickless idle) :
+ * - Le comptage continue : les entrées réveillent le CPU par interruption de niveau
+ *   (réveil GPIO), les timers d'anti-rebond par leur échéance
+ * - Le Wi-Fi reste associé en modem sleep (WIFI_PS_MAX_MODEM, réveil toutes les
+ *   WIFI_LISTEN_INTERVAL balises) ; pendant une fenêtre de publication, la radio
+ *   repasse en WIFI_PS_MIN_MODEM et le CPU est maintenu à LOW_POWER_MAX_FREQ_MHZ
+ *
+ * Sans LOW_POWER, toutes les fonctions sont sans effet.
+ *
+ * Usage typique :
+ * 1. lowpower_init() au démarrage en mode normal (pas en mode AP de configuration)
+ * 2. lowpower_publish_begin() / lowpower_publish_end() autour de chaque publication
+ */
+
+/**
+ * @brief Active le light sleep automatique et le réveil par GPIO.
+ *
+ * Appelée avant la configuration des entrées de comptage.
+ */
+void lowpower_init(void);
+
+/**
+ * @brief Passe le Wi-Fi en modem sleep profond une fois la station démarrée.
+ *
+ * Appelée par wifi_init() après esp_wifi_start().
+ */
+void lowpower_wifi_started(void);
+
+/**
+ * @brief Ouvre une fenêtre de publication : CPU à pleine fréquence, radio réactive.
+ */
+void lowpower_publish_begin(void);
+
+/**
+ * @brief Ferme la fenêtre de publication : retour au modem sleep profond et au light sleep.
+ */
+void lowpower_publish_end(void);
+
+#endif // LOWPOWER_H
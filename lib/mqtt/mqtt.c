@@ -9,22 +9,138 @@
  * - mqtt_init : Initialise le client MQTT.
  * - mqtt_publish : Publie un message MQTT.
  * - mqtt_publish_config : Publie un message de configuration MQTT.
+ * - mqtt_publish_counters : Publie les compteurs, un message par compteur ou un message groupé.
+ * - mqtt_publish_backlog : Publie un relevé de la file d'attente hors ligne sur energie/<DEVICE_NAME>/backlog.
+ * - mqtt_publish_stats : Publie, à la demande (energie/<DEVICE_NAME>/stats/get), les statistiques du comptage.
+ * - mqtt_publish_diag : Publie le diagnostic périodique (diag.h) sur energie/<DEVICE_NAME>/diag.
+ *
+ * Les commandes reçues sur energie/<DEVICE_NAME>/cmd sont mises en file pour la tâche mqtt_cmd (mqtt_cmd.h).
+ *
+ * Publication groupée (mqtt_batch_mode) :
+ * - MQTT_BATCH_OFF  : un message par compteur sur energie/<nom> (channel_count PUBLISH/PUBACK par cycle)
+ * - MQTT_BATCH_JSON : un seul message {"ts":..,"up":..,"c0":..,"p0":..,...} sur energie/<DEVICE_NAME>/state,
+ *                     la découverte Home Assistant pointe sur ce topic avec value_template {{ value_json.cN }}
+ * - MQTT_BATCH_CBOR : le même contenu encodé en CBOR (RFC 8949) sur energie/<DEVICE_NAME>/state/cbor,
+ *                     destiné aux consommateurs de flotte (pas de découverte Home Assistant dans ce mode)
+ *
+ * Seuls les channel_count compteurs actifs sont publiés. Les compteurs comptent des impulsions ;
+ * l'énergie publiée est convertie en Wh à 3 décimales (entiers 64 bits, sans virgule flottante)
+ * avec la constante de chaque compteur (channels[i].ppkwh, counter_store_mwh).
+ *
+ * Topics, documents de découverte et messages groupés sont préformatés une fois par configuration
+ * (mqtt_payload). La découverte n'est republiée que si son empreinte a changé, ou quand
+ * Home Assistant annonce son redémarrage sur homeassistant/status. Les contenus publiés ne sont
+ * jamais journalisés au niveau INFO.
  */
 
 #include "mqtt_client.h" // ESP-IDF : fonctions MQTT client
 #include "mqtt.h"        // Header du module MQTT personnalisé
 #include "esp_log.h"        // ESP-IDF : fonctions de logging
+#include "esp_netif.h"      // ESP-IDF : IP_EVENT (reconnexion au retour du Wi-Fi)
 #include <string.h>       // Pour les fonctions de manipulation de chaînes (ex: strlen)
 #include <stdlib.h>      // Pour les fonctions de conversion (ex: atoi)
 #include <stdio.h>     // Pour les fonctions de formatage (ex: sprintf)
+#include <time.h>      // Horodatage des messages groupés
+#include <math.h>      // Pour lroundf
+#include "esp_timer.h" // Temps depuis le démarrage
+#include "counter_store.h" // Conversion des impulsions en énergie
+#include "power_meter.h" // Puissance instantanée et moyennes glissantes
+#include "publish_sched.h" // Demande de publication à la connexion
+#include "outbox.h"        // File d'attente hors ligne vidée à la connexion
+#include "boot_timing.h"   // Chronométrage du démarrage
 #include "gpio_pulse.h"    // Pour accéder au tableau global counters
+#include "pulse_stats.h"   // Statistiques du chemin de comptage (PULSE_STATS)
 #include "storage.h"       // Pour les fonctions de stockage NVS (sauvegarde des compteurs)
-#include "config.h"     // Pour les constantes de configuration (ex: NB_COUNTERS, mqtt_names, etc.)
+#include "mqtt_cmd.h"      // Commandes à distance
+#include "mqtt_payload.h"  // Topics, documents de découverte et modèles d'état préformatés
+#include "nvs.h"           // Empreinte des documents de découverte publiés
+#include "config.h"     // Pour les constantes de configuration (ex: channel_count, channels, etc.)
 
 static esp_mqtt_client_handle_t client; // Handle global du client MQTT
+static volatile bool connected = false; // Vrai entre MQTT_EVENT_CONNECTED et MQTT_EVENT_DISCONNECTED
 
 static const char *TAG = "MQTT_HANDLER"; //Identifiant des message log de la lib pour faciliter le debug      
 
+#define MQTT_STATS_TOPIC "energie/" DEVICE_NAME "/stats" // Topic du rapport de statistiques du comptage
+#define MQTT_STATS_GET_TOPIC MQTT_STATS_TOPIC "/get"     // Tout message sur ce topic déclenche un rapport
+#define MQTT_SELFTEST_TOPIC "energie/" DEVICE_NAME "/selftest" // Topic du rapport du banc de débit (PULSE_SELFTEST)
+#define MQTT_HA_STATUS_TOPIC "homeassistant/status"       // Message de naissance de Home Assistant ("online")
+#define MQTT_DISCOVERY_KEY "disc"                         // Clé NVS (espace "mqtt") de l'empreinte de découverte publiée
+#define MQTT_VALID_TIME  1600000000                       // En dessous, l'horloge n'a pas été mise à l'heure (ts = 0)
+
+/**
+ * @brief Empreinte des documents de découverte déjà publiés (retenus par le broker), 0 si aucune.
+ */
+static uint32_t discovery_hash_load(void)
+{
+    nvs_handle_t handle;
+    uint32_t hash = 0;
+    if (nvs_open("mqtt", NVS_READONLY, &handle) == ESP_OK)
+    {
+        nvs_get_u32(handle, MQTT_DISCOVERY_KEY, &hash); // ESP_ERR_NVS_NOT_FOUND : jamais publiés
+        nvs_close(handle);
+    }
+    return hash;
+}
+
+/**
+ * @brief Enregistre l'empreinte des documents de découverte publiés.
+ */
+static void discovery_hash_save(uint32_t hash)
+{
+    nvs_handle_t handle;
+    if (nvs_open("mqtt", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        nvs_set_u32(handle, MQTT_DISCOVERY_KEY, hash);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
+/**
+ * @brief Publie la configuration MQTT Discovery de chaque compteur pour Home Assistant.
+ *
+ * Chaque compteur expose un capteur d'énergie (Wh) et un capteur de puissance
+ * instantanée (W). En mode groupé JSON, chaque capteur lit sa valeur dans le
+ * message d'état commun (value_template) ; sinon, chaque capteur suit son topic
+ * energie/<nom> (énergie) et energie/<nom>/power (puissance).
+ * En mode CBOR, Home Assistant ne sait pas décoder le contenu : rien n'est publié.
+ *
+ * Les documents sont préformatés dans l'arène (mqtt_payload) et publiés retenus :
+ * tant que leur empreinte n'a pas changé depuis la dernière publication, le broker
+ * les a déjà et rien n'est renvoyé, sauf si force est vrai (redémarrage de Home Assistant).
+ * L'empreinte n'est enregistrée que si tous les documents ont été acceptés par le client MQTT.
+ *
+ * @param force Publie même si les documents retenus sont à jour
+ */
+static void mqtt_publish_discovery(bool force)
+{
+    uint32_t hash = mqtt_payload_discovery_hash();
+    uint32_t published = discovery_hash_load();
+    if (!force && hash == published) // Documents inchangés, déjà retenus
+    {
+        ESP_LOGI(TAG, "Découverte Home Assistant inchangée, non republiée");
+        return;
+    }
+
+    int count = mqtt_payload_discovery_count();
+    int failed = 0;
+    for (int k = 0; k < count; k++)
+    {
+        const char *topic;
+        size_t len;
+        const char *doc = mqtt_payload_discovery(k, &topic, &len);
+        if (esp_mqtt_client_publish(client, topic, doc, (int)len, 1, 1) < 0) failed++; // QoS 1, retenu
+    }
+    if (failed > 0) // Empreinte non enregistrée : tout sera republié à la prochaine connexion
+    {
+        ESP_LOGW(TAG, "Découverte Home Assistant : %d documents sur %d non publiés", failed, count);
+        return;
+    }
+    if (hash != published) discovery_hash_save(hash); // Une écriture NVS par changement de configuration
+    ESP_LOGI(TAG, "Découverte Home Assistant publiée (%d documents)", count);
+}
+
 /**
  * @brief Traite les événements MQTT reçus par le client.
  *
@@ -50,34 +166,20 @@ static void mqtt_event_handler(void *handler_args,
 
         case MQTT_EVENT_CONNECTED: //    Traite la connexion réussie au broker
             ESP_LOGI(TAG, "MQTT connecté au broker"); // Log de la connexion pour le debug
-            char topic[128]; // Buffer pour construire les topics MQTT à publier    
-            char json[512]; // Buffer pour construire les messages JSON à publier (ex: configuration Home Assistant)
+            boot_timing_mark(BOOT_MARK_MQTT);
             esp_mqtt_client_publish(client, "energie/status", "connected", 0, 1, 0); // Publie un message de statut à la connexion
-            for(int i=0; i<NB_COUNTERS; i++){
-                snprintf(topic, sizeof(topic),"homeassistant/sensor/energie/%s/config",mqtt_names[i]); // Topic Discovery Home Assistant  
-                snprintf(json, sizeof(json),
-                    "{\"name\": \"%s\","
-                    "\"state_topic\": \"energie/%s\","
-                    "\"unit_of_measurement\" : \"Wh\","
-                    "\"device_class\": \"energy\","
-                    "\"state_class\": \"total_increasing\","
-                    "\"unique_id\": \"%s_%s\","
-                    "\"device\": {"
-                    "  \"identifiers\": [\"%s_%s\"],"
-                    "  \"name\": \"%s_%s\","
-                    "  \"manufacturer\": \"DIY\","
-                    "  \"model\": \"ESP32 Energy\"}}",
-                    mqtt_names[i],
-                    mqtt_names[i],
-                    DEVICE_NAME,mqtt_names[i],
-                    DEVICE_NAME,mqtt_names[i],
-                    DEVICE_NAME,mqtt_names[i]);
-                mqtt_publish_config(topic, json);   // Publie la configuration de chaque compteur pour Home Assistant (MQTT Discovery)  
-            }
+            mqtt_publish_discovery(false); // Configuration de chaque compteur pour Home Assistant (MQTT Discovery), si elle a changé
+            esp_mqtt_client_subscribe(client, MQTT_STATS_GET_TOPIC, 0); // Demandes de statistiques du comptage
+            esp_mqtt_client_subscribe(client, MQTT_HA_STATUS_TOPIC, 0); // Redémarrage de Home Assistant : découverte à republier
+            esp_mqtt_client_subscribe(client, MQTT_CMD_TOPIC, 1); // Commandes à distance (QoS 1 : pas de commande perdue)
+            connected = true; // Broker joignable : publications en direct
+            publish_sched_request_all(); // Resynchronise toutes les valeurs après la (re)connexion
+            outbox_resume(); // Vide la file des relevés mis en attente pendant la coupure
             break; //   Important : ne pas oublier le break pour éviter de traiter les autres cas après une connexion réussie
 
         case MQTT_EVENT_DISCONNECTED: //    Traite la déconnexion du broker
             ESP_LOGW(TAG, "MQTT déconnecté du broker"); // Log de la déconnexion pour le debug
+            connected = false; // Les relevés suivants iront dans la file d'attente hors ligne
             break; //   Important : ne pas oublier le break pour éviter de traiter les autres cas après une déconnexion
 
         case MQTT_EVENT_ERROR: //    Traite les erreurs MQTT
@@ -85,9 +187,23 @@ static void mqtt_event_handler(void *handler_args,
             break; //   Important : ne pas oublier le break pour éviter de traiter les autres cas après une erreur  
 
         case MQTT_EVENT_DATA: //    Traite les messages reçus sur les topics MQTT
-            ESP_LOGI(TAG, "Message reçu"); // Log de la réception d'un message pour le debug
-            printf("TOPIC=%.*s\r\n", event->topic_len, event->topic); // Affiche le topic du message reçu pour le debug
-            printf("DATA=%.*s\r\n", event->data_len, event->data); // Affiche le contenu du message reçu pour le debug
+            ESP_LOGD(TAG, "Message reçu : %.*s (%d octets)", event->topic_len, event->topic, event->data_len); // Log de la réception d'un message pour le debug
+            if (event->topic_len == strlen(MQTT_CMD_TOPIC) &&
+                memcmp(event->topic, MQTT_CMD_TOPIC, event->topic_len) == 0) // Commande : exécutée hors du gestionnaire
+            {
+                mqtt_cmd_post(event->data, event->data_len);
+            }
+            else if (event->topic_len == strlen(MQTT_STATS_GET_TOPIC) &&
+                memcmp(event->topic, MQTT_STATS_GET_TOPIC, event->topic_len) == 0) // Demande de statistiques
+            {
+                mqtt_cmd_post("stats", 5); // Rapport formaté et publié par la seule tâche mqtt_cmd
+            }
+            else if (event->topic_len == strlen(MQTT_HA_STATUS_TOPIC) &&
+                     memcmp(event->topic, MQTT_HA_STATUS_TOPIC, event->topic_len) == 0 &&
+                     event->data_len == 6 && memcmp(event->data, "online", 6) == 0) // Home Assistant (re)démarré
+            {
+                mqtt_publish_discovery(true); // Son broker a pu perdre les messages retenus
+            }
             break; //   Important : ne pas oublier le break pour éviter de traiter les autres cas après la réception d'un message
 
         default: //    Cas par défaut pour les événements non traités
@@ -97,6 +213,23 @@ static void mqtt_event_handler(void *handler_args,
 }
 
 
+/**
+ * @brief Relance immédiatement la connexion au broker quand le Wi-Fi obtient une adresse IP.
+ *
+ * Le client MQTT est démarré sans attendre le Wi-Fi ; sans ce coup de pouce, il
+ * attendrait la fin de son délai de reconnexion après les échecs pendant la coupure.
+ */
+static void mqtt_ip_event_handler(void *handler_args,
+                                  esp_event_base_t base,
+                                  int32_t event_id,
+                                  void *event_data)
+{
+    if (client != NULL && !connected)   // Client démarré mais pas connecté
+    {
+        esp_mqtt_client_reconnect(client); // Tentative immédiate
+    }
+}
+
 /**
  * @brief Initialise le client MQTT et se connecte au broker.
  *
@@ -104,11 +237,14 @@ static void mqtt_event_handler(void *handler_args,
  *  - Configure le broker, le nom d'utilisateur et le mot de passe
  *  - Initialise le client MQTT
  *  - Enregistre l'event handler
- *  - Démarre le client
+ *  - Démarre le client, sans attendre que le Wi-Fi soit connecté
  */
 void mqtt_init(void)
 {
-    char uri_server[256]; // Buffer pour construire l'URI du broker MQTT (ex: "mqtt://
+    mqtt_payload_build(); // Topics, découverte et modèle d'état préformatés une fois pour la configuration chargée
+    mqtt_cmd_init();      // Tâche des commandes, prête avant le premier abonnement
+
+    static char uri_server[256]; // URI du broker MQTT (ex: "mqtt://...") ; statique : hors de la pile de task_mqtt
     snprintf(uri_server, sizeof(uri_server), "mqtt://%s:%s", mqtt_Server, mqtt_port); // Construction de l'URI du broker MQTT à partir des paramètres de configuration
     ESP_LOGI(TAG, "Configuration MQTT sans auth : uri=%s user=%s Pass=%s",uri_server, mqtt_user, mqtt_pass); // Log de la configuration utilisée     
     esp_mqtt_client_config_t mqtt_cfg = {                         // Structure de configuration MQTT
@@ -131,7 +267,10 @@ void mqtt_init(void)
                                    mqtt_event_handler,
                                    NULL);
 
-    esp_mqtt_client_start(client);                                 // Démarrage de la connexion MQTT
+    esp_mqtt_client_start(client);                                 // Démarrage de la connexion MQTT (le client réessaie tant que le réseau est absent)
+
+    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP,      // Reconnexion immédiate au retour du Wi-Fi
+                               mqtt_ip_event_handler, NULL);
 }
 /**
  * @brief Publie un message MQTT.
@@ -143,7 +282,7 @@ void mqtt_init(void)
  */
 void mqtt_publish(const char *topic, const char *payload)
 {
-    ESP_LOGI(TAG, "Publication MQTT : topic=%s payload=%s", topic, payload); // Log de la publication MQTT
+    ESP_LOGD(TAG, "Publication MQTT : topic=%s (%u octets)", topic, (unsigned)strlen(payload)); // Contenu jamais journalisé
 
     esp_mqtt_client_publish(client,   // Client MQTT actif
                             topic,    // Topic de destination
@@ -164,7 +303,7 @@ void mqtt_publish(const char *topic, const char *payload)
  */
 void mqtt_publish_config(const char *topic, const char *payload)
 {
-    ESP_LOGI(TAG, "Publication MQTT : topic=%s payload=%s", topic, payload); // Log de la publication MQTT
+    ESP_LOGD(TAG, "Publication MQTT : topic=%s (%u octets, retenu)", topic, (unsigned)strlen(payload)); // Contenu jamais journalisé
 
     esp_mqtt_client_publish(client,   // Client MQTT actif
                             topic,    // Topic de destination
@@ -172,4 +311,180 @@ void mqtt_publish_config(const char *topic, const char *payload)
                             0,        // Longueur auto-détectée
                             1,        // QoS 1 (au moins une fois)
                             1);       // Retain activé pour les messages de configuration
-    }
\ No newline at end of file
+    }
+
+/**
+ * @brief Publie le rapport JSON des statistiques du comptage sur energie/<DEVICE_NAME>/stats.
+ *
+ * Avec PULSE_STATS à 0, le rapport vaut {"enabled":false}. Appelée uniquement par la tâche
+ * mqtt_cmd (commande stats, ou energie/<DEVICE_NAME>/stats/get) : le buffer statique n'a qu'un écrivain.
+ */
+void mqtt_publish_stats(void)
+{
+    static char payload[PULSE_STATS_JSON_MAX]; // Hors pile : jusqu'à MAX_CHANNELS compteurs
+    pulse_stats_json(payload, sizeof(payload));
+    mqtt_publish(MQTT_STATS_TOPIC, payload);
+}
+
+/**
+ * @brief Publie le diagnostic de l'appareil sur energie/<DEVICE_NAME>/diag.
+ *
+ * QoS 0 : un message perdu est remplacé par le suivant, rien n'attend d'accusé.
+ */
+void mqtt_publish_diag(const char *json)
+{
+    esp_mqtt_client_publish(client, MQTT_DIAG_TOPIC, json, 0, 0, 0);
+}
+
+/**
+ * @brief Publie le rapport du banc de débit sur energie/<DEVICE_NAME>/selftest.
+ */
+void mqtt_publish_selftest(const char *report)
+{
+    mqtt_publish(MQTT_SELFTEST_TOPIC, report);
+}
+
+/**
+ * @brief Écrit l'énergie du compteur i en Wh à 3 décimales ("12345.678").
+ */
+static int format_wh(char *buf, size_t size, int i, uint64_t pulses)
+{
+    uint64_t mwh = counter_store_mwh(i, pulses);
+    return snprintf(buf, size, "%llu.%03u", (unsigned long long)(mwh / 1000), (unsigned)(mwh % 1000));
+}
+
+/**
+ * @brief Arrondit une puissance au watt (jamais négative).
+ */
+static uint32_t power_w(float w)
+{
+    return (w > 0) ? (uint32_t)lroundf(w) : 0;
+}
+
+/**
+ * @brief Publie les valeurs des compteurs selon le mode de publication configuré.
+ *
+ * - MQTT_BATCH_OFF  : un message texte par compteur sur energie/<nom>
+ * - MQTT_BATCH_JSON : un seul message JSON sur energie/<DEVICE_NAME>/state
+ * - MQTT_BATCH_CBOR : un seul message CBOR sur energie/<DEVICE_NAME>/state/cbor
+ *
+ * Les messages groupés portent l'heure Unix ("ts", 0 si l'horloge n'est pas à l'heure)
+ * et le temps depuis le démarrage en secondes ("up"). Pour chaque compteur N, ils
+ * contiennent l'énergie ("cN", Wh à 3 décimales), la puissance instantanée ("pN", W) et ses moyennes
+ * sur 1, 10 et 60 s ("pN_1", "pN_10", "pN_60"). En mode historique, la puissance
+ * instantanée est publiée sur energie/<nom>/power.
+ *
+ * Un message groupé contient toujours tous les compteurs (il ne coûte qu'une publication) ;
+ * en mode historique, seuls les compteurs du masque sont publiés.
+ * Les messages groupés sont les modèles préformatés de mqtt_payload dont seuls les
+ * chiffres sont réécrits (valeurs à largeur fixe). Ils ne sont modifiés que par cette
+ * fonction, appelée par task_mqtt seule.
+ *
+ * @param values Valeurs des compteurs actifs (channel_count) (copie cohérente de counter_store)
+ * @param power  Puissances calculées des compteurs actifs
+ * @param mask   Compteurs à publier (bit i = compteur i), fourni par l'ordonnanceur
+ */
+void mqtt_publish_counters(const uint64_t values[MAX_CHANNELS],
+                           const power_reading_t power[MAX_CHANNELS],
+                           uint32_t mask)
+{
+    time_t now = time(NULL); // Heure courante
+    uint32_t ts = (now >= MQTT_VALID_TIME) ? (uint32_t)now : 0; // Horodatage, 0 si inconnu
+    uint32_t up = (uint32_t)(esp_timer_get_time() / 1000000);  // Secondes depuis le démarrage
+
+    if (mqtt_batch_mode != MQTT_BATCH_OFF) // Un seul message groupé : réécriture des champs du modèle préformaté
+    {
+        mqtt_payload_state_set(MQTT_FIELD_TS, ts);
+        mqtt_payload_state_set(MQTT_FIELD_UP, up);
+        for (int i = 0; i < channel_count; i++)
+        {
+            mqtt_payload_state_set_energy(i, counter_store_mwh(i, values[i]));
+            mqtt_payload_state_set(MQTT_FIELD_CH(i, 1), power_w(power[i].instant_w));
+            mqtt_payload_state_set(MQTT_FIELD_CH(i, 2), power_w(power[i].avg_1s_w));
+            mqtt_payload_state_set(MQTT_FIELD_CH(i, 3), power_w(power[i].avg_10s_w));
+            mqtt_payload_state_set(MQTT_FIELD_CH(i, 4), power_w(power[i].avg_60s_w));
+        }
+
+        size_t len;
+        const char *payload = mqtt_payload_state(&len);
+        if (payload == NULL) return;           // Arène non allouée
+        ESP_LOGD(TAG, "Publication MQTT : topic=%s%s (%u octets)", MQTT_STATE_TOPIC,
+                 (mqtt_batch_mode == MQTT_BATCH_CBOR) ? "/cbor" : "", (unsigned)len);
+        esp_mqtt_client_publish(client,                    // Client MQTT actif
+                                (mqtt_batch_mode == MQTT_BATCH_CBOR) ? MQTT_STATE_TOPIC "/cbor" : MQTT_STATE_TOPIC,
+                                payload,                   // Modèle de l'arène, publié sans copie
+                                (int)len,                  // Longueur explicite (CBOR non terminé par 0)
+                                1,                         // QoS 1 (au moins une fois)
+                                0);                        // Retain désactivé
+    }
+    else // Mode historique : un message par compteur
+    {
+        char payload[32]; // Valeur du compteur en texte (ex: "12345.678")
+        for (int i = 0; i < channel_count; i++)
+        {
+            if (!(mask & (1UL << i))) continue; // Compteur non concerné par cette publication
+
+            format_wh(payload, sizeof(payload), i, values[i]); // Énergie du compteur i (Wh)
+            mqtt_publish(mqtt_payload_energy_topic(i), payload); // Topic préformaté energie/<nom>
+
+            snprintf(payload, sizeof(payload), "%lu", (unsigned long)power_w(power[i].instant_w)); // Puissance instantanée en W
+            mqtt_publish(mqtt_payload_power_topic(i), payload);
+        }
+    }
+}
+
+/**
+ * @brief Indique si le client est connecté au broker.
+ */
+bool mqtt_is_connected(void)
+{
+    return connected;
+}
+
+/**
+ * @brief Taille des messages QoS 1 en attente d'accusé dans le client MQTT.
+ */
+int mqtt_outbox_bytes(void)
+{
+    return client ? esp_mqtt_client_get_outbox_size(client) : 0;
+}
+
+/**
+ * @brief Publie un relevé de la file d'attente hors ligne.
+ *
+ * Le message {"seq":..,"ts":..,"up":..,"c0":..,...} part sur energie/<DEVICE_NAME>/backlog
+ * en QoS 1 : sa séquence permet au consommateur d'écarter un doublon (lot renvoyé).
+ *
+ * @param rec Relevé mis en attente
+ * @param seq Séquence du relevé dans la file
+ */
+void mqtt_publish_backlog(const outbox_record_t *rec, uint32_t seq)
+{
+    char payload[48 + MAX_CHANNELS * 32]; // {"seq":..,"ts":..,"up":..} + ,"cN":valeur par compteur
+    uint64_t values[MAX_CHANNELS];
+    outbox_record_values(rec, values);
+    int len = snprintf(payload, sizeof(payload), "{\"seq\":%lu,\"ts\":%lu,\"up\":%lu",
+                       (unsigned long)seq, (unsigned long)rec->ts, (unsigned long)rec->up);
+    for (int i = 0; i < rec->count && i < channel_count; i++)
+    {
+        len += snprintf(payload + len, sizeof(payload) - len, ",\"c%d\":", i);
+        len += format_wh(payload + len, sizeof(payload) - len, i, values[i]);
+    }
+    snprintf(payload + len, sizeof(payload) - len, "}");
+    mqtt_publish("energie/" DEVICE_NAME "/backlog", payload); // Publication QoS 1
+}
+
+/**
+ * @brief Publie le détail du démarrage sur "energie/<DEVICE_NAME>/boot" (retenu).
+ *
+ * Message {"reset":..,"flags":..,"app":..,"nvs":..,...} : raison du redémarrage,
+ * options du démarrage rapide (bit 0 = AP mémorisé, bit 1 = IP statique) et
+ * millisecondes écoulées à chaque étape (voir boot_timing.h).
+ */
+void mqtt_publish_boot_timing(void)
+{
+    char payload[192]; // Détail du démarrage en JSON
+    boot_timing_format(payload, sizeof(payload));
+    ESP_LOGI(TAG, "Démarrage : %s", payload);
+    mqtt_publish_config("energie/" DEVICE_NAME "/boot", payload); // QoS 1, retenu : consultable après coup
+}
@@ -1,6 +1,6 @@
 #ifndef MQTT_H
 #define MQTT_H
-#include "config.h" // Pour NB_COUNTERS et global_mode_config
+#include "config.h" // Pour channel_count, channels et global_mode_config
 /**
  * @file mqtt.h
  * @brief Header pour le module MQTT ESP32.
@@ -12,9 +12,13 @@
  * Usage typique :
  * 1. Appeler mqtt_init() après la connexion Wi-Fi
  * 2. Appeler mqtt_publish(topic, payload) pour envoyer des messages (ex: JSON)
+ * 3. Appeler mqtt_publish_counters(values, power, mask) quand l'ordonnanceur de publication le demande
  */
 
-extern char mqtt_names[NB_COUNTERS][32]; // tableau de noms pour MQTT
+#include <stdint.h> // Pour uint32_t
+#include <stdbool.h> // Pour bool
+#include "power_meter.h" // Pour power_reading_t
+#include "outbox.h"      // Pour outbox_record_t
 
 /**
  * @brief Initialise le client MQTT et démarre la connexion au broker.
@@ -45,4 +49,70 @@ void mqtt_publish(const char *topic, const char *payload); // Publication des va
  */
 void mqtt_publish_config(const char *topic, const char *payload); // Publication de la configuration MQTT (ex: noms des compteurs)   
 
+/**
+ * @brief Publie les valeurs des compteurs selon mqtt_batch_mode.
+ *
+ * @param values Valeurs des compteurs actifs (channel_count)
+ * @param power  Puissances calculées des compteurs actifs
+ * @param mask   Compteurs à publier (bit i = compteur i) ; les messages groupés contiennent toujours tous les compteurs
+ *
+ * - MQTT_BATCH_OFF  : un message par compteur sur "energie/<nom>"
+ * - MQTT_BATCH_JSON : un seul message {"ts":..,"up":..,"c0":..} sur "energie/<DEVICE_NAME>/state"
+ * - MQTT_BATCH_CBOR : le même contenu en CBOR sur "energie/<DEVICE_NAME>/state/cbor"
+ */
+void mqtt_publish_counters(const uint64_t values[MAX_CHANNELS],
+                           const power_reading_t power[MAX_CHANNELS],
+                           uint32_t mask);
+
+/**
+ * @brief Indique si le client est connecté au broker.
+ *
+ * @return true entre MQTT_EVENT_CONNECTED et MQTT_EVENT_DISCONNECTED
+ */
+bool mqtt_is_connected(void);
+
+/**
+ * @brief Taille des messages en attente d'accusé (PUBACK) dans le client MQTT.
+ *
+ * @return Nombre d'octets dans la file interne du client
+ */
+int mqtt_outbox_bytes(void);
+
+/**
+ * @brief Publie un relevé de la file d'attente hors ligne sur "energie/<DEVICE_NAME>/backlog".
+ *
+ * @param rec Relevé mis en attente
+ * @param seq Séquence du relevé, reprise dans le message pour l'élimination des doublons
+ */
+void mqtt_publish_backlog(const outbox_record_t *rec, uint32_t seq);
+
+/**
+ * @brief Publie les statistiques du comptage (pulse_stats_json) sur "energie/<DEVICE_NAME>/stats".
+ *
+ * Appelée par la tâche mqtt_cmd seulement (commande stats ; un message sur
+ * "energie/<DEVICE_NAME>/stats/get" y est transmis comme une commande stats).
+ */
+void mqtt_publish_stats(void);
+
+/**
+ * @brief Publie le message de diagnostic (diag.h) sur "energie/<DEVICE_NAME>/diag".
+ *
+ * @param json Message terminé par un zéro
+ */
+void mqtt_publish_diag(const char *json);
+
+/**
+ * @brief Publie le rapport JSON du banc de débit (selftest) sur "energie/<DEVICE_NAME>/selftest".
+ *
+ * @param report Rapport terminé par un zéro
+ */
+void mqtt_publish_selftest(const char *report);
+
+/**
+ * @brief Publie le détail du démarrage (boot_timing) sur "energie/<DEVICE_NAME>/boot".
+ *
+ * À appeler une fois, après la première publication des compteurs.
+ */
+void mqtt_publish_boot_timing(void);
+
 #endif // MQTT_H
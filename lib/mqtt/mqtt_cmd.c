@@ -0,0 +1,204 @@
+/**
+ * @file mqtt_cmd.c
+ * @brief File et tâche d'exécution des commandes MQTT.
+ *
+ * La file est un anneau de MQTT_CMD_QUEUE lignes : le gestionnaire d'événements MQTT
+ * (seul producteur) avance head, la tâche mqtt_cmd (seule consommatrice) avance tail.
+ * Aucune attente côté producteur : file pleine, la commande est ignorée.
+ *
+ * set n'écrit jamais la valeur absolue : l'écart avec la valeur courante est ajouté à la base
+ * par counter_store_adjust. Le comptage n'est jamais bloqué et une impulsion
+ * validée pendant la commande n'est pas perdue (elle s'ajoute à la valeur recalée).
+ * L'écart passe par history_adjust_counter pour ne pas être compté dans l'intervalle en cours.
+ */
+
+#include <stdatomic.h>              // Indices de l'anneau
+#include <stdio.h>                  // snprintf
+#include <stdlib.h>                 // strtoull
+#include <string.h>                 // memcpy, strcmp
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche et notifications
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "mqtt_cmd.h"               // Header du module
+#include "mqtt.h"                   // Réponses et rapport de statistiques
+#include "counter_store.h"          // Recalage sans verrou des compteurs
+#include "publish_sched.h"          // Publication immédiate, nouvelles règles
+#include "storage.h"                // Sauvegarde des compteurs et des règles
+#include "history.h"                // Recalage hors intervalles, requêtes de plage
+#include "ota.h"                    // Mise à jour du firmware
+
+static const char *TAG = "MQTT_CMD";       // Identifiant de log du module
+
+static char ring[MQTT_CMD_QUEUE][MQTT_CMD_MAX_LEN + 1]; // Commandes en attente, terminées par un zéro
+static _Atomic uint32_t head;                // Prochaine case écrite (producteur)
+static _Atomic uint32_t tail;                // Prochaine case lue (consommateur)
+static TaskHandle_t cmd_task;                // Tâche mqtt_cmd
+
+bool mqtt_cmd_post(const char *data, int len)
+{
+    uint32_t h = atomic_load_explicit(&head, memory_order_relaxed);
+    if (len <= 0 || len > MQTT_CMD_MAX_LEN ||
+        h - atomic_load_explicit(&tail, memory_order_acquire) >= MQTT_CMD_QUEUE) // Trop longue ou file pleine
+    {
+        ESP_LOGW(TAG, "Commande ignorée (%d octets)", len);
+        return false;
+    }
+    memcpy(ring[h % MQTT_CMD_QUEUE], data, len);
+    ring[h % MQTT_CMD_QUEUE][len] = '\0';
+    atomic_store_explicit(&head, h + 1, memory_order_release); // Case visible par la tâche
+    xTaskNotifyGive(cmd_task);
+    return true;
+}
+
+/**
+ * @brief Lit un entier décimal non signé.
+ *
+ * @return false si le mot est absent ou n'est pas un nombre
+ */
+static bool parse_u32(const char *word, uint32_t *out)
+{
+    char *end;
+    if (word == NULL || *word < '0' || *word > '9') return false;
+    unsigned long long v = strtoull(word, &end, 10);
+    if (*end != '\0' || v > UINT32_MAX) return false;
+    *out = (uint32_t)v;
+    return true;
+}
+
+/**
+ * @brief Lit un numéro de compteur actif.
+ */
+static bool parse_channel(const char *word, int *out)
+{
+    uint32_t idx;
+    if (!parse_u32(word, &idx) || idx >= channel_count) return false;
+    *out = (int)idx;
+    return true;
+}
+
+/**
+ * @brief set <n> <wh> : recale l'énergie d'un compteur.
+ */
+static const char *cmd_set(char **argv, int argc)
+{
+    int idx;
+    uint32_t wh;
+    if (argc != 3 || !parse_channel(argv[1], &idx) || !parse_u32(argv[2], &wh)) return "usage : set <n> <wh>";
+
+    uint32_t ppkwh = channels[idx].ppkwh ? channels[idx].ppkwh : PULSES_PER_KWH; // Constante du compteur
+    uint64_t pulses = (uint64_t)wh * ppkwh / 1000;
+    if (pulses > COUNTER_MAX) return "valeur hors limites";
+
+    history_adjust_counter(idx, pulses - counter_store_get(idx)); // Écart modulo 2^64 : exact, comptage jamais bloqué
+    storage_request_save();            // Nouvelle valeur dans le journal sans attendre le seuil
+    publish_sched_notify(idx);         // Publiée dès que l'intervalle minimal le permet
+    return NULL;
+}
+
+/**
+ * @brief rate <n|*> <min_s> <max_s> [delta [deadband_w]] : règles de publication.
+ */
+static const char *cmd_rate(char **argv, int argc)
+{
+    int first = 0, last = channel_count - 1;
+    publish_cfg_t rule;
+    if (argc < 4 || argc > 6) return "usage : rate <n|*> <min_s> <max_s> [delta [deadband_w]]";
+    if (strcmp(argv[1], "*") != 0)
+    {
+        if (!parse_channel(argv[1], &first)) return "compteur invalide";
+        last = first;
+    }
+    if (!parse_u32(argv[2], &rule.min_s) || !parse_u32(argv[3], &rule.max_s)) return "intervalle invalide";
+    if (rule.max_s > 0 && rule.min_s > rule.max_s) return "min_s > max_s";
+
+    for (int i = first; i <= last; i++)
+    {
+        rule.delta = publish_cfg[i].delta;           // Inchangés si absents
+        rule.deadband_w = publish_cfg[i].deadband_w;
+        if (argc > 4 && !parse_u32(argv[4], &rule.delta)) return "delta invalide";
+        if (argc > 5 && !parse_u32(argv[5], &rule.deadband_w)) return "deadband_w invalide";
+        publish_cfg[i] = rule;                       // Champs 32 bits : relus tels quels par l'ordonnanceur
+    }
+    storage_save_config();                           // Un seul blob, remplacé atomiquement
+    for (int i = first; i <= last; i++) publish_sched_notify(i); // Échéances recalculées
+    return NULL;
+}
+
+/**
+ * @brief history <1|15|60> <de> [<à>] : intervalles d'une plage (energie/<DEVICE_NAME>/history/range).
+ */
+static const char *cmd_history(char **argv, int argc)
+{
+    uint32_t res, from, to = UINT32_MAX;   // Sans fin : jusqu'au dernier intervalle
+    if (argc < 3 || argc > 4 || !parse_u32(argv[1], &res) || !parse_u32(argv[2], &from) ||
+        (argc > 3 && !parse_u32(argv[3], &to))) return "usage : history <1|15|60> <de> [<à>]";
+    return history_publish_range(res, from, to);
+}
+
+/**
+ * @brief ota <url> : télécharge et installe une nouvelle image (avancement sur energie/<DEVICE_NAME>/ota).
+ */
+static const char *cmd_ota(char **argv, int argc)
+{
+    if (argc != 2) return "usage : ota <url>";
+    return ota_start(argv[1]);
+}
+
+/**
+ * @brief Exécute une commande et publie la réponse.
+ */
+static void run_command(char *line)
+{
+    char reply[MQTT_CMD_MAX_LEN + 96];   // "ok <commande>" ou "err <commande> : <raison>"
+    char echo[MQTT_CMD_MAX_LEN + 1];
+    char *argv[8];
+    int argc = 0;
+    char *saveptr = NULL;
+
+    snprintf(echo, sizeof(echo), "%s", line);
+    for (char *w = strtok_r(line, " \t\r\n", &saveptr); w != NULL && argc < 8; w = strtok_r(NULL, " \t\r\n", &saveptr))
+    {
+        argv[argc++] = w;
+    }
+    if (argc == 0) return;
+
+    const char *err = NULL;
+    if (strcmp(argv[0], "read") == 0) publish_sched_request_all();
+    else if (strcmp(argv[0], "set") == 0) err = cmd_set(argv, argc);
+    else if (strcmp(argv[0], "rate") == 0) err = cmd_rate(argv, argc);
+    else if (strcmp(argv[0], "flush") == 0) storage_request_save();
+    else if (strcmp(argv[0], "stats") == 0) mqtt_publish_stats();
+    else if (strcmp(argv[0], "history") == 0) err = cmd_history(argv, argc);
+    else if (strcmp(argv[0], "ota") == 0) err = cmd_ota(argv, argc);
+    else err = "commande inconnue";
+
+    if (err == NULL) snprintf(reply, sizeof(reply), "ok %s", echo);
+    else snprintf(reply, sizeof(reply), "err %s : %s", echo, err);
+    ESP_LOGI(TAG, "%s", reply);
+    mqtt_publish(MQTT_CMD_ACK_TOPIC, reply);
+}
+
+/**
+ * @brief Tâche mqtt_cmd : exécute les commandes dans l'ordre de réception.
+ */
+static void mqtt_cmd_task(void *pv)
+{
+    char line[MQTT_CMD_MAX_LEN + 1];     // Copie de travail (découpée par strtok_r)
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t t = atomic_load_explicit(&tail, memory_order_relaxed);
+        while (t != atomic_load_explicit(&head, memory_order_acquire))
+        {
+            memcpy(line, ring[t % MQTT_CMD_QUEUE], sizeof(line));
+            atomic_store_explicit(&tail, ++t, memory_order_release); // Case libérée pour le producteur
+            run_command(line);
+        }
+    }
+}
+
+void mqtt_cmd_init(void)
+{
+    xTaskCreatePinnedToCore(mqtt_cmd_task, "mqtt_cmd", 3072, NULL, MQTT_CMD_PRIORITY, &cmd_task, CORE_NET);
+}
@@ -0,0 +1,46 @@
+#ifndef MQTT_CMD_H
+#define MQTT_CMD_H
+
+/**
+ * @file mqtt_cmd.h
+ * @brief Commandes à distance reçues sur energie/<DEVICE_NAME>/cmd.
+ *
+ * Protocole texte, une commande par message, mots séparés par des espaces :
+ * - read                                  : publication immédiate de tous les compteurs
+ * - set <n> <wh>                          : recale l'énergie du compteur n (Wh)
+ * - rate <n|*> <min_s> <max_s> [delta [deadband_w]] : règles de publication (enregistrées)
+ * - flush                                 : sauvegarde immédiate des compteurs dans le journal
+ * - stats                                 : rapport des statistiques du comptage (energie/<DEVICE_NAME>/stats)
+ * - history <1|15|60> <de> [<à>]          : intervalles d'énergie d'une plage (energie/<DEVICE_NAME>/history/range)
+ * - ota <url>                             : mise à jour du firmware en HTTPS (energie/<DEVICE_NAME>/ota)
+ *
+ * Chaque commande reçoit une réponse sur energie/<DEVICE_NAME>/cmd/ack :
+ * "ok <commande>" ou "err <commande> : <raison>".
+ *
+ * Le gestionnaire d'événements MQTT ne fait que copier la commande dans une file sans
+ * verrou (un producteur, un consommateur) : l'exécution a lieu dans la tâche mqtt_cmd.
+ */
+
+#include <stdbool.h>    // Pour bool
+#include "config.h"     // Pour DEVICE_NAME
+
+#define MQTT_CMD_TOPIC     "energie/" DEVICE_NAME "/cmd"  // Topic des commandes (abonnement QoS 1)
+#define MQTT_CMD_ACK_TOPIC MQTT_CMD_TOPIC "/ack"          // Topic des réponses
+
+/**
+ * @brief Crée la tâche d'exécution des commandes.
+ *
+ * Appelée par mqtt_init(), avant le démarrage du client.
+ */
+void mqtt_cmd_init(void);
+
+/**
+ * @brief Met une commande en file (appelée depuis le gestionnaire d'événements MQTT).
+ *
+ * @param data Contenu du message (non terminé par un zéro)
+ * @param len  Longueur du contenu
+ * @return false si la commande est trop longue ou si la file est pleine (commande ignorée)
+ */
+bool mqtt_cmd_post(const char *data, int len);
+
+#endif // MQTT_CMD_H
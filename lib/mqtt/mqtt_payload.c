@@ -0,0 +1,414 @@
+/**
+ * @file mqtt_payload.c
+ * @brief Arène des topics, documents de découverte et modèles d'état MQTT.
+ *
+ * La construction passe deux fois sur la même séquence d'écritures : la première ne fait
+ * que mesurer (arène sans buffer), la seconde écrit dans un bloc alloué à la taille exacte.
+ * Les entrées sont repérées par leur position dans l'arène.
+ */
+
+#include <stdarg.h>                 // va_list
+#include <stdbool.h>                // bool
+#include <stdio.h>                  // vsnprintf
+#include <stdlib.h>                 // malloc, free
+#include <string.h>                 // memcpy, strlen
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "esp_rom_crc.h"            // CRC32 de l'empreinte de découverte
+#include "mqtt_payload.h"           // Header du module
+
+#define JSON_WIDTH_U32   10         // Largeur d'un champ JSON 32 bits (4294967295)
+#define JSON_WIDTH_POWER 7          // Largeur d'un champ JSON de puissance (W), plafonné à 9999999
+#define JSON_WIDTH_ENERGY 14        // Largeur d'un champ JSON d'énergie (Wh à 3 décimales), plafonné à 9999999999.999
+#define JSON_ENERGY_MAX  9999999999999ULL // Plafond d'un champ d'énergie (mWh)
+#define CBOR_WIDTH       4          // Octets d'un entier CBOR (argument sur 4 octets, type 0 + 26)
+#define CBOR_WIDTH_ENERGY 8         // Octets de la mantisse d'une énergie CBOR (argument sur 8 octets, type 0 + 27)
+
+static const char *TAG = "MQTT_PAYLOAD";   // Identifiant de log du module
+
+/**
+ * @brief Arène en construction (base NULL : passe de mesure).
+ */
+typedef struct {
+    char *base;
+    size_t len;
+    size_t cap;
+} arena_t;
+
+/**
+ * @brief Positions des entrées d'un compteur dans l'arène.
+ */
+typedef struct {
+    uint32_t energy_topic;      // energie/<nom>
+    uint32_t power_topic;       // energie/<nom>/power
+    uint32_t disc_topic[2];     // homeassistant/sensor/energie/<nom>[_power]/config
+    uint32_t disc_doc[2];       // Documents JSON correspondants
+    uint32_t disc_len[2];       // Longueur des documents
+} chan_entries_t;
+
+/**
+ * @brief Capteur Home Assistant lu dans le message de diagnostic.
+ */
+typedef struct {
+    const char *key;            // Clé du message (value_json.<key>)
+    const char *unit;
+    const char *dev_class;      // NULL : aucune
+} diag_sensor_t;
+
+static const diag_sensor_t diag_sensors[] = {
+    { "heap",     "B",   "data_size" },         // Tas libre
+    { "heap_min", "B",   "data_size" },         // Minimum du tas libre depuis le démarrage
+    { "heap_blk", "B",   "data_size" },         // Plus grand bloc allouable
+    { "rssi",     "dBm", "signal_strength" },   // Niveau du point d'accès
+    { "up",       "s",   "duration" },          // Temps depuis le démarrage
+    { "load0",    "%",   NULL },                // Charge du cœur 0
+    { "load1",    "%",   NULL },                // Charge du cœur 1
+};
+#define DIAG_SENSORS (int)(sizeof(diag_sensors) / sizeof(diag_sensors[0]))
+
+static char *arena;                             // Bloc unique, alloué par mqtt_payload_build
+static chan_entries_t entries[MAX_CHANNELS];    // Entrées des compteurs actifs
+static uint32_t state_off, state_len;           // Modèle d'état groupé (mode JSON ou CBOR)
+static uint32_t field_off[2 + MQTT_FIELDS_PER_CH * MAX_CHANNELS]; // Position de chaque champ dans le modèle
+static uint8_t field_width[2 + MQTT_FIELDS_PER_CH * MAX_CHANNELS]; // Largeur de chaque champ
+static uint32_t diag_topic[DIAG_SENSORS], diag_doc[DIAG_SENSORS], diag_len[DIAG_SENSORS]; // Découverte du diagnostic
+static uint8_t state_mode;                      // mqtt_batch_mode au moment de la construction
+static int discovery_count;                     // Documents de découverte
+static uint32_t discovery_hash;                 // Empreinte des documents et du broker
+
+/**
+ * @brief Ajoute du texte formaté ; le zéro final n'est conservé que par arena_end().
+ *
+ * @return Position du texte dans l'arène
+ */
+static uint32_t arena_printf(arena_t *a, const char *fmt, ...)
+{
+    uint32_t off = (uint32_t)a->len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(a->base ? a->base + a->len : NULL, a->base ? a->cap - a->len : 0, fmt, ap);
+    va_end(ap);
+    if (n > 0) a->len += (size_t)n;
+    return off;
+}
+
+/**
+ * @brief Ajoute des octets bruts (modèle CBOR).
+ */
+static uint32_t arena_put(arena_t *a, const void *data, size_t len)
+{
+    uint32_t off = (uint32_t)a->len;
+    if (a->base) memcpy(a->base + a->len, data, len);
+    a->len += len;
+    return off;
+}
+
+/**
+ * @brief Termine l'entrée en cours par un zéro.
+ */
+static void arena_end(arena_t *a)
+{
+    if (a->base) a->base[a->len] = '\0';
+    a->len++;
+}
+
+/**
+ * @brief Écrit un document de découverte Home Assistant.
+ *
+ * Tous les capteurs d'un compteur partagent le même appareil (identifiers) ;
+ * l'identifiant unique du capteur d'énergie reste celui des versions précédentes.
+ */
+static void put_discovery(arena_t *a, int i, int sensor)
+{
+    static const char *const suffix[2] = { "", "_power" };
+    static const char *const unit[2] = { "Wh", "W" };
+    static const char *const dev_class[2] = { "energy", "power" };
+    static const char *const state_class[2] = { "total_increasing", "measurement" };
+    static const char *const field[2] = { "c", "p" };
+    const char *name = channels[i].name;
+    chan_entries_t *e = &entries[i];
+
+    e->disc_topic[sensor] = arena_printf(a, "homeassistant/sensor/energie/%s%s/config", name, suffix[sensor]);
+    arena_end(a);
+
+    e->disc_doc[sensor] = arena_printf(a, "{\"name\":\"%s%s\",", name, suffix[sensor]);
+    if (mqtt_batch_mode == MQTT_BATCH_JSON) // Lecture dans le message groupé
+    {
+        arena_printf(a, "\"state_topic\":\"" MQTT_STATE_TOPIC "\",\"value_template\":\"{{ value_json.%s%d }}\",",
+                     field[sensor], i);
+    }
+    else // Un topic par compteur
+    {
+        arena_printf(a, "\"state_topic\":\"energie/%s%s\",", name, sensor ? "/power" : "");
+    }
+    arena_printf(a,
+        "\"unit_of_measurement\":\"%s\",\"device_class\":\"%s\",\"state_class\":\"%s\","
+        "\"unique_id\":\"%s_%s%s\","
+        "\"device\":{\"identifiers\":[\"%s_%s\"],\"name\":\"%s_%s\",\"manufacturer\":\"DIY\",\"model\":\"ESP32 Energy\"}}",
+        unit[sensor], dev_class[sensor], state_class[sensor],
+        DEVICE_NAME, name, suffix[sensor],
+        DEVICE_NAME, name,
+        DEVICE_NAME, name);
+    e->disc_len[sensor] = (uint32_t)a->len - e->disc_doc[sensor];
+    arena_end(a);
+}
+
+/**
+ * @brief Écrit le document de découverte du capteur de diagnostic s.
+ *
+ * Les capteurs de diagnostic sont rattachés à l'appareil <DEVICE_NAME> lui-même,
+ * rangés par Home Assistant dans la catégorie « diagnostic ».
+ */
+static void put_diag_discovery(arena_t *a, int s)
+{
+    const diag_sensor_t *d = &diag_sensors[s];
+
+    diag_topic[s] = arena_printf(a, "homeassistant/sensor/energie/" DEVICE_NAME "_%s/config", d->key);
+    arena_end(a);
+
+    diag_doc[s] = arena_printf(a,
+        "{\"name\":\"" DEVICE_NAME " %s\",\"state_topic\":\"" MQTT_DIAG_TOPIC "\","
+        "\"value_template\":\"{{ value_json.%s }}\",\"unit_of_measurement\":\"%s\",",
+        d->key, d->key, d->unit);
+    if (d->dev_class) arena_printf(a, "\"device_class\":\"%s\",", d->dev_class);
+    arena_printf(a,
+        "\"state_class\":\"measurement\",\"entity_category\":\"diagnostic\","
+        "\"unique_id\":\"" DEVICE_NAME "_diag_%s\","
+        "\"device\":{\"identifiers\":[\"" DEVICE_NAME "\"],\"name\":\"" DEVICE_NAME "\","
+        "\"manufacturer\":\"DIY\",\"model\":\"ESP32 Energy\"}}",
+        d->key);
+    diag_len[s] = (uint32_t)a->len - diag_doc[s];
+    arena_end(a);
+}
+
+/**
+ * @brief Écrit l'en-tête d'un élément CBOR (type majeur + argument sur 1 octet au plus).
+ */
+static void put_cbor_head(arena_t *a, uint8_t major, size_t val)
+{
+    uint8_t head[2] = { (uint8_t)(major << 5), 0 };
+    if (val < 24)
+    {
+        head[0] |= (uint8_t)val;
+        arena_put(a, head, 1);
+    }
+    else                                    // Au plus 2 + 5 * MAX_CHANNELS paires : tient sur 1 octet
+    {
+        head[0] |= 24;
+        head[1] = (uint8_t)val;
+        arena_put(a, head, 2);
+    }
+}
+
+/**
+ * @brief Indique si le champ est l'énergie d'un compteur (cN).
+ */
+static bool is_energy_field(int field)
+{
+    return field > MQTT_FIELD_UP && (field - 2) % MQTT_FIELDS_PER_CH == 0;
+}
+
+/**
+ * @brief Écrit un champ du modèle d'état : clé puis valeur nulle de largeur fixe.
+ *
+ * En CBOR, l'énergie est une fraction décimale (tag 4, RFC 8949 §3.4.4) : [-3, mWh], soit des Wh
+ * à 3 décimales, dont seule la mantisse sur 8 octets est réécrite.
+ */
+static void put_field(arena_t *a, int field, const char *fmt, ...)
+{
+    char key[8];                            // Clé du champ (ex : "p12_60")
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(key, sizeof(key), fmt, ap);
+    va_end(ap);
+
+    if (state_mode == MQTT_BATCH_JSON)
+    {
+        uint8_t width = is_energy_field(field) ? JSON_WIDTH_ENERGY : (field <= MQTT_FIELD_UP) ? JSON_WIDTH_U32 : JSON_WIDTH_POWER;
+        arena_printf(a, "%s\"%s\":", (field == MQTT_FIELD_TS) ? "{" : ",", key);
+        field_off[field] = arena_printf(a, "%*s", width, is_energy_field(field) ? "0.000" : "0") - state_off;
+        field_width[field] = width;
+    }
+    else if (is_energy_field(field))
+    {
+        static const uint8_t zero[4 + CBOR_WIDTH_ENERGY] = { 0xC4, 0x82, 0x22, 27 }; // Tag 4, [-3, entier sur 8 octets]
+        put_cbor_head(a, 3, strlen(key));
+        arena_put(a, key, strlen(key));
+        field_off[field] = arena_put(a, zero, sizeof(zero)) + 4 - state_off;
+        field_width[field] = CBOR_WIDTH_ENERGY;
+    }
+    else
+    {
+        static const uint8_t zero[1 + CBOR_WIDTH] = { 26 };   // Type 0, argument sur 4 octets
+        put_cbor_head(a, 3, strlen(key));
+        arena_put(a, key, strlen(key));
+        field_off[field] = arena_put(a, zero, sizeof(zero)) + 1 - state_off;
+        field_width[field] = CBOR_WIDTH;
+    }
+}
+
+/**
+ * @brief Écrit toutes les entrées ; appelée une fois pour mesurer, une fois pour écrire.
+ */
+static void build(arena_t *a)
+{
+    for (int i = 0; i < channel_count; i++)
+    {
+        entries[i].energy_topic = arena_printf(a, "energie/%s", channels[i].name);
+        arena_end(a);
+        entries[i].power_topic = arena_printf(a, "energie/%s/power", channels[i].name);
+        arena_end(a);
+        if (discovery_count > 0)
+        {
+            put_discovery(a, i, 0);         // Énergie
+            put_discovery(a, i, 1);         // Puissance instantanée
+        }
+    }
+    if (discovery_count > 2 * channel_count) // Capteurs de diagnostic
+    {
+        for (int s = 0; s < DIAG_SENSORS; s++) put_diag_discovery(a, s);
+    }
+
+    if (state_mode == MQTT_BATCH_OFF) return;
+
+    state_off = (uint32_t)a->len;
+    if (state_mode == MQTT_BATCH_CBOR) put_cbor_head(a, 5, 2 + MQTT_FIELDS_PER_CH * channel_count);
+    put_field(a, MQTT_FIELD_TS, "ts");
+    put_field(a, MQTT_FIELD_UP, "up");
+    for (int i = 0; i < channel_count; i++)
+    {
+        put_field(a, MQTT_FIELD_CH(i, 0), "c%d", i);
+        put_field(a, MQTT_FIELD_CH(i, 1), "p%d", i);
+        put_field(a, MQTT_FIELD_CH(i, 2), "p%d_1", i);
+        put_field(a, MQTT_FIELD_CH(i, 3), "p%d_10", i);
+        put_field(a, MQTT_FIELD_CH(i, 4), "p%d_60", i);
+    }
+    if (state_mode == MQTT_BATCH_JSON) arena_printf(a, "}");
+    state_len = (uint32_t)a->len - state_off;
+    if (state_mode == MQTT_BATCH_JSON) arena_end(a);
+}
+
+void mqtt_payload_build(void)
+{
+    state_mode = mqtt_batch_mode;
+    discovery_count = (mqtt_batch_mode == MQTT_BATCH_CBOR) ? 0 : 2 * channel_count; // CBOR : pas de découverte
+    if (discovery_count > 0 && DIAG_PERIOD_S > 0) discovery_count += DIAG_SENSORS;
+
+    arena_t a = { NULL, 0, 0 };
+    build(&a);                              // Passe de mesure
+
+    free(arena);
+    arena = malloc(a.len + 1);              // +1 : zéro de vsnprintf après une entrée binaire finale
+    if (arena == NULL)
+    {
+        ESP_LOGE(TAG, "Arène MQTT : %u octets indisponibles", (unsigned)a.len);
+        return;
+    }
+    a = (arena_t){ arena, 0, a.len + 1 };
+    build(&a);
+
+    discovery_hash = esp_rom_crc32_le(0, (const uint8_t *)mqtt_Server, strlen(mqtt_Server)); // Autre broker : documents à publier
+    discovery_hash = esp_rom_crc32_le(discovery_hash, (const uint8_t *)mqtt_port, strlen(mqtt_port));
+    for (int k = 0; k < discovery_count; k++)
+    {
+        const char *topic;
+        size_t len;
+        const char *doc = mqtt_payload_discovery(k, &topic, &len);
+        discovery_hash = esp_rom_crc32_le(discovery_hash, (const uint8_t *)topic, strlen(topic));
+        discovery_hash = esp_rom_crc32_le(discovery_hash, (const uint8_t *)doc, len);
+    }
+
+    ESP_LOGI(TAG, "Arène MQTT : %u octets (%d documents de découverte, message d'état %u octets)",
+             (unsigned)a.len, discovery_count, (unsigned)state_len);
+}
+
+const char *mqtt_payload_energy_topic(int i)
+{
+    return arena + entries[i].energy_topic;
+}
+
+const char *mqtt_payload_power_topic(int i)
+{
+    return arena + entries[i].power_topic;
+}
+
+int mqtt_payload_discovery_count(void)
+{
+    return arena ? discovery_count : 0;
+}
+
+const char *mqtt_payload_discovery(int k, const char **topic, size_t *len)
+{
+    if (k >= 2 * channel_count)             // Capteurs de diagnostic
+    {
+        k -= 2 * channel_count;
+        *topic = arena + diag_topic[k];
+        *len = diag_len[k];
+        return arena + diag_doc[k];
+    }
+    const chan_entries_t *e = &entries[k / 2];
+    *topic = arena + e->disc_topic[k % 2];
+    *len = e->disc_len[k % 2];
+    return arena + e->disc_doc[k % 2];
+}
+
+uint32_t mqtt_payload_discovery_hash(void)
+{
+    return discovery_hash;
+}
+
+void mqtt_payload_state_set(int field, uint32_t value)
+{
+    if (arena == NULL || state_mode == MQTT_BATCH_OFF) return;
+    char *p = arena + state_off + field_off[field];
+
+    if (state_mode == MQTT_BATCH_CBOR)      // Entier gros-boutiste sur 4 octets
+    {
+        for (int s = 0; s < CBOR_WIDTH; s++) p[s] = (char)(value >> (8 * (CBOR_WIDTH - 1 - s)));
+        return;
+    }
+
+    int width = field_width[field];
+    if (width == JSON_WIDTH_POWER && value > 9999999) value = 9999999; // Plafond du champ
+    char *q = p + width;
+    do                                      // Chiffres cadrés à droite
+    {
+        *--q = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (q > p) *--q = ' ';               // Complété par des espaces
+}
+
+void mqtt_payload_state_set_energy(int i, uint64_t mwh)
+{
+    if (arena == NULL || state_mode == MQTT_BATCH_OFF) return;
+    int field = MQTT_FIELD_CH(i, 0);
+    char *p = arena + state_off + field_off[field];
+
+    if (state_mode == MQTT_BATCH_CBOR)      // Mantisse gros-boutiste sur 8 octets
+    {
+        for (int s = 0; s < CBOR_WIDTH_ENERGY; s++) p[s] = (char)(mwh >> (8 * (CBOR_WIDTH_ENERGY - 1 - s)));
+        return;
+    }
+
+    if (mwh > JSON_ENERGY_MAX) mwh = JSON_ENERGY_MAX; // Plafond du champ
+    char *q = p + JSON_WIDTH_ENERGY;
+    for (int d = 0; d < 3; d++)             // Décimales
+    {
+        *--q = (char)('0' + mwh % 10);
+        mwh /= 10;
+    }
+    *--q = '.';
+    do                                      // Wh entiers, cadrés à droite
+    {
+        *--q = (char)('0' + mwh % 10);
+        mwh /= 10;
+    } while (mwh != 0);
+    while (q > p) *--q = ' ';               // Complété par des espaces
+}
+
+const char *mqtt_payload_state(size_t *len)
+{
+    if (arena == NULL || state_mode == MQTT_BATCH_OFF) return NULL;
+    *len = state_len;
+    return arena + state_off;
+}
@@ -0,0 +1,101 @@
+#ifndef MQTT_PAYLOAD_H
+#define MQTT_PAYLOAD_H
+
+/**
+ * @file mqtt_payload.h
+ * @brief Topics et documents MQTT préformatés, construits une fois par configuration.
+ *
+ * mqtt_payload_build() écrit dans une arène unique, allouée à la taille exacte :
+ * - les topics energie/<nom> et energie/<nom>/power de chaque compteur (mode historique)
+ * - les topics et documents de découverte Home Assistant (sauf en mode CBOR), y compris
+ *   les capteurs de diagnostic de l'appareil (DIAG_PERIOD_S)
+ * - le modèle du message d'état groupé (JSON ou CBOR selon mqtt_batch_mode)
+ *
+ * Dans le modèle d'état, chaque valeur occupe un champ de largeur fixe à une position
+ * connue : une publication ne fait que réécrire les chiffres (mqtt_payload_state_set),
+ * sans formatage ni copie. En JSON, les valeurs sont cadrées à droite et complétées par
+ * des espaces (blancs autorisés par la grammaire JSON) ; en CBOR, chaque entier est
+ * encodé sur 4 octets (forme non minimale, valide selon la RFC 8949). L'énergie est en Wh
+ * à 3 décimales : nombre à virgule fixe en JSON, fraction décimale (tag 4) en CBOR.
+ *
+ * La configuration (table des compteurs, mode de publication) ne change qu'au
+ * redémarrage : l'arène est construite par mqtt_init() et n'est réallouée que si
+ * mqtt_payload_build() est rappelée.
+ */
+
+#include <stddef.h>     // Pour size_t
+#include <stdint.h>     // Pour uint32_t, uint64_t
+#include "config.h"     // Pour DEVICE_NAME, MAX_CHANNELS
+
+#define MQTT_STATE_TOPIC "energie/" DEVICE_NAME "/state" // Topic des messages groupés
+#define MQTT_DIAG_TOPIC  "energie/" DEVICE_NAME "/diag"  // Topic du message de diagnostic (diag.h)
+
+#define MQTT_FIELD_TS       0   // Heure Unix du message groupé
+#define MQTT_FIELD_UP       1   // Secondes depuis le démarrage
+#define MQTT_FIELDS_PER_CH  5   // cN, pN, pN_1, pN_10, pN_60
+#define MQTT_FIELD_CH(i, k) (2 + MQTT_FIELDS_PER_CH * (i) + (k)) // Champ k (0 = énergie, 1..4 = puissances) du compteur i
+
+/**
+ * @brief Construit l'arène à partir de la table des compteurs et de mqtt_batch_mode.
+ */
+void mqtt_payload_build(void);
+
+/**
+ * @brief Topic d'énergie du compteur i ("energie/<nom>").
+ */
+const char *mqtt_payload_energy_topic(int i);
+
+/**
+ * @brief Topic de puissance du compteur i ("energie/<nom>/power").
+ */
+const char *mqtt_payload_power_topic(int i);
+
+/**
+ * @brief Nombre de documents de découverte (0 en mode CBOR, 2 par compteur sinon,
+ *        plus les capteurs de diagnostic si DIAG_PERIOD_S est non nul).
+ */
+int mqtt_payload_discovery_count(void);
+
+/**
+ * @brief Document de découverte k (compteur k / 2, énergie puis puissance,
+ *        puis capteurs de diagnostic à partir de k = 2 * channel_count).
+ *
+ * @param k     Indice du document
+ * @param topic Topic homeassistant/sensor/... (sortie)
+ * @param len   Longueur du document (sortie)
+ * @return Document JSON
+ */
+const char *mqtt_payload_discovery(int k, const char **topic, size_t *len);
+
+/**
+ * @brief Empreinte (CRC32) de tous les documents de découverte et du broker.
+ *
+ * Tant qu'elle ne change pas, les documents déjà retenus par le broker sont à jour.
+ */
+uint32_t mqtt_payload_discovery_hash(void);
+
+/**
+ * @brief Réécrit la valeur d'un champ du modèle d'état.
+ *
+ * @param field MQTT_FIELD_TS, MQTT_FIELD_UP ou MQTT_FIELD_CH(i, k) avec k de 1 à 4 (puissances)
+ * @param value Valeur (plafonnée à la largeur du champ)
+ */
+void mqtt_payload_state_set(int field, uint32_t value);
+
+/**
+ * @brief Réécrit l'énergie du compteur i (champ MQTT_FIELD_CH(i, 0)) dans le modèle d'état.
+ *
+ * @param i   Index du compteur
+ * @param mwh Énergie en mWh (counter_store_mwh), publiée en Wh à 3 décimales
+ */
+void mqtt_payload_state_set_energy(int i, uint64_t mwh);
+
+/**
+ * @brief Message d'état groupé, prêt à publier.
+ *
+ * @param len Longueur du message (sortie)
+ * @return Contenu (non terminé par un zéro en CBOR), NULL en mode historique
+ */
+const char *mqtt_payload_state(size_t *len);
+
+#endif // MQTT_PAYLOAD_H
@@ -0,0 +1,232 @@
+/**
+ * @file ota.c
+ * @brief Téléchargement HTTPS vers la partition OTA inactive et validation de l'image au démarrage.
+ *
+ * esp_https_ota_perform() lit un bloc de OTA_BUFFER_SIZE octets et l'écrit aussitôt dans la
+ * partition ; les secteurs sont effacés au fil de l'écriture (bulk_flash_erase à false), comme
+ * pour le journal : aucune pause de plusieurs secondes pour effacer toute la partition d'un coup.
+ * Pendant chaque programmation flash, seules les interruptions en IRAM sont servies : celles
+ * du comptage le sont (ESP_INTR_FLAG_IRAM), les impulsions sont au pire validées un peu plus tard.
+ *
+ * Seules les URL commençant par OTA_URL_PREFIX sont acceptées : un client du broker peut
+ * déclencher une mise à jour, mais uniquement depuis le serveur choisi à la compilation.
+ *
+ * Le bootloader (CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE) démarre une nouvelle image dans l'état
+ * ESP_OTA_IMG_PENDING_VERIFY. Tout redémarrage avant esp_ota_mark_app_valid_cancel_rollback(),
+ * panic et redémarrage par le superviseur des tâches compris, revient à l'image précédente.
+ * OTA_HEALTH_MIN_S couvre une période de battement plus WDT_TIMEOUT_S : une tâche bloquée dans
+ * la nouvelle image a fait redémarrer l'appareil avant la validation.
+ */
+
+#include "config.h"                 // OTA_*
+#include "ota.h"                    // Header du module
+
+#if OTA_ENABLE
+
+#include <stdatomic.h>              // Téléchargement en cours, image à valider
+#include <stdbool.h>                // bool
+#include <stdio.h>                  // snprintf
+#include <string.h>                 // strcmp, strlen
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâches de téléchargement et de validation
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "esp_timer.h"              // Temps depuis le démarrage
+#include "esp_system.h"             // esp_restart
+#include "esp_app_desc.h"           // Version de l'image courante
+#include "esp_ota_ops.h"            // État des images, validation et retour arrière
+#include "esp_https_ota.h"          // Téléchargement et écriture de l'image
+#include "esp_crt_bundle.h"         // Certificats racine du serveur
+#include "counter_store.h"          // Copie des compteurs avant le redémarrage
+#include "storage.h"                // Sauvegarde des compteurs dans le journal
+#include "mqtt.h"                   // Avancement sur OTA_TOPIC
+
+#define OTA_LOG_STEP        (64 * 1024) // Avancement journalisé tous les 64 Ko
+#define OTA_REBOOT_DELAY_MS 1000        // Délai laissé au message "reboot" avant le redémarrage
+
+static const char *TAG = "OTA";            // Identifiant de log du module
+
+static atomic_bool busy;                   // Téléchargement en cours
+static atomic_bool pending;                // Image courante pas encore validée
+static char ota_url[OTA_URL_MAX + 1];      // URL du téléchargement en cours
+
+/**
+ * @brief Sauvegarde les compteurs avant un redémarrage volontaire.
+ */
+static void save_counters(void)
+{
+    uint64_t values[MAX_CHANNELS];
+    counter_store_snapshot(values);
+    storage_save_counters(values);
+}
+
+/**
+ * @brief Publie l'avancement sur OTA_TOPIC (QoS 1).
+ */
+static void publish_state(const char *state, const char *key, const char *value)
+{
+    char msg[160];
+    snprintf(msg, sizeof(msg), "{\"state\":\"%s\",\"%s\":\"%s\"}", state, key, value);
+    ESP_LOGI(TAG, "%s", msg);
+    if (mqtt_is_connected()) mqtt_publish(OTA_TOPIC, msg);
+}
+
+/**
+ * @brief Tâche de téléchargement : écrit l'image dans la partition inactive puis redémarre dessus.
+ */
+static void task_ota(void *pv)
+{
+    esp_http_client_config_t http = {
+        .url = ota_url,
+        .crt_bundle_attach = esp_crt_bundle_attach,  // Serveur authentifié par le bundle ESP-IDF
+        .timeout_ms = OTA_HTTP_TIMEOUT_MS,
+        .buffer_size = OTA_BUFFER_SIZE,              // Bloc reçu puis écrit à chaque tour
+        .keep_alive_enable = true,
+    };
+    esp_https_ota_config_t cfg = {
+        .http_config = &http,
+        .bulk_flash_erase = false,                   // Un secteur effacé à la fois, au fil de l'écriture
+    };
+    esp_https_ota_handle_t handle = NULL;
+    esp_app_desc_t desc;
+    char msg[160];
+
+    ESP_LOGI(TAG, "Téléchargement de %s", ota_url);
+    esp_err_t err = esp_https_ota_begin(&cfg, &handle);
+    if (err == ESP_OK) err = esp_https_ota_get_img_desc(handle, &desc); // En-tête de l'image reçu
+    if (err == ESP_OK && strcmp(desc.project_name, esp_app_get_description()->project_name) != 0)
+    {
+        ESP_LOGE(TAG, "Image du projet %s refusée", desc.project_name);
+        err = ESP_ERR_INVALID_VERSION;
+    }
+    if (err == ESP_OK)
+    {
+        int size = esp_https_ota_get_image_size(handle); // -1 si le serveur ne l'annonce pas
+        snprintf(msg, sizeof(msg), "{\"state\":\"download\",\"version\":\"%s\",\"size\":%d}", desc.version, size);
+        ESP_LOGI(TAG, "%s", msg);
+        if (mqtt_is_connected()) mqtt_publish(OTA_TOPIC, msg);
+
+        int next_log = OTA_LOG_STEP;
+        while ((err = esp_https_ota_perform(handle)) == ESP_ERR_HTTPS_OTA_IN_PROGRESS) // Un bloc par tour
+        {
+            int read = esp_https_ota_get_image_len_read(handle);
+            if (read >= next_log)
+            {
+                ESP_LOGI(TAG, "%d / %d octets", read, size);
+                next_log = read + OTA_LOG_STEP;
+            }
+        }
+        if (err == ESP_OK && !esp_https_ota_is_complete_data_received(handle)) err = ESP_ERR_INVALID_SIZE; // Connexion coupée
+    }
+
+    int bytes = handle ? esp_https_ota_get_image_len_read(handle) : 0;
+    if (handle != NULL)
+    {
+        if (err == ESP_OK) err = esp_https_ota_finish(handle); // Vérifie l'image et la choisit au prochain démarrage
+        else esp_https_ota_abort(handle);
+    }
+    if (err != ESP_OK)
+    {
+        publish_state("error", "err", esp_err_to_name(err));
+        atomic_store(&busy, false);
+        vTaskDelete(NULL);
+    }
+
+    snprintf(msg, sizeof(msg), "{\"state\":\"reboot\",\"version\":\"%s\",\"bytes\":%d}", desc.version, bytes);
+    ESP_LOGI(TAG, "%s", msg);
+    if (mqtt_is_connected()) mqtt_publish(OTA_TOPIC, msg);
+    save_counters();                                 // Aucune impulsion perdue au redémarrage
+    vTaskDelay(pdMS_TO_TICKS(OTA_REBOOT_DELAY_MS));
+    esp_restart();
+}
+
+/**
+ * @brief Tâche de validation : valide l'image courante ou revient à la précédente.
+ */
+static void task_ota_health(void *pv)
+{
+    const char *version = esp_app_get_description()->version;
+
+    while (esp_timer_get_time() < OTA_HEALTH_MIN_S * 1000000LL || !mqtt_is_connected())
+    {
+        if (esp_timer_get_time() >= OTA_HEALTH_TIMEOUT_S * 1000000LL)
+        {
+            ESP_LOGE(TAG, "Image %s sans broker après %d s : retour à l'image précédente", version, OTA_HEALTH_TIMEOUT_S);
+            save_counters();
+            esp_ota_mark_app_invalid_rollback_and_reboot(); // Ne revient qu'en l'absence d'image précédente valide
+            ESP_LOGW(TAG, "Aucune image précédente : image %s conservée", version);
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+
+    esp_ota_mark_app_valid_cancel_rollback();
+    atomic_store(&pending, false);
+    char msg[160];
+    snprintf(msg, sizeof(msg), "{\"state\":\"valid\",\"version\":\"%s\",\"partition\":\"%s\"}",
+             version, esp_ota_get_running_partition()->label);
+    ESP_LOGI(TAG, "%s", msg);
+    if (mqtt_is_connected()) mqtt_publish(OTA_TOPIC, msg);
+    vTaskDelete(NULL);
+}
+
+void ota_init(void)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_t *invalid = esp_ota_get_last_invalid_partition();
+    esp_app_desc_t desc;
+    esp_ota_img_states_t state;
+
+    ESP_LOGI(TAG, "Image %s sur %s", esp_app_get_description()->version, running->label);
+    if (invalid != NULL && esp_ota_get_partition_description(invalid, &desc) == ESP_OK)
+    {
+        ESP_LOGW(TAG, "Image %s de %s invalidée (retour à l'image précédente)", desc.version, invalid->label);
+    }
+    if (esp_ota_get_state_partition(running, &state) != ESP_OK || state != ESP_OTA_IMG_PENDING_VERIFY)
+    {
+        return;                                      // Image validée, ou flashée par USB
+    }
+    atomic_store(&pending, true);
+    xTaskCreatePinnedToCore(task_ota_health, "ota_health", 3072, NULL, OTA_PRIORITY, NULL, CORE_NET);
+}
+
+/**
+ * @brief Vrai si OTA_URL_PREFIX fixe le serveur : https://, puis un hôte non vide fermé par '/'.
+ */
+static bool prefix_valid(void)
+{
+    const char *prefix = OTA_URL_PREFIX;
+    if (strncmp(prefix, "https://", 8) != 0) return false;
+    const char *slash = strchr(prefix + 8, '/');     // "https://serveur" accepterait "https://serveur.autre.example"
+    return slash != NULL && slash > prefix + 8;
+}
+
+const char *ota_start(const char *url)
+{
+    if (!prefix_valid()) return "OTA_URL_PREFIX non configuré";
+    if (strncmp(url, OTA_URL_PREFIX, strlen(OTA_URL_PREFIX)) != 0) return "URL hors de OTA_URL_PREFIX";
+    if (strstr(url, "..") != NULL) return "URL invalide";  // Reste sous le chemin du préfixe
+    if (strlen(url) > OTA_URL_MAX) return "URL trop longue";
+    if (atomic_load(&pending)) return "image courante pas encore validée";
+    if (atomic_exchange(&busy, true)) return "mise à jour déjà en cours";
+
+    snprintf(ota_url, sizeof(ota_url), "%s", url);
+    if (xTaskCreatePinnedToCore(task_ota, "ota", 8192, NULL, OTA_PRIORITY, NULL, CORE_NET) != pdPASS) // TLS : pile large
+    {
+        atomic_store(&busy, false);
+        return "mémoire insuffisante";
+    }
+    return NULL;
+}
+
+#else // OTA_ENABLE == 0
+
+void ota_init(void)
+{
+}
+
+const char *ota_start(const char *url)
+{
+    return "mise à jour désactivée (OTA_ENABLE)";
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef OTA_H
+#define OTA_H
+
+/**
+ * @file ota.h
+ * @brief Mise à jour du firmware à distance (HTTPS) avec retour à l'image précédente.
+ *
+ * La commande MQTT "ota <url>" télécharge l'image en HTTPS (certificats du bundle ESP-IDF),
+ * depuis une URL commençant par OTA_URL_PREFIX (sans préfixe configuré, la commande est refusée),
+ * dans la partition OTA inactive, par blocs de OTA_BUFFER_SIZE octets écrits en flash au fil
+ * de la réception : l'image n'est jamais en RAM. Le téléchargement tourne dans une tâche de
+ * basse priorité sur CORE_NET ; le comptage continue sur CORE_PULSE.
+ *
+ * Une fois l'image vérifiée, les compteurs sont sauvegardés dans le journal et l'appareil
+ * redémarre dessus. La nouvelle image reste « à valider » : elle est validée après
+ * OTA_HEALTH_MIN_S secondes de fonctionnement avec le broker joignable. Sans connexion au bout
+ * de OTA_HEALTH_TIMEOUT_S, ou si le superviseur des tâches (watchdog.h) la redémarre avant sa
+ * validation, le bootloader revient à l'image précédente.
+ *
+ * L'avancement est publié sur energie/<DEVICE_NAME>/ota :
+ *
+ *   {"state":"download","version":"1.4.0","size":1234567}
+ *   {"state":"reboot","version":"1.4.0","bytes":1234567}
+ *   {"state":"valid","version":"1.4.0","partition":"ota_1"}
+ *   {"state":"error","err":"ESP_ERR_OTA_VALIDATE_FAILED"}
+ *
+ * Avec OTA_ENABLE à 0, le module est inactif et la commande ota répond par une erreur.
+ *
+ * Usage typique :
+ * 1. ota_init() après mqtt_init(), en mode normal
+ * 2. ota_start(url) depuis la commande MQTT
+ */
+
+#include "config.h"     // Pour DEVICE_NAME
+
+#define OTA_TOPIC "energie/" DEVICE_NAME "/ota" // Avancement des mises à jour (QoS 1)
+
+/**
+ * @brief Démarre la validation de l'image courante si elle vient d'être installée.
+ *
+ * Sans effet si l'image est déjà validée (ou installée par USB).
+ */
+void ota_init(void);
+
+/**
+ * @brief Lance le téléchargement d'une nouvelle image.
+ *
+ * @param url URL de l'image sous OTA_URL_PREFIX (au plus OTA_URL_MAX caractères)
+ * @return NULL si le téléchargement est lancé, sinon la raison du refus
+ */
+const char *ota_start(const char *url);
+
+#endif // OTA_H
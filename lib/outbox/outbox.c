@@ -0,0 +1,281 @@
+/**
+ * @file outbox.c
+ * @brief File d'attente persistante des relevés, vidée à débit limité à la reconnexion.
+ *
+ * Les relevés sont des enregistrements d'un journal circulaire ; la taille des slots est la plus petite
+ * puissance de 2 contenant un relevé des channel_count compteurs actifs (64 octets pour 5 compteurs).
+ * Si elle change (nombre de compteurs modifié), la file est effacée : ses relevés ne sont plus lisibles.
+ * Les valeurs sont écrites sur 48 bits ; les relevés 32 bits d'une version précédente restent lisibles
+ * (champ format à 0) tant que la taille des slots ne change pas.
+ *
+ * leur numéro de séquence sert d'identifiant. La file contient les séquences de ack_seq + 1 à
+ * journal.last_seq : ack_seq (dernier relevé acquitté par le broker) est mémorisé en NVS après
+ * chaque lot, une coupure pendant le vidage provoque donc au plus le renvoi d'un lot.
+ *
+ * Contre-pression : un lot n'est envoyé que si le client MQTT a moins de OUTBOX_MAX_INFLIGHT
+ * octets en attente d'accusé, et le lot suivant attend que tous ses messages soient acquittés.
+ */
+
+#include <string.h>                 // Pour memcpy
+#include <stddef.h>                 // Pour offsetof
+#include <time.h>                   // Horodatage des relevés
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche de vidage et notifications
+#include "freertos/semphr.h"        // Mutex d'accès au journal
+#include "esp_timer.h"              // Temps depuis le démarrage
+#include "esp_log.h"                // Fonctions ESP_LOG pour debug
+#include "nvs.h"                    // Mémorisation du dernier relevé acquitté
+#include "esp_partition.h"          // Effacement de la file au changement de format
+#include "journal.h"                // Journal circulaire en flash
+#include "outbox.h"                 // Header du module
+#include "mqtt.h"                   // Publication des relevés en attente
+
+#define OUTBOX_LEGACY_SLOT_SIZE 64      // Taille des slots avant la table des compteurs (slot non mémorisé)
+#define OUTBOX_JOURNAL_HDR_SIZE 12      // En-tête d'un enregistrement du journal
+#define OUTBOX_VALID_TIME 1600000000    // En dessous, l'horloge n'a pas été mise à l'heure (ts = 0)
+
+static const char *TAG = "OUTBOX";  // Tag pour les logs du module
+
+static journal_t outbox_journal;    // Journal des relevés en attente
+static SemaphoreHandle_t outbox_mutex; // Sérialise l'ajout (tâche de publication) et la lecture (tâche de vidage)
+static TaskHandle_t drain_task;     // Tâche de vidage
+static uint32_t ack_seq;            // Séquence du dernier relevé acquitté par le broker
+static int64_t last_push_us;        // Heure du dernier relevé mis en attente
+
+/**
+ * @brief Taille d'un relevé de count compteurs, telle qu'écrite dans le journal.
+ */
+static size_t record_len(uint32_t count, uint16_t format)
+{
+    return offsetof(outbox_record_t, values) +
+           (format == OUTBOX_FORMAT_48 ? COUNTER_PACK48_SIZE(count) : count * sizeof(uint32_t));
+}
+
+/**
+ * @brief Plus petite taille de slot (puissance de 2) contenant un relevé des compteurs actifs.
+ */
+static uint32_t slot_size_for_channels(void)
+{
+    uint32_t need = OUTBOX_JOURNAL_HDR_SIZE + record_len(channel_count, OUTBOX_FORMAT_48); // En-tête + relevé
+    uint32_t size = 32;                          // Plus petit slot accepté par le journal
+    while (size < need) size <<= 1;
+    return size;                                 // 64 octets pour 5 compteurs, 256 pour 32
+}
+
+/**
+ * @brief Mémorise en NVS la séquence du dernier relevé acquitté.
+ */
+static void save_ack(uint32_t seq)
+{
+    nvs_handle_t handle; // Handle pour accéder à la NVS
+    if (nvs_open("outbox", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        nvs_set_u32(handle, "ack", seq); // Dernier relevé acquitté
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
+uint32_t outbox_pending(void)
+{
+    return outbox_journal.last_seq - ack_seq;   // Relevés écrits mais pas encore acquittés
+}
+
+void outbox_record_values(const outbox_record_t *rec, uint64_t values[MAX_CHANNELS])
+{
+    if (rec->format == OUTBOX_FORMAT_48)
+    {
+        counter_unpack48(values, rec->values, rec->count);
+        return;
+    }
+    for (int i = 0; i < rec->count; i++)      // Relevé 32 bits d'une version précédente
+    {
+        uint32_t v;
+        memcpy(&v, rec->values + i * sizeof(v), sizeof(v));
+        values[i] = v;
+    }
+}
+
+bool outbox_push(const uint64_t values[MAX_CHANNELS])
+{
+    if (outbox_mutex == NULL || outbox_journal.part == NULL) // File inactive
+    {
+        return false;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    if (last_push_us != 0 && now_us - last_push_us < OUTBOX_MIN_PERIOD_S * 1000000LL) // Relevé trop rapproché
+    {
+        return false;
+    }
+
+    time_t now = time(NULL);                    // Heure courante
+    outbox_record_t rec = {
+        .ts = (now >= OUTBOX_VALID_TIME) ? (uint32_t)now : 0, // Horodatage, 0 si inconnu
+        .up = (uint32_t)(now_us / 1000000),     // Secondes depuis le démarrage
+        .count = channel_count,                 // Compteurs actifs
+        .format = OUTBOX_FORMAT_48,
+    };
+    counter_pack48(rec.values, values, channel_count); // Valeurs actives sur 48 bits
+
+    xSemaphoreTake(outbox_mutex, portMAX_DELAY);
+    esp_err_t ret = journal_append(&outbox_journal, &rec, record_len(channel_count, OUTBOX_FORMAT_48)); // Une programmation de page
+    xSemaphoreGive(outbox_mutex);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Relevé non mis en attente : %s", esp_err_to_name(ret));
+        return false;
+    }
+    last_push_us = now_us;
+    ESP_LOGI(TAG, "Relevé %lu mis en attente (%lu en attente)",
+             (unsigned long)outbox_journal.last_seq, (unsigned long)outbox_pending());
+    return true;
+}
+
+void outbox_resume(void)
+{
+    if (drain_task != NULL)
+    {
+        xTaskNotifyGive(drain_task);            // Réveille la tâche de vidage
+    }
+}
+
+/**
+ * @brief Attend que le client MQTT ait reçu l'accusé de tous les messages envoyés.
+ *
+ * @return true si tout a été acquitté, false sur déconnexion ou délai dépassé
+ */
+static bool wait_acked(void)
+{
+    for (int t = 0; t < OUTBOX_ACK_TIMEOUT_MS; t += 50)
+    {
+        if (!mqtt_is_connected()) return false; // Coupure pendant le lot
+        if (mqtt_outbox_bytes() == 0) return true; // Plus rien en attente de PUBACK
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return false;
+}
+
+/**
+ * @brief Tâche de vidage : publie les relevés en attente par lots, à débit limité.
+ *
+ * @param pv Non utilisé
+ */
+static void outbox_drain_task(void *pv)
+{
+    outbox_record_t rec;               // Relevé lu
+    uint32_t slot = 0;                 // Curseur de lecture dans le journal
+    uint32_t next_seq = 0;             // Prochaine séquence à lire (0 = curseur à repositionner)
+    uint32_t slots_per_sector = JOURNAL_SECTOR_SIZE / outbox_journal.slot_size;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Attente d'une connexion au broker
+
+        while (mqtt_is_connected() && outbox_pending() > 0)
+        {
+            if (mqtt_outbox_bytes() > OUTBOX_MAX_INFLIGHT) // Contre-pression : le client MQTT a déjà trop en vol
+            {
+                vTaskDelay(pdMS_TO_TICKS(OUTBOX_DRAIN_INTERVAL_MS));
+                continue;
+            }
+
+            xSemaphoreTake(outbox_mutex, portMAX_DELAY);
+            if (next_seq == 0 ||                                             // Premier vidage ou reprise
+                outbox_pending() > outbox_journal.nb_slots - slots_per_sector) // Relevés écrasés : repartir du plus ancien
+            {
+                slot = outbox_journal.next_slot;   // Les slots suivant le plus récent sont les plus anciens
+                next_seq = ack_seq + 1;
+            }
+
+            uint32_t sent = 0;                 // Relevés publiés dans ce lot
+            uint32_t last = ack_seq;           // Séquence du dernier relevé publié
+            while (sent < OUTBOX_DRAIN_BATCH)
+            {
+                size_t len = sizeof(rec);
+                uint32_t seq;
+                if (journal_read_next(&outbox_journal, &slot, next_seq, &rec, &len, &seq) != ESP_OK) // Plus rien à lire
+                {
+                    break;
+                }
+                if (rec.count > MAX_CHANNELS || len != record_len(rec.count, rec.format)) // Format inattendu : relevé ignoré
+                {
+                    last = seq;
+                    next_seq = seq + 1;
+                    continue;
+                }
+                mqtt_publish_backlog(&rec, seq); // Publication QoS 1 sur le topic backlog
+                last = seq;
+                next_seq = seq + 1;
+                sent++;
+            }
+            xSemaphoreGive(outbox_mutex);
+
+            if (sent == 0)                     // Séquences manquantes (écrasées) : tout est considéré envoyé
+            {
+                ack_seq = outbox_journal.last_seq;
+                save_ack(ack_seq);
+                break;
+            }
+
+            if (!wait_acked())                 // Lot non acquitté : il sera renvoyé à la prochaine connexion
+            {
+                next_seq = 0;
+                break;
+            }
+            ack_seq = last;                    // Lot acquitté
+            save_ack(ack_seq);
+            ESP_LOGI(TAG, "%lu relevés publiés, %lu en attente", (unsigned long)sent, (unsigned long)outbox_pending());
+
+            vTaskDelay(pdMS_TO_TICKS(OUTBOX_DRAIN_INTERVAL_MS)); // Débit limité : laisse la main au comptage et au live
+        }
+    }
+}
+
+void outbox_init(void)
+{
+    uint32_t slot_size = slot_size_for_channels(); // Slots ajustés au nombre de compteurs actifs
+    uint32_t stored_size = OUTBOX_LEGACY_SLOT_SIZE; // Taille des slots de la file existante
+
+    nvs_handle_t handle; // Handle pour accéder à la NVS
+    if (nvs_open("outbox", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        nvs_get_u32(handle, "ack", &ack_seq); // Dernier relevé acquitté (0 si absent)
+        nvs_get_u32(handle, "slot", &stored_size); // Taille des slots (absente : ancien format)
+        if (stored_size != slot_size)         // Nombre de compteurs modifié : ancienne file illisible
+        {
+            const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                   ESP_PARTITION_SUBTYPE_ANY, "outbox");
+            if (part != NULL && esp_partition_erase_range(part, 0, part->size) == ESP_OK)
+            {
+                ESP_LOGW(TAG, "Slots de %lu o au lieu de %lu o : file effacée",
+                         (unsigned long)slot_size, (unsigned long)stored_size);
+                ack_seq = 0;
+                nvs_set_u32(handle, "ack", 0);
+                nvs_set_u32(handle, "slot", slot_size);
+                nvs_commit(handle);
+            }
+        }
+        nvs_close(handle);
+    }
+
+    if (journal_open(&outbox_journal, "outbox", slot_size) != ESP_OK) // Partition absente : file inactive
+    {
+        ESP_LOGW(TAG, "File d'attente hors ligne désactivée");
+        return;
+    }
+    if (ack_seq > outbox_journal.last_seq)   // Partition effacée depuis : rien en attente
+    {
+        ack_seq = outbox_journal.last_seq;
+    }
+
+    outbox_mutex = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(outbox_drain_task, "outbox_drain", 4096, NULL, OUTBOX_DRAIN_PRIORITY, &drain_task, CORE_NET);
+    if (mqtt_is_connected())                 // Broker connecté avant l'ouverture de la file : réveil manqué
+    {
+        outbox_resume();
+    }
+
+    ESP_LOGI(TAG, "%lu relevés en attente", (unsigned long)outbox_pending());
+}
@@ -0,0 +1,80 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+/**
+ * @file outbox.h
+ * @brief File d'attente en flash des relevés non publiés (broker ou Wi-Fi indisponible).
+ *
+ * Pendant une coupure, la tâche de publication range des instantanés horodatés des
+ * compteurs dans un journal circulaire dédié (partition "outbox", lib/journal) :
+ * - Taille bornée : quand la partition est pleine, les plus anciens relevés sont écrasés
+ * - Les relevés survivent à un redémarrage
+ *
+ * À la connexion au broker (MQTT_EVENT_CONNECTED), une tâche de basse priorité vide la
+ * file par lots de OUTBOX_DRAIN_BATCH messages, au plus un lot toutes les
+ * OUTBOX_DRAIN_INTERVAL_MS, en attendant que le client MQTT ait reçu les accusés
+ * (PUBACK) avant d'envoyer le lot suivant. Le dernier relevé acquitté est mémorisé
+ * en NVS : après un redémarrage, la reprise se fait au relevé suivant.
+ *
+ * Usage typique :
+ * 1. outbox_init() au démarrage de la tâche de publication
+ * 2. outbox_push(values) à la place de la publication quand le broker est injoignable
+ * 3. outbox_resume() à la connexion au broker
+ */
+
+#include <stdint.h>  // Pour uint32_t, uint64_t
+#include <stdbool.h> // Pour bool
+#include "config.h"  // Pour MAX_CHANNELS, channel_count
+#include "counter_store.h" // Pour COUNTER_PACK48_SIZE
+
+#define OUTBOX_FORMAT_32 0          // Relevé d'une version précédente : valeurs sur 32 bits
+#define OUTBOX_FORMAT_48 1          // Valeurs sur 48 bits (counter_pack48)
+
+/**
+ * @brief Relevé mis en attente, tel qu'écrit dans le journal "outbox".
+ */
+typedef struct {
+    uint32_t ts;                    ///< Heure Unix du relevé (0 si l'horloge n'était pas à l'heure)
+    uint32_t up;                    ///< Secondes depuis le démarrage au moment du relevé
+    uint16_t count;                 ///< Nombre de compteurs du relevé
+    uint16_t format;                ///< OUTBOX_FORMAT_* (0 dans les relevés des versions précédentes)
+    uint8_t values[COUNTER_PACK48_SIZE(MAX_CHANNELS)]; ///< Valeurs des compteurs (seules les count premières sont écrites)
+} outbox_record_t;
+
+/**
+ * @brief Ouvre la file d'attente et démarre la tâche de vidage.
+ *
+ * Sans partition "outbox", la file reste inactive : outbox_push() retourne false.
+ */
+void outbox_init(void);
+
+/**
+ * @brief Met un instantané des compteurs en attente de publication.
+ *
+ * Au plus un relevé toutes les OUTBOX_MIN_PERIOD_S secondes (les relevés plus
+ * rapprochés sont ignorés, la valeur courante est republiée à la reconnexion).
+ *
+ * @param values Valeurs des compteurs actifs (channel_count)
+ * @return true si le relevé a été écrit dans la file
+ */
+bool outbox_push(const uint64_t values[MAX_CHANNELS]);
+
+/**
+ * @brief Valeurs des compteurs d'un relevé lu dans la file, quel que soit son format.
+ *
+ * @param rec    Relevé
+ * @param values Valeurs des rec->count compteurs (sortie)
+ */
+void outbox_record_values(const outbox_record_t *rec, uint64_t values[MAX_CHANNELS]);
+
+/**
+ * @brief Réveille la tâche de vidage (connexion au broker établie).
+ */
+void outbox_resume(void);
+
+/**
+ * @brief Nombre de relevés en attente de publication.
+ */
+uint32_t outbox_pending(void);
+
+#endif // OUTBOX_H
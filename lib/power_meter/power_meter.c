@@ -0,0 +1,191 @@
+/**
+ * @file power_meter.c
+ * @brief Buffers circulaires d'horodatage des impulsions et calcul de puissance.
+ *
+ * Chaque compteur possède un buffer de POWER_RING_SIZE événements {heure en ms, nombre d'impulsions}
+ * et un index d'écriture croissant (nombre total d'événements écrits). Le producteur écrit l'événement
+ * puis publie l'index (release) ; le lecteur copie les derniers événements, relit l'index et écarte
+ * ceux qui ont pu être réécrits pendant la copie. Aucun verrou ; les buffers des channel_count compteurs
+ * actifs sont alloués une fois au démarrage (power_meter_init), jamais sur le chemin des impulsions.
+ *
+ * Le moteur PCNT signale plusieurs impulsions par lecture : un événement porte donc un nombre
+ * d'impulsions, réparties sur l'intervalle qui le sépare de l'événement précédent.
+ *
+ * L'heure est stockée en millisecondes sur 32 bits : les différences restent exactes pendant 49 jours,
+ * bien au-delà des fenêtres de calcul.
+ */
+
+#include <stdatomic.h>              // Opérations atomiques C11
+#include <stdlib.h>                 // Pour calloc
+#include <stdbool.h>                // Pour bool
+#include "esp_attr.h"               // Attribut IRAM_ATTR
+#include "esp_timer.h"              // Heure courante
+#include "esp_log.h"                // Fonctions ESP_LOG pour debug
+#include "power_meter.h"            // Header du module
+
+#define POWER_KWH_MS_TO_W (3600.0f * 1000.0f * 1000.0f) // kWh par ms → W (à diviser par les impulsions par kWh)
+
+static const char *TAG = "POWER_METER"; // Tag pour les logs du module
+
+/**
+ * @brief Impulsions validées à un instant donné.
+ */
+typedef struct {
+    uint32_t t_ms;                  ///< Heure de validation en ms depuis le démarrage
+    uint32_t n;                     ///< Nombre d'impulsions
+} power_event_t;
+
+/**
+ * @brief Buffer circulaire d'un compteur.
+ */
+typedef struct {
+    power_event_t ev[POWER_RING_SIZE]; ///< Derniers événements
+    _Atomic uint32_t head;             ///< Nombre total d'événements écrits (prochain index)
+} power_ring_t;
+
+static power_ring_t *rings = NULL;      // Un buffer par compteur actif, alloué au démarrage
+static int nb_rings = 0;                // Nombre de buffers alloués
+
+void power_meter_init(void)
+{
+    rings = calloc(channel_count, sizeof(power_ring_t)); // Uniquement les compteurs actifs
+    if (rings == NULL)
+    {
+        ESP_LOGE(TAG, "Allocation des buffers de puissance impossible");
+        return;
+    }
+    nb_rings = channel_count;
+}
+
+/**
+ * @brief Facteur de conversion impulsions par ms → W du compteur idx.
+ */
+static float pulse_factor(int idx)
+{
+    uint32_t ppkwh = channels[idx].ppkwh ? channels[idx].ppkwh : PULSES_PER_KWH; // Constante du compteur (jamais nulle)
+    return POWER_KWH_MS_TO_W / ppkwh;
+}
+
+/**
+ * @brief Ajoute un événement au buffer du compteur idx (producteur unique).
+ */
+void IRAM_ATTR power_meter_record(int idx, uint32_t n, int64_t t_us)
+{
+    if (idx >= nb_rings) return;                    // Buffers non alloués ou compteur inactif
+
+    power_ring_t *r = &rings[idx];
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed); // Seul le producteur modifie head
+
+    power_event_t *e = &r->ev[h % POWER_RING_SIZE]; // Emplacement le plus ancien
+    e->t_ms = (uint32_t)(t_us / 1000);              // Heure en ms
+    e->n = n;                                       // Impulsions validées
+
+    atomic_store_explicit(&r->head, h + 1, memory_order_release); // Publie l'événement
+}
+
+/**
+ * @brief Copie les derniers événements valides d'un compteur, du plus récent au plus ancien.
+ *
+ * @param idx   Index du compteur
+ * @param out   Buffer de POWER_RING_SIZE événements
+ * @param total Nombre total d'événements écrits depuis le démarrage
+ * @return Nombre d'événements copiés et garantis intacts
+ */
+static uint32_t ring_copy(int idx, power_event_t *out, uint32_t *total)
+{
+    power_ring_t *r = &rings[idx];
+    uint32_t h1 = atomic_load_explicit(&r->head, memory_order_acquire); // Index avant la copie
+    uint32_t cnt = (h1 < POWER_RING_SIZE) ? h1 : POWER_RING_SIZE;
+
+    for (uint32_t k = 0; k < cnt; k++)
+    {
+        out[k] = r->ev[(h1 - 1 - k) % POWER_RING_SIZE]; // Du plus récent au plus ancien
+    }
+
+    atomic_thread_fence(memory_order_acquire);       // La copie précède la relecture de l'index
+    uint32_t h2 = atomic_load_explicit(&r->head, memory_order_relaxed); // Index après la copie
+
+    // L'événement de rang s est intact s'il n'a pas pu être réécrit : s > h2 - POWER_RING_SIZE
+    // (le slot de rang h2 - POWER_RING_SIZE est peut-être en cours d'écriture).
+    while (cnt > 0 && h2 >= POWER_RING_SIZE && (h1 - cnt) <= h2 - POWER_RING_SIZE)
+    {
+        cnt--;                                       // Écarte le plus ancien
+    }
+
+    *total = h1;
+    return cnt;
+}
+
+/**
+ * @brief Puissance moyenne sur une fenêtre glissante se terminant maintenant.
+ *
+ * Si le buffer ne couvre pas toute la fenêtre, la moyenne porte sur la durée
+ * réellement couverte (depuis l'événement le plus ancien disponible).
+ */
+static float window_power(const power_event_t *ev, uint32_t cnt, bool truncated,
+                          uint32_t now_ms, uint32_t window_ms, float factor)
+{
+    uint32_t pulses = 0;                             // Impulsions dans la fenêtre
+    uint32_t k;
+
+    for (k = 0; k < cnt; k++)
+    {
+        if (now_ms - ev[k].t_ms >= window_ms)        // Hors fenêtre : les suivants le sont aussi
+        {
+            return pulses * factor / window_ms;
+        }
+        pulses += ev[k].n;
+    }
+
+    if (truncated && cnt > 1)                        // Buffer plus court que la fenêtre
+    {
+        uint32_t span = now_ms - ev[cnt - 1].t_ms;   // Durée couverte depuis le plus ancien événement
+        return (pulses - ev[cnt - 1].n) * factor / span; // Ses impulsions appartiennent à l'intervalle précédent
+    }
+    return pulses * factor / window_ms;
+}
+
+/**
+ * @brief Calcule la puissance instantanée et les moyennes glissantes d'un compteur.
+ *
+ * La puissance instantanée vaut n / intervalle entre les deux derniers événements ;
+ * si aucune impulsion n'arrive depuis plus longtemps que cet intervalle, elle est
+ * bornée par une impulsion / temps écoulé, ce qui la fait décroître vers 0 quand
+ * la consommation s'arrête.
+ */
+void power_meter_get(int idx, power_reading_t *out)
+{
+    power_event_t ev[POWER_RING_SIZE];               // Copie locale des événements
+    uint32_t total;                                  // Nombre total d'événements écrits
+
+    if (idx >= nb_rings)                             // Buffers non alloués ou compteur inactif
+    {
+        *out = (power_reading_t){ 0 };
+        return;
+    }
+
+    uint32_t cnt = ring_copy(idx, ev, &total);
+    float factor = pulse_factor(idx);                // Impulsions par ms → W pour ce compteur
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000); // Heure courante en ms
+
+    out->instant_w = 0.0f;
+    if (cnt >= 2)                                    // Il faut deux événements pour un intervalle
+    {
+        uint32_t dt = ev[0].t_ms - ev[1].t_ms;       // Intervalle entre les deux derniers événements
+        uint32_t since = now_ms - ev[0].t_ms;        // Temps écoulé depuis le dernier
+        if (dt > 0)
+        {
+            out->instant_w = ev[0].n * factor / dt;
+        }
+        if (since > dt && since > 0)                 // Plus d'impulsion depuis : la puissance a baissé
+        {
+            float bound = factor / since;            // Au plus une impulsion sur le temps écoulé
+            if (bound < out->instant_w) out->instant_w = bound;
+        }
+    }
+
+    bool truncated = total > cnt;                    // Des événements plus anciens ont été écrasés
+    out->avg_1s_w  = window_power(ev, cnt, truncated, now_ms, 1000, factor);
+    out->avg_10s_w = window_power(ev, cnt, truncated, now_ms, 10000, factor);
+    out->avg_60s_w = window_power(ev, cnt, truncated, now_ms, 60000, factor);
+}
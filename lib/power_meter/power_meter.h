@@ -0,0 +1,67 @@
+#ifndef POWER_METER_H
+#define POWER_METER_H
+
+/**
+ * @file power_meter.h
+ * @brief Calcul de la puissance instantanée (W) à partir de l'horodatage des impulsions.
+ *
+ * Chaque impulsion validée est horodatée dans un buffer circulaire de taille fixe,
+ * un par compteur actif (alloués par power_meter_init) :
+ * - L'écriture (power_meter_record) ne prend aucun verrou et n'alloue rien :
+ *   elle est appelée depuis le contexte du timer de validation / lecture PCNT
+ * - Le calcul (power_meter_get) se fait dans la tâche appelante, sur une copie
+ *   des derniers événements
+ *
+ * La puissance instantanée est déduite de l'intervalle entre les deux dernières
+ * impulsions ; les moyennes glissantes sur 1 s, 10 s et 60 s sont calculées à
+ * partir de l'énergie comptée dans chaque fenêtre.
+ *
+ * Usage typique :
+ * 0. power_meter_init() une fois la table des compteurs chargée
+ * 1. power_meter_record(idx, n, t_us) à chaque impulsion validée (gpio_pulse)
+ * 2. power_meter_get(idx, &reading) au moment de publier
+ */
+
+#include <stdint.h>  // Pour uint32_t, int64_t
+#include "config.h"  // Pour MAX_CHANNELS, channels (constante des compteurs), POWER_RING_SIZE
+
+/**
+ * @brief Puissances calculées pour un compteur, en watts.
+ */
+typedef struct {
+    float instant_w;   ///< Puissance instantanée (intervalle entre les deux dernières impulsions)
+    float avg_1s_w;    ///< Moyenne glissante sur 1 s
+    float avg_10s_w;   ///< Moyenne glissante sur 10 s
+    float avg_60s_w;   ///< Moyenne glissante sur 60 s
+} power_reading_t;
+
+/**
+ * @brief Alloue un buffer d'événements par compteur actif (channel_count).
+ *
+ * À appeler une fois, après le chargement de la configuration et avant le
+ * démarrage du comptage. Sans elle, record et get sont sans effet.
+ */
+void power_meter_init(void);
+
+/**
+ * @brief Horodate n impulsions validées sur le compteur idx.
+ *
+ * Sans verrou ni allocation, placée en IRAM. Un seul contexte producteur par
+ * compteur (tâche esp_timer) : l'écriture d'un événement puis la publication
+ * de l'index suffisent.
+ *
+ * @param idx  Index du compteur (0..channel_count-1)
+ * @param n    Nombre d'impulsions validées à cet instant
+ * @param t_us Horodatage des impulsions (esp_timer_get_time())
+ */
+void power_meter_record(int idx, uint32_t n, int64_t t_us);
+
+/**
+ * @brief Calcule la puissance instantanée et les moyennes glissantes d'un compteur.
+ *
+ * @param idx Index du compteur (0..channel_count-1)
+ * @param out Puissances calculées (0 tant que les impulsions sont insuffisantes)
+ */
+void power_meter_get(int idx, power_reading_t *out);
+
+#endif // POWER_METER_H
@@ -0,0 +1,102 @@
+/**
+ * @file powerfail.c
+ * @brief Sauvegarde d'urgence des compteurs sur coupure d'alimentation.
+ *
+ * Le détecteur de brownout de l'ESP32 ne laisse pas la main au programme : son gestionnaire
+ * redémarre la puce aussitôt. La coupure est donc signalée plus tôt, par un superviseur qui
+ * surveille l'alimentation en amont de la capacité de réserve ; celle-ci doit couvrir la latence
+ * de la tâche et une programmation flash de l'enregistrement (moins d'une milliseconde).
+ *
+ * L'interruption est de niveau (réveil possible du light sleep avec LOW_POWER) : l'ISR la
+ * désarme, la tâche la réarme une fois l'alimentation revenue depuis POWER_FAIL_REARM_MS.
+ */
+
+#include "config.h"                 // POWER_FAIL, POWER_FAIL_*
+#include "powerfail.h"              // Header du module
+
+#if POWER_FAIL
+
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche et notifications
+#include "driver/gpio.h"            // Entrée du superviseur
+#include "hal/gpio_ll.h"            // Désarmement de l'interruption depuis l'ISR
+#include "esp_attr.h"               // IRAM_ATTR
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "storage.h"                // Sauvegarde d'urgence
+
+#if POWER_FAIL_ACTIVE_LEVEL
+#define POWER_FAIL_INTR GPIO_INTR_HIGH_LEVEL
+#else
+#define POWER_FAIL_INTR GPIO_INTR_LOW_LEVEL
+#endif
+
+static const char *TAG = "POWERFAIL";      // Identifiant de log du module
+static TaskHandle_t powerfail_task;        // Tâche réveillée par l'interruption
+
+/**
+ * @brief ISR de l'entrée de coupure : réveille la tâche powerfail.
+ */
+static void IRAM_ATTR powerfail_isr(void *arg)
+{
+    gpio_ll_set_intr_type(&GPIO, POWER_FAIL_GPIO, GPIO_INTR_DISABLE); // Désarmée jusqu'au retour de l'alimentation
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(powerfail_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief Tâche powerfail : écriture d'urgence, puis réarmement après une coupure brève.
+ */
+static void task_powerfail(void *pv)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        storage_emergency_save();          // Avant tout log : la réserve d'énergie est comptée
+        ESP_LOGW(TAG, "Coupure d'alimentation : compteurs sauvegardés");
+
+        do                                 // Toujours alimenté : attend le retour durable de la tension
+        {
+            vTaskDelay(pdMS_TO_TICKS(POWER_FAIL_REARM_MS));
+        } while (gpio_get_level(POWER_FAIL_GPIO) == POWER_FAIL_ACTIVE_LEVEL);
+
+        storage_emergency_rearm();         // Secteur effacé, journal déverrouillé
+        storage_request_save();            // Les valeurs courantes passent dans le journal
+        ESP_LOGI(TAG, "Alimentation revenue : sauvegarde d'urgence réarmée");
+        gpio_set_intr_type(POWER_FAIL_GPIO, POWER_FAIL_INTR);
+    }
+}
+
+void powerfail_init(void)
+{
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << POWER_FAIL_GPIO,   // Sortie du superviseur
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,         // Niveau imposé par le superviseur
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = POWER_FAIL_INTR,
+    };
+    gpio_config(&io_conf);
+
+    xTaskCreatePinnedToCore(task_powerfail, "powerfail", 3072, NULL, POWER_FAIL_PRIORITY, &powerfail_task, 0);
+
+    esp_err_t ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM); // Déjà installé si des compteurs sont servis par ISR
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGE(TAG, "Service ISR indisponible : %s", esp_err_to_name(ret));
+        return;
+    }
+    gpio_isr_handler_add(POWER_FAIL_GPIO, powerfail_isr, NULL);
+#if LOW_POWER
+    gpio_wakeup_enable(POWER_FAIL_GPIO, POWER_FAIL_INTR); // Une coupure réveille le CPU du light sleep
+#endif
+
+    ESP_LOGI(TAG, "Surveillance de l'alimentation sur GPIO %d", POWER_FAIL_GPIO);
+}
+
+#else
+
+void powerfail_init(void) {}
+
+#endif // POWER_FAIL
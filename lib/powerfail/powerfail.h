@@ -0,0 +1,27 @@
+#ifndef POWERFAIL_H
+#define POWERFAIL_H
+
+/**
+ * @file powerfail.h
+ * @brief Détection de coupure d'alimentation et sauvegarde d'urgence des compteurs.
+ *
+ * Avec POWER_FAIL (config.h), l'entrée POWER_FAIL_GPIO suit la sortie d'un superviseur de
+ * tension placé en amont de la capacité de réserve. Au passage à POWER_FAIL_ACTIVE_LEVEL :
+ * 1. L'interruption réveille la tâche powerfail, de priorité maximale
+ * 2. Tous les compteurs sont écrits en une fois dans la partition "pfail" (storage_emergency_save)
+ * 3. Si l'alimentation revient (coupure brève), la partition est effacée et une sauvegarde
+ *    normale est demandée au journal
+ *
+ * Au démarrage suivant, storage_load_counters() reprend l'enregistrement de coupure.
+ *
+ * Sans POWER_FAIL, toutes les fonctions sont sans effet.
+ */
+
+/**
+ * @brief Configure l'entrée de coupure et démarre la tâche de sauvegarde d'urgence.
+ *
+ * Appelée après storage_load_counters() : la partition "pfail" est alors effacée.
+ */
+void powerfail_init(void);
+
+#endif // POWERFAIL_H
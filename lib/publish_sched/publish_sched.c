@@ -0,0 +1,165 @@
+/**
+ * @file publish_sched.c
+ * @brief Décision de publication par compteur : seuil d'impulsions, bande morte de puissance,
+ *        intervalles minimal et maximal.
+ *
+ * La tâche de publication bloque dans xTaskNotifyWait ; le délai d'attente est la plus proche
+ * échéance parmi :
+ *  - l'intervalle maximal de chaque compteur
+ *  - la fin de l'intervalle minimal d'un compteur dont le seuil est déjà atteint
+ *  - PUBLISH_POWER_RECHECK_MS si une bande morte est active et que la dernière puissance publiée
+ *    la dépasse (la puissance décroît sans impulsion, il faut la suivre dans le temps) ; une fois
+ *    la puissance publiée sous la bande morte, plus aucun réveil périodique
+ *  - l'attente maximale demandée par l'appelant (battement du watchdog), qui reprend alors
+ *    la main sans rien publier
+ *
+ * Les notifications du chemin de comptage (un bit par compteur) réveillent la tâche plus tôt.
+ */
+
+#include <math.h>                   // Pour fabsf
+#include <stdbool.h>                // Pour bool
+#include <stdatomic.h>              // Demande de publication complète
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Notifications de tâche
+#include "esp_timer.h"              // Heure courante
+#include "esp_attr.h"               // Attribut IRAM_ATTR
+#include "publish_sched.h"          // Header du module
+#include "counter_store.h"          // Copie cohérente des compteurs
+
+/**
+ * @brief État de publication d'un compteur.
+ */
+typedef struct {
+    uint64_t value;      ///< Dernière valeur publiée
+    float power_w;       ///< Dernière puissance instantanée publiée
+    int64_t time_us;     ///< Heure de la dernière publication (0 = jamais publié)
+} publish_state_t;
+
+static TaskHandle_t publisher;                  // Tâche de publication à réveiller
+static publish_state_t state[MAX_CHANNELS];     // Dernière publication de chaque compteur
+static atomic_bool request_all;                 // Publier tous les compteurs (les 32 bits de notification servent aux compteurs)
+
+void publish_sched_init(void)
+{
+    publisher = xTaskGetCurrentTaskHandle();    // La tâche appelante publie
+}
+
+void publish_sched_notify(int idx)
+{
+    TaskHandle_t task = publisher;              // Lecture unique du handle
+    if (task != NULL)                           // Tâche de publication démarrée
+    {
+        xTaskNotify(task, 1UL << idx, eSetBits); // Réveille la tâche, sans bloquer
+    }
+}
+
+void IRAM_ATTR publish_sched_notify_from_isr(int idx, BaseType_t *woken)
+{
+    TaskHandle_t task = publisher;
+    if (task != NULL)
+    {
+        xTaskNotifyFromISR(task, 1UL << idx, eSetBits, woken);
+    }
+}
+
+void publish_sched_request_all(void)
+{
+    TaskHandle_t task = publisher;
+    if (task != NULL)
+    {
+        atomic_store(&request_all, true);
+        xTaskNotify(task, 0, eNoAction);        // Réveil seul
+    }
+}
+
+/**
+ * @brief Évalue un compteur et calcule sa prochaine échéance.
+ *
+ * @param i       Index du compteur
+ * @param now     Heure courante (µs)
+ * @param value   Valeur courante du compteur
+ * @param power_w Puissance instantanée courante
+ * @param next_us Prochaine échéance de réévaluation (entrée/sortie, µs depuis maintenant)
+ * @return true si le compteur doit être publié maintenant
+ */
+static bool channel_due(int i, int64_t now, uint64_t value, float power_w, int64_t *next_us)
+{
+    const publish_cfg_t *cfg = &publish_cfg[i];
+    const publish_state_t *st = &state[i];
+
+    if (st->time_us == 0) return true;          // Jamais publié : publication initiale
+
+    int64_t since = now - st->time_us;          // Temps écoulé depuis la dernière publication
+    int64_t min_us = (int64_t)cfg->min_s * 1000000;
+    int64_t max_us = (int64_t)cfg->max_s * 1000000;
+
+    if (cfg->max_s > 0 && since >= max_us) return true; // Intervalle maximal atteint
+
+    bool moved = cfg->delta > 0 && (value - st->value) >= cfg->delta;  // Seuil d'impulsions
+    bool crossed = cfg->deadband_w > 0 &&
+                   fabsf(power_w - st->power_w) >= (float)cfg->deadband_w; // Bande morte franchie
+
+    if ((moved || crossed) && since >= min_us) return true; // Seuil atteint hors intervalle minimal
+
+    if (cfg->max_s > 0 && max_us - since < *next_us)        // Prochaine valeur de vie
+    {
+        *next_us = max_us - since;
+    }
+    if ((moved || crossed) && min_us - since < *next_us)    // Seuil atteint : fin de l'intervalle minimal
+    {
+        *next_us = min_us - since;
+    }
+    if (cfg->deadband_w > 0 && st->power_w > (float)cfg->deadband_w &&
+        PUBLISH_POWER_RECHECK_MS * 1000LL < *next_us)        // La puissance peut encore baisser d'une bande morte : suivi de sa décroissance
+    {
+        *next_us = PUBLISH_POWER_RECHECK_MS * 1000LL;
+    }
+    return false;
+}
+
+uint32_t publish_sched_wait(uint64_t values[MAX_CHANNELS], power_reading_t power[MAX_CHANNELS], uint32_t max_wait_ms)
+{
+    int64_t deadline = max_wait_ms ? esp_timer_get_time() + (int64_t)max_wait_ms * 1000 : INT64_MAX; // Retour au plus tard
+
+    while (1)
+    {
+        bool all = atomic_exchange(&request_all, false); // Demande de publication complète
+        counter_store_snapshot(values);         // Copie des compteurs au réveil
+        int64_t now = esp_timer_get_time();
+        int64_t next_us = INT64_MAX;            // Prochaine échéance, aucune par défaut
+        uint32_t mask = 0;                      // Compteurs à publier
+
+        for (int i = 0; i < channel_count; i++)
+        {
+            power_meter_get(i, &power[i]);      // Puissance courante
+            if (all ||
+                channel_due(i, now, values[i], power[i].instant_w, &next_us))
+            {
+                mask |= 1UL << i;
+            }
+        }
+
+        if (mask != 0)                          // Au moins un compteur à publier
+        {
+            for (int i = 0; i < channel_count; i++)
+            {
+                if (mask & (1UL << i))          // Mémorise la publication
+                {
+                    state[i].value = values[i];
+                    state[i].power_w = power[i].instant_w;
+                    state[i].time_us = now;
+                }
+            }
+            return mask;
+        }
+        if (now >= deadline) return 0;          // Rien à publier dans le délai : la tâche reprend la main
+
+        if (deadline != INT64_MAX && deadline - now < next_us) next_us = deadline - now;
+        TickType_t timeout = portMAX_DELAY;     // Sans échéance : attente d'une notification
+        if (next_us != INT64_MAX)
+        {
+            timeout = pdMS_TO_TICKS(next_us / 1000) + 1; // Arrondi au tick supérieur
+        }
+        xTaskNotifyWait(0, UINT32_MAX, NULL, timeout); // Réveil par impulsion, demande ou échéance
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef PUBLISH_SCHED_H
+#define PUBLISH_SCHED_H
+
+/**
+ * @file publish_sched.h
+ * @brief Ordonnanceur de publication des compteurs piloté par notifications.
+ *
+ * Remplace l'attente fixe de MQTT_PUBLISH_PERIOD_MS : la tâche de publication dort
+ * jusqu'à ce qu'un compteur doive être publié. Un compteur est publié lorsque :
+ * - il a avancé d'au moins `delta` impulsions depuis sa dernière publication,
+ * - ou sa puissance instantanée s'est écartée de plus de `deadband_w` de la
+ *   dernière valeur publiée,
+ * - et dans les deux cas, au moins `min_s` secondes se sont écoulées ;
+ * - ou `max_s` secondes se sont écoulées sans publication (valeur de vie).
+ *
+ * Le chemin de comptage réveille la tâche par xTaskNotify (publish_sched_notify) :
+ * aucune scrutation tant que rien ne bouge, hormis le suivi de la décroissance
+ * de la puissance quand une bande morte est configurée.
+ *
+ * Usage typique (tâche de publication) :
+ * 1. publish_sched_init() depuis la tâche qui publie
+ * 2. mask = publish_sched_wait(values, power, délai) puis publication des compteurs du masque
+ */
+
+#include <stdint.h>      // Pour uint32_t
+#include "config.h"      // Pour MAX_CHANNELS, channel_count, publish_cfg
+#include "power_meter.h" // Pour power_reading_t
+#include "freertos/FreeRTOS.h" // Pour BaseType_t
+
+/**
+ * @brief Enregistre la tâche appelante comme tâche de publication.
+ *
+ * À appeler depuis la tâche de publication avant publish_sched_wait().
+ * Tant qu'elle n'est pas appelée, publish_sched_notify() ne fait rien.
+ */
+void publish_sched_init(void);
+
+/**
+ * @brief Signale de nouvelles impulsions sur le compteur idx.
+ *
+ * Appelée depuis le chemin de comptage (contexte tâche esp_timer) ;
+ * ne bloque pas.
+ *
+ * @param idx Index du compteur (0..channel_count-1)
+ */
+void publish_sched_notify(int idx);
+
+/**
+ * @brief Variante de publish_sched_notify() pour une ISR.
+ *
+ * @param idx   Index du compteur (0..channel_count-1)
+ * @param woken Mis à pdTRUE si la tâche de publication doit prendre la main en sortie d'ISR
+ */
+void publish_sched_notify_from_isr(int idx, BaseType_t *woken);
+
+/**
+ * @brief Demande la publication de tous les compteurs dès que possible.
+ *
+ * Utilisée à la (re)connexion au broker pour resynchroniser les valeurs,
+ * sans tenir compte de l'intervalle minimal.
+ */
+void publish_sched_request_all(void);
+
+/**
+ * @brief Attend qu'au moins un compteur doive être publié.
+ *
+ * Copie les compteurs et calcule les puissances au moment du réveil,
+ * puis considère les compteurs retournés comme publiés.
+ *
+ * @param values Copie cohérente des compteurs (sortie)
+ * @param power  Puissances calculées (sortie)
+ * @param max_wait_ms Attente maximale en ms (battement de la tâche appelante), 0 = sans limite
+ * @return Masque des compteurs à publier (bit i = compteur i), 0 si le délai est écoulé sans publication
+ */
+uint32_t publish_sched_wait(uint64_t values[MAX_CHANNELS], power_reading_t power[MAX_CHANNELS], uint32_t max_wait_ms);
+
+#endif // PUBLISH_SCHED_H
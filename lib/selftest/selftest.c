@@ -0,0 +1,447 @@
+/**
+ * @file selftest.c
+ * @brief Banc de débit du comptage : trains d'impulsions RMT rebouclés sur les entrées.
+ *
+ * Un palier = une fréquence, un profil (fronts propres ou SELFTEST_BOUNCES rebonds),
+ * un nombre de compteurs générés (le premier seul, puis tous). Le même train de symboles,
+ * construit une fois par palier, est émis en parallèle sur chaque canal RMT.
+ *
+ * Charge CPU : un hook idle par cœur compte ses passages dans la boucle idle. Le rapport
+ * entre le rythme mesuré pendant l'émission et celui de la mesure de référence au repos
+ * donne la part de temps consommée par le comptage (et le reste du firmware).
+ *
+ * Gigue : avec PULSE_STATS, chaque palier rend le plus grand délai front → validation de ses
+ * compteurs. Le palier SELFTEST_JITTER_HZ est rejoué au repos puis pendant un flot de datagrammes
+ * UDP diffusés depuis CORE_NET ; l'écart entre ce délai et l'anti-rebond est la gigue de la
+ * validation, au repos et sous charge réseau.
+ *
+ * Limite : le générateur recharge sa mémoire RMT (64 symboles) par interruption ; elle est
+ * prioritaire (SELFTEST_RMT_INTR_PRIORITY) sur les ISR de comptage pour ne pas déformer le train.
+ */
+
+#include "config.h"                 // PULSE_SELFTEST, SELFTEST_*, table des compteurs
+#include "selftest.h"               // Header du module
+
+#if PULSE_SELFTEST
+
+#include <stdio.h>                  // snprintf
+#include <stdatomic.h>              // Arrêt de la charge réseau, délai max des statistiques
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // xTaskCreatePinnedToCore, vTaskDelay
+#include "driver/rmt_tx.h"          // Canaux RMT en émission, encodeur de copie
+#include "driver/gpio.h"            // GPIO_IS_VALID_OUTPUT_GPIO
+#include "esp_freertos_hooks.h"     // Hooks idle par cœur
+#include "esp_timer.h"              // Horloge µs
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "lwip/sockets.h"           // Charge réseau : datagrammes UDP diffusés
+#include "gpio_pulse.h"             // gpio_pulse_pin_valid
+#include "counter_store.h"          // Lecture et restauration des compteurs
+#include "storage.h"                // Sauvegarde des compteurs restaurés
+#include "mqtt.h"                   // Publication du rapport
+#include "pulse_stats.h"            // Délai max front → validation (PULSE_STATS)
+
+#if LOW_POWER
+#error "PULSE_SELFTEST : le light sleep (LOW_POWER) fausse la mesure de charge et suspend le générateur"
+#endif
+
+#if PULSE_BACKEND == PULSE_BACKEND_PCNT
+#define SELFTEST_BACKEND "PCNT"
+#elif PULSE_BACKEND == PULSE_BACKEND_SAMPLER
+#define SELFTEST_BACKEND "SAMPLER"
+#else
+#define SELFTEST_BACKEND "ISR"
+#endif
+
+#if PULSE_BACKEND == PULSE_BACKEND_ISR && CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+#define SELFTEST_DISPATCH "isr"     // Validation anti-rebond dans l'ISR esp_timer (CORE_PULSE)
+#else
+#define SELFTEST_DISPATCH "task"    // Validation dans une tâche (esp_timer, échantillonneur)
+#endif
+
+#define SELFTEST_RMT_HZ    1000000  // Résolution du générateur : 1 tick = 1 µs
+#define SELFTEST_MAX_TICKS 32767    // Durée max d'une demi-période de symbole (15 bits)
+
+static const char *TAG = "SELFTEST";       // Identifiant de log du module
+
+static const uint32_t freqs[] = SELFTEST_FREQS_HZ;     // Paliers du balayage
+#define FREQ_COUNT ((int)(sizeof(freqs) / sizeof(freqs[0])))
+
+/**
+ * @brief Générateur associé à un compteur.
+ */
+typedef struct {
+    int idx;                        // Indice du compteur dans la table
+    rmt_channel_handle_t tx;        // Canal RMT rebouclé sur son GPIO
+} selftest_gen_t;
+
+static selftest_gen_t gens[SELFTEST_MAX_CHANNELS]; // Compteurs générés
+static int gen_count;                              // Nombre de générateurs prêts
+static rmt_encoder_handle_t encoder;               // Copie brute des symboles
+static rmt_symbol_word_t train[SELFTEST_MAX_SYMBOLS]; // Train du palier en cours, partagé par les canaux
+static volatile uint32_t idle_loops[portNUM_PROCESSORS]; // Passages dans la boucle idle, par cœur
+static float idle_rate[portNUM_PROCESSORS];        // Passages par µs au repos (référence)
+static char report[SELFTEST_JSON_MAX];             // Rapport JSON, hors pile
+static atomic_bool net_load_on;                    // Charge réseau demandée
+static _Atomic uint32_t net_load_bytes;            // Octets envoyés par la charge réseau
+static TaskHandle_t net_load_owner;                // Tâche du banc, réveillée à l'arrêt de la charge
+
+/**
+ * @brief Hook idle : compte les passages du cœur courant.
+ */
+static bool idle_hook(void)
+{
+    idle_loops[xPortGetCoreID()]++;    // Chaque cœur n'écrit que sa propre case
+    return false;                      // Rappelé en boucle tant que le cœur est inactif
+}
+
+void selftest_prepare(void)
+{
+    for (int i = 0; i < channel_count; i++)
+    {
+        channels[i].debounce_us = SELFTEST_DEBOUNCE_US; // Non sauvegardé : storage_save_config n'est pas appelé
+    }
+}
+
+/**
+ * @brief Crée un canal RMT rebouclé par compteur câblé sur un GPIO capable de sortie.
+ */
+static void init_generators(void)
+{
+    rmt_copy_encoder_config_t enc_cfg = {};
+    if (rmt_new_copy_encoder(&enc_cfg, &encoder) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Encodeur RMT indisponible");
+        return;
+    }
+
+    for (int i = 0; i < channel_count && gen_count < SELFTEST_MAX_CHANNELS; i++)
+    {
+        int pin = channels[i].pin;
+        if (pin < 0 || !gpio_pulse_pin_valid(pin) || !GPIO_IS_VALID_OUTPUT_GPIO(pin)) // GPIO d'entrée seule, expandeur...
+        {
+            ESP_LOGW(TAG, "Compteur %d : GPIO %d non générable, ignoré", i, pin);
+            continue;
+        }
+
+        rmt_tx_channel_config_t cfg = {
+            .gpio_num = pin,
+            .clk_src = RMT_CLK_SRC_DEFAULT,
+            .resolution_hz = SELFTEST_RMT_HZ,
+            .mem_block_symbols = 64,                     // Un bloc par canal : 8 canaux simultanés
+            .trans_queue_depth = 1,
+            .intr_priority = SELFTEST_RMT_INTR_PRIORITY,
+            .flags.io_loop_back = 1,                     // Sortie renvoyée sur l'entrée du même GPIO
+        };
+        rmt_channel_handle_t tx;
+        if (rmt_new_tx_channel(&cfg, &tx) != ESP_OK || rmt_enable(tx) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "Compteur %d : canal RMT indisponible", i);
+            continue;
+        }
+        gens[gen_count++] = (selftest_gen_t){ i, tx };
+    }
+}
+
+/**
+ * @brief Construit le train d'un palier.
+ *
+ * Chaque impulsion : bounces allers-retours de SELFTEST_BOUNCE_US, puis le niveau haut
+ * stable et le niveau bas sur le reste de la période (rapport cyclique 50 %).
+ *
+ * @param hz      Fréquence des impulsions
+ * @param bounces Rebonds par front montant
+ * @param pulses  Impulsions du train (sortie)
+ * @return Nombre de symboles, 0 si les niveaux stables seraient plus courts que 1,5 × l'anti-rebond
+ */
+static size_t build_train(uint32_t hz, int bounces, uint32_t *pulses)
+{
+    uint32_t period = SELFTEST_RMT_HZ / hz;
+    uint32_t bounce = 2 * SELFTEST_BOUNCE_US * bounces;
+    uint32_t low = period - period / 2;
+    uint32_t min = SELFTEST_DEBOUNCE_US * 3 / 2;   // Marge : une impulsion plus courte peut être rejetée à juste titre
+
+    if (period / 2 < bounce + min || low < min || low > SELFTEST_MAX_TICKS) return 0;
+    uint32_t high = period / 2 - bounce;
+
+    uint32_t n = hz * SELFTEST_STEP_MS / 1000;
+    uint32_t max = SELFTEST_MAX_SYMBOLS / (uint32_t)(bounces + 1);
+    if (n > max) n = max;                          // Palier raccourci : le train tient dans SELFTEST_MAX_SYMBOLS
+
+    size_t k = 0;
+    for (uint32_t p = 0; p < n; p++)
+    {
+        for (int b = 0; b < bounces; b++)
+        {
+            train[k++] = (rmt_symbol_word_t){ .level0 = 1, .duration0 = SELFTEST_BOUNCE_US,
+                                              .level1 = 0, .duration1 = SELFTEST_BOUNCE_US };
+        }
+        train[k++] = (rmt_symbol_word_t){ .level0 = 1, .duration0 = high, .level1 = 0, .duration1 = low };
+    }
+    *pulses = n;
+    return k;
+}
+
+/**
+ * @brief Mesure le rythme de la boucle idle de chaque cœur au repos.
+ */
+static void calibrate_idle(void)
+{
+    uint32_t start[portNUM_PROCESSORS];
+    for (int c = 0; c < portNUM_PROCESSORS; c++) start[c] = idle_loops[c];
+    int64_t t0 = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(SELFTEST_IDLE_CAL_MS));
+    float elapsed = (float)(esp_timer_get_time() - t0);
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        idle_rate[c] = (float)(idle_loops[c] - start[c]) / elapsed;
+    }
+}
+
+/**
+ * @brief Exécute un palier et ajoute son résultat au rapport.
+ *
+ * @param chans  Nombre de générateurs utilisés (les premiers de gens[])
+ * @param n      Position d'écriture dans le rapport (mise à jour)
+ * @param lat_us Plus grand délai front → validation du palier (sortie, 0 sans PULSE_STATS)
+ * @return -1 palier irréalisable (ignoré), 0 toutes les impulsions comptées, 1 pertes ou excédents
+ */
+static int run_step(uint32_t hz, int bounces, int chans, size_t *n, uint32_t *lat_us)
+{
+    uint32_t sent;
+    size_t count = build_train(hz, bounces, &sent);
+    if (count == 0) return -1;
+
+    uint64_t before[MAX_CHANNELS], after[MAX_CHANNELS], idle0[portNUM_PROCESSORS];
+    counter_store_snapshot(before);
+#if PULSE_STATS
+    for (int g = 0; g < chans; g++) atomic_store(&pulse_stats[gens[g].idx].max_latency_us, 0); // Délai max du seul palier
+#endif
+    for (int c = 0; c < portNUM_PROCESSORS; c++) idle0[c] = idle_loops[c];
+    int64_t t0 = esp_timer_get_time();
+
+    rmt_transmit_config_t tx_cfg = { .loop_count = 0, .flags.eot_level = 0 }; // Ligne basse au repos
+    for (int g = 0; g < chans; g++)
+    {
+        rmt_transmit(gens[g].tx, encoder, train, count * sizeof(train[0]), &tx_cfg);
+    }
+    for (int g = 0; g < chans; g++)
+    {
+        rmt_tx_wait_all_done(gens[g].tx, 2 * SELFTEST_STEP_MS); // Émission ≤ SELFTEST_STEP_MS
+    }
+
+    float elapsed = (float)(esp_timer_get_time() - t0);
+    int load[portNUM_PROCESSORS];
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        float ratio = (idle_rate[c] > 0) ? (float)(idle_loops[c] - idle0[c]) / elapsed / idle_rate[c] : 1.0f;
+        load[c] = (ratio >= 1.0f) ? 0 : (int)(100.0f * (1.0f - ratio) + 0.5f);
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(SELFTEST_SETTLE_MS)); // Dernières validations, lecture PCNT
+    counter_store_snapshot(after);
+
+    uint32_t missed = 0, extra = 0, lat = 0;
+    for (int g = 0; g < chans; g++)
+    {
+        uint32_t got = after[gens[g].idx] - before[gens[g].idx];
+        if (got < sent) missed += sent - got;
+        else extra += got - sent;
+#if PULSE_STATS
+        uint32_t l = atomic_load(&pulse_stats[gens[g].idx].max_latency_us);
+        if (l > lat) lat = l;
+#endif
+    }
+    *lat_us = lat;
+
+    if (*n < sizeof(report))
+    {
+        *n += snprintf(report + *n, sizeof(report) - *n,
+                       "{\"hz\":%lu,\"bounces\":%d,\"ch\":%d,\"sent\":%lu,\"missed\":%lu,\"extra\":%lu,\"load\":[",
+                       (unsigned long)hz, bounces, chans, (unsigned long)sent,
+                       (unsigned long)missed, (unsigned long)extra);
+    }
+    for (int c = 0; c < portNUM_PROCESSORS && *n < sizeof(report); c++)
+    {
+        *n += snprintf(report + *n, sizeof(report) - *n, "%s%d", c ? "," : "", load[c]);
+    }
+    if (*n < sizeof(report)) *n += snprintf(report + *n, sizeof(report) - *n, "]");
+#if PULSE_STATS
+    if (*n < sizeof(report)) *n += snprintf(report + *n, sizeof(report) - *n, ",\"lat_max_us\":%lu", (unsigned long)lat);
+#endif
+    if (*n < sizeof(report)) *n += snprintf(report + *n, sizeof(report) - *n, "},");
+
+    ESP_LOGI(TAG, "%5lu Hz, %d rebond(s), %d compteur(s) : %lu émises, %lu perdues, %lu en trop, charge %d%%/%d%%",
+             (unsigned long)hz, bounces, chans, (unsigned long)sent, (unsigned long)missed,
+             (unsigned long)extra, load[0], load[portNUM_PROCESSORS - 1]);
+    return (missed || extra) ? 1 : 0;
+}
+
+/**
+ * @brief Tâche de charge réseau : datagrammes diffusés en continu tant que net_load_on.
+ *
+ * Sur CORE_NET, à la priorité de task_mqtt : Wi-Fi, LwIP et cette tâche se partagent le
+ * cœur réseau comme pendant une rafale de publications. Une file d'émission pleine
+ * (ENOMEM) cède le cœur un tick.
+ */
+static void task_net_load(void *pv)
+{
+    static uint8_t payload[SELFTEST_NET_PAYLOAD]; // Contenu indifférent
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock >= 0)
+    {
+        int on = 1;
+        setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+        struct sockaddr_in dest = {
+            .sin_family = AF_INET,
+            .sin_port = htons(SELFTEST_NET_PORT),
+            .sin_addr.s_addr = htonl(INADDR_BROADCAST),
+        };
+        while (atomic_load(&net_load_on))
+        {
+            int sent = sendto(sock, payload, sizeof(payload), 0, (struct sockaddr *)&dest, sizeof(dest));
+            if (sent > 0) atomic_fetch_add(&net_load_bytes, (uint32_t)sent);
+            else vTaskDelay(1);
+        }
+        close(sock);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Charge réseau : socket UDP indisponible");
+    }
+    xTaskNotifyGive(net_load_owner);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Rejoue le palier SELFTEST_JITTER_HZ au repos puis sous charge réseau.
+ *
+ * @param n Position d'écriture dans le rapport (mise à jour)
+ */
+static void run_jitter(size_t *n)
+{
+    uint32_t lat_idle, lat_net = 0, kbps = 0;
+    run_step(SELFTEST_JITTER_HZ, 0, gen_count, n, &lat_idle);
+
+    net_load_owner = xTaskGetCurrentTaskHandle();
+    atomic_store(&net_load_bytes, 0);
+    atomic_store(&net_load_on, true);
+    int64_t t0 = esp_timer_get_time();
+    if (xTaskCreatePinnedToCore(task_net_load, "selftest_net", 3072, NULL, SELFTEST_NET_PRIORITY, NULL, CORE_NET) == pdPASS)
+    {
+        run_step(SELFTEST_JITTER_HZ, 0, gen_count, n, &lat_net);
+        atomic_store(&net_load_on, false);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Socket fermé
+        int64_t elapsed_ms = (esp_timer_get_time() - t0) / 1000;
+        if (elapsed_ms > 0) kbps = (uint32_t)((uint64_t)atomic_load(&net_load_bytes) * 8 / (uint64_t)elapsed_ms);
+    }
+    else
+    {
+        atomic_store(&net_load_on, false);
+        ESP_LOGW(TAG, "Charge réseau : tâche non créée");
+    }
+
+    uint32_t jit_idle = lat_idle > SELFTEST_DEBOUNCE_US ? lat_idle - SELFTEST_DEBOUNCE_US : 0;
+    uint32_t jit_net = lat_net > SELFTEST_DEBOUNCE_US ? lat_net - SELFTEST_DEBOUNCE_US : 0;
+    if (*n < sizeof(report) && report[*n - 1] == ',') (*n)--; // Virgule du dernier palier
+    if (*n < sizeof(report))
+    {
+        *n += snprintf(report + *n, sizeof(report) - *n,
+                       "],\"jitter\":{\"hz\":%d,\"net_kbps\":%lu", SELFTEST_JITTER_HZ, (unsigned long)kbps);
+    }
+#if PULSE_STATS
+    if (*n < sizeof(report))
+    {
+        *n += snprintf(report + *n, sizeof(report) - *n, ",\"idle_us\":%lu,\"net_us\":%lu",
+                       (unsigned long)jit_idle, (unsigned long)jit_net);
+    }
+    ESP_LOGI(TAG, "Gigue de validation : %lu µs au repos, %lu µs sous charge réseau (%lu kbit/s)",
+             (unsigned long)jit_idle, (unsigned long)jit_net, (unsigned long)kbps);
+#else
+    (void)jit_idle;
+    (void)jit_net;
+#endif
+    if (*n < sizeof(report)) *n += snprintf(report + *n, sizeof(report) - *n, "}");
+}
+
+/**
+ * @brief Tâche du banc : balayage complet, restauration des compteurs, rapport.
+ */
+static void task_selftest(void *pv)
+{
+    for (int t = 0; t < SELFTEST_MQTT_WAIT_S && !mqtt_is_connected(); t++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1000)); // Référence idle mesurée avec le Wi-Fi déjà associé
+    }
+
+    init_generators();
+    if (gen_count == 0)
+    {
+        ESP_LOGE(TAG, "Aucun compteur générable, banc annulé");
+        vTaskDelete(NULL);
+    }
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) esp_register_freertos_idle_hook_for_cpu(idle_hook, c);
+    calibrate_idle();
+
+    uint64_t saved[MAX_CHANNELS];
+    counter_store_snapshot(saved);   // Valeurs réelles, remises en place après le banc
+
+    size_t n = snprintf(report, sizeof(report),
+                        "{\"backend\":\"" SELFTEST_BACKEND "\",\"dispatch\":\"" SELFTEST_DISPATCH "\",\"debounce_us\":%d,\"bounce_us\":%d,\"channels\":%d,\"steps\":[",
+                        SELFTEST_DEBOUNCE_US, SELFTEST_BOUNCE_US, gen_count);
+
+    static const char *const names[2][2] = { { "single", "all" }, { "single_bounce", "all_bounce" } };
+    uint32_t max_hz[2][2] = { { 0 } };
+    for (int profile = 0; profile < 2; profile++)
+    {
+        for (int mode = 0; mode < 2; mode++)
+        {
+            bool failed = false;
+            for (int f = 0; f < FREQ_COUNT; f++)
+            {
+                uint32_t lat;
+                int res = run_step(freqs[f], profile ? SELFTEST_BOUNCES : 0, mode ? gen_count : 1, &n, &lat);
+                if (res == 1) failed = true;
+                if (res == 0 && !failed) max_hz[profile][mode] = freqs[f]; // Dernier palier avant la première perte
+            }
+        }
+    }
+
+    run_jitter(&n);
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) esp_deregister_freertos_idle_hook_for_cpu(idle_hook, c);
+    counter_store_set_all(saved);
+    storage_request_save();
+
+    if (n < sizeof(report))
+    {
+        n += snprintf(report + n, sizeof(report) - n,
+                      ",\"max_hz\":{\"%s\":%lu,\"%s\":%lu,\"%s\":%lu,\"%s\":%lu}}",
+                      names[0][0], (unsigned long)max_hz[0][0], names[0][1], (unsigned long)max_hz[0][1],
+                      names[1][0], (unsigned long)max_hz[1][0], names[1][1], (unsigned long)max_hz[1][1]);
+    }
+    if (n >= sizeof(report)) ESP_LOGW(TAG, "Rapport tronqué (SELFTEST_JSON_MAX)");
+
+    ESP_LOGI(TAG, "%s", report);
+    if (mqtt_is_connected()) mqtt_publish_selftest(report);
+    vTaskDelete(NULL);
+}
+
+void selftest_start(void)
+{
+    xTaskCreatePinnedToCore(
+        task_selftest,
+        "task_selftest",
+        4096,
+        NULL,
+        3,                // Sous la tâche MQTT et le bouton : n'interfère pas avec le comptage
+        NULL,
+        CORE_NET);        // Générateur et charge réseau hors du cœur de comptage
+}
+
+#else
+
+void selftest_prepare(void) {}
+void selftest_start(void) {}
+
+#endif // PULSE_SELFTEST
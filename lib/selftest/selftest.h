@@ -0,0 +1,41 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+/**
+ * @file selftest.h
+ * @brief Banc de débit du comptage sur cible : générateur d'impulsions interne (RMT).
+ *
+ * Avec PULSE_SELFTEST (config.h), chaque entrée de comptage câblée sur un GPIO capable
+ * de sortie reçoit un canal RMT en émission, rebouclé sur l'entrée par la matrice GPIO
+ * (io_loop_back) : le moteur de comptage voit le train généré comme un signal externe.
+ *
+ * Le banc balaie les fréquences SELFTEST_FREQS_HZ, sans puis avec rebonds, sur un seul
+ * compteur puis sur tous à la fois, et compare pour chaque palier les impulsions émises
+ * aux incréments des compteurs. La charge de chaque cœur est mesurée par les hooks idle.
+ * Un dernier palier (SELFTEST_JITTER_HZ, tous les compteurs) est rejoué sous un flot UDP
+ * émis depuis CORE_NET : le rapport donne la gigue de validation au repos et sous charge
+ * réseau (PULSE_STATS) et le débit de la charge.
+ * Le rapport JSON est publié sur energie/<DEVICE_NAME>/selftest et écrit dans les logs.
+ *
+ * Les compteurs sont remis à leur valeur d'avant le banc à la fin du balayage.
+ *
+ * Sans PULSE_SELFTEST, toutes les fonctions sont sans effet.
+ *
+ * Usage typique :
+ * 1. selftest_prepare() avant gpio_init_pulses()
+ * 2. selftest_start() une fois les tâches de comptage et MQTT créées
+ */
+
+/**
+ * @brief Impose l'anti-rebond du banc (SELFTEST_DEBOUNCE_US) aux compteurs actifs.
+ *
+ * Modification en RAM seulement : la configuration enregistrée n'est pas touchée.
+ */
+void selftest_prepare(void);
+
+/**
+ * @brief Lance la tâche du banc (CORE_NET, faible priorité).
+ */
+void selftest_start(void);
+
+#endif // SELFTEST_H
@@ -9,97 +9,304 @@
  * - Le mode de configuration actuel (normal ou AP)
  *
  * Il fournit des fonctions pour initialiser la mémoire NVS, charger les paramètres à partir de celle-ci et sauvegarder les modifications.
+ *
+ * Les valeurs des compteurs ne sont plus écrites clé par clé dans la NVS : chaque sauvegarde ajoute
+ * un instantané de tous les compteurs au journal circulaire de la partition "journal" (lib/journal).
+ * Les anciennes clés NVS "c0".."c4" ne sont plus lues qu'une fois, pour migrer un appareil existant.
+ * Les instantanés gardent 48 bits par compteur (counter_pack48) ; ceux de la version 1 (32 bits)
+ * sont relus au démarrage et le suivant est écrit au format courant.
+ * Avec POWER_FAIL, une coupure d'alimentation écrit en plus un enregistrement unique dans la
+ * partition "pfail" (storage_emergency_save) ; il est repris au démarrage s'il est plus récent que
+ * le journal.
+ *
+ * De même, les paramètres (Wi-Fi, MQTT, table et règles des compteurs) forment un seul blob NVS
+ * "app/cfg" versionné et protégé par CRC, lu en une fois au démarrage et réécrit en entier par
+ * storage_save_config(). L'ancien format, une clé par paramètre, est migré au premier démarrage,
+ * de même que le blob de version 1 (cinq compteurs fixes, sans table des compteurs).
+ * Le mode de configuration (normal ou AP) reste une clé à part : c'est un drapeau basculé par le
+ * bouton BOOT, pas un paramètre.
  */
 
+#include <string.h>          // Pour memcpy, strcpy
+#include <stdlib.h>          // Pour malloc, free
+#include <stddef.h>          // Pour offsetof
 #include "storage.h"         // Header du module storage pour les prototypes
 #include "nvs_flash.h"       // Fonctions NVS pour initialiser la mémoire flash
 #include "nvs.h"             // Fonctions NVS pour lire/écrire des valeurs
 #include "esp_log.h"         // Fonctions ESP_LOG pour debug
 #include "gpio_pulse.h"      // Pour accéder au tableau global counters
-#include "config.h"          // Pour NB_COUNTERS et global_mode_config  
+#include "config.h"          // Pour la table des compteurs et global_mode_config
+#include "counter_store.h"   // Stockage sans verrou des compteurs
+#include "journal.h"         // Journal circulaire des compteurs en flash
+#include "esp_rom_crc.h"     // CRC32 du blob de configuration
+#include "esp_attr.h"        // Attribut IRAM_ATTR
+#include "freertos/FreeRTOS.h" // Types FreeRTOS
+#include "freertos/semphr.h" // Mutex d'accès au journal
+#include "freertos/task.h"   // Réveil de la tâche de sauvegarde
+#include "freertos/event_groups.h" // Fin du chargement des compteurs
+
+#define COUNTERS_RECORD_VERSION 2 // Version du format d'instantané des compteurs dans le journal (valeurs sur 48 bits)
+#define COUNTERS_RECORD_VERSION_1 1 // Premier format : valeurs sur 32 bits
+#define COUNTERS_SLOT_SIZE      256 // Taille d'un slot du journal : une page flash
+#define STORAGE_COUNTERS_LOADED_BIT BIT0 // Compteurs restaurés dans counter_store
+
+#define APP_CONFIG_NAMESPACE "app"   // Espace NVS du blob de configuration
+#define APP_CONFIG_KEY       "cfg"   // Clé du blob de configuration
+#define APP_CONFIG_VERSION   2       // Version du format du blob (à incrémenter si app_config_hdr_t, channel_cfg_t ou publish_cfg_t change)
+#define APP_CONFIG_VERSION_1 1       // Premier format du blob : cinq compteurs, noms seuls
+#define LEGACY_CHANNEL_COUNT 5       // Nombre de compteurs des formats précédents (NB_COUNTERS)
+
+#define PFAIL_MAGIC 0x324C4650       // "PFL2" : enregistrement de coupure présent (valeurs sur 64 bits)
+#define PFAIL_MAGIC_V1 0x4C494650    // "PFIL" : enregistrement d'une version précédente (valeurs sur 32 bits)
+#define PFAIL_BLANK 0xFFFFFFFF       // Premier mot d'un secteur effacé
+
+/**
+ * @brief Instantané de tous les compteurs, tel qu'écrit dans le journal.
+ */
+typedef struct {
+    uint16_t version;               ///< COUNTERS_RECORD_VERSION
+    uint16_t count;                 ///< Nombre de compteurs enregistrés
+    uint8_t values[COUNTER_PACK48_SIZE(MAX_CHANNELS)]; ///< Valeurs des compteurs sur 48 bits (COUNTER_PACK48_SIZE(count) octets écrits)
+} counters_record_t;
+
+/**
+ * @brief Enregistrement de coupure d'alimentation, écrit en une fois au début de la partition "pfail".
+ *
+ * Taille fixe : une seule programmation flash, sans calcul de longueur dans l'urgence.
+ */
+typedef struct {
+    uint32_t magic;                 ///< PFAIL_MAGIC
+    uint32_t seq;                   ///< Séquence du dernier instantané du journal au moment de la coupure
+    uint32_t count;                 ///< Nombre de compteurs enregistrés
+    uint32_t reserved;              ///< Alignement des valeurs
+    uint64_t values[MAX_CHANNELS];  ///< Valeurs des compteurs
+    uint32_t crc;                   ///< CRC32 de tous les champs précédents
+} pfail_record_t;
+
+/**
+ * @brief Enregistrement de coupure d'une version précédente (PFAIL_MAGIC_V1), relu au premier démarrage.
+ */
+typedef struct {
+    uint32_t magic;                 ///< PFAIL_MAGIC_V1
+    uint32_t seq;                   ///< Séquence du dernier instantané du journal au moment de la coupure
+    uint32_t count;                 ///< Nombre de compteurs enregistrés
+    uint32_t values[MAX_CHANNELS];  ///< Valeurs des compteurs
+    uint32_t crc;                   ///< CRC32 de tous les champs précédents
+} pfail_record_v1_t;
+
+/**
+ * @brief Paramètres généraux de l'appareil, en tête du blob de configuration (communs à toutes les versions).
+ */
+typedef struct {
+    uint16_t version;                   ///< APP_CONFIG_VERSION
+    uint8_t mqtt_batch;                 ///< Mode de publication (MQTT_BATCH_xxx)
+    uint8_t channel_count;              ///< Nombre de compteurs actifs (0 en version 1)
+    char wifi_ssid[32];                 ///< SSID Wi-Fi
+    char wifi_pass[64];                 ///< Mot de passe Wi-Fi
+    char wifi_ip[16];                   ///< Adresse IP statique (vide = DHCP)
+    char wifi_gw[16];                   ///< Passerelle
+    char wifi_mask[16];                 ///< Masque de sous-réseau
+    char wifi_dns[16];                  ///< Serveur DNS
+    char mqtt_server[64];               ///< Adresse du broker
+    char mqtt_user[32];                 ///< Utilisateur MQTT
+    char mqtt_pass[32];                 ///< Mot de passe MQTT
+    char mqtt_port[8];                  ///< Port du broker
+} app_config_hdr_t;
+
+/**
+ * @brief Paramètres de l'appareil, tels qu'écrits dans le blob de configuration.
+ *
+ * Le blob est lu en une seule fois au démarrage et réécrit en entier à chaque sauvegarde :
+ * une sauvegarde interrompue laisse l'ancien blob intact (remplacement atomique par la NVS),
+ * un blob altéré est détecté par son CRC.
+ *
+ * Le nombre d'entrées des deux tables vaut le MAX_CHANNELS du firmware qui l'a écrit : il se déduit
+ * de la taille du blob (en-tête + n × APP_CONFIG_SLOT_SIZE + CRC). Un blob écrit avec une autre
+ * capacité reste lisible par load_config_blob.
+ */
+typedef struct {
+    app_config_hdr_t hdr;               ///< Paramètres généraux
+    channel_cfg_t channels[MAX_CHANNELS]; ///< Table des compteurs
+    publish_cfg_t publish[MAX_CHANNELS]; ///< Règles de publication des compteurs
+    uint32_t crc;                       ///< CRC32 de tous les champs précédents
+} app_config_t;
+
+#define APP_CONFIG_SLOT_SIZE (sizeof(channel_cfg_t) + sizeof(publish_cfg_t)) // Octets d'un compteur dans le blob
+
+_Static_assert(offsetof(app_config_t, publish) == sizeof(app_config_hdr_t) + MAX_CHANNELS * sizeof(channel_cfg_t) &&
+               sizeof(app_config_t) == sizeof(app_config_hdr_t) + MAX_CHANNELS * APP_CONFIG_SLOT_SIZE + sizeof(uint32_t),
+               "Le blob de configuration doit être compact : sa taille donne le nombre de compteurs enregistrés");
+
+/**
+ * @brief Résultat de la lecture du blob de configuration.
+ */
+typedef enum {
+    CONFIG_BLOB_NONE,       ///< Pas de blob (appareil neuf ou ancien format clé par clé)
+    CONFIG_BLOB_OK,         ///< Blob au format courant, chargé
+    CONFIG_BLOB_MIGRATED,   ///< Blob de version 1, chargé, à réécrire au format courant
+    CONFIG_BLOB_INVALID,    ///< Blob présent mais illisible : jamais écrasé ni effacé automatiquement
+} config_blob_t;
+
+/**
+ * @brief Blob de configuration de version 1 (relu une seule fois pour migration).
+ */
+typedef struct {
+    app_config_hdr_t hdr;               ///< Paramètres généraux
+    char names[LEGACY_CHANNEL_COUNT][32]; ///< Noms MQTT des compteurs
+    publish_cfg_t publish[LEGACY_CHANNEL_COUNT]; ///< Règles de publication des compteurs
+    uint32_t crc;                       ///< CRC32 de tous les champs précédents
+} app_config_v1_t;
 
 static const char *TAG = "STORAGE"; // Tag pour les logs du module storage
 
+static journal_t counters_journal;      // Journal des instantanés de compteurs
+static SemaphoreHandle_t journal_mutex; // Sérialise les ajouts au journal (tâche compteur, serveur web)
+static EventGroupHandle_t storage_events; // Signale la fin de la restauration des compteurs
+static TaskHandle_t saver_task;           // Tâche de sauvegarde, réveillée par storage_request_save()
+#if POWER_FAIL
+static const esp_partition_t *pfail_part; // Partition de la sauvegarde d'urgence
+static bool pfail_locked;                 // Journal verrouillé par storage_emergency_save()
+#endif
+
 char wifi_ssid[32] = {0}; // SSID Wi-Fi
 char wifi_pass[64] = {0}; // MQTT configuration
-char mqtt_names[NB_COUNTERS][32] = { 
-    "compteur0",
-    "compteur1",
-    "compteur2",
-    "compteur3",
-    "compteur4"
-}; // Noms des compteurs pour MQTT, chargés depuis NVS ou par défaut
+uint8_t channel_count = DEFAULT_CHANNEL_COUNT; // Nombre de compteurs actifs, chargé depuis la NVS
+uint8_t channel_count_next = DEFAULT_CHANNEL_COUNT; // Nombre de compteurs enregistré, actif au prochain démarrage
+channel_cfg_t channels[MAX_CHANNELS]; // Table des compteurs, chargée depuis la NVS ou par défaut (set_channel_defaults)
 uint8_t global_mode_config = 1; // Mode de configuration (0 = normal, 1 = AP)    
 
+char wifi_ip[16] = {0};   // Adresse IP statique (vide = DHCP)
+char wifi_gw[16] = {0};   // Passerelle de l'adresse statique
+char wifi_mask[16] = {0}; // Masque de sous-réseau de l'adresse statique
+char wifi_dns[16] = {0};  // Serveur DNS de l'adresse statique (passerelle si vide)
+
 char mqtt_Server[64]= {"192.168.1.1"} ;   // URI du broker MQTT
 char mqtt_user[32]= {0}  ;               // Nom d'utilisateur MQTT
 char mqtt_pass[32] = {0};                // Password MQTT
 char mqtt_port[8] = {"1883"}; // Port du server MQTT
+publish_cfg_t publish_cfg[MAX_CHANNELS]; // Règles de publication de chaque compteur, chargées depuis NVS ou par défaut
+uint8_t mqtt_batch_mode = MQTT_BATCH_DEFAULT; // Mode de publication des compteurs (un message par compteur ou groupé)
 
 /**
- * @brief Initialise la mémoire NVS et charge les paramètres de configuration.
+ * @brief Remplit la table des compteurs et leurs règles de publication avec les valeurs par défaut.
  *
- * Cette fonction effectue plusieurs tâches :
- * 1. Initialise la mémoire NVS en gérant les erreurs courantes comme l'absence de pages libres ou une nouvelle version incompatibilité.
- * 2. Charge les compteurs depuis la mémoire NVS, initialisant ceux qui ne sont pas trouvés à zéro.
- * 3. Charge le SSID et le mot de passe Wi-Fi depuis la mémoire NVS, utilisant des valeurs par défaut si ces paramètres ne sont pas trouvés.
- * 4. Charge les paramètres MQTT (URI du broker, port, nom d'utilisateur et mot de passe) depuis la mémoire NVS, utilisant des valeurs par défaut si nécessaire.
- * 5. Charge le mode de configuration actuel (normal ou AP) depuis la mémoire NVS, initialisant à 0 (mode normal) si ce paramètre n'est pas trouvé.
+ * Les compteurs 0 à 4 reprennent le câblage historique (DEFAULT_PULSE_PINS), les suivants
+ * ne sont pas câblés tant que leur GPIO n'est pas saisi dans la page de configuration.
+ */
+static void set_channel_defaults(void)
+{
+    static const int8_t default_pins[] = DEFAULT_PULSE_PINS; // GPIO d'un appareil neuf
+
+    channel_count = DEFAULT_CHANNEL_COUNT;
+    for (int i = 0; i < MAX_CHANNELS; i++)
+    {
+        channels[i] = (channel_cfg_t){
+            .pin = (i < (int)sizeof(default_pins)) ? default_pins[i] : -1,
+            .ppkwh = PULSES_PER_KWH,
+            .debounce_us = DEBOUNCE_US,
+        };
+        snprintf(channels[i].name, sizeof(channels[i].name), "compteur%d", i);
+
+        publish_cfg[i] = (publish_cfg_t){
+            .delta = PUBLISH_DEFAULT_DELTA,
+            .min_s = PUBLISH_DEFAULT_MIN_S,
+            .max_s = PUBLISH_DEFAULT_MAX_S,
+            .deadband_w = PUBLISH_DEFAULT_DEADBAND_W,
+        };
+    }
+}
+
+/**
+ * @brief Lit une règle de publication d'un compteur dans la NVS.
  *
- * Cette fonction est appelée au démarrage du système pour s'assurer que tous les paramètres sont correctement chargés et disponibles.
+ * La valeur par défaut déjà présente dans *value est conservée si la clé n'existe pas.
+ *
+ * @param handle Handle NVS ouvert sur "counters"
+ * @param prefix Préfixe de la clé ("pd", "pn", "px", "pb")
+ * @param i      Index du compteur
+ * @param value  Valeur lue (entrée : valeur par défaut)
  */
-void nvs_init_and_load(void)
+static void load_publish_rule(nvs_handle_t handle, const char *prefix, int i, uint32_t *value)
 {
-    // --- Initialisation NVS ---
-    esp_err_t ret = nvs_flash_init(); // Initialise la NVS
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) // Si la NVS est corrompue ou incompatible, on efface et réinitialise
+    char key[8]; // Clé de la règle (ex : "pd0")
+    snprintf(key, sizeof(key), "%s%d", prefix, i);
+    esp_err_t ret = nvs_get_u32(handle, key, value); // Valeur par défaut conservée si absente
+    if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND)
     {
-        ESP_ERROR_CHECK(nvs_flash_erase()); // Efface la NVS
-        ret = nvs_flash_init(); // Réinitialise la NVS après effacement
+        ESP_LOGW(TAG, "Erreur lecture NVS %s", key); // Log d'avertissement
     }
-    ESP_ERROR_CHECK(ret); // Vérifie que l'initialisation a réussi
+}
+
+/**
+ * @brief Lit une chaîne optionnelle dans la NVS (chaîne vide si absente ou illisible).
+ *
+ * @param handle Handle NVS ouvert
+ * @param key    Clé à lire
+ * @param dst    Buffer de destination
+ * @param size   Taille du buffer
+ */
+static void load_optional_str(nvs_handle_t handle, const char *key, char *dst, size_t size)
+{
+    size_t len = size; // Taille du buffer
+    if (nvs_get_str(handle, key, dst, &len) != ESP_OK) // Absente : option désactivée
+    {
+        dst[0] = '\0';
+    }
+}
+
+/**
+ * @brief CRC32 d'un blob de configuration (tous les champs précédant le CRC).
+ *
+ * @param cfg     Blob (toutes versions)
+ * @param crc_off Position du champ crc dans le blob
+ */
+static uint32_t app_config_crc(const void *cfg, size_t crc_off)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)cfg, crc_off);
+}
+
+/**
+ * @brief Charge les paramètres depuis l'ancien format, une clé NVS par paramètre (migration).
+ *
+ * 1. Charge les noms MQTT et règles de publication des cinq compteurs de l'ancien format depuis l'espace "counters".
+ * 2. Charge le SSID et le mot de passe Wi-Fi depuis la mémoire NVS, utilisant des valeurs par défaut si ces paramètres ne sont pas trouvés,
+ *    ainsi que l'adresse IP statique optionnelle.
+ * 3. Charge les paramètres MQTT (URI du broker, port, nom d'utilisateur, mot de passe et mode de publication) depuis la mémoire NVS, utilisant des valeurs par défaut si nécessaire.
+ *
+ * Sur un appareil neuf, aucune clé n'existe : ce chargement conserve les valeurs par défaut
+ * (set_channel_defaults) et fournit celles du Wi-Fi et du MQTT.
+ */
+static void load_legacy_settings(void)
+{
+    esp_err_t ret; // Résultat des lectures NVS
+
+    // --- Chargement des paramètres des compteurs ---
+    channel_count = LEGACY_CHANNEL_COUNT; // L'ancien format a toujours cinq compteurs
 
-    // --- Chargement des compteurs ---
     nvs_handle_t counters_handle; //    Handle pour accéder à la NVS des compteurs
-    ret = nvs_open("counters", NVS_READWRITE, &counters_handle); // Ouvre la NVS "counters" en mode lecture/écriture
-    if (ret != ESP_OK)  // Si l'ouverture échoue, on log une erreur et on initialise les compteurs à 0
+    ret = nvs_open("counters", NVS_READONLY, &counters_handle); // Ouvre la NVS "counters" en lecture
+    if (ret != ESP_OK)  // Si l'ouverture échoue (premier démarrage), noms et règles par défaut
     {
-        ESP_LOGE(TAG, "Impossible d'ouvrir la NVS counters"); // Log d'erreur
+        ESP_LOGW(TAG, "Impossible d'ouvrir la NVS counters"); // Log d'avertissement
     } 
-    else // Si l'ouverture réussit, on lit les compteurs et les noms MQTT
+    else // Si l'ouverture réussit, on lit les noms MQTT et règles de publication
     {
-        for (int i = 0; i < NB_COUNTERS; i++) { // Pour chaque compteur
-            char key[8]; // Clé pour lire le compteur (ex : "c0", "c1", etc.)
-            snprintf(key, sizeof(key), "c%d", i); // Formate la clé pour le compteur i
-            uint32_t value = 0; // Variable pour stocker la valeur lue de la NVS
-            ret = nvs_get_u32(counters_handle, key, &value); // Tente de lire la valeur du compteur i depuis la NVS
-            if (ret == ESP_OK) // Si la lecture réussit, on stocke la valeur dans le tableau global counters
-            { 
-                counters[i] = value;// Stocke la valeur lue dans le tableau global counters
-            } 
-            else if (ret == ESP_ERR_NVS_NOT_FOUND) // Si la clé n'est pas trouvée dans la NVS, on initialise le compteur à 0
-            {
-                counters[i] = 0; // Initialise à 0 si non trouvé
-            } 
-            else // Si une autre erreur survient lors de la lecture, on log une erreur et on initialise le compteur à 0
-            {
-                ESP_LOGW(TAG, "Erreur lecture NVS compteur %d", i);// Log d'avertissement
-                counters[i] = 0; // Initialise à 0 en cas d'erreur
-            }
+        for (int i = 0; i < LEGACY_CHANNEL_COUNT; i++) { // Pour chaque compteur
+            // --- Règles de publication (valeurs par défaut si absentes) ---
+            load_publish_rule(counters_handle, "pd", i, &publish_cfg[i].delta);
+            load_publish_rule(counters_handle, "pn", i, &publish_cfg[i].min_s);
+            load_publish_rule(counters_handle, "px", i, &publish_cfg[i].max_s);
+            load_publish_rule(counters_handle, "pb", i, &publish_cfg[i].deadband_w);
 
             // --- Lecture des noms MQTT ---
             char mqtt_key[8]; // Clé pour lire le nom MQTT (ex : "m0", "m1", etc.)
             snprintf(mqtt_key, sizeof(mqtt_key), "m%d", i); // Formate la clé pour le nom MQTT du compteur i
-            size_t len = sizeof(mqtt_names[i]); // Taille du buffer pour lire le nom MQTT
-            ret = nvs_get_str(counters_handle, mqtt_key, mqtt_names[i], &len); // Tente de lire le nom MQTT depuis la NVS
-            if (ret == ESP_ERR_NVS_NOT_FOUND) // Si la clé n'est pas trouvée dans la NVS, on initialise le nom MQTT à une valeur par défaut (ex : "compteur0", "compteur1", etc.)
-            { 
-                mqtt_names[i][0] = ' '; // Vide si non trouvé
-            }
-            else if (ret != ESP_OK)  // Si une autre erreur survient lors de la lecture, on log une erreur et on initialise le nom MQTT à une valeur par défaut
+            size_t len = sizeof(channels[i].name); // Taille du buffer pour lire le nom MQTT
+            ret = nvs_get_str(counters_handle, mqtt_key, channels[i].name, &len); // Tente de lire le nom MQTT depuis la NVS
+            if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) // Clé absente : le nom par défaut ("compteur0", "compteur1", etc.) est conservé
             {
                 ESP_LOGW(TAG, "Erreur lecture NVS nom MQTT %d", i); // Log d'avertissement
-                mqtt_names[i][0] = ' '; // Vide en cas d'erreur
+                snprintf(channels[i].name, sizeof(channels[i].name), "compteur%d", i); // Nom par défaut, même après une lecture partielle
             }
         }
         nvs_close(counters_handle); // Ferme la NVS après lecture
@@ -135,6 +342,12 @@ void nvs_init_and_load(void)
             strcpy(wifi_pass, "TEST_Wifi"); // Valeur par défaut en cas d'erreur
         }
 
+        // Adresse IP statique (optionnelle, DHCP si vide)
+        load_optional_str(wifi_handle, "ip",   wifi_ip,   sizeof(wifi_ip));
+        load_optional_str(wifi_handle, "gw",   wifi_gw,   sizeof(wifi_gw));
+        load_optional_str(wifi_handle, "mask", wifi_mask, sizeof(wifi_mask));
+        load_optional_str(wifi_handle, "dns",  wifi_dns,  sizeof(wifi_dns));
+
         nvs_close(wifi_handle);// Ferme la NVS après lecture
     } 
     else // Si l'ouverture échoue, on log une erreur et on initialise le SSID et le mot de passe à des valeurs par défaut
@@ -197,6 +410,12 @@ void nvs_init_and_load(void)
             ESP_LOGW(TAG, "Erreur lecture NVS password"); // Log d'avertissement
             strcpy(mqtt_pass, " "); //  Valeur par défaut en cas d'erreur
         }
+
+        ret = nvs_get_u8(mqtt_handle, "batch", &mqtt_batch_mode); // Tente de lire le mode de publication depuis la NVS
+        if (ret != ESP_OK || mqtt_batch_mode > MQTT_BATCH_CBOR) // Clé absente, erreur ou valeur inconnue : mode par défaut
+        {
+            mqtt_batch_mode = MQTT_BATCH_DEFAULT;
+        }
         nvs_close(mqtt_handle);// Ferme la NVS après lecture
 
     }
@@ -207,6 +426,274 @@ void nvs_init_and_load(void)
         strcpy(mqtt_port,"1883"); //
         strcpy(mqtt_user, " "); // Valeur par défaut pour le nom d'utilisateur MQTT
         strcpy(mqtt_pass, " "); // Valeur par défaut pour le mot de passe MQTT
+        mqtt_batch_mode = MQTT_BATCH_DEFAULT; // Mode de publication par défaut
+    }
+}
+
+/**
+ * @brief Efface les clés de l'ancien format une fois les paramètres migrés dans le blob.
+ *
+ * Les anciennes valeurs de compteurs "c0".."c4" sont conservées : storage_load_counters() les migre
+ * vers le journal si celui-ci est vide.
+ */
+static void erase_legacy_settings(void)
+{
+    static const char *const wifi_keys[] = { "ssid", "pass", "ip", "gw", "mask", "dns" };
+    static const char *const mqtt_keys[] = { "mqtt_server", "mqtt_port", "mqtt_user", "mqtt_pass", "batch" };
+    static const char *const rule_prefixes[] = { "m", "pd", "pn", "px", "pb" };
+    nvs_handle_t handle; // Handle pour accéder à la NVS
+
+    if (nvs_open("wifi", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        for (size_t k = 0; k < sizeof(wifi_keys) / sizeof(wifi_keys[0]); k++)
+        {
+            nvs_erase_key(handle, wifi_keys[k]); // ESP_ERR_NVS_NOT_FOUND ignoré
+        }
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (nvs_open("mqtt", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        for (size_t k = 0; k < sizeof(mqtt_keys) / sizeof(mqtt_keys[0]); k++)
+        {
+            nvs_erase_key(handle, mqtt_keys[k]);
+        }
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+    if (nvs_open("counters", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        for (int i = 0; i < LEGACY_CHANNEL_COUNT; i++)
+        {
+            for (size_t k = 0; k < sizeof(rule_prefixes) / sizeof(rule_prefixes[0]); k++)
+            {
+                char key[8]; // Clé de l'ancien format (ex : "m0", "pd0")
+                snprintf(key, sizeof(key), "%s%d", rule_prefixes[k], i);
+                nvs_erase_key(handle, key);
+            }
+        }
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
+/**
+ * @brief Copie les paramètres généraux d'un blob dans les variables globales.
+ */
+static void apply_config_hdr(const app_config_hdr_t *hdr)
+{
+    memcpy(wifi_ssid, hdr->wifi_ssid, sizeof(wifi_ssid));
+    memcpy(wifi_pass, hdr->wifi_pass, sizeof(wifi_pass));
+    memcpy(wifi_ip,   hdr->wifi_ip,   sizeof(wifi_ip));
+    memcpy(wifi_gw,   hdr->wifi_gw,   sizeof(wifi_gw));
+    memcpy(wifi_mask, hdr->wifi_mask, sizeof(wifi_mask));
+    memcpy(wifi_dns,  hdr->wifi_dns,  sizeof(wifi_dns));
+    memcpy(mqtt_Server, hdr->mqtt_server, sizeof(mqtt_Server));
+    memcpy(mqtt_user, hdr->mqtt_user, sizeof(mqtt_user));
+    memcpy(mqtt_pass, hdr->mqtt_pass, sizeof(mqtt_pass));
+    memcpy(mqtt_port, hdr->mqtt_port, sizeof(mqtt_port));
+    mqtt_batch_mode = (hdr->mqtt_batch <= MQTT_BATCH_CBOR) ? hdr->mqtt_batch : MQTT_BATCH_DEFAULT;
+}
+
+/**
+ * @brief Charge tous les paramètres depuis le blob de configuration, en une seule lecture NVS.
+ *
+ * Un blob de version 2 est accepté quelle que soit la capacité (MAX_CHANNELS) du firmware qui
+ * l'a écrit : les compteurs au-delà de la capacité courante sont ignorés, ceux qui manquent
+ * gardent leurs valeurs par défaut. Un blob de version 1 (cinq compteurs, noms seuls) est
+ * accepté : ses compteurs gardent le câblage et les constantes par défaut.
+ *
+ * @return CONFIG_BLOB_OK ou CONFIG_BLOB_MIGRATED si les paramètres ont été chargés,
+ *         CONFIG_BLOB_NONE sans blob, CONFIG_BLOB_INVALID si le blob existe mais n'est pas lisible
+ */
+static config_blob_t load_config_blob(void)
+{
+    nvs_handle_t handle; // Handle pour accéder à la NVS
+    esp_err_t ret = nvs_open(APP_CONFIG_NAMESPACE, NVS_READONLY, &handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) // Espace absent : appareil neuf ou ancien format
+    {
+        return CONFIG_BLOB_NONE;
+    }
+
+    size_t len = 0;
+    uint8_t *blob = NULL;
+    if (ret == ESP_OK)
+    {
+        ret = nvs_get_blob(handle, APP_CONFIG_KEY, NULL, &len); // Taille seule
+        if (ret == ESP_OK)
+        {
+            blob = malloc(len); // Hors de la pile de app_main
+            ret = (blob != NULL) ? nvs_get_blob(handle, APP_CONFIG_KEY, blob, &len) : ESP_ERR_NO_MEM; // Une seule lecture
+        }
+        nvs_close(handle);
+    }
+    if (ret == ESP_ERR_NVS_NOT_FOUND)
+    {
+        free(blob);
+        return CONFIG_BLOB_NONE;
+    }
+
+    config_blob_t result = CONFIG_BLOB_INVALID;
+    const app_config_hdr_t *hdr = (const app_config_hdr_t *)blob;
+    size_t slots = (ret == ESP_OK && len >= sizeof(app_config_hdr_t) + sizeof(uint32_t))
+                   ? len - sizeof(app_config_hdr_t) - sizeof(uint32_t) : 0; // Octets des tables
+    bool current = slots > 0 && slots % APP_CONFIG_SLOT_SIZE == 0 && hdr->version == APP_CONFIG_VERSION;
+    if (current) // Tables complètes au format courant : CRC en fin de blob
+    {
+        uint32_t crc;
+        memcpy(&crc, blob + len - sizeof(crc), sizeof(crc));
+        current = (crc == app_config_crc(blob, len - sizeof(crc)));
+    }
+    if (current) // Blob complet, au format courant et intact
+    {
+        size_t n = slots / APP_CONFIG_SLOT_SIZE;        // Compteurs enregistrés
+        size_t used = (n < MAX_CHANNELS) ? n : MAX_CHANNELS;
+        const uint8_t *tab = blob + sizeof(app_config_hdr_t);
+        apply_config_hdr(hdr);
+        memcpy(channels, tab, used * sizeof(channel_cfg_t));
+        memcpy(publish_cfg, tab + n * sizeof(channel_cfg_t), used * sizeof(publish_cfg_t));
+        channel_count = hdr->channel_count;
+        if (n != MAX_CHANNELS)
+        {
+            ESP_LOGW(TAG, "Blob de configuration de %u compteurs, capacité %d", (unsigned)n, MAX_CHANNELS);
+            if (channel_count > used) channel_count = used; // Compteurs actifs au-delà de la capacité ignorés
+        }
+        result = CONFIG_BLOB_OK;
+    }
+    else if (ret == ESP_OK && len == sizeof(app_config_v1_t) && hdr->version == APP_CONFIG_VERSION_1)
+    {
+        const app_config_v1_t *v1 = (const app_config_v1_t *)blob; // Même en-tête, compteurs au format de la version 1
+        if (v1->crc == app_config_crc(v1, offsetof(app_config_v1_t, crc)))
+        {
+            apply_config_hdr(&v1->hdr);
+            for (int i = 0; i < LEGACY_CHANNEL_COUNT; i++) // GPIO, constante et anti-rebond par défaut
+            {
+                memcpy(channels[i].name, v1->names[i], sizeof(channels[i].name));
+                publish_cfg[i] = v1->publish[i];
+            }
+            channel_count = LEGACY_CHANNEL_COUNT;
+            result = CONFIG_BLOB_MIGRATED;
+        }
+    }
+
+    if (result != CONFIG_BLOB_INVALID) // Valeurs hors plage d'un blob pourtant intact (constante nulle, nombre de compteurs)
+    {
+        if (channel_count < 1 || channel_count > MAX_CHANNELS) channel_count = DEFAULT_CHANNEL_COUNT;
+        for (int i = 0; i < MAX_CHANNELS; i++)
+        {
+            if (channels[i].ppkwh == 0) channels[i].ppkwh = PULSES_PER_KWH;
+            channels[i].name[sizeof(channels[i].name) - 1] = '\0';
+        }
+    }
+    else if (ret == ESP_OK && len >= sizeof(app_config_hdr_t))
+    {
+        ESP_LOGE(TAG, "Blob de configuration invalide (taille %u, version %u)", (unsigned)len, hdr->version);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Lecture du blob de configuration impossible : %s (taille %u)", esp_err_to_name(ret), (unsigned)len);
+    }
+    free(blob);
+    return result;
+}
+
+void storage_save_config(void)
+{
+    app_config_t *cfg = calloc(1, sizeof(*cfg)); // Hors de la pile de la tâche httpd
+    if (cfg == NULL)
+    {
+        ESP_LOGE(TAG, "Sauvegarde de la configuration impossible : mémoire insuffisante");
+        return;
+    }
+
+    cfg->hdr.version = APP_CONFIG_VERSION;
+    cfg->hdr.mqtt_batch = mqtt_batch_mode;
+    cfg->hdr.channel_count = channel_count_next; // channel_count dimensionne les modules démarrés : inchangé jusqu'au redémarrage
+    memcpy(cfg->hdr.wifi_ssid, wifi_ssid, sizeof(cfg->hdr.wifi_ssid));
+    memcpy(cfg->hdr.wifi_pass, wifi_pass, sizeof(cfg->hdr.wifi_pass));
+    memcpy(cfg->hdr.wifi_ip,   wifi_ip,   sizeof(cfg->hdr.wifi_ip));
+    memcpy(cfg->hdr.wifi_gw,   wifi_gw,   sizeof(cfg->hdr.wifi_gw));
+    memcpy(cfg->hdr.wifi_mask, wifi_mask, sizeof(cfg->hdr.wifi_mask));
+    memcpy(cfg->hdr.wifi_dns,  wifi_dns,  sizeof(cfg->hdr.wifi_dns));
+    memcpy(cfg->hdr.mqtt_server, mqtt_Server, sizeof(cfg->hdr.mqtt_server));
+    memcpy(cfg->hdr.mqtt_user, mqtt_user, sizeof(cfg->hdr.mqtt_user));
+    memcpy(cfg->hdr.mqtt_pass, mqtt_pass, sizeof(cfg->hdr.mqtt_pass));
+    memcpy(cfg->hdr.mqtt_port, mqtt_port, sizeof(cfg->hdr.mqtt_port));
+    memcpy(cfg->channels, channels, sizeof(cfg->channels));
+    memcpy(cfg->publish, publish_cfg, sizeof(cfg->publish));
+    cfg->crc = app_config_crc(cfg, offsetof(app_config_t, crc)); // Calculé en dernier, sur tout le reste
+
+    nvs_handle_t handle; // Handle pour accéder à la NVS
+    esp_err_t ret = nvs_open(APP_CONFIG_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK)
+    {
+        ret = nvs_set_blob(handle, APP_CONFIG_KEY, cfg, sizeof(*cfg)); // Remplacement atomique de l'ancien blob
+        if (ret == ESP_OK)
+        {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    free(cfg);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Erreur sauvegarde de la configuration : %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGI(TAG, "Configuration sauvegardée (%u octets)", (unsigned)sizeof(app_config_t));
+}
+
+/**
+ * @brief Initialise la mémoire NVS et charge les paramètres de configuration.
+ *
+ * Cette fonction effectue plusieurs tâches :
+ * 1. Initialise la mémoire NVS en gérant les erreurs courantes comme l'absence de pages libres ou une nouvelle version incompatibilité.
+ * 2. Charge tous les paramètres (table et règles des compteurs, Wi-Fi, MQTT) depuis le blob de configuration,
+ *    en une seule lecture vérifiée par CRC ; un blob de version 1 est converti puis réécrit.
+ * 3. À défaut de blob (premier démarrage après mise à jour), charge l'ancien format clé par clé,
+ *    écrit le blob puis efface les anciennes clés. Un blob présent mais illisible (CRC, version
+ *    inconnue) n'est jamais écrasé : les paramètres par défaut ne sont alors qu'en mémoire.
+ * 4. Charge le mode de configuration actuel (normal ou AP) depuis la mémoire NVS, initialisant à 0 (mode normal) si ce paramètre n'est pas trouvé.
+ *
+ * Cette fonction est appelée au démarrage du système pour s'assurer que tous les paramètres sont correctement chargés et disponibles.
+ * Les valeurs des compteurs sont restaurées ensuite par storage_load_counters(),
+ * pendant que le Wi-Fi et le client MQTT se connectent.
+ */
+void nvs_init_and_load(void)
+{
+    // --- Initialisation NVS ---
+    esp_err_t ret = nvs_flash_init(); // Initialise la NVS
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) // Si la NVS est corrompue ou incompatible, on efface et réinitialise
+    {
+        ESP_ERROR_CHECK(nvs_flash_erase()); // Efface la NVS
+        ret = nvs_flash_init(); // Réinitialise la NVS après effacement
+    }
+    ESP_ERROR_CHECK(ret); // Vérifie que l'initialisation a réussi
+    storage_events = xEventGroupCreate(); // Attente de storage_load_counters() par les autres tâches
+
+    // --- Chargement des paramètres ---
+    set_channel_defaults(); // Valeurs des compteurs absentes des anciens formats
+    config_blob_t blob = load_config_blob();
+    if (blob == CONFIG_BLOB_NONE || blob == CONFIG_BLOB_INVALID)
+    {
+        load_legacy_settings(); // Ancien format clé par clé (ou valeurs par défaut)
+    }
+    channel_count_next = channel_count; // Aucun changement en attente
+    if (blob == CONFIG_BLOB_NONE) // Premier démarrage après la mise à jour, ou appareil neuf
+    {
+        ESP_LOGI(TAG, "Migration des paramètres vers le blob de configuration");
+        storage_save_config();
+        erase_legacy_settings();
+    }
+    else if (blob == CONFIG_BLOB_MIGRATED) // Blob de version 1 : réécrit au format courant
+    {
+        ESP_LOGI(TAG, "Blob de configuration converti en version %d", APP_CONFIG_VERSION);
+        storage_save_config();
+    }
+    else if (blob == CONFIG_BLOB_INVALID) // Ni réécrit ni effacé : seule une sauvegarde depuis la page de configuration le remplace
+    {
+        ESP_LOGE(TAG, "Paramètres par défaut en mémoire, blob de configuration conservé");
     }
 
     // --- Chargement du mode configuration ---
@@ -237,51 +724,259 @@ void nvs_init_and_load(void)
         global_mode_config = 0; // Initialise à 0 (mode normal) par défaut en cas d'erreur d'ouverture
     }
 
-    ESP_LOGI(TAG, "Compteurs, noms MQTT et configuration Wi-Fi chargés depuis NVS");// Log de fin de chargement
+    ESP_LOGI(TAG, "%u compteurs, configuration Wi-Fi et MQTT chargés", channel_count);// Log de fin de chargement
 }
 
+#if POWER_FAIL
 /**
- * @brief Sauvegarde la valeur d'un compteur dans la mémoire NVS.
+ * @brief Lit l'enregistrement de coupure et le retient s'il complète le journal.
  *
- * Cette fonction permet de sauvegarder une nouvelle valeur pour un compteur spécifique dans la mémoire NVS. Elle effectue les étapes suivantes :
- * 1. Ouvre la mémoire NVS en mode lecture/écriture pour le groupe "counters".
- * 2. Formate une clé unique pour ce compteur (par exemple, "c0", "c1", etc.) en utilisant l'index du compteur.
- * 3. Écrit la nouvelle valeur dans la mémoire NVS sous cette clé.
- * 4. Commite les modifications pour s'assurer que la valeur est bien sauvegardée.
- * 5. Ferme la mémoire NVS après l'écriture.
+ * L'enregistrement n'est valable que s'il a été écrit après le dernier instantané du journal :
+ * sa séquence doit être celle du journal. Une écriture interrompue (CRC faux) ou une coupure
+ * suivie d'une sauvegarde normale (séquence dépassée) laisse les valeurs du journal.
  *
- * Cette fonction permet de mettre à jour dynamiquement les compteurs utilisés par le système sans avoir à redémarrer le système.
+ * @param values Valeurs restaurées (remplacées si l'enregistrement est retenu)
+ * @return true si l'enregistrement est retenu
+ */
+static bool pfail_recover(uint64_t values[MAX_CHANNELS])
+{
+    pfail_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "pfail");
+    if (pfail_part == NULL)
+    {
+        ESP_LOGE(TAG, "Partition pfail absente : sauvegarde d'urgence désactivée");
+        return false;
+    }
+
+    pfail_record_t rec;
+    if (esp_partition_read(pfail_part, 0, &rec, sizeof(rec)) != ESP_OK || rec.magic == PFAIL_BLANK) // Secteur vierge : pas de coupure
+    {
+        return false;
+    }
+    if (rec.magic == PFAIL_MAGIC_V1)                 // Coupure juste avant une mise à jour : valeurs sur 32 bits
+    {
+        pfail_record_v1_t old;
+        memcpy(&old, &rec, sizeof(old));
+        if (old.count <= MAX_CHANNELS &&
+            old.crc == esp_rom_crc32_le(0, (const uint8_t *)&old, offsetof(pfail_record_v1_t, crc)))
+        {
+            rec.magic = PFAIL_MAGIC;
+            rec.seq = old.seq;
+            rec.count = old.count;
+            for (uint32_t i = 0; i < old.count; i++) rec.values[i] = old.values[i];
+            rec.crc = esp_rom_crc32_le(0, (const uint8_t *)&rec, offsetof(pfail_record_t, crc));
+        }
+    }
+    if (rec.magic != PFAIL_MAGIC || rec.count > MAX_CHANNELS ||
+        rec.crc != esp_rom_crc32_le(0, (const uint8_t *)&rec, offsetof(pfail_record_t, crc)))
+    {
+        ESP_LOGW(TAG, "Enregistrement de coupure invalide, ignoré");
+        return false;
+    }
+    if (rec.seq != counters_journal.last_seq)
+    {
+        ESP_LOGI(TAG, "Enregistrement de coupure antérieur au journal, ignoré");
+        return false;
+    }
+
+    for (int i = 0; i < channel_count && i < (int)rec.count; i++)
+    {
+        values[i] = rec.values[i];
+    }
+    ESP_LOGI(TAG, "Compteurs restaurés depuis la sauvegarde d'urgence");
+    return true;
+}
+
+/**
+ * @brief Efface le secteur de la sauvegarde d'urgence s'il n'est pas vierge.
+ */
+static void pfail_erase(void)
+{
+    uint32_t magic = PFAIL_BLANK;
+    if (pfail_part == NULL) return;
+    esp_partition_read(pfail_part, 0, &magic, sizeof(magic));
+    if (magic == PFAIL_BLANK) return;              // Déjà prêt : pas d'usure inutile
+    esp_err_t ret = esp_partition_erase_range(pfail_part, 0, pfail_part->size);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Effacement de la partition pfail : %s", esp_err_to_name(ret));
+    }
+}
+
+void storage_emergency_save(void)
+{
+    pfail_record_t rec = {
+        .magic = PFAIL_MAGIC,
+        .count = channel_count,
+    };
+    if (pfail_part == NULL) return;
+
+    // Le journal reste verrouillé jusqu'au réarmement : aucun instantané plus ancien ne peut
+    // passer après celui-ci. Un ajout en cours (effacement de secteur) n'est pas attendu au-delà
+    // de POWER_FAIL_LOCK_MS ; l'enregistrement est alors écrit quand même et sera écarté au
+    // démarrage si l'ajout a abouti.
+    pfail_locked = xSemaphoreTake(journal_mutex, pdMS_TO_TICKS(POWER_FAIL_LOCK_MS)) == pdTRUE;
+    rec.seq = counters_journal.last_seq;
+    counter_store_snapshot(rec.values);
+    rec.crc = esp_rom_crc32_le(0, (const uint8_t *)&rec, offsetof(pfail_record_t, crc));
+    esp_partition_write(pfail_part, 0, &rec, sizeof(rec)); // Unique programmation d'un secteur déjà effacé
+}
+
+void storage_emergency_rearm(void)
+{
+    pfail_erase();                                 // Prêt pour la prochaine coupure
+    if (pfail_locked)
+    {
+        pfail_locked = false;
+        xSemaphoreGive(journal_mutex);             // Verrou pris par storage_emergency_save()
+    }
+}
+#endif // POWER_FAIL
+
+/**
+ * @brief Restaure les compteurs depuis le journal flash.
  *
- * @param idx Index du compteur à sauvegarder (doit être compris entre 0 et NB_COUNTERS-1).
- * @param value Nouvelle valeur du compteur à sauvegarder.
+ * Charge le dernier instantané valide du journal ; si le journal est vide, reprend les anciennes
+ * clés NVS "c0".."c4" (migration) et les inscrit dans le journal. Le parcours du journal lit toute
+ * sa partition : il est fait après le démarrage du Wi-Fi pour ne pas retarder la connexion.
+ * Avec POWER_FAIL, un enregistrement de coupure plus récent que le journal remplace ses valeurs,
+ * est inscrit dans le journal, puis la partition "pfail" est effacée pour la prochaine coupure.
+ * Les tâches qui ont besoin des compteurs attendent la fin du chargement avec storage_wait_counters().
  */
-void save_counter_to_nvs(int idx, uint32_t value)
+void storage_load_counters(void)
 {
-    nvs_handle_t handle;   // Handle pour accéder à la NVS des compteurs   
-    esp_err_t ret = nvs_open("counters", NVS_READWRITE, &handle); // Ouvre la NVS "counters" en mode lecture/écriture
-    if (ret != ESP_OK)  // Si l'ouverture échoue, on log une erreur et on retourne
-    { 
-        ESP_LOGE(TAG, "Impossible d'ouvrir la NVS pour écriture compteur %d", idx);// Log d'erreur
-        return; // Retourne en cas d'erreur d'ouverture
+    journal_mutex = xSemaphoreCreateMutex(); // Mutex d'accès au journal
+    uint64_t loaded[MAX_CHANNELS] = {0}; // Valeurs lues, publiées en une seule écriture dans counter_store
+    bool from_journal = false; // Vrai si un instantané valide a été trouvé dans le journal
+    bool migrated = false; // Vrai si l'instantané est d'une version précédente
+
+    if (journal_open(&counters_journal, "journal", COUNTERS_SLOT_SIZE) == ESP_OK) // Ouvre le journal et retrouve le dernier instantané
+    {
+        counters_record_t rec; // Dernier instantané
+        size_t len = sizeof(rec); // Taille du buffer
+        uint64_t values[MAX_CHANNELS]; // Valeurs de l'instantané
+        if (journal_read_latest(&counters_journal, &rec, &len) == ESP_OK && rec.count <= MAX_CHANNELS)
+        {
+            size_t head = offsetof(counters_record_t, values);
+            if (rec.version == COUNTERS_RECORD_VERSION && len >= head + COUNTER_PACK48_SIZE(rec.count)) // Format courant
+            {
+                counter_unpack48(values, rec.values, rec.count);
+                from_journal = true;
+            }
+            else if (rec.version == COUNTERS_RECORD_VERSION_1 && len >= head + rec.count * sizeof(uint32_t)) // Valeurs sur 32 bits
+            {
+                for (int i = 0; i < rec.count; i++)
+                {
+                    uint32_t v;
+                    memcpy(&v, rec.values + i * sizeof(v), sizeof(v));
+                    values[i] = v;
+                }
+                from_journal = true;
+                migrated = true;
+            }
+        }
+        for (int i = 0; from_journal && i < channel_count && i < rec.count; i++) // Compteurs actifs présents dans l'instantané
+        {
+            loaded[i] = values[i];
+        }
+        if (from_journal) ESP_LOGI(TAG, "Compteurs restaurés depuis le journal%s", migrated ? " (format 32 bits)" : "");
     }
 
-    char key[8]; // Clé pour le compteur (ex : "c0", "c1", etc.)
-    snprintf(key, sizeof(key), "c%d", idx); // Formate la clé pour le compteur idx
+    nvs_handle_t counters_handle; // Handle pour accéder à la NVS des compteurs
+    if (!from_journal && nvs_open("counters", NVS_READONLY, &counters_handle) == ESP_OK) // Journal vide : migration depuis les anciennes clés NVS
+    {
+        for (int i = 0; i < LEGACY_CHANNEL_COUNT && i < channel_count; i++) // Pour chaque compteur de l'ancien format
+        {
+            char key[8]; // Clé pour lire le compteur (ex : "c0", "c1", etc.)
+            snprintf(key, sizeof(key), "c%d", i); // Formate la clé pour le compteur i
+            uint32_t value = 0; // Variable pour stocker la valeur lue de la NVS
+            esp_err_t ret = nvs_get_u32(counters_handle, key, &value); // Tente de lire la valeur du compteur i depuis la NVS
+            if (ret == ESP_OK) // Si la lecture réussit, on stocke la valeur
+            { 
+                loaded[i] = value;// Stocke la valeur lue
+            } 
+            else if (ret != ESP_ERR_NVS_NOT_FOUND) // Si une autre erreur survient lors de la lecture, on log une erreur (compteur à 0)
+            {
+                ESP_LOGW(TAG, "Erreur lecture NVS compteur %d", i);// Log d'avertissement
+            }
+        }
+        nvs_close(counters_handle); // Ferme la NVS après lecture
+    }
 
-    ret = nvs_set_u32(handle, key, value);  // Tente d'écrire la nouvelle valeur du compteur dans la NVS
-    if (ret != ESP_OK)  // Si l'écriture échoue, on log une erreur, on ferme la NVS et on retourne
+    bool from_pfail = false; // Vrai si la sauvegarde d'urgence complète le journal
+#if POWER_FAIL
+    from_pfail = pfail_recover(loaded);
+#endif
+
+    counter_store_set_all(loaded); // Charge toutes les valeurs lues dans les compteurs
+    if (!from_journal || migrated || from_pfail) // Migration ou coupure : le journal reprend les valeurs restaurées
     {
-        ESP_LOGE(TAG, "Impossible d'écrire compteur %d", idx); // Log d'erreur
-        nvs_close(handle); // Ferme la NVS avant de retourner
-        return; // Retourne en cas d'erreur d'écriture
+        storage_save_counters(loaded);
     }
+#if POWER_FAIL
+    pfail_erase(); // Après l'inscription au journal : une coupure entre les deux ne perd rien
+#endif
+
+    xEventGroupSetBits(storage_events, STORAGE_COUNTERS_LOADED_BIT); // Débloque les tâches en attente des compteurs
+}
+
+void storage_wait_counters(void)
+{
+    xEventGroupWaitBits(storage_events, STORAGE_COUNTERS_LOADED_BIT, pdFALSE, pdTRUE, portMAX_DELAY); // Bit jamais effacé
+}
+
+void storage_saver_init(void)
+{
+    saver_task = xTaskGetCurrentTaskHandle();  // Tâche appelante
+}
 
-    ret = nvs_commit(handle); // Commite les modifications pour s'assurer que la valeur est bien sauvegardée
-    if (ret != ESP_OK)  // Si le commit échoue, on log une erreur
+void storage_request_save(void)
+{
+    TaskHandle_t task = saver_task;            // Lecture unique du handle
+    if (task != NULL)                          // Tâche de sauvegarde démarrée
     {
-        ESP_LOGE(TAG, "Erreur commit NVS compteur %d", idx); // Log d'erreur
+        xTaskNotifyGive(task);                 // Réveille la tâche, sans bloquer
     }
+}
 
-    nvs_close(handle); // Ferme la NVS après l'écriture
-    ESP_LOGI(TAG, "Compteur %d sauvegardé : %lu", idx, value);// Log de succès de sauvegarde
+void IRAM_ATTR storage_request_save_from_isr(BaseType_t *woken)
+{
+    TaskHandle_t task = saver_task;
+    if (task != NULL)
+    {
+        vTaskNotifyGiveFromISR(task, woken);
+    }
+}
+
+/**
+ * @brief Sauvegarde un instantané de tous les compteurs dans le journal flash.
+ *
+ * Cette fonction remplace l'ancienne écriture clé par clé (nvs_set_u32 + nvs_commit par compteur) :
+ * 1. Construit un enregistrement contenant les channel_count valeurs (taille ajustée au nombre de compteurs).
+ * 2. L'ajoute au journal circulaire : une seule programmation de page flash,
+ *    l'effacement d'un secteur n'intervenant qu'une fois tous les 16 ajouts.
+ *
+ * Le journal répartit l'usure sur toute sa partition ; au démarrage, storage_load_counters()
+ * restaure le plus récent enregistrement valide.
+ *
+ * @param values Valeurs des compteurs actifs (channel_count) (copie cohérente de counter_store)
+ */
+void storage_save_counters(const uint64_t values[MAX_CHANNELS])
+{
+    counters_record_t rec = {
+        .version = COUNTERS_RECORD_VERSION, // Format courant
+        .count = channel_count,             // Nombre de compteurs enregistrés
+    };
+    counter_pack48(rec.values, values, channel_count); // Valeurs actives sur 48 bits
+    size_t len = offsetof(counters_record_t, values) + COUNTER_PACK48_SIZE(channel_count); // Sans les compteurs inactifs
+
+    xSemaphoreTake(journal_mutex, portMAX_DELAY); // Un seul ajout à la fois (ne concerne pas le comptage)
+    esp_err_t ret = journal_append(&counters_journal, &rec, len); // Ajout au journal
+    xSemaphoreGive(journal_mutex);
+
+    if (ret != ESP_OK)  // Si l'écriture échoue, on log une erreur
+    {
+        ESP_LOGE(TAG, "Erreur sauvegarde des compteurs : %s", esp_err_to_name(ret)); // Log d'erreur
+        return;
+    }
+    ESP_LOGI(TAG, "Compteurs sauvegardés (séquence %lu)", (unsigned long)counters_journal.last_seq);// Log de succès de sauvegarde
 }
@@ -3,44 +3,114 @@
 
 /**
  * @file storage.h
- * @brief Header pour le module de stockage persistant des compteurs ESP32 via NVS.
+ * @brief Header pour le module de stockage persistant des compteurs ESP32 (NVS + journal flash).
  *
  * Ce module permet de :
  *  - Initialiser la NVS et charger les compteurs depuis la mémoire flash
- *  - Sauvegarder un compteur spécifique dans la NVS
+ *  - Sauvegarder un instantané de tous les compteurs dans le journal flash
  *
  * Usage typique :
- * 1. Appeler nvs_init_and_load() au démarrage pour initialiser la NVS
- *    et charger les compteurs dans le tableau global `counters[]`.
- * 2. Appeler save_counter_to_nvs(idx, value) pour sauvegarder un compteur
+ * 1. Appeler nvs_init_and_load() au démarrage pour initialiser la NVS et charger les paramètres.
+ * 2. Appeler storage_load_counters() pour restaurer les compteurs dans counter_store
+ *    (les autres tâches attendent la fin avec storage_wait_counters()).
+ * 3. Appeler storage_save_counters(values) pour sauvegarder les compteurs
+ *    (la tâche de sauvegarde dort jusqu'à storage_request_save(), voir storage_saver_init())
  *    après un certain nombre d'impulsions.
  */
 
-#include <stdint.h>  // Pour uint32_t
+#include <stdint.h>  // Pour uint64_t
+#include "config.h"  // Pour MAX_CHANNELS, channel_count
+#include "freertos/FreeRTOS.h" // Pour BaseType_t
 
 /**
- * @brief Initialise la NVS et charge les compteurs depuis la mémoire persistante.
+ * @brief Initialise la NVS et charge les paramètres depuis la mémoire persistante.
  *
  * Cette fonction :
  *  - Initialise la NVS (efface si nécessaire)
- *  - Ouvre l'espace "counters" en lecture/écriture
- *  - Lit les compteurs existants et les stocke dans counters[]
- *  - Initialise à 0 si aucun compteur n'est trouvé
+ *  - Charge la table des compteurs (GPIO, constante, anti-rebond, nom), leurs règles de publication, les paramètres Wi-Fi
+ *    (dont l'adresse IP statique optionnelle) et MQTT, en une lecture du blob de configuration
+ *  - Migre l'ancien format (une clé NVS par paramètre) si le blob est absent
+ *  - Charge le mode de configuration (normal ou AP)
  */
 void nvs_init_and_load(void);
 
 /**
- * @brief Sauvegarde un compteur spécifique dans la NVS.
+ * @brief Sauvegarde tous les paramètres (Wi-Fi, MQTT, table et règles des compteurs) dans le blob de configuration.
+ *
+ * Le blob est écrit en une seule opération NVS : une coupure pendant la sauvegarde
+ * laisse la configuration précédente intacte. Le nombre de compteurs enregistré est
+ * channel_count_next : channel_count ne change qu'au redémarrage.
+ */
+void storage_save_config(void);
+
+/**
+ * @brief Restaure les compteurs depuis la mémoire persistante.
+ *
+ * Cette fonction :
+ *  - Ouvre le journal des compteurs et restaure le dernier instantané valide
+ *  - À défaut, migre les anciennes clés NVS "c0".."c4" vers le journal
+ *  - Initialise à 0 si aucun compteur n'est trouvé
+ *
+ * À appeler après nvs_init_and_load(), avant d'activer le comptage.
+ */
+void storage_load_counters(void);
+
+/**
+ * @brief Attend que storage_load_counters() ait restauré les compteurs.
  *
- * @param idx   Index du compteur (0 à NB_COUNTERS-1)
- * @param value Valeur du compteur à sauvegarder
+ * Retourne immédiatement si c'est déjà le cas.
+ */
+void storage_wait_counters(void);
+
+/**
+ * @brief Sauvegarde un instantané de tous les compteurs dans le journal flash.
+ *
+ * @param values Valeurs des compteurs actifs (channel_count)
  *
  * Cette fonction :
- *  - Ouvre l'espace "counters" en lecture/écriture
- *  - Écrit la valeur dans la NVS
- *  - Commit pour s'assurer que la valeur est persistée
+ *  - Construit un enregistrement (version, nombre de compteurs, valeurs)
+ *  - L'ajoute au journal circulaire en une seule écriture de page flash
+ *  - Le CRC de l'enregistrement permet d'ignorer une écriture interrompue
  */
+void storage_save_counters(const uint64_t values[MAX_CHANNELS]);
 
-void save_counter_to_nvs(int idx, uint32_t value);
+/**
+ * @brief Enregistre la tâche appelante comme tâche de sauvegarde des compteurs.
+ *
+ * La tâche attend ensuite ulTaskNotifyTake() : elle n'est réveillée que par
+ * storage_request_save(). Tant qu'elle n'est pas appelée, storage_request_save() ne fait rien.
+ */
+void storage_saver_init(void);
+
+/**
+ * @brief Demande une sauvegarde des compteurs à la tâche de sauvegarde.
+ *
+ * Appelée par le chemin de comptage quand un compteur franchit un multiple de
+ * COUNTER_SAVE_WH ; ne bloque pas.
+ */
+void storage_request_save(void);
+
+/**
+ * @brief Variante de storage_request_save() pour une ISR.
+ *
+ * @param woken Mis à pdTRUE si la tâche de sauvegarde doit prendre la main en sortie d'ISR
+ */
+void storage_request_save_from_isr(BaseType_t *woken);
+
+/**
+ * @brief Écrit tous les compteurs dans la partition "pfail" (POWER_FAIL).
+ *
+ * Appelée par la tâche de coupure d'alimentation : une seule écriture flash, dans un secteur
+ * effacé d'avance. Le journal reste verrouillé jusqu'à storage_emergency_rearm().
+ */
+void storage_emergency_save(void);
+
+/**
+ * @brief Efface la partition "pfail" et déverrouille le journal après une coupure brève.
+ *
+ * L'enregistrement effacé n'est plus nécessaire : la sauvegarde normale qui suit
+ * (storage_request_save) le remplace dans le journal.
+ */
+void storage_emergency_rearm(void);
 
 #endif // STORAGE_H
@@ -1,53 +1,174 @@
 /**
  * @file watchdog.c
- * @brief Gestion du Watchdog Timer (WDT) pour surveiller les tâches sur les deux cœurs de l'ESP32.
- *        Permet d'initialiser le WDT, d'ajouter une tâche à surveiller et de réinitialiser le WDT.
+ * @brief Superviseur des battements des tâches critiques, seul inscrit au Task Watchdog (TWDT).
+ *
+ * Les battements sont des horodatages atomiques en ms : une tâche surveillée ne prend aucun
+ * verrou et ne dépend pas du superviseur. Toutes les WDT_CHECK_MS, le superviseur compare
+ * l'âge de chaque battement à sa période :
+ *  - tous frais : le TWDT est alimenté ;
+ *  - un en retard : la tâche est journalisée et mémorisée en RTC, le TWDT n'est plus
+ *    alimenté ; il redémarre l'appareil si le battement ne reprend pas dans WDT_TIMEOUT_S.
+ *
+ * Le TWDT surveille aussi les tâches idle des deux cœurs : un cœur affamé redémarre
+ * l'appareil de la même façon.
  */
 
-#include "watchdog.h"       // Header du module watchdog pour les prototypes
-#include "esp_task_wdt.h"   // Fonctions ESP-IDF pour le task watchdog
-#include "esp_log.h"        // Fonctions ESP_LOG pour debug
+#include <stdatomic.h>              // Battements sans verrou
+#include <string.h>                 // strncpy
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche du superviseur
+#include "esp_attr.h"               // RTC_NOINIT_ATTR
+#include "esp_system.h"             // esp_reset_reason
+#include "esp_task_wdt.h"           // Fonctions ESP-IDF pour le task watchdog
+#include "esp_timer.h"              // Horodatage des battements
+#include "esp_log.h"                // Fonctions ESP_LOG pour debug
+#include "watchdog.h"               // Header du module watchdog pour les prototypes
+#include "config.h"                 // WDT_*
 
-#define WDT_TIMEOUT_S 10    // Timeout du watchdog en secondes
+#define WDT_RECORD_MAGIC 0x4D544457 // "WDTM" : enregistrement RTC valide
+#define WDT_NAME_MAX     16         // configMAX_TASK_NAME_LEN de l'ESP-IDF
 
 static const char *TAG = "WDT"; // Tag utilisé pour les logs ESP_LOG
 
 /**
- * @brief Initialise le task watchdog pour l'ESP32.
- *
- * Configure le timeout, les cœurs surveillés et le comportement en cas de timeout.
- * Devrait être appelé une seule fois au démarrage.
+ * @brief Battement d'une tâche surveillée.
  */
-void watchdog_init(void)
+typedef struct {
+    const char *name;                   // Nom de la tâche
+    _Atomic uint32_t period_ms;         // 0 tant que l'enregistrement n'est pas terminé
+    _Atomic uint32_t last_ms;           // Dernier battement (ms depuis le démarrage, modulo 2^32)
+} heartbeat_t;
+
+/**
+ * @brief Tâche en retard, conservée en RTC au redémarrage par le TWDT.
+ */
+typedef struct {
+    uint32_t magic;
+    char name[WDT_NAME_MAX];
+} wdt_record_t;
+
+static heartbeat_t beats[WDT_MAX_HEARTBEATS];
+static _Atomic int beat_count;          // Battements réservés (peut dépasser WDT_MAX_HEARTBEATS)
+static RTC_NOINIT_ATTR wdt_record_t record; // Non effacé par un redémarrage logiciel
+static char last_miss[WDT_NAME_MAX];    // Copie de l'enregistrement du démarrage précédent
+
+/**
+ * @brief Temps depuis le démarrage en ms (modulo 2^32, 49 jours).
+ */
+static uint32_t now_ms(void)
 {
-    // Configuration du watchdog
-    esp_task_wdt_config_t config = {
-        .timeout_ms = WDT_TIMEOUT_S * 1000,       // Convertit secondes en millisecondes
-        .idle_core_mask = (1 << 0) | (1 << 1),   // Surveille les deux cores (Core0 et Core1)
-        .trigger_panic = true                     // Si timeout, déclenche un panic (reset du CPU)
-    };
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+int watchdog_register(const char *name, uint32_t period_ms)
+{
+    int id = atomic_fetch_add(&beat_count, 1);
+    if (id >= WDT_MAX_HEARTBEATS)
+    {
+        ESP_LOGE(TAG, "Tâche %s non surveillée (WDT_MAX_HEARTBEATS = %d)", name, WDT_MAX_HEARTBEATS);
+        return -1;
+    }
+    beats[id].name = name;
+    atomic_store_explicit(&beats[id].last_ms, now_ms(), memory_order_relaxed);
+    atomic_store_explicit(&beats[id].period_ms, period_ms, memory_order_release); // Visible par le superviseur
+    return id;
+}
+
+void watchdog_beat(int id)
+{
+    if (id < 0) return;
+    atomic_store_explicit(&beats[id].last_ms, now_ms(), memory_order_relaxed);
+}
 
-    esp_task_wdt_init(&config);                  // Initialise le watchdog avec cette config
-    ESP_LOGI(TAG, "Watchdog initialisé (%ds)", WDT_TIMEOUT_S); // Log info
+const char *watchdog_last_miss(void)
+{
+    return last_miss[0] ? last_miss : NULL;
 }
 
 /**
- * @brief Ajoute la tâche courante à la liste des tâches surveillées par le watchdog.
+ * @brief Battement le plus en retard sur sa période.
  *
- * Chaque tâche critique doit appeler cette fonction au démarrage pour être surveillée.
+ * @param late_ms Retard au-delà de la période (sortie)
+ * @return Indice du battement, -1 si tous sont frais
  */
-void watchdog_add_task(void)
+static int find_late(uint32_t *late_ms)
 {
-    esp_task_wdt_add(NULL); // NULL = tâche courante
+    uint32_t now = now_ms();
+    int count = atomic_load(&beat_count);
+    int late = -1;
+    if (count > WDT_MAX_HEARTBEATS) count = WDT_MAX_HEARTBEATS;
+
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t period = atomic_load_explicit(&beats[i].period_ms, memory_order_acquire);
+        if (period == 0) continue;           // Enregistrement en cours
+        int32_t age = (int32_t)(now - atomic_load_explicit(&beats[i].last_ms, memory_order_relaxed));
+        if (age <= (int32_t)period) continue; // Frais (âge négatif : battement postérieur à now)
+        if (late < 0 || (uint32_t)age - period > *late_ms)
+        {
+            late = i;
+            *late_ms = (uint32_t)age - period;
+        }
+    }
+    return late;
 }
 
 /**
- * @brief Réinitialise le compteur du watchdog pour la tâche courante.
- *
- * Doit être appelé périodiquement dans la boucle principale d'une tâche
- * pour éviter que le WDT déclenche un reset.
+ * @brief Tâche du superviseur : alimente le TWDT tant que tous les battements sont frais.
  */
-void watchdog_reset(void)
+static void task_supervisor(void *pv)
+{
+    int late_prev = -1;                      // Battement en retard au contrôle précédent
+
+    esp_task_wdt_add(NULL);                  // Seule tâche inscrite au TWDT
+    while (1)
+    {
+        uint32_t late_ms = 0;
+        int late = find_late(&late_ms);
+        if (late < 0)
+        {
+            esp_task_wdt_reset();
+            if (late_prev >= 0)              // La tâche est repartie à temps
+            {
+                ESP_LOGW(TAG, "Tâche %s repartie", beats[late_prev].name);
+                record.magic = 0;
+            }
+        }
+        else if (late != late_prev)          // Nouvelle tâche en retard : mémorisée avant le redémarrage
+        {
+            ESP_LOGE(TAG, "Tâche %s sans battement depuis %lu ms au-delà de sa période, redémarrage dans %d s",
+                     beats[late].name, (unsigned long)late_ms, WDT_TIMEOUT_S);
+            strncpy(record.name, beats[late].name, sizeof(record.name) - 1);
+            record.name[sizeof(record.name) - 1] = '\0';
+            record.magic = WDT_RECORD_MAGIC;
+        }
+        late_prev = late;
+        vTaskDelay(pdMS_TO_TICKS(WDT_CHECK_MS));
+    }
+}
+
+void watchdog_init(void)
 {
-    esp_task_wdt_reset(); // Reset du compteur WDT pour la tâche actuelle
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (record.magic == WDT_RECORD_MAGIC &&
+        reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT) // RTC conservée : enregistrement valide
+    {
+        memcpy(last_miss, record.name, sizeof(last_miss));
+        last_miss[sizeof(last_miss) - 1] = '\0';
+        ESP_LOGW(TAG, "Redémarrage précédent : tâche %s bloquée", last_miss);
+    }
+    record.magic = 0;
+
+    esp_task_wdt_config_t config = {
+        .timeout_ms = WDT_TIMEOUT_S * 1000,               // Convertit secondes en millisecondes
+        .idle_core_mask = (1 << portNUM_PROCESSORS) - 1,  // Surveille les tâches idle de tous les cœurs
+        .trigger_panic = true                             // Si timeout, déclenche un panic (reset du CPU)
+    };
+    if (esp_task_wdt_init(&config) == ESP_ERR_INVALID_STATE) // Déjà démarré par l'ESP-IDF (CONFIG_ESP_TASK_WDT_INIT)
+    {
+        esp_task_wdt_reconfigure(&config);
+    }
+
+    xTaskCreatePinnedToCore(task_supervisor, "watchdog", 3072, NULL, WDT_PRIORITY, NULL, CORE_NET);
+    ESP_LOGI(TAG, "Watchdog initialisé (%ds, %d tâches surveillées)", WDT_TIMEOUT_S, atomic_load(&beat_count));
 }
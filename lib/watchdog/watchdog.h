@@ -3,32 +3,56 @@
 
 /**
  * @file watchdog.h
- * @brief Header pour le module Watchdog Timer (WDT) ESP32.
- *        Permet d'initialiser le WDT, d'ajouter une tâche à surveiller
- *        et de réinitialiser le compteur pour éviter le reset.
+ * @brief Surveillance des tâches critiques par battements et Task Watchdog (TWDT) ESP32.
+ *
+ * Chaque tâche critique enregistre un battement avec sa période attendue, puis le renouvelle
+ * à chaque tour de boucle. Seul le superviseur est inscrit au TWDT : il l'alimente tant
+ * que tous les battements sont frais. Une tâche en retard est journalisée et mémorisée en
+ * RTC (conservée au redémarrage logiciel) ; si elle ne repart pas avant WDT_TIMEOUT_S,
+ * le TWDT déclenche un panic et l'appareil redémarre. Au démarrage suivant, la tâche en
+ * cause est rendue par watchdog_last_miss() (diagnostic).
+ *
+ * Une opération longue mais bornée (écriture du journal, effacement de secteur) ne
+ * déclenche rien tant qu'elle reste sous la période du battement : aucune tâche
+ * n'alimente le TWDT elle-même.
  *
  * Usage typique :
- * 1. watchdog_init()   → au démarrage de l'application
- * 2. watchdog_add_task() → au démarrage de chaque tâche critique
- * 3. watchdog_reset()  → régulièrement dans la boucle de la tâche
+ * 1. id = watchdog_register("nom", période) → au démarrage de chaque tâche critique
+ * 2. watchdog_beat(id)  → à chaque tour de boucle, au moins une fois par période
+ * 3. watchdog_init()    → depuis app_main, une fois les compteurs restaurés
  */
 
+#include <stdint.h>     // Pour uint32_t
+
 /**
- * @brief Initialise le task watchdog pour les tâches critiques.
- *        Configure le timeout, les cores surveillés et l'action en cas de timeout.
+ * @brief Reconfigure le TWDT (panic après WDT_TIMEOUT_S) et démarre le superviseur.
+ *
+ * Relit l'enregistrement RTC de la tâche en retard avant le redémarrage précédent.
+ * Les battements enregistrés avant l'appel sont surveillés dès le premier contrôle.
  */
 void watchdog_init(void);
 
 /**
- * @brief Ajoute la tâche courante à la liste des tâches surveillées par le WDT.
- *        Chaque tâche critique doit appeler cette fonction au démarrage.
+ * @brief Enregistre un battement.
+ *
+ * @param name      Nom de la tâche (chaîne statique)
+ * @param period_ms Intervalle maximal entre deux battements
+ * @return Identifiant du battement, -1 si WDT_MAX_HEARTBEATS sont déjà enregistrés
+ */
+int watchdog_register(const char *name, uint32_t period_ms);
+
+/**
+ * @brief Renouvelle un battement (sans verrou, depuis la tâche surveillée).
+ *
+ * @param id Identifiant rendu par watchdog_register (sans effet si -1)
  */
-void watchdog_add_task(void);
+void watchdog_beat(int id);
 
 /**
- * @brief Réinitialise le compteur du WDT pour la tâche courante.
- *        Doit être appelé régulièrement pour éviter le reset.
+ * @brief Tâche en retard qui a provoqué le redémarrage précédent.
+ *
+ * @return Nom de la tâche, NULL si le redémarrage précédent n'est pas dû au superviseur
  */
-void watchdog_reset(void);
+const char *watchdog_last_miss(void);
 
 #endif // WATCHDOG_H
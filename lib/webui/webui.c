@@ -0,0 +1,617 @@
+/**
+ * @file webui.c
+ * @brief Serveur HTTP : page statique gzip avec ETag, API JSON de configuration et de suivi.
+ *
+ * La page (lib/webui/www/index.html) est compressée et convertie en tableau C par
+ * tools/webui/embed.py : elle est envoyée telle quelle depuis la flash, en un appel, avec
+ * Content-Encoding: gzip. Son ETag est calculé à la génération ; un navigateur qui la
+ * possède déjà reçoit 304 sans corps.
+ *
+ * Les réponses JSON sont écrites dans un buffer statique puis envoyées en une fois
+ * (le serveur traite les requêtes une à une, dans sa propre tâche).
+ *
+ * Le corps de POST /api/config est reçu dans un buffer statique et analysé sur place :
+ * les chaînes sont décodées dans le buffer lui-même (terminées par un zéro à la place
+ * du guillemet fermant) et copiées une seule fois, dans leur paramètre. Le document est
+ * d'abord validé en entier : un JSON invalide ne modifie aucun paramètre. Il est ensuite
+ * appliqué à une copie de travail des paramètres, qui ne les remplace qu'une fois tout le
+ * document accepté ; les valeurs de compteurs saisies ne sont recalées qu'après.
+ */
+
+#include <stdio.h>                  // snprintf
+#include <stdlib.h>                 // strtod, strtoul
+#include <string.h>                 // strcmp, strncpy
+#include <stdarg.h>                 // Écriture JSON formatée
+#include "esp_http_server.h"        // Serveur HTTP
+#include "esp_timer.h"              // Durée depuis le démarrage
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "config.h"                 // Paramètres globaux, table des compteurs
+#include "webui.h"                  // Header du module
+#include "webui_assets.h"           // Page compressée et son ETag
+#include "webui_stream.h"           // Suivi en direct par WebSocket
+#include "counter_store.h"          // Lecture et recalage des compteurs
+#include "power_meter.h"            // Puissance des compteurs
+#include "storage.h"                // Sauvegarde des compteurs et des paramètres
+#include "gpio_pulse.h"             // Validité des GPIO de compteur
+#include "pulse_stats.h"            // Statistiques du chemin de comptage (PULSE_STATS)
+#include "wifi.h"                   // Oubli du dernier AP après un changement de réseau
+#include "history.h"                // Recalage hors intervalles, intervalles d'énergie
+
+#define STR_(x) #x
+#define STR(x) STR_(x)                     // Constante numérique en littéral de chaîne (en-tête Cache-Control)
+
+static const char *TAG = "WEBUI";          // Identifiant de log du module
+
+static httpd_handle_t server;              // Serveur HTTP (NULL tant qu'il n'est pas démarré)
+static bool server_writable;               // POST /api/config accepté
+static char json[WEBUI_JSON_MAX];          // Réponse JSON en cours (hors pile de la tâche httpd)
+static char body[WEBUI_POST_MAX];          // Corps du POST, analysé sur place
+
+/**
+ * @brief Copie de travail des paramètres modifiables par POST /api/config.
+ */
+typedef struct {
+    char wifi_ssid[sizeof(wifi_ssid)];
+    char wifi_pass[sizeof(wifi_pass)];
+    char wifi_ip[sizeof(wifi_ip)];
+    char wifi_gw[sizeof(wifi_gw)];
+    char wifi_mask[sizeof(wifi_mask)];
+    char wifi_dns[sizeof(wifi_dns)];
+    char mqtt_server[sizeof(mqtt_Server)];
+    char mqtt_port[sizeof(mqtt_port)];
+    char mqtt_user[sizeof(mqtt_user)];
+    char mqtt_pass[sizeof(mqtt_pass)];
+    uint8_t batch;                         ///< mqtt_batch_mode
+    uint8_t nch;                           ///< channel_count_next
+    channel_cfg_t channels[MAX_CHANNELS];  ///< Table des compteurs
+    publish_cfg_t publish[MAX_CHANNELS];   ///< Règles de publication
+    bool has_value[MAX_CHANNELS];          ///< Valeur de compteur saisie
+    uint64_t value[MAX_CHANNELS];          ///< Valeur saisie, recalée après l'application
+} config_stage_t;
+
+static config_stage_t stage;               // Copie de travail (hors pile de la tâche httpd)
+
+/* ========================= Écriture JSON ========================= */
+
+/**
+ * @brief Réponse JSON en cours d'écriture ; len peut dépasser size (réponse tronquée).
+ */
+typedef struct {
+    char *buf;      ///< Buffer de sortie
+    size_t size;    ///< Taille du buffer
+    size_t len;     ///< Longueur écrite (ou nécessaire)
+} jw_t;
+
+/**
+ * @brief Ajoute du texte formaté.
+ */
+static void jw_printf(jw_t *w, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(w->buf + (w->len < w->size ? w->len : w->size),
+                      w->len < w->size ? w->size - w->len : 0, fmt, ap);
+    va_end(ap);
+    if (n > 0) w->len += n;
+}
+
+/**
+ * @brief Ajoute "<clé>":"<chaîne échappée>" précédé d'une virgule si sep est vrai.
+ */
+static void jw_str(jw_t *w, bool sep, const char *key, const char *s)
+{
+    jw_printf(w, "%s\"%s\":\"", sep ? "," : "", key);
+    for (; *s != '\0'; s++)
+    {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') jw_printf(w, "\\%c", c);
+        else if (c < 0x20) jw_printf(w, "\\u%04x", c);   // Caractères de contrôle
+        else jw_printf(w, "%c", c);
+    }
+    jw_printf(w, "\"");
+}
+
+/**
+ * @brief Envoie la réponse JSON, ou une erreur 500 si elle a été tronquée.
+ */
+static esp_err_t jw_send(httpd_req_t *req, const jw_t *w)
+{
+    if (w->len >= w->size)
+    {
+        ESP_LOGE(TAG, "Réponse JSON tronquée (%u octets nécessaires)", (unsigned)w->len);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "WEBUI_JSON_MAX trop petit");
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, w->buf, w->len);
+}
+
+/* ========================= Lecture JSON sur place ========================= */
+
+/**
+ * @brief Position de lecture dans le corps (terminé par un zéro).
+ */
+typedef struct {
+    char *p;        ///< Prochain caractère à lire
+} jr_t;
+
+static void jr_ws(jr_t *r)
+{
+    while (*r->p == ' ' || *r->p == '\t' || *r->p == '\r' || *r->p == '\n') r->p++;
+}
+
+/**
+ * @brief Consomme le caractère c (après les blancs).
+ */
+static bool jr_char(jr_t *r, char c)
+{
+    jr_ws(r);
+    if (*r->p != c) return false;
+    r->p++;
+    return true;
+}
+
+/**
+ * @brief Valeur d'un chiffre hexadécimal, -1 sinon.
+ */
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Lit une chaîne ; avec decode, la décode sur place et la termine par un zéro.
+ *
+ * Une séquence d'échappement est toujours plus longue que les octets qu'elle produit
+ * (\\uXXXX : six caractères, trois octets UTF-8 au plus) : l'écriture ne rattrape
+ * jamais la lecture.
+ *
+ * @return Début de la chaîne (décodée si decode), NULL si la chaîne est invalide
+ */
+static char *jr_string(jr_t *r, bool decode)
+{
+    if (!jr_char(r, '"')) return NULL;
+    char *start = r->p, *out = r->p;
+    while (*r->p != '"')
+    {
+        char c = *r->p++;
+        if (c == '\0' || (unsigned char)c < 0x20) return NULL;  // Fin du corps ou caractère de contrôle
+        if (c == '\\')
+        {
+            c = *r->p++;
+            switch (c)
+            {
+                case '"': case '\\': case '/': break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                {
+                    unsigned cp = 0;
+                    for (int k = 0; k < 4; k++)
+                    {
+                        int d = hex_digit(*r->p++);
+                        if (d < 0) return NULL;
+                        cp = cp << 4 | d;
+                    }
+                    if (!decode) continue;
+                    if (cp < 0x80) *out++ = (char)cp;           // Encodage UTF-8 (hors paires de substitution)
+                    else if (cp < 0x800) { *out++ = (char)(0xC0 | cp >> 6); *out++ = (char)(0x80 | (cp & 0x3F)); }
+                    else { *out++ = (char)(0xE0 | cp >> 12); *out++ = (char)(0x80 | (cp >> 6 & 0x3F)); *out++ = (char)(0x80 | (cp & 0x3F)); }
+                    continue;
+                }
+                default: return NULL;
+            }
+        }
+        if (decode) *out++ = c;
+    }
+    r->p++;                                          // Guillemet fermant
+    if (decode) *out = '\0';                         // Au plus à la place du guillemet fermant
+    return start;
+}
+
+/**
+ * @brief Lit un nombre et le tronque à l'entier (exact jusqu'à 2^53, au-delà des compteurs 32 bits).
+ */
+static bool jr_int(jr_t *r, long long *out)
+{
+    jr_ws(r);
+    char *end;
+    double v = strtod(r->p, &end);
+    if (end == r->p || *r->p == 'i' || *r->p == 'I' || *r->p == 'n' || *r->p == 'N') return false; // Pas de nombre (ni inf, ni nan)
+    *out = v > 1e18 ? (long long)1e18 : v < -1e18 ? (long long)-1e18 : (long long)v;
+    r->p = end;
+    return true;
+}
+
+/**
+ * @brief Saute une valeur quelconque sans la modifier (validation du document).
+ */
+static bool jr_skip(jr_t *r, int depth)
+{
+    jr_ws(r);
+    if (depth > 8) return false;                     // Imbrication bornée : pile de la tâche httpd
+    if (*r->p == '"') return jr_string(r, false) != NULL;
+    if (*r->p == '{' || *r->p == '[')
+    {
+        char close = *r->p == '{' ? '}' : ']';
+        bool obj = close == '}';
+        r->p++;
+        if (jr_char(r, close)) return true;          // Objet ou tableau vide
+        do
+        {
+            if (obj && (jr_string(r, false) == NULL || !jr_char(r, ':'))) return false;
+            if (!jr_skip(r, depth + 1)) return false;
+        } while (jr_char(r, ','));
+        return jr_char(r, close);
+    }
+    if (strncmp(r->p, "true", 4) == 0) { r->p += 4; return true; }
+    if (strncmp(r->p, "false", 5) == 0) { r->p += 5; return true; }
+    if (strncmp(r->p, "null", 4) == 0) { r->p += 4; return true; }
+    long long v;
+    return jr_int(r, &v);
+}
+
+/* ========================= Page statique ========================= */
+
+/**
+ * @brief GET / : page compressée, 304 si le navigateur a déjà la même version.
+ */
+static esp_err_t index_get_handler(httpd_req_t *req)
+{
+    char etag[16];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", etag, sizeof(etag)) == ESP_OK &&
+        strcmp(etag, WEBUI_INDEX_ETAG) == 0)         // Version en cache à jour
+    {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_set_hdr(req, "ETag", WEBUI_INDEX_ETAG);
+        return httpd_resp_send(req, NULL, 0);
+    }
+    httpd_resp_set_type(req, "text/html; charset=UTF-8");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "ETag", WEBUI_INDEX_ETAG);
+    httpd_resp_set_hdr(req, "Cache-Control", "public, max-age=" STR(WEBUI_CACHE_MAX_AGE_S));
+    return httpd_resp_send(req, (const char *)webui_index_gz, sizeof(webui_index_gz));
+}
+
+/* ========================= API JSON ========================= */
+
+/**
+ * @brief GET /api/config : paramètres et table des compteurs (mots de passe jamais renvoyés).
+ */
+static esp_err_t config_get_handler(httpd_req_t *req)
+{
+    jw_t w = { json, sizeof(json), 0 };
+    jw_printf(&w, "{");
+    jw_str(&w, false, "device", DEVICE_NAME);
+    jw_printf(&w, ",\"readonly\":%s,\"max_channels\":%d", server_writable ? "false" : "true", MAX_CHANNELS);
+    jw_str(&w, true, "ssid", wifi_ssid);
+    jw_str(&w, true, "ip", wifi_ip);
+    jw_str(&w, true, "gw", wifi_gw);
+    jw_str(&w, true, "mask", wifi_mask);
+    jw_str(&w, true, "dns", wifi_dns);
+    jw_str(&w, true, "mqtt_server", mqtt_Server);
+    jw_str(&w, true, "mqtt_port", mqtt_port);
+    jw_str(&w, true, "mqtt_user", mqtt_user);
+    jw_printf(&w, ",\"batch\":%u,\"nch\":%u,\"channels\":[", mqtt_batch_mode, channel_count_next);
+    int shown = channel_count_next > channel_count ? channel_count_next : channel_count; // Compteurs ajoutés en attente compris
+    for (int i = 0; i < shown; i++)
+    {
+        jw_printf(&w, "%s{", i ? "," : "");
+        jw_str(&w, false, "name", channels[i].name);
+        jw_printf(&w, ",\"pin\":%d,\"ppkwh\":%lu,\"debounce_ms\":%lu,\"delta\":%lu,\"deadband_w\":%lu,\"min_s\":%lu,\"max_s\":%lu}",
+                  channels[i].pin, (unsigned long)channels[i].ppkwh, (unsigned long)(channels[i].debounce_us / 1000),
+                  (unsigned long)publish_cfg[i].delta, (unsigned long)publish_cfg[i].deadband_w,
+                  (unsigned long)publish_cfg[i].min_s, (unsigned long)publish_cfg[i].max_s);
+    }
+    jw_printf(&w, "]}");
+    return jw_send(req, &w);
+}
+
+/**
+ * @brief GET /api/counters : valeurs, énergie (Wh) et puissance (W) des compteurs.
+ */
+static esp_err_t counters_get_handler(httpd_req_t *req)
+{
+    uint64_t values[MAX_CHANNELS];                   // Copie cohérente des compteurs
+    counter_store_snapshot(values);
+
+    jw_t w = { json, sizeof(json), 0 };
+    jw_printf(&w, "{\"uptime\":%lu,\"counters\":[", (unsigned long)(esp_timer_get_time() / 1000000));
+    for (int i = 0; i < channel_count; i++)
+    {
+        power_reading_t p;
+        power_meter_get(i, &p);
+        uint64_t mwh = counter_store_mwh(i, values[i]);
+        jw_printf(&w, "%s{", i ? "," : "");
+        jw_str(&w, false, "name", channels[i].name);
+        jw_printf(&w, ",\"value\":%llu,\"wh\":%llu.%03u,\"w\":%.0f,\"w60\":%.0f}",
+                  (unsigned long long)values[i], (unsigned long long)(mwh / 1000), (unsigned)(mwh % 1000),
+                  (double)p.instant_w, (double)p.avg_60s_w);
+    }
+    jw_printf(&w, "]}");
+    return jw_send(req, &w);
+}
+
+/**
+ * @brief Copie une chaîne décodée dans un paramètre, tronquée à sa taille.
+ */
+static void set_str(char *dst, size_t size, const char *src)
+{
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+/**
+ * @brief Applique un champ d'un objet de "channels" à la copie de travail.
+ *
+ * @return false si la valeur n'a pas le type attendu
+ */
+static bool apply_channel_field(jr_t *r, int i, const char *key)
+{
+    long long v;
+    jr_ws(r);
+    if (strcmp(key, "name") == 0)
+    {
+        if (*r->p != '"') return jr_skip(r, 0);      // Nom non textuel : ignoré
+        const char *s = jr_string(r, true);
+        if (s == NULL) return false;
+        set_str(stage.channels[i].name, sizeof(stage.channels[i].name), s);
+        return true;
+    }
+    if (!jr_int(r, &v)) return jr_skip(r, 0);        // Champ non numérique : ignoré
+
+    channel_cfg_t *ch = &stage.channels[i];
+    publish_cfg_t *pub = &stage.publish[i];
+    if (strcmp(key, "value") == 0 && i < channel_count)
+    {
+        stage.has_value[i] = true;                   // Recalé après l'application du document
+        stage.value[i] = v < 0 ? 0 : (uint64_t)v;
+    }
+    else if (strcmp(key, "pin") == 0) ch->pin = gpio_pulse_pin_valid((int)v) ? (int8_t)v : -1; // Hors plage = non câblé
+    else if (strcmp(key, "ppkwh") == 0) ch->ppkwh = v > 0 ? (uint32_t)v : PULSES_PER_KWH;     // Jamais nulle (division)
+    else if (strcmp(key, "debounce_ms") == 0) ch->debounce_us = v > 0 ? (uint32_t)v * 1000 : 0;
+    else if (strcmp(key, "delta") == 0) pub->delta = v > 0 ? (uint32_t)v : 0;
+    else if (strcmp(key, "deadband_w") == 0) pub->deadband_w = v > 0 ? (uint32_t)v : 0;
+    else if (strcmp(key, "min_s") == 0) pub->min_s = v > 0 ? (uint32_t)v : 0;
+    else if (strcmp(key, "max_s") == 0) pub->max_s = v > 0 ? (uint32_t)v : 0;
+    return true;
+}
+
+/**
+ * @brief Applique le tableau "channels" : l'objet n décrit le compteur n.
+ */
+static bool apply_channels(jr_t *r)
+{
+    if (!jr_char(r, '[')) return jr_skip(r, 0);
+    if (jr_char(r, ']')) return true;
+    int i = 0;
+    do
+    {
+        if (i >= MAX_CHANNELS) return jr_skip(r, 0);  // Au-delà de la table : ignoré
+        if (!jr_char(r, '{')) return false;
+        if (!jr_char(r, '}'))
+        {
+            do
+            {
+                const char *key = jr_string(r, true);
+                if (key == NULL || !jr_char(r, ':') || !apply_channel_field(r, i, key)) return false;
+            } while (jr_char(r, ','));
+            if (!jr_char(r, '}')) return false;
+        }
+        i++;
+    } while (jr_char(r, ','));
+    return jr_char(r, ']');
+}
+
+/**
+ * @brief Paramètre texte de premier niveau désigné par sa clé.
+ */
+typedef struct {
+    const char *key;    ///< Clé JSON
+    char *live;         ///< Paramètre (global de config.h)
+    char *dst;          ///< Copie de travail du paramètre
+    size_t size;        ///< Taille du paramètre
+} str_field_t;
+
+static const str_field_t fields[] = {
+    { "ssid", wifi_ssid, stage.wifi_ssid, sizeof(wifi_ssid) },
+    { "pass", wifi_pass, stage.wifi_pass, sizeof(wifi_pass) },
+    { "ip", wifi_ip, stage.wifi_ip, sizeof(wifi_ip) },
+    { "gw", wifi_gw, stage.wifi_gw, sizeof(wifi_gw) },
+    { "mask", wifi_mask, stage.wifi_mask, sizeof(wifi_mask) },
+    { "dns", wifi_dns, stage.wifi_dns, sizeof(wifi_dns) },
+    { "mqtt_server", mqtt_Server, stage.mqtt_server, sizeof(mqtt_Server) },
+    { "mqtt_port", mqtt_port, stage.mqtt_port, sizeof(mqtt_port) },
+    { "mqtt_user", mqtt_user, stage.mqtt_user, sizeof(mqtt_user) },
+    { "mqtt_pass", mqtt_pass, stage.mqtt_pass, sizeof(mqtt_pass) },
+};
+
+/**
+ * @brief Copie les paramètres courants dans la copie de travail.
+ */
+static void stage_load(void)
+{
+    for (size_t k = 0; k < sizeof(fields) / sizeof(fields[0]); k++) memcpy(fields[k].dst, fields[k].live, fields[k].size);
+    stage.batch = mqtt_batch_mode;
+    stage.nch = channel_count_next;
+    memcpy(stage.channels, channels, sizeof(stage.channels));
+    memcpy(stage.publish, publish_cfg, sizeof(stage.publish));
+    memset(stage.has_value, 0, sizeof(stage.has_value));
+}
+
+/**
+ * @brief Remplace les paramètres par la copie de travail, puis recale les compteurs saisis.
+ */
+static void stage_commit(void)
+{
+    for (size_t k = 0; k < sizeof(fields) / sizeof(fields[0]); k++) memcpy(fields[k].live, fields[k].dst, fields[k].size);
+    mqtt_batch_mode = stage.batch;
+    channel_count_next = stage.nch;
+    memcpy(channels, stage.channels, sizeof(stage.channels));
+    memcpy(publish_cfg, stage.publish, sizeof(stage.publish));
+    for (int i = 0; i < channel_count; i++)
+    {
+        if (stage.has_value[i]) history_adjust_counter(i, stage.value[i] - counter_store_get(i)); // Écart modulo 2^64
+    }
+}
+
+/**
+ * @brief Applique le document de POST /api/config, déjà validé par jr_skip(), à la copie de travail.
+ */
+static bool apply_config(jr_t *r)
+{
+    if (!jr_char(r, '{')) return false;
+    if (jr_char(r, '}')) return true;
+    do
+    {
+        const char *key = jr_string(r, true);
+        if (key == NULL || !jr_char(r, ':')) return false;
+
+        size_t k = 0;
+        while (k < sizeof(fields) / sizeof(fields[0]) && strcmp(key, fields[k].key) != 0) k++;
+        long long v;
+        jr_ws(r);
+        if (k < sizeof(fields) / sizeof(fields[0]) && *r->p == '"') // Paramètre texte (absent = inchangé)
+        {
+            const char *s = jr_string(r, true);
+            if (s == NULL) return false;
+            set_str(fields[k].dst, fields[k].size, s);
+        }
+        else if (strcmp(key, "channels") == 0)
+        {
+            if (!apply_channels(r)) return false;
+        }
+        else if (strcmp(key, "batch") == 0 && jr_int(r, &v))
+        {
+            stage.batch = (v >= 0 && v <= MQTT_BATCH_CBOR) ? (uint8_t)v : MQTT_BATCH_DEFAULT; // Valeur inconnue : mode par défaut
+        }
+        else if (strcmp(key, "nch") == 0 && jr_int(r, &v))
+        {
+            stage.nch = (v >= 1 && v <= MAX_CHANNELS) ? (uint8_t)v : stage.nch; // Pris en compte au redémarrage
+        }
+        else if (!jr_skip(r, 0))                     // Clé inconnue
+        {
+            return false;
+        }
+    } while (jr_char(r, ','));
+    return jr_char(r, '}');
+}
+
+/**
+ * @brief POST /api/config : enregistre les paramètres (redémarrage nécessaire).
+ */
+static esp_err_t config_post_handler(httpd_req_t *req)
+{
+    if (!server_writable)
+    {
+        return httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Lecture seule hors du mode configuration");
+    }
+    if (req->content_len >= sizeof(body))
+    {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Payload too large");
+    }
+
+    size_t received = 0;
+    while (received < req->content_len)
+    {
+        int ret = httpd_req_recv(req, body + received, req->content_len - received);
+        if (ret <= 0) return ESP_FAIL;               // Erreur ou connexion fermée par le client
+        received += ret;
+    }
+    body[received] = '\0';
+
+    jr_t r = { body };
+    if (!jr_skip(&r, 0) || (jr_ws(&r), *r.p != '\0')) // Document complet et bien formé avant toute modification
+    {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "JSON invalide");
+    }
+    r.p = body;
+    stage_load();
+    if (!apply_config(&r))                           // Copie de travail abandonnée : aucun paramètre modifié
+    {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Document inattendu");
+    }
+    stage_commit();
+    ESP_LOGI(TAG, "Configuration reçue (%u octets, %u compteurs)", (unsigned)received, channel_count_next);
+
+    uint64_t values[MAX_CHANNELS];                   // Copie cohérente des compteurs à enregistrer
+    counter_store_snapshot(values);
+    storage_save_counters(values);                   // Un instantané de tous les compteurs dans le journal flash
+    storage_save_config();                           // Un seul blob, remplacé atomiquement
+    wifi_forget_ap();                                // Le réseau a pu changer : le prochain démarrage refait un balayage
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, "{\"saved\":true,\"reboot\":true}");
+}
+
+/**
+ * @brief GET /stats : rapport JSON des statistiques du comptage.
+ */
+static esp_err_t stats_get_handler(httpd_req_t *req)
+{
+    pulse_stats_json(json, sizeof(json));
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, json);
+}
+
+/**
+ * @brief Lit un paramètre numérique de l'URL (def s'il est absent).
+ */
+static uint32_t query_u32(const char *query, const char *key, uint32_t def)
+{
+    char val[16];
+    if (httpd_query_key_value(query, key, val, sizeof(val)) != ESP_OK) return def;
+    return (uint32_t)strtoul(val, NULL, 10);
+}
+
+/**
+ * @brief GET /api/history?res=15&from=..&to=.. : intervalles d'énergie d'une plage (history.h).
+ */
+static esp_err_t history_get_handler(httpd_req_t *req)
+{
+    char query[64] = "";
+    httpd_req_get_url_query_str(req, query, sizeof(query)); // Absente : valeurs par défaut
+    size_t len = history_query(query_u32(query, "res", HISTORY_PERIOD_S / 60), query_u32(query, "from", 0),
+                               query_u32(query, "to", UINT32_MAX), json, sizeof(json));
+    if (len == 0) return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "res : 1, 15 ou 60");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, json, len);
+}
+
+void webui_start(bool writable)
+{
+    server_writable = writable;
+    if (server != NULL) return;
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.core_id = CORE_NET;      // Avec la pile réseau, hors du cœur de comptage
+    esp_err_t ret = httpd_start(&server, &config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Serveur HTTP indisponible : %s", esp_err_to_name(ret));
+        server = NULL;
+        return;
+    }
+
+    const httpd_uri_t routes[] = {
+        { .uri = "/",             .method = HTTP_GET,  .handler = index_get_handler },
+        { .uri = "/api/config",   .method = HTTP_GET,  .handler = config_get_handler },
+        { .uri = "/api/config",   .method = HTTP_POST, .handler = config_post_handler },
+        { .uri = "/api/counters", .method = HTTP_GET,  .handler = counters_get_handler },
+        { .uri = "/api/history",  .method = HTTP_GET,  .handler = history_get_handler },
+        { .uri = "/stats",        .method = HTTP_GET,  .handler = stats_get_handler },
+    };
+    for (size_t i = 0; i < sizeof(routes) / sizeof(routes[0]); i++)
+    {
+        httpd_register_uri_handler(server, &routes[i]);
+    }
+    webui_stream_register(server);                   // GET /ws
+    ESP_LOGI(TAG, "Interface web démarrée (%s)", writable ? "configuration" : "lecture seule");
+}
@@ -0,0 +1,34 @@
+#ifndef WEBUI_H
+#define WEBUI_H
+
+/**
+ * @file webui.h
+ * @brief Interface web : page statique compressée et API JSON de configuration et de suivi.
+ *
+ * Routes :
+ * - GET  /             : page compressée gzip, servie depuis la flash avec ETag (304 si inchangée)
+ * - GET  /api/config   : paramètres et table des compteurs (sans les mots de passe)
+ * - POST /api/config   : enregistrement des paramètres (mode AP de configuration seulement)
+ * - GET  /api/counters : valeurs, énergie et puissance des compteurs
+ * - GET  /api/history  : intervalles d'énergie d'une plage (history.h)
+ * - GET  /stats        : statistiques du comptage (PULSE_STATS)
+ * - GET  /ws           : suivi en direct des compteurs par WebSocket (webui_stream.h)
+ *
+ * La page ne contient aucune donnée : elle est mise en cache par le navigateur et
+ * interroge l'API. Le corps d'un POST est analysé sur place, dans le buffer de réception.
+ *
+ * Usage typique :
+ * 1. webui_start(true) par start_config_ap() : configuration complète
+ * 2. webui_start(false) en mode normal (WEBUI_STA) : tableau de bord en lecture seule
+ */
+
+#include <stdbool.h>    // Pour bool
+
+/**
+ * @brief Démarre le serveur HTTP (sans effet s'il tourne déjà).
+ *
+ * @param writable true pour accepter POST /api/config (mode AP), false pour la lecture seule
+ */
+void webui_start(bool writable);
+
+#endif // WEBUI_H
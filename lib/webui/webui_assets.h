@@ -0,0 +1,156 @@
+#ifndef WEBUI_ASSETS_H
+#define WEBUI_ASSETS_H
+
+/**
+ * @file webui_assets.h
+ * @brief Page de l'interface web, compressée gzip (généré par tools/webui/embed.py, ne pas modifier).
+ *
+ * Source : lib/webui/www/index.html (4762 octets, 2204 compressés).
+ */
+
+#include <stdint.h>   // Pour uint8_t
+
+#define WEBUI_INDEX_ETAG "\"5e1abccf\"" // CRC32 de la page compressée
+
+static const uint8_t webui_index_gz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x58, 0x5d, 0x72, 0xdb, 0x38,
+    0x12, 0x7e, 0xd7, 0x29, 0x10, 0xce, 0x6c, 0x48, 0x95, 0x29, 0xca, 0xb2, 0xd7, 0xa9, 0x8c, 0x24,
+    0x2a, 0x95, 0x89, 0x93, 0x19, 0x6f, 0x4d, 0x12, 0xef, 0xda, 0xa9, 0xd4, 0x96, 0xd6, 0x95, 0x82,
+    0x48, 0x50, 0xc2, 0x18, 0x24, 0x18, 0x00, 0xd4, 0xcf, 0x2a, 0x3a, 0xc0, 0x5e, 0x63, 0xdf, 0x7c,
+    0x0e, 0x5f, 0x6c, 0xbb, 0x41, 0x8a, 0x22, 0x6d, 0x67, 0x6a, 0xab, 0xe6, 0x21, 0x11, 0xd9, 0x68,
+    0xf4, 0x1f, 0xbe, 0xfe, 0xd0, 0xf4, 0xf8, 0xd9, 0xf9, 0xc7, 0x37, 0xd7, 0xff, 0xbc, 0x7c, 0x4b,
+    0x16, 0x26, 0x15, 0x93, 0xce, 0x18, 0x7f, 0x88, 0xa0, 0xd9, 0x3c, 0x74, 0x12, 0xe5, 0x4c, 0xc6,
+    0x0b, 0x46, 0x63, 0x10, 0xa7, 0xcc, 0x50, 0x12, 0x2d, 0xa8, 0xd2, 0xcc, 0x84, 0xce, 0xa7, 0xeb,
+    0x77, 0xbd, 0x97, 0xce, 0x5e, 0x9c, 0xd1, 0x94, 0x85, 0xce, 0x92, 0xb3, 0x55, 0x2e, 0x95, 0x71,
+    0x48, 0x24, 0x33, 0xc3, 0x32, 0x50, 0x5b, 0xf1, 0xd8, 0x2c, 0xc2, 0x98, 0x2d, 0x79, 0xc4, 0x7a,
+    0xf6, 0xc5, 0x27, 0x3c, 0xe3, 0x86, 0x53, 0xd1, 0xd3, 0x11, 0x15, 0x2c, 0x1c, 0xa0, 0x11, 0xc3,
+    0x8d, 0x60, 0x93, 0x37, 0x32, 0xcd, 0x0d, 0x2b, 0x94, 0x26, 0x6f, 0xaf, 0x2e, 0x4f, 0x4f, 0xc6,
+    0xfd, 0x52, 0xdc, 0x19, 0x6b, 0xb3, 0xc1, 0xdf, 0x99, 0x8c, 0x37, 0xdb, 0x04, 0x4c, 0xf7, 0x12,
+    0x9a, 0x72, 0xb1, 0x19, 0x6a, 0x9a, 0xe9, 0x9e, 0x66, 0x8a, 0x27, 0xa3, 0x94, 0xaa, 0x39, 0xcf,
+    0x86, 0x83, 0x17, 0xf9, 0x1a, 0x9e, 0xd7, 0xa5, 0xaf, 0xe1, 0x4f, 0xc7, 0xc7, 0xf9, 0x7a, 0xd7,
+    0x11, 0x74, 0xc6, 0xc4, 0x36, 0xe6, 0x3a, 0x17, 0x74, 0x33, 0x9c, 0x09, 0x19, 0xdd, 0x56, 0x1b,
+    0x7a, 0x46, 0xe6, 0xc3, 0x97, 0xa8, 0xc3, 0xb3, 0xbc, 0x30, 0xbe, 0x66, 0x82, 0x45, 0x66, 0x9b,
+    0xd3, 0x38, 0xe6, 0xd9, 0x7c, 0x78, 0x66, 0xad, 0x59, 0xcb, 0xa7, 0xf9, 0x9a, 0x1c, 0x37, 0x4c,
+    0x9f, 0x9d, 0x80, 0xe9, 0x51, 0xf9, 0x3c, 0x38, 0x3e, 0xfe, 0xcb, 0x68, 0x26, 0xd7, 0x3d, 0xcd,
+    0xff, 0x8d, 0xdb, 0x66, 0x52, 0xc5, 0x4c, 0xf5, 0x40, 0xb2, 0xeb, 0x24, 0x9c, 0x89, 0x18, 0x4a,
+    0xb6, 0x6d, 0x38, 0x1c, 0xfc, 0x35, 0x6f, 0xac, 0x10, 0xeb, 0x3a, 0xc8, 0xb6, 0xfb, 0x98, 0x71,
+    0xd1, 0xd0, 0x99, 0x60, 0xdb, 0xca, 0x50, 0x24, 0x85, 0xa0, 0xb9, 0x66, 0xc3, 0xfd, 0x43, 0xc3,
+    0x2f, 0xa8, 0xc6, 0xbe, 0x59, 0x6c, 0x6b, 0x9f, 0xc6, 0xc8, 0x74, 0x38, 0x80, 0x68, 0xb5, 0x14,
+    0x3c, 0x26, 0x3f, 0x44, 0x51, 0x34, 0xda, 0xe7, 0x03, 0x7e, 0x09, 0x64, 0x3b, 0x32, 0x6c, 0x6d,
+    0x7a, 0x54, 0xf0, 0x79, 0x36, 0x54, 0x7c, 0xbe, 0x30, 0x68, 0x64, 0x98, 0x70, 0xa5, 0x4d, 0x2f,
+    0x5a, 0x70, 0x81, 0x06, 0x9b, 0xaf, 0xdb, 0x86, 0xbe, 0x60, 0x09, 0xa8, 0xcf, 0x0a, 0x70, 0x93,
+    0xd5, 0x75, 0x02, 0x9b, 0x04, 0x93, 0x6a, 0x56, 0x75, 0x70, 0x82, 0x79, 0xfc, 0x90, 0xea, 0x79,
+    0x79, 0x66, 0x2b, 0x86, 0x9e, 0xa0, 0x36, 0x22, 0xde, 0x75, 0x02, 0x25, 0x49, 0x22, 0x55, 0x5a,
+    0x1f, 0x4a, 0x26, 0x33, 0xb6, 0xeb, 0x8c, 0xfb, 0xd5, 0x51, 0x8f, 0xfb, 0x16, 0x75, 0x63, 0x3c,
+    0x72, 0x84, 0xe4, 0x49, 0x03, 0x1c, 0x63, 0x9d, 0xd3, 0x8c, 0xf0, 0x38, 0x74, 0x00, 0x57, 0x80,
+    0xcf, 0x3e, 0xbe, 0xc3, 0x0f, 0x28, 0x01, 0x92, 0xb0, 0x6e, 0x93, 0xb1, 0x29, 0xb7, 0x1b, 0x85,
+    0x8f, 0xf5, 0x5e, 0x40, 0xd4, 0xc2, 0x0a, 0x2e, 0xd2, 0xbc, 0x10, 0x9a, 0xcb, 0x4c, 0xd7, 0xa2,
+    0xfb, 0xff, 0x64, 0x0c, 0x62, 0x67, 0xc4, 0xbb, 0xfd, 0xbc, 0xe8, 0xd6, 0xe2, 0xcb, 0x82, 0x6b,
+    0x80, 0x59, 0x04, 0xf2, 0xcf, 0x07, 0xe9, 0x7b, 0xb9, 0x09, 0xc8, 0x8b, 0x63, 0xa2, 0x0f, 0xd2,
+    0x3e, 0xfa, 0xea, 0x9b, 0xaa, 0x59, 0x0c, 0x06, 0x6e, 0x63, 0x14, 0x7c, 0xc9, 0x30, 0x48, 0x2b,
+    0xc1, 0x5f, 0x1b, 0x60, 0x67, 0x9c, 0x4f, 0xc6, 0x3a, 0xa5, 0x42, 0x4c, 0xce, 0xef, 0xef, 0xa0,
+    0x6a, 0xea, 0xfe, 0x8e, 0xc4, 0x2c, 0x07, 0x6f, 0x8d, 0xfc, 0x8a, 0xdc, 0x99, 0xf4, 0xaa, 0xfc,
+    0x08, 0x84, 0x5a, 0x6e, 0x18, 0xf7, 0xf3, 0x49, 0xa7, 0x33, 0xc6, 0xf2, 0x59, 0xad, 0x28, 0x99,
+    0x63, 0x0f, 0x2d, 0x4e, 0x27, 0x9f, 0x79, 0xef, 0x1d, 0x87, 0x42, 0x9c, 0xc2, 0xab, 0xc5, 0xfc,
+    0xe4, 0xea, 0xea, 0xe2, 0x7c, 0x6c, 0xf1, 0x55, 0xf5, 0xa8, 0xd6, 0x3c, 0xc6, 0x70, 0xca, 0xe5,
+    0xbd, 0xda, 0x7b, 0x69, 0xc0, 0x3b, 0xc9, 0xa9, 0xd6, 0x90, 0xe8, 0x92, 0xc3, 0x73, 0x08, 0xb0,
+    0x84, 0x6e, 0xcf, 0xe6, 0xf7, 0x77, 0xdd, 0x96, 0x05, 0x54, 0x72, 0x88, 0xd9, 0xe4, 0xd5, 0xf3,
+    0x0a, 0x80, 0xf7, 0xd8, 0xe2, 0xeb, 0x58, 0x31, 0x34, 0x76, 0x71, 0x49, 0xb4, 0xa1, 0x86, 0x7f,
+    0x2d, 0x0e, 0x86, 0xcf, 0x7f, 0x7d, 0x73, 0xd9, 0xb6, 0xc9, 0x73, 0x87, 0x00, 0x0c, 0x22, 0xb6,
+    0x00, 0x74, 0x30, 0x15, 0x3a, 0x83, 0x9f, 0x4e, 0x82, 0xc1, 0x8b, 0x97, 0xc1, 0x20, 0x38, 0x3b,
+    0x7e, 0x6c, 0xfc, 0x12, 0xe3, 0x54, 0x4c, 0x08, 0xd6, 0xb2, 0x32, 0x5f, 0x7d, 0xd7, 0xca, 0xe0,
+    0x89, 0x9c, 0xa9, 0x86, 0xa0, 0x5a, 0x06, 0x52, 0xaa, 0x6f, 0x1f, 0x98, 0x38, 0x39, 0x3b, 0x0b,
+    0xf6, 0xff, 0x9e, 0x88, 0xe4, 0xfc, 0xc3, 0x15, 0xf1, 0xf2, 0x3a, 0x1c, 0xa2, 0x39, 0xc1, 0x24,
+    0xdb, 0xd9, 0xc5, 0x99, 0x6e, 0xee, 0x84, 0xe3, 0x79, 0xff, 0xf7, 0xeb, 0xeb, 0xf6, 0x39, 0x31,
+    0xb5, 0x44, 0x80, 0xb6, 0xa2, 0xf9, 0x6a, 0xcc, 0x17, 0x8d, 0x0b, 0xea, 0x41, 0x50, 0xb8, 0x32,
+    0xec, 0xf7, 0xff, 0x30, 0xbd, 0x4b, 0x20, 0xe2, 0xc7, 0xe6, 0x4a, 0x7a, 0x6e, 0x17, 0xe9, 0xe5,
+    0xcb, 0xd3, 0xc7, 0xdb, 0x3f, 0x19, 0x2e, 0xb8, 0xa6, 0xe6, 0xc9, 0xa0, 0x0a, 0x88, 0xea, 0xcf,
+    0x81, 0xa8, 0x0c, 0xe6, 0xff, 0x42, 0xd2, 0x65, 0x31, 0x13, 0x3c, 0x02, 0x08, 0xc9, 0x0c, 0xcc,
+    0x6b, 0xb8, 0x5b, 0x2a, 0x22, 0x18, 0x97, 0x64, 0x5d, 0x59, 0x9c, 0x51, 0x13, 0x2d, 0xb0, 0x0f,
+    0x64, 0x6e, 0x55, 0x97, 0x54, 0x14, 0x20, 0x86, 0x33, 0xfb, 0x94, 0x91, 0x14, 0xb0, 0x48, 0xe7,
+    0x18, 0x9b, 0xaa, 0xf7, 0x8f, 0xfb, 0xa5, 0xe6, 0xa3, 0x2d, 0x50, 0xcc, 0x5f, 0x94, 0x2c, 0xf2,
+    0xfb, 0x3b, 0x46, 0xfe, 0x76, 0xf5, 0xf1, 0xc3, 0x77, 0x15, 0x4f, 0x1a, 0x8a, 0x6f, 0x7e, 0xfe,
+    0xf8, 0x8f, 0x86, 0x62, 0xbf, 0x8c, 0xad, 0x7d, 0xea, 0x35, 0x85, 0xb5, 0x8e, 0xfe, 0x83, 0x4c,
+    0x67, 0x8a, 0x61, 0xe5, 0xea, 0xcc, 0x00, 0x52, 0x0a, 0x88, 0x80, 0x65, 0x95, 0x88, 0xd0, 0x82,
+    0x28, 0x16, 0x97, 0x44, 0x01, 0x79, 0xb4, 0x6b, 0x09, 0x15, 0xde, 0x57, 0x31, 0x2b, 0xd2, 0x19,
+    0xa2, 0x25, 0xe5, 0x99, 0xcd, 0xe3, 0xe0, 0x3e, 0xe6, 0xcb, 0x92, 0x2c, 0x16, 0x16, 0x8b, 0xf0,
+    0x0a, 0xc2, 0x92, 0xc5, 0xab, 0xbd, 0xba, 0x98, 0xa5, 0xdc, 0x38, 0x93, 0xb7, 0x99, 0x62, 0x73,
+    0xae, 0x8d, 0x62, 0x50, 0xa2, 0x52, 0x63, 0xd2, 0xe0, 0x24, 0xe0, 0xf3, 0x9a, 0x73, 0x21, 0x4f,
+    0x64, 0x21, 0x64, 0x23, 0x1d, 0x29, 0x9e, 0x9b, 0x49, 0x07, 0x6e, 0x7e, 0x6d, 0xc8, 0x8f, 0x21,
+    0xa8, 0x4e, 0x62, 0x19, 0x15, 0x29, 0x8c, 0x01, 0xc1, 0x9c, 0x99, 0xb7, 0x82, 0xe1, 0xe3, 0xcf,
+    0x9b, 0x8b, 0xd8, 0xe3, 0x71, 0x77, 0x54, 0x29, 0xbe, 0x0b, 0xa7, 0x53, 0xc7, 0x96, 0xd3, 0xf1,
+    0x9d, 0x03, 0x2b, 0x3b, 0x37, 0xfe, 0xd4, 0xc1, 0xec, 0x40, 0x0a, 0xf5, 0x71, 0xfc, 0x01, 0x0a,
+    0x72, 0x9e, 0xc1, 0xfb, 0x2f, 0x97, 0x17, 0x1f, 0x89, 0xd7, 0x1b, 0x00, 0xb8, 0xe0, 0xd2, 0x20,
+    0xd1, 0xfd, 0x7f, 0x67, 0x02, 0xe0, 0x65, 0xb7, 0xe4, 0xf9, 0xed, 0x6a, 0xd1, 0xb2, 0xd4, 0x07,
+    0x36, 0x87, 0xa5, 0xce, 0x14, 0x2e, 0x8b, 0x99, 0x2c, 0x80, 0xc8, 0xbf, 0xa4, 0x1a, 0x34, 0x5e,
+    0x67, 0x86, 0xf7, 0x14, 0x88, 0xb2, 0x98, 0x78, 0xa9, 0x2e, 0xb7, 0xc7, 0x4c, 0x18, 0x0a, 0x8b,
+    0x4d, 0xc8, 0x19, 0x59, 0x68, 0x22, 0x00, 0x77, 0x1e, 0xaf, 0x8d, 0xee, 0xb5, 0x69, 0x3c, 0xa3,
+    0x59, 0xfc, 0x65, 0x05, 0x5b, 0x64, 0x41, 0xee, 0xef, 0x22, 0xaa, 0x6c, 0x0b, 0xc0, 0xa5, 0x50,
+    0xfa, 0x84, 0x73, 0xf8, 0x62, 0xbd, 0x15, 0xd0, 0x73, 0x60, 0x07, 0x8c, 0x19, 0x56, 0x99, 0xab,
+    0xac, 0xc0, 0x44, 0xb1, 0x57, 0x49, 0x25, 0xcf, 0x1e, 0xe8, 0xf8, 0xe4, 0x18, 0xf2, 0xfc, 0x9d,
+    0xa6, 0x94, 0xa3, 0xfe, 0xcd, 0xa8, 0x23, 0x60, 0x60, 0x00, 0xc6, 0x1f, 0x75, 0x12, 0x48, 0xc6,
+    0x46, 0x68, 0xe7, 0x08, 0x2f, 0xf1, 0xb9, 0xbf, 0xec, 0x6e, 0x15, 0x33, 0x85, 0xca, 0x88, 0x5b,
+    0x81, 0xcb, 0x3d, 0x4a, 0xa6, 0x83, 0x9b, 0x23, 0xb7, 0x02, 0x4c, 0x24, 0xa0, 0xcd, 0x42, 0xc7,
+    0x3d, 0xf2, 0x92, 0xe9, 0xc9, 0xcd, 0x2b, 0xd7, 0x1d, 0xba, 0x99, 0xdb, 0x3d, 0x72, 0x1d, 0x12,
+    0x53, 0x43, 0xe1, 0xb2, 0xc7, 0x35, 0x5e, 0xbf, 0xdf, 0xe2, 0x6b, 0x32, 0x3d, 0x06, 0x03, 0xf0,
+    0xd0, 0x21, 0x87, 0x5d, 0x6d, 0xbc, 0xa1, 0x89, 0x7d, 0x53, 0xb8, 0x47, 0x57, 0x46, 0xc1, 0x4c,
+    0xe0, 0x2d, 0xbb, 0x81, 0x62, 0x96, 0x69, 0xbc, 0xbe, 0xd3, 0x9f, 0xfb, 0xee, 0xf3, 0xaf, 0x85,
+    0x34, 0x23, 0xeb, 0xae, 0x06, 0xa6, 0x3b, 0xda, 0x75, 0xa8, 0xde, 0x64, 0x11, 0xa9, 0xd3, 0x11,
+    0x92, 0xc6, 0x5e, 0x77, 0xdb, 0xc1, 0x2c, 0x43, 0xba, 0xa2, 0xdc, 0x10, 0xaf, 0xfc, 0x49, 0x18,
+    0xb4, 0xb8, 0xe7, 0xf6, 0x69, 0xce, 0xfb, 0x00, 0x9f, 0x84, 0xcf, 0xdd, 0x6e, 0x37, 0xf8, 0x5d,
+    0xcb, 0xcc, 0x03, 0x40, 0x91, 0x1f, 0x3d, 0x17, 0x06, 0x02, 0xb7, 0x1b, 0xe0, 0xb4, 0xf2, 0xa6,
+    0x9a, 0x40, 0xc1, 0x48, 0x50, 0x8e, 0x9f, 0xa0, 0xc1, 0x13, 0x0f, 0xdf, 0x15, 0x1c, 0x9c, 0xcc,
+    0xc4, 0xa6, 0x5b, 0x03, 0x14, 0xef, 0xe6, 0xc0, 0x16, 0xe7, 0x37, 0x40, 0x7e, 0x00, 0x53, 0x8d,
+    0xe7, 0x2a, 0xe9, 0xa2, 0xd5, 0x12, 0xa7, 0x49, 0x08, 0xd6, 0x61, 0xaf, 0x15, 0x01, 0xe6, 0xbd,
+    0x52, 0x7c, 0x4b, 0x64, 0x42, 0xa6, 0xe5, 0xa5, 0xea, 0xe3, 0x2d, 0xe6, 0xe3, 0x25, 0xe4, 0x97,
+    0x17, 0x89, 0x6f, 0x89, 0xdf, 0x6f, 0xf1, 0xb8, 0xdf, 0xa0, 0x61, 0xbf, 0x41, 0xa6, 0x7e, 0xc5,
+    0x5f, 0xbe, 0xed, 0xe6, 0x9b, 0x6e, 0x12, 0xb0, 0xb2, 0x61, 0xf4, 0xf4, 0xf6, 0x26, 0x28, 0x4b,
+    0x0b, 0xee, 0xe1, 0x05, 0xfd, 0xd7, 0x8b, 0x01, 0x68, 0x07, 0x80, 0x20, 0x9b, 0x26, 0x22, 0x09,
+    0xc9, 0x36, 0x63, 0x42, 0x97, 0xe5, 0x80, 0x66, 0x87, 0x72, 0x70, 0x90, 0xa8, 0x5f, 0xaf, 0xdf,
+    0xff, 0x66, 0xb5, 0xf6, 0x1a, 0xa0, 0x9e, 0x7b, 0x5e, 0xe4, 0xf3, 0x6e, 0x38, 0x71, 0xc7, 0xfb,
+    0x59, 0x74, 0x32, 0x16, 0x6c, 0xce, 0xb2, 0xb8, 0xe6, 0x2a, 0x02, 0x58, 0xe1, 0x47, 0x03, 0x38,
+    0x34, 0x38, 0xb2, 0x72, 0x09, 0x91, 0x40, 0xde, 0xd9, 0xfd, 0xeb, 0x70, 0x52, 0xa2, 0x6f, 0x0d,
+    0xe8, 0x5b, 0x03, 0x50, 0xc2, 0xb0, 0xea, 0xe6, 0x57, 0x8e, 0x33, 0x8c, 0xa6, 0x28, 0xba, 0xc1,
+    0x33, 0x02, 0x64, 0x7b, 0xae, 0x6b, 0xad, 0xd4, 0xae, 0xdc, 0x83, 0x7c, 0xd4, 0x79, 0x0c, 0x03,
+    0x98, 0x9b, 0x2c, 0x0c, 0x8c, 0xda, 0xc0, 0xff, 0xd5, 0x39, 0xe8, 0x3f, 0x42, 0x44, 0x01, 0x47,
+    0xae, 0x74, 0x0b, 0x13, 0x58, 0x85, 0x22, 0x7f, 0x80, 0x09, 0x1d, 0x14, 0xc0, 0xd3, 0x29, 0xab,
+    0xd6, 0xd1, 0x53, 0xab, 0x4c, 0x3a, 0xd8, 0xdb, 0xb2, 0x49, 0x46, 0x58, 0x20, 0x3b, 0x49, 0x62,
+    0xee, 0x51, 0x80, 0xbc, 0x74, 0x80, 0xf6, 0xd8, 0x42, 0x5b, 0x94, 0xc0, 0x86, 0xf1, 0x2e, 0xae,
+    0xf5, 0x6c, 0x21, 0x5a, 0x32, 0xf0, 0x47, 0xbc, 0x28, 0x58, 0x2d, 0xfa, 0x30, 0xb9, 0x1f, 0x43,
+    0x50, 0xf2, 0x1d, 0x5f, 0xb3, 0xd8, 0x3b, 0x7d, 0xb8, 0x75, 0xf5, 0xf0, 0xfd, 0xc5, 0xf1, 0x5e,
+    0x82, 0x73, 0x66, 0xab, 0x72, 0x64, 0x17, 0x21, 0x74, 0x3c, 0xd6, 0xdd, 0xee, 0xa0, 0x8c, 0x7b,
+    0x9c, 0x06, 0x50, 0x2f, 0xcb, 0xe8, 0x61, 0x59, 0x58, 0x16, 0x4e, 0xa0, 0x8c, 0x2c, 0xc8, 0x15,
+    0x5b, 0x42, 0x11, 0xce, 0x59, 0x42, 0x0b, 0x61, 0xbc, 0x26, 0xc4, 0x59, 0x60, 0x60, 0x7c, 0x67,
+    0xc6, 0x97, 0xe1, 0x76, 0xf7, 0x07, 0x38, 0xb7, 0xf7, 0xf6, 0x9f, 0x84, 0xfb, 0x61, 0x00, 0xb8,
+    0xe9, 0x42, 0x59, 0xa0, 0x33, 0x9f, 0x80, 0xfc, 0x33, 0x80, 0x93, 0xf3, 0xed, 0xdb, 0xb3, 0xdb,
+    0x00, 0x70, 0xa7, 0x3f, 0x73, 0xb3, 0xf0, 0x4a, 0xe7, 0xdd, 0xae, 0x04, 0xa5, 0xf0, 0x89, 0x2d,
+    0x10, 0xb6, 0x0c, 0x6c, 0x2f, 0x85, 0x47, 0x8d, 0x3e, 0xb1, 0x92, 0x4a, 0x43, 0x62, 0xd7, 0xb4,
+    0x56, 0xb3, 0x7a, 0x0d, 0x77, 0xef, 0x3b, 0xe4, 0x89, 0x76, 0x81, 0x5e, 0xf1, 0xb6, 0xbb, 0x6e,
+    0x9b, 0x04, 0xd6, 0x58, 0x9c, 0x9a, 0x4a, 0x60, 0xa6, 0x54, 0x9b, 0x2b, 0x7b, 0xfb, 0x4b, 0xf5,
+    0x5a, 0x08, 0xcf, 0x9d, 0x56, 0xdc, 0x7a, 0x03, 0xc8, 0xdc, 0x96, 0xb9, 0xae, 0xab, 0x96, 0xc6,
+    0xfc, 0x9e, 0x3f, 0x5f, 0x07, 0xa8, 0x01, 0x2d, 0x11, 0xdc, 0xd6, 0xfd, 0xd3, 0xc5, 0x4f, 0x68,
+    0x9e, 0xd9, 0x90, 0x1a, 0x31, 0x4d, 0x0f, 0xba, 0x60, 0xb0, 0xf1, 0x06, 0xd5, 0x58, 0x07, 0x96,
+    0x94, 0x6b, 0x56, 0x7e, 0x75, 0x54, 0xb9, 0x19, 0xae, 0xeb, 0xec, 0x76, 0xfb, 0xd3, 0x56, 0xe1,
+    0x77, 0x39, 0xd5, 0xdf, 0xc2, 0x37, 0xfd, 0x42, 0xc6, 0x43, 0xf7, 0xf2, 0xe3, 0xd5, 0xb5, 0xeb,
+    0xe3, 0x27, 0x0d, 0xf4, 0xc2, 0x70, 0xeb, 0x56, 0x0d, 0xd4, 0xbb, 0x06, 0x3f, 0x70, 0x09, 0xd0,
+    0x3c, 0xdf, 0x5f, 0x93, 0x7d, 0xec, 0x38, 0x77, 0xe7, 0x23, 0x91, 0x0e, 0x71, 0x68, 0x0a, 0xb4,
+    0xbd, 0x05, 0x78, 0xb2, 0xf1, 0x64, 0x77, 0x57, 0xd1, 0x33, 0xcc, 0x0e, 0x0f, 0x5a, 0x51, 0x05,
+    0xf2, 0xf6, 0x95, 0x5b, 0x8f, 0x1c, 0xf7, 0x77, 0xfe, 0x61, 0xd0, 0x61, 0x8a, 0x88, 0x7f, 0xa1,
+    0x13, 0xaa, 0x18, 0x17, 0xe0, 0xef, 0x2d, 0xc8, 0x80, 0x91, 0x86, 0xc0, 0x49, 0x65, 0xf0, 0xca,
+    0xda, 0x42, 0x0c, 0xef, 0x1a, 0xf7, 0x21, 0x8e, 0x2e, 0x34, 0x2d, 0xaf, 0x90, 0x8a, 0x34, 0x32,
+    0xb6, 0x22, 0x9f, 0xd9, 0xec, 0x0a, 0x3e, 0xfc, 0x99, 0xf1, 0xdc, 0x95, 0x86, 0xe9, 0xd9, 0x3d,
+    0x12, 0xb2, 0x0c, 0x3e, 0x58, 0x48, 0x6d, 0x8e, 0xdc, 0xfe, 0x4a, 0xdb, 0x7e, 0xd2, 0xd0, 0x3a,
+    0xd5, 0xc0, 0x18, 0x96, 0x5d, 0x53, 0x77, 0x88, 0xcd, 0x2c, 0xc7, 0x3f, 0x81, 0x78, 0xcc, 0x96,
+    0xbe, 0xeb, 0x2b, 0xb9, 0xd2, 0xe1, 0x81, 0x45, 0xf0, 0x15, 0x8f, 0xec, 0x00, 0x8f, 0x08, 0xe1,
+    0x91, 0x04, 0x91, 0x3d, 0xfb, 0xba, 0xfa, 0xa8, 0x37, 0x8d, 0x02, 0x7e, 0x33, 0x02, 0x38, 0x3c,
+    0x53, 0x00, 0x72, 0x40, 0x5b, 0xeb, 0xd0, 0x21, 0xbb, 0x08, 0xbe, 0x29, 0x34, 0xdc, 0xdf, 0xed,
+    0x1b, 0x2d, 0x58, 0x8e, 0xf6, 0x4b, 0x27, 0xed, 0x25, 0xe0, 0x96, 0x65, 0xdf, 0x6b, 0xc2, 0xd6,
+    0xba, 0x08, 0xec, 0x58, 0xf4, 0xed, 0x9b, 0x25, 0x9d, 0x26, 0xeb, 0xd4, 0x76, 0x4e, 0x1f, 0xba,
+    0x58, 0x61, 0x04, 0x00, 0x96, 0x5d, 0x55, 0x8f, 0x48, 0x48, 0xcd, 0x42, 0xc4, 0x3f, 0x80, 0xed,
+    0x1a, 0xb8, 0x13, 0x86, 0x14, 0xaf, 0x2c, 0xb4, 0x7f, 0x86, 0x66, 0x91, 0xc1, 0xcb, 0x9b, 0x3b,
+    0x80, 0x6f, 0xe0, 0xcc, 0xc3, 0x72, 0x54, 0x8f, 0xa5, 0x5a, 0x77, 0x04, 0x3b, 0x2f, 0x90, 0x55,
+    0x01, 0x8b, 0x76, 0x79, 0xbf, 0x11, 0x86, 0xc9, 0x6a, 0x78, 0x84, 0x79, 0xb3, 0xfc, 0x48, 0x2e,
+    0xff, 0x12, 0xf5, 0x3f, 0x2c, 0x8a, 0x69, 0x3a, 0x9a, 0x12, 0x00, 0x00,
+};
+
+#endif // WEBUI_ASSETS_H
@@ -0,0 +1,195 @@
+/**
+ * @file webui_stream.c
+ * @brief Diffusion WebSocket des compteurs : une trame partagée par période, clients lents écartés.
+ *
+ * Les envois passent par httpd_ws_send_data_async() : ils sont exécutés par la tâche du
+ * serveur HTTP, jamais par la tâche de diffusion. Le compteur inflight suit les envois
+ * de la trame courante ; le buffer n'est réécrit qu'une fois tous les envois terminés.
+ * Un client dont l'envoi échoue (délai d'émission dépassé, connexion perdue) est fermé.
+ */
+
+#include <stdatomic.h>              // Clients et envois en cours
+#include <stdio.h>                  // snprintf
+#include "sdkconfig.h"              // CONFIG_HTTPD_WS_SUPPORT
+#include "freertos/FreeRTOS.h"      // API FreeRTOS
+#include "freertos/task.h"          // Tâche de diffusion
+#include "esp_timer.h"              // Horodatage des trames
+#include "esp_log.h"                // Système de logs ESP-IDF
+#include "config.h"                 // WEBUI_STREAM_*, channel_count
+#include "webui_stream.h"           // Header du module
+#include "counter_store.h"          // Valeurs des compteurs
+#include "power_meter.h"            // Puissance des compteurs
+
+static const char *TAG = "WEBUI_WS";       // Identifiant de log du module
+
+#if CONFIG_HTTPD_WS_SUPPORT
+
+static httpd_handle_t ws_server;           // Serveur portant la route /ws
+static TaskHandle_t stream_task;           // Tâche de diffusion
+static _Atomic int clients[WEBUI_STREAM_MAX_CLIENTS]; // Sockets des clients (-1 = libre)
+static _Atomic int inflight;               // Envois de la trame courante non terminés
+static _Atomic bool full_pending;          // Nouveau client : prochaine trame complète
+static char frame[WEBUI_STREAM_FRAME_MAX]; // Trame partagée par tous les clients
+
+/**
+ * @brief Fin d'un envoi asynchrone (tâche httpd) : ferme le client en cas d'échec.
+ */
+static void send_done(esp_err_t err, int fd, void *arg)
+{
+    if (err != ESP_OK)
+    {
+        for (int k = 0; k < WEBUI_STREAM_MAX_CLIENTS; k++)
+        {
+            int expected = fd;
+            atomic_compare_exchange_strong(&clients[k], &expected, -1);
+        }
+        httpd_sess_trigger_close(ws_server, fd);   // Client trop lent ou parti
+    }
+    atomic_fetch_sub(&inflight, 1);
+}
+
+/**
+ * @brief Gestionnaire de /ws : inscrit le client à la poignée de main, ignore ses messages.
+ */
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET)               // Poignée de main terminée
+    {
+        int fd = httpd_req_to_sockfd(req);
+        for (int k = 0; k < WEBUI_STREAM_MAX_CLIENTS; k++)
+        {
+            int expected = -1;
+            if (atomic_compare_exchange_strong(&clients[k], &expected, fd))
+            {
+                atomic_store(&full_pending, true);
+                xTaskNotifyGive(stream_task);  // Réveille la diffusion si elle dormait
+                ESP_LOGI(TAG, "Client %d connecté", fd);
+                return ESP_OK;
+            }
+        }
+        ESP_LOGW(TAG, "Trop de clients, %d refusé", fd);
+        return ESP_FAIL;                       // Connexion fermée par le serveur
+    }
+
+    uint8_t buf[32];                           // Messages du client : lus et ignorés
+    httpd_ws_frame_t in = { .payload = NULL };
+    esp_err_t ret = httpd_ws_recv_frame(req, &in, 0); // Longueur seule
+    if (ret != ESP_OK || in.len > sizeof(buf)) return ESP_FAIL;
+    in.payload = buf;
+    return in.len ? httpd_ws_recv_frame(req, &in, in.len) : ESP_OK;
+}
+
+/**
+ * @brief Écrit la trame des compteurs modifiés depuis la trame précédente.
+ *
+ * @param last   Valeurs envoyées dans la trame précédente (mises à jour)
+ * @param last_w Puissances envoyées dans la trame précédente (mises à jour)
+ * @param full   true pour inclure tous les compteurs
+ * @return Longueur de la trame, 0 si rien n'a changé
+ */
+static size_t build_frame(uint64_t last[MAX_CHANNELS], int32_t last_w[MAX_CHANNELS], bool full)
+{
+    uint64_t values[MAX_CHANNELS];
+    counter_store_snapshot(values);
+
+    size_t len = snprintf(frame, sizeof(frame), "{\"t\":%llu%s,\"c\":[",
+                          (unsigned long long)(esp_timer_get_time() / 1000), full ? ",\"full\":true" : "");
+    int n = 0;
+    for (int i = 0; i < channel_count; i++)
+    {
+        power_reading_t p;
+        power_meter_get(i, &p);
+        int32_t w = (int32_t)(p.instant_w + 0.5f);
+        if (!full && values[i] == last[i] && w == last_w[i]) continue; // Compteur inchangé
+
+        int k = snprintf(frame + len, sizeof(frame) - len, "%s{\"i\":%d,\"v\":%llu,\"d\":%llu,\"w\":%ld}",
+                         n ? "," : "", i, (unsigned long long)values[i],
+                         (unsigned long long)(values[i] - last[i]), (long)w);
+        if (k < 0 || len + k + 3 > sizeof(frame)) break; // Trame pleine : le reste passe à la suivante
+        len += k;
+        last[i] = values[i];
+        last_w[i] = w;
+        n++;
+    }
+    if (n == 0 && !full) return 0;
+    len += snprintf(frame + len, sizeof(frame) - len, "]}");
+    return len;
+}
+
+/**
+ * @brief Tâche de diffusion : dort sans client, sinon une trame par période.
+ */
+static void task_stream(void *pv)
+{
+    uint64_t last[MAX_CHANNELS] = {0};         // Valeurs de la dernière trame envoyée
+    int32_t last_w[MAX_CHANNELS] = {0};
+
+    while (1)
+    {
+        int fds[WEBUI_STREAM_MAX_CLIENTS];
+        int count = 0;
+        for (int k = 0; k < WEBUI_STREAM_MAX_CLIENTS; k++)
+        {
+            int fd = atomic_load(&clients[k]);
+            if (fd < 0) continue;
+            if (httpd_ws_get_fd_info(ws_server, fd) != HTTPD_WS_CLIENT_WEBSOCKET) // Déconnecté
+            {
+                atomic_compare_exchange_strong(&clients[k], &fd, -1);
+                continue;
+            }
+            fds[count++] = fd;
+        }
+        if (count == 0)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Réveillée par la connexion d'un client
+            continue;
+        }
+
+        if (atomic_load(&inflight) == 0)       // Trame précédente remise à tous : sinon, écarts cumulés
+        {
+            size_t len = build_frame(last, last_w, atomic_exchange(&full_pending, false));
+            if (len > 0)
+            {
+                httpd_ws_frame_t out = {
+                    .type = HTTPD_WS_TYPE_TEXT,
+                    .payload = (uint8_t *)frame,
+                    .len = len,
+                    .final = true,
+                };
+                atomic_store(&inflight, count);
+                for (int k = 0; k < count; k++)
+                {
+                    if (httpd_ws_send_data_async(ws_server, fds[k], &out, send_done, NULL) != ESP_OK)
+                    {
+                        atomic_fetch_sub(&inflight, 1); // File de travail du serveur pleine : client sauté
+                    }
+                }
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(WEBUI_STREAM_PERIOD_MS));
+    }
+}
+
+void webui_stream_register(httpd_handle_t server)
+{
+    ws_server = server;
+    for (int k = 0; k < WEBUI_STREAM_MAX_CLIENTS; k++) atomic_store(&clients[k], -1);
+    xTaskCreatePinnedToCore(task_stream, "webui_ws", 3072, NULL, WEBUI_STREAM_PRIORITY, &stream_task, CORE_NET);
+
+    const httpd_uri_t ws = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true,
+    };
+    httpd_register_uri_handler(server, &ws);
+}
+
+#else
+
+void webui_stream_register(httpd_handle_t server)
+{
+    ESP_LOGW(TAG, "CONFIG_HTTPD_WS_SUPPORT désactivé : pas de suivi en direct");
+}
+
+#endif // CONFIG_HTTPD_WS_SUPPORT
@@ -0,0 +1,30 @@
+#ifndef WEBUI_STREAM_H
+#define WEBUI_STREAM_H
+
+/**
+ * @file webui_stream.h
+ * @brief Suivi en direct des compteurs par WebSocket (ws://<appareil>/ws).
+ *
+ * Toutes les WEBUI_STREAM_PERIOD_MS, une trame JSON regroupe les compteurs qui ont
+ * avancé (ou dont la puissance a changé) depuis la trame précédente :
+ *   {"t":<ms>,"c":[{"i":<n>,"v":<impulsions>,"d":<écart>,"w":<W>}, ...]}
+ * Une trame complète ("full":true, tous les compteurs) suit chaque nouvelle connexion.
+ *
+ * La trame est encodée une fois par période et envoyée à tous les clients. Tant qu'elle
+ * n'a pas été remise à tous, aucune nouvelle trame n'est construite : les écarts
+ * s'accumulent dans la suivante. Le comptage n'attend jamais le réseau : la tâche de
+ * diffusion ne fait que lire counter_store et power_meter.
+ *
+ * Nécessite CONFIG_HTTPD_WS_SUPPORT ; sans lui, la route n'est pas enregistrée.
+ */
+
+#include "esp_http_server.h"    // Pour httpd_handle_t
+
+/**
+ * @brief Enregistre la route /ws et crée la tâche de diffusion (endormie sans client).
+ *
+ * @param server Serveur démarré par webui_start()
+ */
+void webui_stream_register(httpd_handle_t server);
+
+#endif // WEBUI_STREAM_H
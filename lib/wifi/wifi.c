@@ -3,35 +3,209 @@
  * @brief Gestion Wi-Fi STA + Mode AP configuration avec serveur Web.
  *
  * Ce fichier gère la configuration et le fonctionnement du Wi-Fi sur l'ESP32 en mode station (STA) et point d'accès (AP).
- * Il inclut également un serveur web pour configurer les paramètres de connexion Wi-Fi, MQTT et compteurs.
+ * En mode AP, il démarre l'interface web (lib/webui) pour configurer les paramètres de connexion Wi-Fi, MQTT et compteurs.
  */
 
 #include "esp_wifi.h"   // API Wi-Fi
 #include "esp_event.h"  // Gestion des événements   
 #include "nvs_flash.h"      // NVS pour stockage des configs
 #include "freertos/event_groups.h"  // Groupes d'événements FreeRTOS
+#include "freertos/timers.h"  // Timer de reconnexion
+#include "esp_random.h"  // Jitter du backoff
 #include "config.h" // Configuration globale (SSID, pass, MQTT, etc.)
 #include "esp_log.h"    // Logging ESP-IDF
-#include "esp_http_server.h"    // Serveur HTTP pour la configuration
 #include "esp_system.h"   // Pour esp_restart()
 #include "esp_netif.h"  // Pour esp_netif_init() et esp_netif_create_default_wifi_sta()
+#include "esp_netif_sntp.h"  // Mise à l'heure (horodatage, intervalles d'énergie)
+#include "boot_timing.h"  // Chronométrage du démarrage
+#include "lowpower.h"    // Modem sleep entre les publications (LOW_POWER)
+#include "webui.h"      // Interface web et API JSON
 #include <string.h>   // Pour memset, memcpy, etc.
 #include <stdio.h>  // Pour snprintf
-#include <ctype.h>  // Pour isprint
-#include <stdlib.h>// Pour malloc, free
 
 static const char *TAG = "WIFI"; // Tag pour les logs
 
 static EventGroupHandle_t wifi_event_group; // Groupe d'événements pour la connexion Wi-Fi
-static httpd_handle_t server = NULL; // Handle du serveur HTTP
 
 /* ========================= WIFI STA ========================= */
 
+/*
+ * Gestionnaire de connexion asynchrone :
+ *  - wifi_init() démarre le Wi-Fi et rend la main immédiatement
+ *  - Après une déconnexion, la tentative suivante est différée (backoff exponentiel
+ *    de WIFI_BACKOFF_MIN_MS à WIFI_BACKOFF_MAX_MS, avec jitter) par un timer FreeRTOS :
+ *    la radio n'est plus sollicitée en boucle pendant une panne de l'AP
+ *  - Le BSSID et le canal du dernier AP sont mémorisés, en RAM et dans la NVS (clé "wifi/ap") :
+ *    les WIFI_FAST_RECONNECT_TRIES premières tentatives, y compris la toute première après
+ *    un redémarrage, visent directement cet AP, sans balayage de tous les canaux
+ *  - Une adresse IP statique optionnelle (wifi_ip) évite l'attente du DHCP
+ *
+ * Le timer de reconnexion tourne dans la tâche de service des timers FreeRTOS,
+ * pas dans la tâche esp_timer qui valide les impulsions : le comptage ne dépend
+ * pas de l'état de la radio.
+ */
+
+static TimerHandle_t retry_timer;        // Timer de la prochaine tentative de connexion
+static uint32_t retry_count = 0;         // Tentatives échouées depuis la dernière connexion
+static bool ap_cache_valid = false;      // Vrai si le BSSID / canal du dernier AP sont connus
+static uint8_t ap_cache_bssid[6];        // BSSID du dernier AP auquel la station s'est connectée
+static uint8_t ap_cache_channel;         // Canal du dernier AP
+
+/**
+ * @brief Dernier AP tel que mémorisé dans la NVS.
+ */
+typedef struct {
+    uint8_t bssid[6];                    ///< BSSID de l'AP
+    uint8_t channel;                     ///< Canal de l'AP
+} ap_cache_t;
+
+/**
+ * @brief Recharge depuis la NVS le dernier AP auquel la station s'est connectée.
+ */
+static void ap_cache_load(void)
+{
+    nvs_handle_t handle; // Handle pour accéder à la NVS du Wi-Fi
+    if (nvs_open("wifi", NVS_READONLY, &handle) != ESP_OK)
+    {
+        return;
+    }
+    ap_cache_t ap; // AP mémorisé
+    size_t len = sizeof(ap);
+    if (nvs_get_blob(handle, "ap", &ap, &len) == ESP_OK && len == sizeof(ap) &&
+        ap.channel >= 1 && ap.channel <= 14) // Enregistrement complet et canal valide
+    {
+        memcpy(ap_cache_bssid, ap.bssid, sizeof(ap_cache_bssid));
+        ap_cache_channel = ap.channel;
+        ap_cache_valid = true;
+        ESP_LOGI(TAG, "AP mémorisé : canal %u", ap_cache_channel);
+    }
+    nvs_close(handle);
+}
+
+/**
+ * @brief Mémorise dans la NVS le dernier AP, seulement s'il a changé (pas d'écriture flash à chaque connexion).
+ */
+static void ap_cache_store(const uint8_t bssid[6], uint8_t channel)
+{
+    if (ap_cache_valid && ap_cache_channel == channel &&
+        memcmp(ap_cache_bssid, bssid, sizeof(ap_cache_bssid)) == 0) // Même AP : rien à écrire
+    {
+        return;
+    }
+    memcpy(ap_cache_bssid, bssid, sizeof(ap_cache_bssid));
+    ap_cache_channel = channel;
+    ap_cache_valid = true;
+
+    ap_cache_t ap = { .channel = channel };
+    memcpy(ap.bssid, bssid, sizeof(ap.bssid));
+    nvs_handle_t handle; // Handle pour accéder à la NVS du Wi-Fi
+    if (nvs_open("wifi", NVS_READWRITE, &handle) == ESP_OK)
+    {
+        nvs_set_blob(handle, "ap", &ap, sizeof(ap));
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+}
+
+/**
+ * @brief Applique l'adresse IP statique configurée, si elle est valide.
+ *
+ * Le client DHCP est arrêté : l'événement IP_EVENT_STA_GOT_IP est émis dès l'association.
+ *
+ * @param netif Interface réseau de la station
+ * @return true si l'adresse statique est appliquée, false pour rester en DHCP
+ */
+static bool wifi_apply_static_ip(esp_netif_t *netif)
+{
+    if (wifi_ip[0] == '\0') // Pas d'adresse statique configurée : DHCP
+    {
+        return false;
+    }
+
+    esp_netif_ip_info_t info = {0}; // Adresse, masque et passerelle
+    if (esp_netif_str_to_ip4(wifi_ip, &info.ip) != ESP_OK ||
+        esp_netif_str_to_ip4(wifi_gw, &info.gw) != ESP_OK ||
+        esp_netif_str_to_ip4(wifi_mask[0] ? wifi_mask : "255.255.255.0", &info.netmask) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Adresse IP statique invalide, DHCP utilisé");
+        return false;
+    }
+
+    esp_netif_dhcpc_stop(netif); // Plus d'attente du bail DHCP
+    if (esp_netif_set_ip_info(netif, &info) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Adresse IP statique refusée, DHCP utilisé");
+        esp_netif_dhcpc_start(netif);
+        return false;
+    }
+
+    esp_netif_dns_info_t dns = {0}; // Serveur DNS (passerelle par défaut)
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    if (esp_netif_str_to_ip4(wifi_dns[0] ? wifi_dns : wifi_gw, &dns.ip.u_addr.ip4) == ESP_OK)
+    {
+        esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns);
+    }
+    ESP_LOGI(TAG, "Adresse IP statique %s", wifi_ip);
+    return true;
+}
+
+/**
+ * @brief Lance une tentative de connexion, ciblée sur le dernier AP si possible.
+ *
+ * Les WIFI_FAST_RECONNECT_TRIES premières tentatives après une déconnexion visent
+ * le BSSID et le canal mémorisés ; ensuite, balayage complet (l'AP a pu changer de canal
+ * ou un autre AP du même SSID peut prendre le relais).
+ */
+static void wifi_try_connect(void)
+{
+    wifi_config_t wifi_config; // Configuration station courante
+    esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+
+    bool fast = ap_cache_valid && retry_count < WIFI_FAST_RECONNECT_TRIES; // Connexion directe au dernier AP
+    wifi_config.sta.bssid_set = fast;
+    wifi_config.sta.channel = fast ? ap_cache_channel : 0; // 0 = tous les canaux
+    if (fast)
+    {
+        memcpy(wifi_config.sta.bssid, ap_cache_bssid, sizeof(ap_cache_bssid));
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+
+    ESP_LOGI(TAG, "Tentative de connexion %lu (%s)", (unsigned long)retry_count + 1,
+             fast ? "AP mémorisé" : "balayage");
+    esp_wifi_connect(); // Tente de se connecter au réseau Wi-Fi configuré
+}
+
+/**
+ * @brief Callback du timer de reconnexion (tâche de service des timers FreeRTOS).
+ */
+static void wifi_retry_callback(TimerHandle_t timer)
+{
+    wifi_try_connect();
+}
+
+/**
+ * @brief Délai avant la prochaine tentative : backoff exponentiel avec jitter.
+ *
+ * Le délai double à chaque échec, de WIFI_BACKOFF_MIN_MS à WIFI_BACKOFF_MAX_MS ;
+ * il est tiré uniformément entre la moitié et la totalité de cette valeur pour que
+ * des appareils coupés en même temps ne se reconnectent pas tous ensemble.
+ */
+static uint32_t wifi_backoff_ms(uint32_t attempt)
+{
+    uint32_t delay = WIFI_BACKOFF_MIN_MS;
+    for (uint32_t i = 1; i < attempt && delay < WIFI_BACKOFF_MAX_MS; i++) // Doublement par échec
+    {
+        delay *= 2;
+    }
+    if (delay > WIFI_BACKOFF_MAX_MS) delay = WIFI_BACKOFF_MAX_MS;
+    return delay / 2 + esp_random() % (delay / 2 + 1); // Jitter : [delay/2, delay]
+}
+
 /**
  * @brief Gère les événements Wi-Fi pour le mode station.
  *
  * Cette fonction est appelée automatiquement par l'ESP-IDF lorsqu'un événement Wi-Fi survient.
- * Elle gère la connexion au réseau, la déconnexion et la réception d'une adresse IP.
+ * Elle gère la connexion au réseau, la déconnexion (reconnexion différée) et la réception d'une adresse IP.
  *
  * @param arg Arguments utilisateur (non utilisés ici).
  * @param event_base Base de l'événement.
@@ -41,33 +215,65 @@ static httpd_handle_t server = NULL; // Handle du serveur HTTP
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) { // Lorsque le Wi-Fi démarre, tente de se connecter au réseau configuré
-        esp_wifi_connect(); // Tente de se connecter au réseau Wi-Fi configuré
+        wifi_try_connect(); // Première tentative immédiate
+    }
+    else if (event_base == WIFI_EVENT &&
+             event_id == WIFI_EVENT_STA_CONNECTED) { // Association réussie : mémorise l'AP pour les reconnexions
+        const wifi_event_sta_connected_t *ev = (const wifi_event_sta_connected_t *)event_data;
+        boot_timing_mark(BOOT_MARK_WIFI_ASSOC);
+        ap_cache_store(ev->bssid, ev->channel); // BSSID et canal de l'AP, en RAM et en NVS
     }
     else if (event_base == WIFI_EVENT && 
-             event_id == WIFI_EVENT_STA_DISCONNECTED) { // Lorsque la station est déconnectée, tente de se reconnecter
-        esp_wifi_connect(); // Tente de se reconnecter au réseau Wi-Fi configuré
+             event_id == WIFI_EVENT_STA_DISCONNECTED) { // Lorsque la station est déconnectée, programme une nouvelle tentative
+        const wifi_event_sta_disconnected_t *ev = (const wifi_event_sta_disconnected_t *)event_data;
+        xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT); // Plus de connexion
+        retry_count++;
+        uint32_t delay = wifi_backoff_ms(retry_count); // Délai avant la prochaine tentative
+        ESP_LOGW(TAG, "Wi-Fi déconnecté (raison %d), nouvelle tentative dans %lu ms",
+                 ev->reason, (unsigned long)delay);
+        xTimerChangePeriod(retry_timer, pdMS_TO_TICKS(delay), 0); // Arme le timer de reconnexion (sans attendre)
     }
     else if (event_base == IP_EVENT &&
              event_id == IP_EVENT_STA_GOT_IP) { // Lorsque la station obtient une adresse IP, signale que la connexion est établie
+        retry_count = 0; // Connexion rétablie : backoff réinitialisé
+        boot_timing_mark(BOOT_MARK_GOT_IP);
         xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT); // Signale que la connexion Wi-Fi est établie en définissant le bit WIFI_CONNECTED_BIT
+        ESP_LOGI(TAG, "Wi-Fi connecté avec succès !"); // Log de succès de la connexion Wi-Fi
     }
 }
 
 /**
- * @brief Initialise le client Wi-Fi en mode station et se connecte au réseau.
+ * @brief Initialise le client Wi-Fi en mode station et lance la connexion au réseau.
  *
  * Cette fonction configure le client Wi-Fi, enregistre les gestionnaires d'événements et démarre la connexion au réseau spécifié.
+ * Si un AP a été mémorisé lors d'une connexion précédente, la première tentative vise directement son canal et son BSSID ;
+ * si une adresse IP statique est configurée, le DHCP est court-circuité.
+ * Elle ne bloque pas : la connexion et les reconnexions se font en arrière-plan (voir wifi_is_connected()).
  */
 void wifi_init(void)
 {
     wifi_event_group = xEventGroupCreate(); // Crée un groupe d'événements pour gérer la connexion Wi-Fi
+    retry_timer = xTimerCreate("wifiRetry", pdMS_TO_TICKS(WIFI_BACKOFF_MIN_MS), pdFALSE, NULL, wifi_retry_callback); // Timer de reconnexion (un coup)
     ESP_LOGI(TAG, "Initialisation du Wi-Fi en mode station..."); // Log d'initialisation
     esp_netif_init(); // Initialise la pile réseau (obligatoire avant d'utiliser le Wi-Fi)
     esp_event_loop_create_default(); // Crée une boucle d'événements par défaut pour gérer les événements système
-    esp_netif_create_default_wifi_sta(); // Crée une interface réseau par défaut pour le mode station Wi-Fi
+    esp_netif_t *netif = esp_netif_create_default_wifi_sta(); // Crée une interface réseau par défaut pour le mode station Wi-Fi
+    if (wifi_apply_static_ip(netif)) // Adresse statique : pas d'attente du DHCP
+    {
+        boot_timing_set_flag(BOOT_FLAG_STATIC_IP);
+    }
+    esp_sntp_config_t sntp_cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG(SNTP_SERVER); // Synchronisation en arrière-plan dès l'obtention d'une adresse
+    esp_netif_sntp_init(&sntp_cfg);
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT(); // Utilise la configuration par défaut pour l'initialisation du Wi-Fi
     esp_wifi_init(&cfg); // Initialise le Wi-Fi avec la configuration spécifiée
+    esp_wifi_set_storage(WIFI_STORAGE_RAM); // La configuration est réappliquée à chaque démarrage : pas d'écriture flash à chaque tentative
+
+    ap_cache_load(); // Dernier AP connu : première tentative sans balayage
+    if (ap_cache_valid)
+    {
+        boot_timing_set_flag(BOOT_FLAG_CACHED_AP);
+    }
 
     esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL); // Enregistre le gestionnaire d'événements pour les événements Wi-Fi
     esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL); //    Enregistre le gestionnaire d'événements pour les événements IP liés à l'obtention d'une adresse IP
@@ -76,440 +282,47 @@ void wifi_init(void)
     strncpy((char *)wifi_config.sta.ssid, wifi_ssid, sizeof(wifi_config.sta.ssid)); // Copie le SSID configuré dans la structure de configuration Wi-Fi
     strncpy((char *)wifi_config.sta.password, wifi_pass, sizeof(wifi_config.sta.password)); // Copie le mot de passe configuré dans la structure de configuration Wi-Fi
     wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK; // Définit le mode d'authentification minimum pour la connexion (WPA2-PSK)
+#if LOW_POWER
+    wifi_config.sta.listen_interval = WIFI_LISTEN_INTERVAL; // Modem sleep profond : réveil radio toutes les WIFI_LISTEN_INTERVAL balises
+#endif
     ESP_LOGI(TAG, "Configuration Wi-Fi : SSID=%s Pass=%s", wifi_ssid, wifi_pass); // Log de la configuration utilisée
 
     esp_wifi_set_mode(WIFI_MODE_STA); // Configure le Wi-Fi en mode station
     esp_wifi_set_config(WIFI_IF_STA, &wifi_config); // Applique la configuration Wi-Fi pour l'interface station
     ESP_LOGI(TAG, "Démarrage du Wi-Fi..."); // Log de démarrage du Wi-Fi
     esp_wifi_start(); // Démarre le Wi-Fi, ce qui déclenchera les événements de connexion
-    ESP_LOGI(TAG, "Attente de la connexion Wi-Fi..."); // Log d'attente de la connexion Wi-Fi
-
-    xEventGroupWaitBits(wifi_event_group, //   
-                        WIFI_CONNECTED_BIT, // Bit à attendre pour indiquer que la connexion Wi-Fi est établie
-                        pdFALSE, // Ne pas effacer les bits après les avoir reçus
-                        pdTRUE, // Attendre que tous les bits spécifiés soient définis (dans ce cas, il n'y en a qu'un)
-                        portMAX_DELAY); // Attendre indéfiniment jusqu'à ce que la connexion Wi-Fi soit établie
-    ESP_LOGI(TAG, "Wi-Fi connecté avec succès !"); // Log de succès de la connexion Wi-Fi
-}
-
-/* ========================= MODE AP ========================= */
- 
-/**
- * @brief Échappe les caractères spéciaux HTML dans une chaîne.
- *
- * Cette fonction remplace certains caractères spéciaux (&, <, >, ", ') par leurs équivalents HTML pour éviter des injections XSS.
- *
- * @param src Chaîne source à échapper.
- * @param dst Buffer de destination pour la chaîne échappée.
- * @param dst_size Taille du buffer de destination.
- */
-static void html_escape(const char *src, char *dst, size_t dst_size)
-{
-    size_t o = 0; // Index de sortie dans dst
-    for (size_t i = 0; src && src[i] != '\0' && o + 1 < dst_size; i++) { // Parcourt la chaîne source tant que le caractère n'est pas nul et que le buffer de destination n'est pas plein
-        const char *rep = NULL; // Pointeur pour la chaîne de remplacement si un caractère spécial est trouvé
-        switch ((unsigned char)src[i]) {
-            case '&': rep = "&amp;";  break;
-            case '<': rep = "&lt;";   break;
-            case '>': rep = "&gt;";   break;
-            case '"': rep = "&quot;"; break;
-            case '\'':rep = "&#39;";  break;
-            default:
-                dst[o++] = src[i];
-                continue;
-        } // Si un caractère spécial est trouvé, rep pointe vers la chaîne de remplacement correspondante
-        size_t rlen = strlen(rep); // Longueur de la chaîne de remplacement
-        if (o + rlen >= dst_size) break; // Si la chaîne de remplacement ne rentre pas dans le buffer de destination, arrêter l'échappement 
-        memcpy(dst + o, rep, rlen); // Copier la chaîne de remplacement dans le buffer de destination
-        o += rlen; // Avancer l'index de sortie de la longueur de la chaîne de remplacement
-    }
-    dst[o] = '\0'; // Terminer la chaîne de destination par un caractère nul
+    lowpower_wifi_started(); // Modem sleep profond entre les publications (LOW_POWER)
+    boot_timing_mark(BOOT_MARK_WIFI_START);
 }
 
 /**
- * @brief Génère une réponse HTML pour afficher les paramètres actuels.
- *
- * Cette fonction génère une page web contenant les paramètres de connexion Wi-Fi, MQTT et compteurs actuels.
- *
- * @param req Pointeur vers la requête HTTP.
+ * @brief Indique si la station est connectée et a une adresse IP.
  */
-static esp_err_t config_get_handler(httpd_req_t *req)
+bool wifi_is_connected(void)
 {
-    httpd_resp_set_type(req, "text/html; charset=UTF-8"); // Définit le type de contenu de la réponse HTTP à HTML avec encodage UTF-8
-    httpd_resp_set_hdr(req, "Cache-Control", "no-store"); // Ajoute un en-tête pour empêcher la mise en cache de la page de configuration
-
-    // Buffers échappés (tailles confortables)
-    char esc_ssid[128], esc_pass[128]; // Buffers pour les valeurs échappées à afficher dans le formulaire HTML (tailles adaptées aux champs de configuration)
-    char esc_mqserv[256], esc_mquser[128], esc_mqpass[128],esc_mqport[128]; // Buffers pour les valeurs MQTT échappées (tailles adaptées aux champs de configuration MQTT)
-    char esc_name[128]; // Buffer pour les noms de compteurs échappés (taille adaptée à la configuration des noms de compteurs)
-
-    html_escape(wifi_ssid,   esc_ssid,  sizeof esc_ssid); // Échappe les caractères spéciaux dans le SSID pour l'affichage HTML
-    html_escape(wifi_pass,   esc_pass,  sizeof esc_pass); // Échappe les caractères spéciaux dans le mot de passe Wi-Fi pour l'affichage HTML
-    html_escape(mqtt_Server, esc_mqserv,sizeof esc_mqserv); //  Échappe les caractères spéciaux dans le serveur MQTT pour l'affichage HTML
-    html_escape(mqtt_user,   esc_mquser,sizeof esc_mquser); //  Échappe les caractères spéciaux dans le nom d'utilisateur MQTT pour l'affichage HTML
-    html_escape(mqtt_pass,   esc_mqpass,sizeof esc_mqpass); //  Échappe les caractères spéciaux dans le mot de passe MQTT pour l'affichage HTML
-    html_escape(mqtt_port,   esc_mqport,sizeof esc_mqport); //  Échappe les caractères spéciaux dans le port MQTT pour l'affichage HTML
-
-    // Macro pour checker les envois    
-    #define SEND(S) do {                              \
-        esp_err_t __e = httpd_resp_sendstr_chunk(req, (S)); \
-        if (__e != ESP_OK) {                          \
-            ESP_LOGE("HTTP", "send failed (%d) at [%s]", __e, (S)); \
-            httpd_resp_sendstr_chunk(req, NULL);      \
-            return __e;                               \
-        }                                             \
-    } while(0)
-
-    // Buffer pour composer les lignes (jamais vide)
-    char line[512];
-
-    // --- Envoi du header/page ---
-    SEND("<!DOCTYPE html>"
-         "<html><head>"
-         "<meta charset=\"UTF-8\">"
-         "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-         "<title>ESP32 Configuration</title>"
-         "<style>"
-         "body{font-family:sans-serif;margin:16px;max-width:860px}"
-         "label{display:block;margin-top:10px}"
-         "input{width:100%;max-width:520px;padding:6px;margin:4px 0}"
-         "h2{margin-bottom:6px} h3{margin-top:18px}"
-         "button{padding:8px 14px;margin-top:12px}"
-         "</style>"
-         "</head><body>"
-         "<h2>Configuration ESP32</h2>"
-         "<form method=\"POST\" action=\"/save\">"
-
-         "<h3>Wi‑Fi</h3>"
-         "<label>SSID</label>"
-    );
-
-    // SSID
-    snprintf(line, sizeof line,
-             "<input type=\"text\" name=\"ssid\" value=\"%s\"><br><br>",
-             esc_ssid);
-    SEND(line);
-
-    // Pass Wi-Fi
-    SEND("<label>Mot de passe</label>");
-    snprintf(line, sizeof line,
-             "<input type=\"text\" name=\"pass\" value=\"%s\"><br><br>",
-             esc_pass);
-    SEND(line);
-
-    // --- MQTT --- 
-    SEND("<h3>MQTT</h3>"
-         "<label>Serveur MQTT</label>");
-    snprintf(line, sizeof line,
-        "<input type=\"text\" name=\"mqtt_server\" "
-        "placeholder=\"mqtt://192.168.1.1\" value=\"%s\">:",
-         esc_mqserv);
-    SEND(line);
-    snprintf(line, sizeof line,
-        "<input type=\"text\" name=\"mqtt_port\" "
-        "placeholder=\"1883\" value=\"%s\"><br><br>",
-         esc_mqport);
-    SEND(line);
-
-    SEND("<label>Utilisateur MQTT</label>");
-    snprintf(line, sizeof line,
-             "<input type=\"text\" name=\"mqtt_user\" value=\"%s\"><br><br>",
-             esc_mquser);
-    SEND(line);
-
-    SEND("<label>Mot de passe MQTT</label>");
-    snprintf(line, sizeof line,
-             "<input type=\"text\" name=\"mqtt_pass\" value=\"%s\"><br><br>",
-             esc_mqpass);
-    SEND(line);
-
-    // --- Compteurs ---
-    SEND("<h3>Compteurs</h3>");
-    for (int i = 0; i < NB_COUNTERS; i++) {
-        html_escape(mqtt_names[i], esc_name, sizeof esc_name);
-        snprintf(line, sizeof line,
-                 "Compteur %d:<br>"
-                 "<input type=\"number\" name=\"c%d\" value=\"%lu\"><br>"
-                 "Nom:<br>"
-                 "<input type=\"text\" name=\"m%d\" value=\"%s\"><br><br>",
-                 i + 1,
-                 i, (unsigned long)counters[i],
-                 i, esc_name);
-        SEND(line);
-    }
-
-    // Bouton + fin
-    SEND("<button type=\"submit\">Enregistrer</button>"
-         "</form></body></html>");
-
-    // Fin de la réponse chunked
-    httpd_resp_sendstr_chunk(req, NULL);
-    return ESP_OK;
-
-    #undef SEND
+    return wifi_event_group != NULL &&
+           (xEventGroupGetBits(wifi_event_group) & WIFI_CONNECTED_BIT) != 0;
 }
 
 /**
- * @brief Décode une chaîne URL-encoded.
- *
- * Cette fonction décode une chaîne encodée en URL (ex: %20 devient espace).
- *
- * @param src Chaîne source à décoder.
- * @param dst Buffer de destination pour la chaîne décodée.
- * @param dst_size Taille du buffer de destination.
+ * @brief Oublie le dernier AP mémorisé : le prochain démarrage refait un balayage complet.
  */
-static void url_decode(const char *src, char *dst, size_t dst_size)
+void wifi_forget_ap(void)
 {
-    size_t si = 0, di = 0; // Index de lecture dans src et d'écriture dans dst
-    if (!src || !dst || dst_size == 0) return; // Vérifie les pointeurs et la taille du buffer de destination
-
-    while (src[si] != '\0' && di + 1 < dst_size) // Parcourt la chaîne source tant que le caractère n'est pas nul et que le buffer de destination n'est pas plein
+    nvs_handle_t handle; // Handle pour accéder à la NVS du Wi-Fi
+    esp_err_t err = nvs_open("wifi", NVS_READWRITE, &handle);
+    if (err != ESP_OK)
     {
-        if (src[si] == '%' &&
-            src[si+1] && src[si+2] &&
-            isxdigit((unsigned char)src[si+1]) &&
-            isxdigit((unsigned char)src[si+2])) // Si on trouve un '%' suivi de deux caractères hexadécimaux, on les décode
-        {
-            char hex[3] = { src[si+1], src[si+2], 0 }; // Extrait les deux caractères hexadécimaux suivants
-            dst[di++] = (char) strtol(hex, NULL, 16); // Convertit les caractères hexadécimaux en un caractère ASCII et l'ajoute à la destination
-            si += 3; // Avance l'index de lecture de 3 caractères (le '%' et les deux hexadécimaux)
-        }
-        else if (src[si] == '+') // Les '+' dans les données encodées en URL représentent des espaces, on les convertit en espace
-        {
-            dst[di++] = ' '; // Remplace le '+' par un espace dans la destination
-            si++; // Avance l'index de lecture d'un caractère
-        }
-        else // Sinon, on copie le caractère tel quel
-        {
-            dst[di++] = src[si++]; // Copie le caractère actuel de la source vers la destination et avance les index de lecture et d'écriture
-        }
+        ESP_LOGE(TAG, "Failed to open NVS wifi: %s", esp_err_to_name(err));
+        return;
     }
-    dst[di] = '\0'; // Termine la chaîne de destination par un caractère nul
+    nvs_erase_key(handle, "ap");
+    nvs_commit(handle);
+    nvs_close(handle);
+    ap_cache_valid = false;
 }
 
-/**
- * @brief Enregistre les paramètres configurés via le serveur web dans NVS.
- *
- * Cette fonction lit les données POST envoyées par le client via le serveur web et enregistre les paramètres de connexion Wi-Fi,
- * MQTT et compteurs dans la non-volatile storage (NVS).
- */
-static esp_err_t save_post_handler(httpd_req_t *req)
-{
-    char buf[512]; // Buffer pour recevoir les données POST (taille adaptée à la configuration attendue)
-    int total_len = req->content_len; // Longueur totale des données POST à recevoir
-    int received = 0; // Nombre de bytes reçus jusqu'à présent
-    int ret; // Variable pour stocker le résultat de la fonction de réception
- 
-    if (total_len >= (int)sizeof(buf))  // Si les données POST sont plus grandes que le buffer, on renvoie une erreur
-    {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Payload too large");
-        return ESP_FAIL;
-    }
-
-    while (received < total_len)  // Tant que nous n'avons pas reçu toutes les données POST, continuer à les recevoir
-    {
-        ret = httpd_req_recv(req, buf + received, total_len - received); // Reçoit une partie des données POST et les stocke dans le buffer à la position appropriée
-        if (ret <= 0)  // Si une erreur se produit lors de la réception, ou si le client a fermé la connexion, on arrête la réception
-        {
-            return ESP_FAIL;// Arrête la réception en cas d'erreur ou de fermeture de la connexion par le client
-        }
-        received += ret; // Met à jour le nombre de bytes reçus avec le nombre de bytes reçus dans cette itération
-    }
-
-    buf[received] = '\0'; // Termine la chaîne reçue par un caractère nul pour pouvoir la traiter comme une chaîne C    
-    ESP_LOGI("SAVE", "POST RAW: %s", buf); // Log de la charge utile brute reçue pour le débogage
-
-    // -------- PARSING ROBUSTE --------
-    // IMPORTANT: séparer sur "&" (et non sur "&amp;")
-    char *saveptr = NULL; // Pointeur de sauvegarde pour strtok_r, permettant de continuer à parcourir la chaîne après chaque token
-    char *token = strtok_r(buf, "&", &saveptr); // Sépare la chaîne reçue en tokens basés sur le caractère '&', qui sépare les paires clé-valeur dans les données POST encodées en URL
-
-    while (token != NULL)// Tant qu'il y a des tokens à traiter, continuer à les analyser
-    {
-        char *eq = strchr(token, '='); // Cherche le caractère '=' dans le token pour séparer la clé de la valeur
-        if (eq) // Si un '=' est trouvé, cela signifie que le token est une paire clé-valeur valide
-        {
-            *eq = '\0'; // Remplace le '=' par un caractère nul pour séparer la clé et la valeur dans le token
-            char *key   = token; // La clé est la partie du token avant le '='
-            char *value = eq + 1; // La valeur est la partie du token après le '='
-
-            // Décoder la valeur encodée en x-www-form-urlencoded
-            char decoded[256]; // Buffer pour la valeur décodée (taille adaptée à la configuration attendue)
-            url_decode(value, decoded, sizeof(decoded)); // Décode la valeur encodée en URL pour obtenir la valeur originale
-
-            // ---- Compteurs ----
-            for (int i = 0; i < NB_COUNTERS; i++) // Vérifie si la clé correspond à un compteur (ex: c0, c1, etc.)
-            {
-                char expected[8]; // Buffer pour la clé attendue (ex: "c0", "c1", etc.)
-                snprintf(expected, sizeof(expected), "c%d", i); // Formate la clé attendue pour le compteur i
-
-                if (strcmp(key, expected) == 0) //  Si la clé correspond à celle du compteur i, on met à jour la valeur du compteur
-                {
-                    if (decoded[0] == '\0')  // Si la valeur décodée est une chaîne vide, on considère que le compteur doit être réinitialisé à zéro
-                    {
-                        counters[i] = 0; // Réinitialise le compteur i à zéro si la valeur décodée est vide
-                    } else {
-                        counters[i] = strtoul(decoded, NULL, 10); // Sinon, convertit la valeur décodée en un nombre entier non signé et l'assigne au compteur i
-                    }
-                    ESP_LOGI("SAVE", "Counter %d = %lu", i, (unsigned long)counters[i]); // Log de la nouvelle valeur du compteur i pour le débogage
-                }
-            }
-
-            // ---- Noms MQTT ----
-            for (int i = 0; i < NB_COUNTERS; i++) // Vérifie si la clé correspond à un nom de compteur MQTT (ex: m0, m1, etc.)
-            {
-                char expected[8]; // Buffer pour la clé attendue (ex: "m0", "m1", etc.)
-                snprintf(expected, sizeof(expected), "m%d", i); // Formate la clé attendue pour le nom du compteur i
-
-                if (strcmp(key, expected) == 0) // Si la clé correspond à celle du nom du compteur i, on met à jour le nom du compteur
-                {
-                    strncpy(mqtt_names[i], decoded, sizeof(mqtt_names[i]) - 1); // Copie la valeur décodée dans le tableau des noms MQTT pour le
-                    mqtt_names[i][sizeof(mqtt_names[i]) - 1] = '\0'; // Assure que la chaîne est terminée par un caractère nul pour éviter les débordements de tampon
-                    ESP_LOGI("SAVE", "MQTT name %d = %s", i, mqtt_names[i]); // Log du nouveau nom MQTT du compteur i pour le débogage
-                }
-            }
-
-            // ---- WiFi ----
-            if (strcmp(key, "ssid") == 0) // Si la clé est "ssid", on met à jour le SSID Wi-Fi
-            {
-                strncpy(wifi_ssid, decoded, sizeof(wifi_ssid) - 1); // Copie la valeur décodée dans la variable wifi_ssid pour le SSID Wi-Fi
-                wifi_ssid[sizeof(wifi_ssid) - 1] = '\0'; // Assure que la chaîne est terminée par un caractère nul pour éviter les débordements de tampon
-                ESP_LOGI("SAVE", "SSID = %s", wifi_ssid); // Log du nouveau SSID Wi-Fi pour le débogage
-            }
-            else if (strcmp(key, "pass") == 0) // Si la clé est "pass", on met à jour le mot de passe Wi-Fi
-            {
-                strncpy(wifi_pass, decoded, sizeof(wifi_pass) - 1); // Copie la valeur décodée dans la variable wifi_pass pour le mot
-                wifi_pass[sizeof(wifi_pass) - 1] = '\0'; // Assure que la chaîne est terminée par un caractère nul pour éviter les débordements de tampon
-                ESP_LOGI("SAVE", "PASS updated (len=%u)", (unsigned)strlen(wifi_pass)); // Log de la mise à jour du mot de passe Wi-Fi (affiche la longueur pour éviter d'afficher le mot de passe en clair dans les logs)
-            }
-            // ---- MQTT Server ----
-            else if (strcmp(key, "mqtt_server") == 0) // Si la clé est "mqtt_server", on met à jour le serveur MQTT
-            {
-                strncpy(mqtt_Server, decoded, sizeof(mqtt_Server) - 1); // Copie la valeur décodée dans la variable mqtt_Server pour le serveur MQTT
-                mqtt_Server[sizeof(mqtt_Server) - 1] = '\0'; // Assure que la chaîne est terminée par un caractère nul pour éviter les débordements de tampon
-                ESP_LOGI("SAVE", "MQTT_SERVER = %s", mqtt_Server); // Log du nouveau serveur MQTT pour le débogage
-            }
-            // ---- MQTT User ----
-            else if (strcmp(key, "mqtt_user") == 0) // Si la clé est "mqtt_user", on met à jour le nom d'utilisateur MQTT
-            {
-                strncpy(mqtt_user, decoded, sizeof(mqtt_user) - 1); // Copie la valeur décodée dans la variable mqtt_user pour le nom d'utilisateur MQTT
-                mqtt_user[sizeof(mqtt_user) - 1] = '\0'; // Assure que la chaîne est terminée par un caractère nul pour éviter les débordements de tampon
-                ESP_LOGI("SAVE", "MQTT_USER = %s", mqtt_user); // Log du nouveau nom d'utilisateur MQTT pour le débogage
-            }
-            // ---- MQTT Password ----
-            else if (strcmp(key, "mqtt_pass") == 0) // Si la clé est "mqtt_pass", on met à jour le mot de passe MQTT
-            {
-                strncpy(mqtt_pass, decoded, sizeof(mqtt_pass) - 1); //  Copie la valeur décodée dans la variable mqtt_pass pour le mot
-                mqtt_pass[sizeof(mqtt_pass) - 1] = '\0'; // Assure que la chaîne est terminée par un caractère nul pour éviter les débordements de tampon
-                ESP_LOGI("SAVE", "MQTT_PASS updated (len=%u)", (unsigned)strlen(mqtt_pass)); // Log de la mise à jour du mot de passe MQTT (affiche la longueur pour éviter d'afficher le mot de passe en clair dans les logs)  
-            }
-            // ---- MQTT Port ----
-            else if (strcmp(key, "mqtt_port") == 0) // Si la clé est "mqtt_port", on met à jour le port MQTT
-            {
-                strncpy(mqtt_port, decoded, sizeof(mqtt_port) - 1); // Copie la valeur décodée dans la variable mqtt_port pour le port MQTT
-                mqtt_port[sizeof(mqtt_port) - 1] = '\0'; // Assure que la chaîne est terminée par un caractère nul pour éviter les débordements de tampon
-                ESP_LOGI("SAVE", "MQTT_PORT updated (len=%u)", (unsigned)strlen(mqtt_port)); // Log de la mise à jour du port MQTT (affiche la longueur pour éviter d'afficher le port en clair dans les logs)
-            }
-        }
-
-        token = strtok_r(NULL, "&", &saveptr);// Récupère le token suivant pour continuer à analyser les paires clé-valeur dans les données POST
-    }
-
-    // -------- SAUVEGARDE NVS --------
-    nvs_handle_t handle; // Handle pour accéder à la NVS
-    esp_err_t err; // Variable pour stocker le résultat des opérations NVS
-
-    // --- Compteurs + noms ---
-    err = nvs_open("counters", NVS_READWRITE, &handle); // Ouvre un espace de noms "counters" en mode lecture-écriture pour stocker les compteurs et leurs noms
-    if (err == ESP_OK) // Si l'ouverture de l'espace de noms "counters" est réussie, on enregistre les compteurs et leurs noms dans la NVS
-    {
-        for (int i = 0; i < NB_COUNTERS; i++) // Pour chaque compteur, on enregistre sa valeur et son nom dans la NVS
-        {
-            char key[8]; // Buffer pour la clé à utiliser dans la NVS (ex: "c0", "m0", etc.)
-
-            snprintf(key, sizeof(key), "c%d", i);// Formate la clé pour le compteur i (ex: "c0", "c1", etc.)
-            nvs_set_u32(handle, key, counters[i]); // Enregistre la valeur du compteur i dans la NVS avec la clé correspondante
-
-            snprintf(key, sizeof(key), "m%d", i); // Formate la clé pour le nom du compteur i (ex: "m0", "m1", etc.)
-            nvs_set_str(handle, key, mqtt_names[i]); // Enregistre le nom du compteur i dans la NVS avec la clé correspondante
-        }
-
-        nvs_commit(handle);//   Valide les modifications apportées à la NVS pour s'assurer qu'elles sont écrites de manière persistante
-        nvs_close(handle); // Ferme le handle de la NVS pour libérer les ressources associées
-    }
-    else // Si l'ouverture de l'espace de noms "counters" échoue, on log une erreur
-    {
-        ESP_LOGE("SAVE", "Failed to open NVS counters: %s", esp_err_to_name(err)); // Log de l'erreur d'ouverture de la NVS pour les compteurs, en affichant le message d'erreur correspondant à l'erreur retournée par nvs_open
-    }
-
-    // --- WiFi --- 
-    err = nvs_open("wifi", NVS_READWRITE, &handle); // Ouvre un espace de noms "wifi" en mode lecture-écriture pour stocker les paramètres de connexion Wi-Fi
-    if (err == ESP_OK) // Si l'ouverture de l'espace de noms "wifi" est réussie, on enregistre les paramètres de connexion Wi-Fi dans la NVS
-    {
-        nvs_set_str(handle, "ssid", wifi_ssid); // Enregistre le SSID Wi-Fi dans la NVS avec la clé "ssid"
-        nvs_set_str(handle, "pass", wifi_pass); // Enregistre le mot de passe Wi-Fi dans la NVS avec la clé "pass"
-        nvs_commit(handle); // Valide les modifications apportées à la NVS pour s'assurer qu'elles sont écrites de manière persistante
-        nvs_close(handle); // Ferme le handle de la NVS pour libérer les ressources associées
-    }
-    else // Si l'ouverture de l'espace de noms "wifi" échoue, on log une erreur
-    {
-        ESP_LOGE("SAVE", "Failed to open NVS wifi: %s", esp_err_to_name(err)); // Log de l'erreur d'ouverture de la NVS pour le Wi-Fi, en affichant le message d'erreur correspondant à l'erreur retournée par nvs_open
-    }
-
-    // --- MQTT ---
-    err = nvs_open("mqtt", NVS_READWRITE, &handle); // Ouvre un espace de noms "mqtt" en mode lecture-écriture pour stocker les paramètres de connexion MQTT
-    if (err == ESP_OK) // Si l'ouverture de l'espace de noms "mqtt" est réussie, on enregistre les paramètres de connexion MQTT dans la NVS
-    {
-        nvs_set_str(handle, "mqtt_server", mqtt_Server); // Enregistre le serveur MQTT dans la NVS avec la clé "mqtt_server"
-        nvs_set_str(handle, "mqtt_user",   mqtt_user); // Enregistre le nom d'utilisateur MQTT dans la NVS avec la clé "mqtt_user"
-        nvs_set_str(handle, "mqtt_pass",   mqtt_pass); // Enregistre le mot de passe MQTT dans la NVS avec la clé "mqtt_pass"
-        nvs_set_str(handle, "mqtt_port",   mqtt_port); // Enregistre le port MQTT dans la NVS avec la clé "mqtt_port"
-        nvs_commit(handle); // Valide les modifications apportées à la NVS pour s'assurer qu'elles sont écrites de manière persistante
-        nvs_close(handle); // Ferme le handle de la NVS pour libérer les ressources associées
-    }
-    else // Si l'ouverture de l'espace de noms "mqtt" échoue, on log une erreur
-    {
-        ESP_LOGE("SAVE", "Failed to open NVS mqtt: %s", esp_err_to_name(err)); // Log de l'erreur d'ouverture de la NVS pour le MQTT, en affichant le message d'erreur correspondant à l'erreur retournée par nvs_open
-    }
-
-
-    // --- Réponse au client ---
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_sendstr(req,
-        "<html><body><h2>Configuration saved, Please reboot the device</h2>"
-        "<p>Rebooting...</p></body></html>");
-
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Attendre un moment pour que le client puisse recevoir la réponse
-
-    return ESP_OK; // Retourne ESP_OK pour indiquer que la requête a été traitée avec succès
-}
-
-/**
- * @brief Démarre le serveur web pour la configuration.
- *
- * Cette fonction initialise et démarre un serveur web qui permet de configurer les paramètres de connexion Wi-Fi, MQTT et compteurs via une interface Web.
- */
-static void start_webserver(void)
-{
-    httpd_config_t config = HTTPD_DEFAULT_CONFIG(); // Utilise la configuration par défaut pour le serveur HTTP
-    httpd_start(&server, &config); // Démarre le serveur HTTP avec la configuration spécifiée et stocke le handle du serveur dans la variable server
-
-    httpd_uri_t root = {
-        .uri = "/",
-        .method = HTTP_GET,
-        .handler = config_get_handler
-    }; // Structure pour définir le gestionnaire de la route racine ("/") qui répond aux requêtes GET en appelant la fonction config_get_handler
-
-    httpd_register_uri_handler(server, &root); // Enregistre le gestionnaire de la route racine ("/") auprès du serveur HTTP pour qu'il puisse traiter les requêtes GET à cette route
-
-     httpd_uri_t save = {
-        .uri = "/save",
-        .method = HTTP_POST,
-        .handler = save_post_handler,
-        .user_ctx = NULL
-    }; // Structure pour définir le gestionnaire de la route "/save" qui répond aux requêtes POST en appelant la fonction save_post_handler
-    httpd_register_uri_handler(server, &save); // Enregistre le gestionnaire de la route "/save" auprès du serveur HTTP pour qu'il puisse traiter les requêtes POST à cette route
-}
+/* ========================= MODE AP ========================= */
 
 /**
  * @brief Démarre le mode AP (point d'accès) pour la configuration.
@@ -545,5 +358,5 @@ void start_config_ap(void)
     vTaskDelay(pdMS_TO_TICKS(1500)); // Attendre un moment pour que le point d'accès soit opérationnel
     ESP_LOGI(TAG, "AP Started. SSID: %s (open)", AP_SSID); // Log de succès du démarrage du point d'accès, affichant le SSID utilisé pour la configuration
 
-    start_webserver(); // Lance le serveur web de configuration
+    webui_start(true); // Lance le serveur web de configuration (API en écriture)
 }
@@ -13,16 +13,34 @@
  *    Cette fonction :
  *      - Initialise la pile réseau et la NVS si nécessaire
  *      - Configure le Wi-Fi avec SSID et mot de passe
- *      - Attend la connexion avant de retourner
+ *      - Lance la connexion en arrière-plan et retourne immédiatement
+ * 2. Interroger wifi_is_connected() si nécessaire ; les reconnexions sont automatiques
+ *    (backoff exponentiel avec jitter, reconnexion directe au dernier AP connu).
  */
 
+#include <stdbool.h> // Pour bool
+
 /**
- * @brief Initialise le Wi-Fi en mode station et attend la connexion.
+ * @brief Initialise le Wi-Fi en mode station et lance la connexion.
  *
- * Configure le SSID et le mot de passe définis dans config.h
- * Bloque jusqu'à ce que l'ESP32 obtienne une adresse IP valide.
+ * Configure le SSID et le mot de passe chargés depuis la NVS.
+ * Ne bloque pas : la connexion, puis les reconnexions après une coupure,
+ * sont gérées par les événements Wi-Fi et un timer de backoff.
  */
 void wifi_init(void);
+
+/**
+ * @brief Indique si la station est connectée et a obtenu une adresse IP.
+ *
+ * @return true si la liaison Wi-Fi est opérationnelle
+ */
+bool wifi_is_connected(void);
+
+/**
+ * @brief Oublie le dernier AP mémorisé (BSSID et canal) après un changement de réseau.
+ */
+void wifi_forget_ap(void);
+
 /**
  * @brief Démarre le mode AP (point d'accès) pour la configuration.
  *
@@ -2,7 +2,7 @@
  * @file main.c
  * @brief Programme principal pour ESP32 :
  *        - Tâche de comptage d'impulsions avec anti-rebond et sauvegarde NVS
- *        - Tâche Wi-Fi + MQTT pour publication périodique des compteurs
+ *        - Tâche Wi-Fi + MQTT pour publication des compteurs (seuils, intervalles, bande morte)
  *        - Initialisation des périphériques et des modules
  */
 
@@ -14,49 +14,73 @@
 #include "esp_timer.h"              // Pour obtenir le temps en microsecondes
 #include "nvs_flash.h"              // Pour initialiser la NVS (stockage persistant)
 #include "nvs.h"                    // Pour lire/écrire des valeurs dans la NVS
-#include "esp_task_wdt.h"           // Pour le Task Watchdog (WDT)
+#include "watchdog.h"               // Battements des tâches critiques et Task Watchdog (WDT)
 #include "wifi.h"                   // Module Wi-Fi personnalisé (wifi_init, etc.)
 #include "mqtt.h"                   // Module MQTT personnalisé (mqtt_init, mqtt_publish)
 #include "gpio_pulse.h"             // Module de comptage d'impulsions et ISR
 #include "storage.h"                // Module de stockage NVS pour les compteurs
-#include "config.h"                 // Inclusion du header global de configuration (ex : DEBOUNCE_US, NB_COUNTERS)
+#include "counter_store.h"          // Stockage sans verrou des compteurs (incrément atomique, lecture par seqlock)
+#include "publish_sched.h"          // Ordonnanceur de publication piloté par notifications
+#include "outbox.h"                 // File d'attente hors ligne des relevés
+#include "boot_timing.h"            // Chronométrage du démarrage
+#include "power_meter.h"            // Buffers de puissance des compteurs
+#include "lowpower.h"               // Light sleep automatique et modem sleep (LOW_POWER)
+#include "selftest.h"               // Banc de débit du comptage sur cible (PULSE_SELFTEST)
+#include "webui.h"                  // Interface web et API JSON (lecture seule en mode normal)
+#include "powerfail.h"              // Sauvegarde d'urgence sur coupure d'alimentation (POWER_FAIL)
+#include "diag.h"                   // Diagnostic périodique : pile, CPU et mémoire (DIAG_PERIOD_S)
+#include "history.h"                // Intervalles d'énergie de 1 min, 15 min et 1 h (HISTORY_ENABLE)
+#include "ota.h"                    // Mise à jour à distance et retour à l'image précédente (OTA_ENABLE)
+#include "config.h"                 // Inclusion du header global de configuration (ex : MAX_CHANNELS, channel_count)
 
 #include "esp_log.h"           // Pour les fonctions de logging ESP_LOGI, ESP_LOGE, etc.
 
 static const char *TAG = "APP_MAIN"; // Tag utilisé pour les logs dans ce fichier
 
-//uint32_t counters[NB_COUNTERS] = {0};
-
-// Mutex pour protéger l'accès aux compteurs partagés
-SemaphoreHandle_t counter_mutex;  // Mutex global pour protéger l'accès aux compteurs partagés entre les tâches et les ISR
-
 // ----------------------------------------------------------------------
 // ------------------- Tâche de comptage des impulsions -----------------
 // ----------------------------------------------------------------------
 /**
- * @brief Tâche qui compte les impulsions sur chaque compteur,
- *        applique un anti-rebond, et sauvegarde toutes les 100 impulsions dans la NVS.
+ * @brief Tâche qui sauvegarde les compteurs dans le journal flash
+ *        dès qu'un compteur a cumulé COUNTER_SAVE_WH Wh depuis le dernier instantané.
+ *
+ * La tâche dort jusqu'à ce que le chemin de comptage la réveille (storage_request_save) ;
+ * sans demande, elle ne se réveille qu'à mi-période de son battement (un réveil toutes les
+ * 30 s, le CPU peut rester en light sleep avec LOW_POWER).
+ * Une sauvegarde écrit un instantané de tous les compteurs en un seul enregistrement, au plus
+ * une fois toutes les COUNTER_SAVE_MIN_S secondes : les demandes plus rapprochées sont regroupées.
+ * Les compteurs sont copiés via counter_store_snapshot() : aucun verrou n'est tenu
+ * pendant l'écriture flash, le comptage n'est donc jamais retardé par une sauvegarde.
  *
  * @param pv : argument passé à la tâche (non utilisé ici)
  */
 void task_counter(void *pv)
 {
-    //esp_task_wdt_add(NULL);                 // Ajoute cette tâche au WDT pour surveillance
-    uint32_t last_saved[NB_COUNTERS] = {0}; // Stocke la dernière valeur sauvegardée pour chaque compteur
+    int heartbeat = watchdog_register("task_counter", WDT_SAVER_PERIOD_MS); // Écriture du journal comprise dans la période
+    uint64_t values[MAX_CHANNELS];            // Copie cohérente des compteurs
+    int64_t last_save_us = -COUNTER_SAVE_MIN_S * 1000000LL; // Première demande servie sans attendre
+
+    storage_saver_init();                     // Cette tâche reçoit les demandes de sauvegarde
 
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(500));    // Délai 500 ms pour limiter la fréquence de vérification
-
-        xSemaphoreTake(counter_mutex, portMAX_DELAY); // Accès exclusif aux compteurs
-        for (int i = 0; i < NB_COUNTERS; i++) {
-            // Si 100 impulsions ou plus depuis la dernière sauvegarde
-            if ((counters[i] - last_saved[i]) >= 100) {
-                save_counter_to_nvs(i, counters[i]); // Sauvegarde dans la NVS
-                last_saved[i] = counters[i];         // Met à jour la dernière valeur sauvegardée
-            }
+        watchdog_beat(heartbeat);             // Signe de vie pour le superviseur
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WDT_SAVER_PERIOD_MS / 2)) == 0) // Attend une demande (plusieurs demandes rapprochées = une seule sauvegarde)
+        {
+            continue;                         // Aucune demande : battement seul
+        }
+
+        int64_t wait_ms = (last_save_us + COUNTER_SAVE_MIN_S * 1000000LL - esp_timer_get_time()) / 1000;
+        if (wait_ms > 0)                      // Instantané trop récent : les demandes suivantes rejoignent celle-ci
+        {
+            watchdog_beat(heartbeat);
+            vTaskDelay(pdMS_TO_TICKS(wait_ms));
+            ulTaskNotifyTake(pdTRUE, 0);      // Demandes reçues pendant l'attente : couvertes par cet instantané
         }
-        xSemaphoreGive(counter_mutex);        // Libère le mutex
-        //esp_task_wdt_reset();                 // Reset WDT pour indiquer que la tâche fonctionne
+
+        gpio_pulse_mark_saved();           // Seuils de sauvegarde de tous les compteurs remis à zéro
+        counter_store_snapshot(values);    // Copie des compteurs, sans verrou
+        storage_save_counters(values);     // Un seul enregistrement pour tous les compteurs
+        last_save_us = esp_timer_get_time();
     }
 }
 /**
@@ -98,37 +122,59 @@ global_mode_config = 0; // reset le flag pour ne pas relancer à chaque reboot
 // ----------------------------------------------------------------------
 /**
  * @brief Tâche qui initialise le Wi-Fi et MQTT,
- *        puis publie périodiquement les compteurs sur le broker MQTT.
+ *        puis publie les compteurs sur le broker MQTT quand l'ordonnanceur le demande.
+ *
+ * La tâche dort dans publish_sched_wait() : elle est réveillée par le chemin de comptage
+ * (nouvelles impulsions), par la connexion au broker ou par l'échéance d'un intervalle
+ * maximal de publication (règles par compteur dans publish_cfg).
+ * Ni le Wi-Fi ni le broker ne sont attendus au démarrage : tant que le broker est
+ * injoignable, les relevés sont mis en attente en flash (outbox)
+ * puis publiés sur energie/<DEVICE_NAME>/backlog à la reconnexion.
+ * La tâche est lancée avant la restauration des compteurs : l'association Wi-Fi et
+ * la session MQTT s'établissent pendant le parcours du journal par app_main.
  *
  * @param pv : argument passé à la tâche (non utilisé ici)
  */
 void task_mqtt(void *pv)
 {
-    wifi_init();  // Initialise le Wi-Fi et attend la connexion
-    ESP_LOGI(TAG, "Wi-Fi connecté, initialisation MQTT...");
-    mqtt_init();  // Initialise le client MQTT
-    ESP_LOGI(TAG, "MQTT initialisé, démarrage de la publication périodique...");
-    char payload[256];           // Buffer pour le message JSON
-
-    //esp_task_wdt_add(NULL);      // Ajoute cette tâche au WDT
+    int heartbeat = watchdog_register("task_mqtt", WDT_PUBLISH_PERIOD_MS); // Un blocage dans l'initialisation est détecté aussi
+    publish_sched_init(); // Cette tâche reçoit les notifications du chemin de comptage
+    wifi_init();  // Lance la connexion Wi-Fi en arrière-plan, sans attendre
+#if WEBUI_STA
+    webui_start(false); // Tableau de bord en lecture seule sur le réseau local
+#endif
+    mqtt_init();  // Initialise le client MQTT : il se connecte dès que le réseau est disponible
+    diag_start(); // Diagnostic publié sur energie/<DEVICE_NAME>/diag
+    ota_init();   // Validation d'une image tout juste installée (retour à la précédente sans broker)
+    storage_wait_counters(); // Les compteurs doivent être restaurés avant la première publication
+    watchdog_beat(heartbeat); // Parcours du journal par app_main terminé
+    outbox_init();        // File d'attente hors ligne, vidée à chaque connexion au broker
+    ESP_LOGI(TAG, "MQTT initialisé, démarrage de la publication...");
+    uint64_t values[MAX_CHANNELS]; // Copie cohérente des compteurs publiés
+    power_reading_t power[MAX_CHANNELS]; // Puissances calculées au moment de la publication
+    bool boot_reported = false; // Détail du démarrage publié
 
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(MQTT_PUBLISH_PERIOD_MS)); // Attente de 5 minutes
-
-        xSemaphoreTake(counter_mutex, portMAX_DELAY);     // Accès exclusif aux compteurs
-
+        watchdog_beat(heartbeat); // Signe de vie pour le superviseur
+        uint32_t mask = publish_sched_wait(values, power, WDT_PUBLISH_PERIOD_MS / 2); // Attend qu'au moins un compteur soit à publier
+        if (mask == 0) continue;  // Rien à publier : battement seul
 
-    // Prépare la payload JSON avec les valeurs actuelles
-        for (int i = 0; i < NB_COUNTERS; i++)  // Pour chaque compteur, publie sa valeur sur un topic dédié (ex: "energie/compteur1", "energie/compteur2", etc.)
+        if (mqtt_is_connected()) // Broker joignable : publication en direct
         {
-            char topic[64]; // Buffer pour le topic MQTT (ex: "energie/compteur1")
-            sprintf(topic, "energie/%s", mqtt_names[i]); // Formate le topic MQTT en utilisant le nom du compteur (ex: "energie/compteur1", "energie/compteur2", etc.)
-            snprintf(payload, sizeof(payload), 
-                "%lu",
-                counters[i]); // Formate la payload avec la valeur du compteur i (ex: "12345")
-            mqtt_publish(topic, payload); // Publie sur le topic MQTT
+            lowpower_publish_begin(); // Fenêtre de publication : CPU et radio réactifs
+            mqtt_publish_counters(values, power, mask); // Un message par compteur concerné ou un message groupé selon mqtt_batch_mode
+            if (!boot_reported) // Première publication : fin du chronométrage du démarrage
+            {
+                boot_timing_mark(BOOT_MARK_FIRST_PUBLISH);
+                mqtt_publish_boot_timing();
+                boot_reported = true;
+            }
+            lowpower_publish_end(); // Retour au modem sleep profond jusqu'à la prochaine publication
+        }
+        else // Broker ou Wi-Fi indisponible : relevé mis en attente en flash
+        {
+            outbox_push(values);
         }
-        xSemaphoreGive(counter_mutex);  // Libère le mutex
     }
 
 }
@@ -138,51 +184,38 @@ void task_mqtt(void *pv)
 // ----------------------------------------------------------------------
 /**
  * @brief Point d'entrée principal du programme.
- *        Initialise la NVS, les GPIO, crée le mutex et lance les tâches sur les cœurs ESP32.
+ *        Initialise la NVS, les GPIO et lance les tâches sur les cœurs ESP32.
  */
 void app_main(void)
 {
-    esp_log_level_set("*", ESP_LOG_INFO); // Définit le niveau de log global à INFO pour afficher les messages d'information et d'erreur, mais pas les messages de débogage détaillés
+    boot_timing_mark(BOOT_MARK_APP_MAIN);
+    esp_log_level_set("*", APP_LOG_LEVEL); // Niveau de log global du profil de compilation (INFO par défaut, WARN en production)
     ESP_LOGI(TAG, "Main_APP start"); // Log de démarrage de l'application principale
 
-    counter_mutex = xSemaphoreCreateMutex(); // Crée le mutex pour protéger les compteurs
     ESP_LOGI(TAG, "global_mode_config = %d", global_mode_config); // Log de la valeur du mode de configuration global pour vérifier son état au démarrage
-    nvs_init_and_load();                     // Initialise la NVS et charge les compteurs
-    ESP_LOGI(TAG, "NVS_Init Done"); // Log de fin d'initialisation de la NVS et de chargement des compteurs
+    nvs_init_and_load();                     // Initialise la NVS et charge les paramètres (quelques clés)
+    boot_timing_mark(BOOT_MARK_NVS);
+    power_meter_init();                      // Buffers de puissance des compteurs actifs (table chargée)
+    ESP_LOGI(TAG, "NVS_Init Done"); // Log de fin d'initialisation de la NVS et de chargement des paramètres
     ESP_LOGI(TAG, "global_mode_config = %d", global_mode_config); // Log de la valeur du mode de configuration global après le chargement de la NVS pour vérifier si elle a été correctement chargée
 
-    gpio_init_pulses();                      // Configure les GPIO pour les impulsions
-    ESP_LOGI(TAG, "GPIO_Init Done"); // Log de fin d'initialisation des GPIO pour les impulsions
+    if (xPortGetCoreID() != CORE_PULSE) // Les interruptions allouées ici seraient servies par le cœur réseau
+    {
+        ESP_LOGW(TAG, "app_main sur le cœur %d : comptage hors de CORE_PULSE (CONFIG_ESP_MAIN_TASK_AFFINITY)", xPortGetCoreID());
+    }
 
-   // Crée la tâche de comptage sur le Core 1
-    xTaskCreatePinnedToCore(
-        task_counter,
-        "task_counter",
-        4096,
-        NULL,
-        10,
-        NULL,
-        1);               // Core 1
-    // Crée la tâche boot/config sur le Core 0  
-    xTaskCreatePinnedToCore(
-        task_boot_button,
-        "task_boot_button",
-        2048,
-        NULL,
-        4,
-        NULL,
-        0);
-    // Crée la tâche MQTT sur le Core 0
+    // Crée la tâche MQTT sur le cœur réseau en premier : le Wi-Fi s'associe pendant la restauration des compteurs
     if(global_mode_config == 0) {
         ESP_LOGI(TAG, "Mode normal : lancement tâche MQTT"); // Log mode normal 
+        lowpower_init(); // Light sleep automatique (LOW_POWER), jamais en mode AP
         xTaskCreatePinnedToCore(
             task_mqtt,        // Fonction de la tâche
             "task_mqtt",      // Nom de la tâche
-            8192,             // Taille de la stack
+            4096,             // Taille de la stack (messages préformatés dans l'arène MQTT, buffers statiques)
             NULL,             // Paramètre passé à la tâche
             5,                // Priorité
             NULL,             // Handle de tâche (pas utilisé)
-            0);               // Core 0
+            CORE_NET);        // Avec la pile réseau
     }else{
         ESP_LOGI(TAG, "Mode AP : lancement tâche CONFIG AP"); // Log mode AP 
         xTaskCreatePinnedToCore(
@@ -192,6 +225,38 @@ void app_main(void)
             NULL,             // Paramètre passé à la tâche
             5,                // Priorité
             NULL,             // Handle de tâche (pas utilisé)
-            0);               // Core 0
+            CORE_NET);        // Avec la pile réseau
     }
+
+    storage_load_counters();                 // Restaure les compteurs depuis le journal flash
+    boot_timing_mark(BOOT_MARK_COUNTERS);
+    ESP_LOGI(TAG, "Counters restored"); // Log de fin de restauration des compteurs
+    history_init();                          // Dernier relevé des intervalles, comparé aux compteurs restaurés avant toute impulsion
+    powerfail_init();                        // Surveillance de l'alimentation (POWER_FAIL), partition pfail prête
+    watchdog_init();                         // Superviseur des battements, après le parcours du journal (aucun panic pendant la restauration)
+
+    selftest_prepare();                      // Anti-rebond du banc (PULSE_SELFTEST), avant la configuration des entrées
+    gpio_init_pulses();                      // Configure les GPIO pour les impulsions (après la restauration des compteurs), ISR sur CORE_PULSE
+    ESP_LOGI(TAG, "GPIO_Init Done"); // Log de fin d'initialisation des GPIO pour les impulsions
+
+   // Crée la tâche de comptage sur le cœur de comptage
+    xTaskCreatePinnedToCore(
+        task_counter,
+        "task_counter",
+        4096,
+        NULL,
+        10,
+        NULL,
+        CORE_PULSE);      // Avec le comptage
+    // Crée la tâche boot/config sur le cœur réseau
+    xTaskCreatePinnedToCore(
+        task_boot_button,
+        "task_boot_button",
+        2048,
+        NULL,
+        4,
+        NULL,
+        CORE_NET);
+
+    selftest_start();                        // Balayage du banc de débit (PULSE_SELFTEST)
 }
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Empreinte flash et RAM de chaque profil de compilation (platformio.ini).
+#
+#   tools/footprint.sh                     tous les profils
+#   tools/footprint.sh upesy_wroom_prod    un seul profil
+#   tools/footprint.sh --readme            tous les profils, tableau écrit dans readme.md
+#
+# Compile chaque environnement puis affiche un tableau Markdown :
+# RAM statique (.data + .bss), taille de l'image et place restante dans une
+# partition OTA (ota_0 / ota_1, partitions.csv). Avec --readme, le tableau
+# remplace celui placé entre les marqueurs footprint de readme.md.
+
+set -e
+cd "$(dirname "$0")/.."
+
+README=
+if [ "$1" = "--readme" ]; then
+    README=readme.md
+    shift
+fi
+ENVS=${*:-"upesy_wroom upesy_wroom_prod upesy_wroom_debug"}
+OTA_SIZE=$((0x1B0000))                 # Taille de ota_0 et ota_1
+
+table() {
+    echo "| Profil | RAM statique (o) | Image (o) | Reste OTA (o) |"
+    echo "|--------|------------------|-----------|---------------|"
+    for env in $ENVS; do
+        out=$(pio run -e "$env" -t size 2>&1) || { echo "$out" >&2; exit 1; }
+        ram=$(echo "$out" | sed -n 's/^RAM:.*(used \([0-9]*\) bytes.*/\1/p' | tail -n 1)
+        bin=.pio/build/$env/firmware.bin
+        img=$(wc -c < "$bin")
+        echo "| \`$env\` | $ram | $img | $((OTA_SIZE - img)) |"
+    done
+}
+
+if [ -z "$README" ]; then
+    table
+    exit 0
+fi
+
+rows=$(mktemp)
+trap 'rm -f "$rows"' EXIT
+table > "$rows"
+cat "$rows"
+# Remplace les lignes entre les marqueurs, marqueurs conservés
+awk -v rows="$rows" '
+    /<!-- footprint:begin -->/ { print; while ((getline l < rows) > 0) print l; skip = 1; next }
+    /<!-- footprint:end -->/   { skip = 0 }
+    !skip
+' "$README" > "$README.tmp" && mv "$README.tmp" "$README"
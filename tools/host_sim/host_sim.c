@@ -0,0 +1,425 @@
+/**
+ * @file host_sim.c
+ * @brief Banc de simulation hôte du chemin de comptage, de la persistance et de la publication.
+ *
+ * Le banc exécute gpio_pulse.c (moteur ISR ou SAMPLER), counter_store, power_meter,
+ * storage/journal, publish_sched, mqtt et outbox sans modification, sur des périphériques
+ * simulés (tools/host_sim/mock), et les alimente avec une trace d'impulsions synthétique
+ * ou enregistrée. Il rapporte :
+ * - les impulsions vraies, acceptées, rejetées (rebonds, parasites), perdues, manquées, en trop
+ * - les percentiles de latence front → prise en compte
+ * - par heure : écritures journal et outbox, effacements de secteurs, écritures NVS,
+ *   messages et octets MQTT
+ *
+ * Usage : host_sim [steady|bursty|bouncy|all] [-t s] [-c n] [-d µs] [-b off|json|cbor]
+ *                  [-o s] [-s graine] [-f trace.csv] [-w sortie.csv] [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+#include "sim_trace.h"
+#include "config.h"
+#include "storage.h"
+#include "gpio_pulse.h"
+#include "counter_store.h"
+#include "power_meter.h"
+#include "publish_sched.h"
+#include "outbox.h"
+#include "mqtt.h"
+#include "mqtt_cmd.h"
+#include "pulse_stats.h"
+
+#define LAT_BUCKETS  200000         // Histogramme de latence au µs près, jusqu'à 200 ms
+#define STARTUP_US   1000000        // Démarrage simulé avant la première impulsion des traces
+#define TRUTH_RING   1024           // Vraies impulsions en attente de validation par compteur
+
+/**
+ * @brief Options de la ligne de commande.
+ */
+typedef struct {
+    const trace_scenario_t *scenario; // NULL : trace CSV
+    const char *csv_in;
+    const char *csv_out;
+    double seconds;                 // 0 : 600 s, ou la durée de la trace CSV
+    int channels;                   // 0 : défaut du scénario
+    uint32_t debounce_us;           // 0 : défaut du scénario
+    int batch;                      // -1 : défaut (MQTT_BATCH_DEFAULT)
+    double offline_s;               // Broker injoignable pendant les premières secondes
+    uint64_t seed;
+    bool verbose;
+    const char *cmds[8];            // Commandes MQTT "s:commande" (-m)
+    int cmd_count;
+} sim_opts_t;
+
+/**
+ * @brief État d'une entrée simulée.
+ */
+typedef struct {
+    int idx;                        // Index du compteur
+    trace_edge_t edge;              // Prochain changement de niveau
+    int64_t truth[TRUTH_RING];      // Fronts des vraies impulsions non encore comptées
+    int truth_head, truth_count;
+    uint64_t seen;                  // Dernière valeur lue dans counter_store
+} sim_input_t;
+
+// GPIO des compteurs : câblage par défaut d'abord, puis toutes les autres pins sauf BOOT
+static const int8_t sim_pins[MAX_CHANNELS] = {
+    18, 19, 23, 21, 22, 4, 5, 12, 13, 14, 15, 16, 17, 25, 26, 27,
+    32, 33, 34, 35, 36, 39, 1, 2, 3, 6, 7, 8, 9, 10, 11, 20,
+};
+
+static sim_opts_t opts;
+static sim_input_t inputs[MAX_CHANNELS];
+static FILE *csv_out;
+static int64_t window_us;           // Au-delà, une vraie impulsion non comptée est manquée
+
+static uint64_t truth_total, matched, missed, extra;
+static uint64_t lat_hist[LAT_BUCKETS + 1];
+static uint64_t lat_count;
+static int64_t lat_max;
+
+// --------------------- Tâches de l'application (reprises de src/main.c) ---------------------
+
+/**
+ * @brief Tâche de sauvegarde : même boucle que task_counter (src/main.c).
+ */
+static void sim_task_counter(void *pv)
+{
+    (void)pv;
+    uint64_t values[MAX_CHANNELS];
+    int64_t last_save_us = -COUNTER_SAVE_MIN_S * 1000000LL;
+    storage_saver_init();
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t wait_ms = (last_save_us + COUNTER_SAVE_MIN_S * 1000000LL - esp_timer_get_time()) / 1000;
+        if (wait_ms > 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(wait_ms));
+            ulTaskNotifyTake(pdTRUE, 0);
+        }
+        gpio_pulse_mark_saved();
+        counter_store_snapshot(values);
+        storage_save_counters(values);
+        last_save_us = esp_timer_get_time();
+    }
+}
+
+/**
+ * @brief Tâche de publication : task_mqtt (src/main.c) sans Wi-Fi ni chronométrage du démarrage.
+ */
+static void sim_task_mqtt(void *pv)
+{
+    (void)pv;
+    publish_sched_init();
+    mqtt_init();
+    storage_wait_counters();
+    outbox_init();
+    uint64_t values[MAX_CHANNELS];
+    power_reading_t power[MAX_CHANNELS];
+    while (1)
+    {
+        uint32_t mask = publish_sched_wait(values, power, 0);
+        if (mqtt_is_connected()) mqtt_publish_counters(values, power, mask);
+        else outbox_push(values);
+    }
+}
+
+// --------------------- Trace et vérité terrain ---------------------
+
+static void input_edge(void *arg);
+
+static void input_schedule(sim_input_t *in)
+{
+    if (trace_next(in->idx, &in->edge)) sim_schedule(in->edge.t_us, input_edge, in);
+}
+
+static void input_edge(void *arg)
+{
+    sim_input_t *in = arg;
+    if (in->edge.truth)
+    {
+        truth_total++;
+        if (in->truth_count == TRUTH_RING) // Plus rien ne valide ce compteur : la plus ancienne est manquée
+        {
+            in->truth_head = (in->truth_head + 1) % TRUTH_RING;
+            in->truth_count--;
+            missed++;
+        }
+        in->truth[(in->truth_head + in->truth_count++) % TRUTH_RING] = in->edge.t_us;
+    }
+    if (csv_out) fprintf(csv_out, "%lld,%d,%d,%d\n", (long long)in->edge.t_us, in->idx, in->edge.level, in->edge.truth);
+    sim_gpio_set(channels[in->idx].pin, in->edge.level);
+    input_schedule(in);
+}
+
+/**
+ * @brief Apparie les nouvelles impulsions comptées aux vraies impulsions en attente.
+ */
+static void check_counts(int64_t now)
+{
+    for (int i = 0; i < channel_count; i++)
+    {
+        sim_input_t *in = &inputs[i];
+        uint64_t value = counter_store_get(i);
+        while (in->seen != value)
+        {
+            in->seen++;
+            while (in->truth_count > 0 && now - in->truth[in->truth_head] > window_us) // Trop ancienne : manquée
+            {
+                in->truth_head = (in->truth_head + 1) % TRUTH_RING;
+                in->truth_count--;
+                missed++;
+            }
+            if (in->truth_count == 0)
+            {
+                extra++;                // Comptée sans vraie impulsion : parasite accepté
+                continue;
+            }
+            int64_t lat = now - in->truth[in->truth_head];
+            in->truth_head = (in->truth_head + 1) % TRUTH_RING;
+            in->truth_count--;
+            matched++;
+            lat_hist[lat < LAT_BUCKETS ? lat : LAT_BUCKETS]++;
+            lat_count++;
+            if (lat > lat_max) lat_max = lat;
+        }
+    }
+}
+
+static int64_t lat_percentile(double p)
+{
+    uint64_t target = (uint64_t)(p * (double)lat_count);
+    uint64_t acc = 0;
+    for (int64_t us = 0; us <= LAT_BUCKETS; us++)
+    {
+        acc += lat_hist[us];
+        if (acc > target) return us;
+    }
+    return lat_max;
+}
+
+// --------------------- Scénario ---------------------
+
+static void sim_connect_evt(void *arg)
+{
+    (void)arg;
+    sim_mqtt_connect();
+}
+
+/**
+ * @brief Démarrage simulé : même ordre que app_main (src/main.c).
+ */
+static void sim_boot(int count, uint32_t debounce_us)
+{
+    nvs_init_and_load();
+    channel_count = channel_count_next = (uint8_t)count;
+    for (int i = 0; i < count; i++)
+    {
+        channels[i].pin = sim_pins[i];
+        channels[i].debounce_us = debounce_us;
+    }
+    if (opts.batch >= 0) mqtt_batch_mode = (uint8_t)opts.batch;
+    power_meter_init();
+
+    xTaskCreatePinnedToCore(sim_task_mqtt, "task_mqtt", 8192, NULL, 5, NULL, 0);
+    storage_load_counters();
+    gpio_init_pulses();
+    xTaskCreatePinnedToCore(sim_task_counter, "task_counter", 4096, NULL, 10, NULL, 1);
+    sim_run_ready();
+    sim_schedule((int64_t)(opts.offline_s * 1e6), sim_connect_evt, NULL);
+}
+
+static int run_scenario(void)
+{
+    const trace_scenario_t *sc = opts.scenario;
+    uint32_t debounce_us = opts.debounce_us ? opts.debounce_us : (sc ? sc->debounce_us : DEBOUNCE_US);
+    int count;
+
+    if (sc)
+    {
+        count = opts.channels ? opts.channels : sc->channels;
+        trace_init_synthetic(sc, count, opts.seed);
+    }
+    else
+    {
+        int64_t last_us;
+        count = trace_load_csv(opts.csv_in, debounce_us, &last_us);
+        if (count == 0)
+        {
+            fprintf(stderr, "host_sim: trace %s illisible ou vide\n", opts.csv_in);
+            return 1;
+        }
+        if (opts.seconds == 0) opts.seconds = (double)(last_us - STARTUP_US) / 1e6 + 1; // Durée de la trace
+        if (opts.channels && opts.channels < count) count = opts.channels;
+    }
+    if (count < 1 || count > MAX_CHANNELS)
+    {
+        fprintf(stderr, "host_sim: 1 à %d compteurs\n", MAX_CHANNELS);
+        return 1;
+    }
+    window_us = 10LL * debounce_us + 100000;
+    sim_log_enable(opts.verbose);
+    if (opts.csv_out)
+    {
+        csv_out = fopen(opts.csv_out, "w");
+        if (csv_out) fprintf(csv_out, "t_us,channel,level,truth\n");
+    }
+
+    sim_boot(count, debounce_us);
+    for (int i = 0; i < count; i++)
+    {
+        inputs[i].idx = i;
+        inputs[i].seen = counter_store_get(i);
+        input_schedule(&inputs[i]);  // Premiers fronts après STARTUP_US
+    }
+    for (int k = 0; k < opts.cmd_count; k++)  // Commandes reçues sur energie/<DEVICE_NAME>/cmd
+    {
+        const char *sep = strchr(opts.cmds[k], ':');
+        if (sep == NULL) continue;
+        sim_mqtt_receive(STARTUP_US + (int64_t)(atof(opts.cmds[k]) * 1e6), MQTT_CMD_TOPIC, sep + 1);
+    }
+    sim_run(STARTUP_US, check_counts);
+    sim_io_stats_t boot_io = sim_io;  // Écritures du démarrage, rapportées à part
+    sim_io = (sim_io_stats_t){ 0 };
+
+    int64_t end_us = STARTUP_US + (int64_t)(opts.seconds * 1e6);
+    sim_run(end_us, check_counts);
+
+    for (int i = 0; i < count; i++)   // Vraies impulsions restantes : manquées si hors fenêtre, sinon en vol
+    {
+        sim_input_t *in = &inputs[i];
+        for (int k = 0; k < in->truth_count; k++)
+        {
+            if (end_us - in->truth[(in->truth_head + k) % TRUTH_RING] > window_us) missed++;
+            else truth_total--;
+        }
+    }
+    if (csv_out) fclose(csv_out);
+
+    uint64_t edges = 0, accepted = 0, dropped = 0, width = 0, rate = 0;
+#if PULSE_STATS
+    for (int i = 0; i < count; i++)
+    {
+        edges += pulse_stats[i].edges;
+        accepted += pulse_stats[i].accepted;
+        dropped += pulse_stats[i].dropped;
+        width += pulse_stats[i].width;
+        rate += pulse_stats[i].rate;
+    }
+#endif
+    uint64_t rejected = (edges > accepted + dropped) ? edges - accepted - dropped : 0;
+    double per_h = 3600.0 / opts.seconds;
+    const char *backend = (PULSE_BACKEND == PULSE_BACKEND_SAMPLER) ? "SAMPLER" : "ISR";
+    const char *batch = mqtt_batch_mode == MQTT_BATCH_JSON ? "json" : mqtt_batch_mode == MQTT_BATCH_CBOR ? "cbor" : "off";
+
+    printf("== %s : %s\n", sc ? sc->name : opts.csv_in, sc ? sc->desc : "trace enregistrée");
+    printf("   %d compteurs, %.0f s simulées, anti-rebond %lu µs, moteur %s%s%s, publication %s\n",
+           count, opts.seconds, (unsigned long)debounce_us, backend, LOW_POWER ? " (LOW_POWER)" : "",
+           PULSE_VALIDATE == PULSE_VALIDATE_WIDTH ? " (largeur)" : "", batch);
+    printf("Impulsions   vraies %llu  comptées %llu  manquées %llu  en trop %llu\n",
+           (unsigned long long)truth_total, (unsigned long long)(matched + extra),
+           (unsigned long long)missed, (unsigned long long)extra);
+    printf("Fronts       bruts %llu  acceptés %llu  rejetés %llu  perdus %llu\n",
+           (unsigned long long)edges, (unsigned long long)accepted,
+           (unsigned long long)rejected, (unsigned long long)dropped);
+    if (PULSE_VALIDATE == PULSE_VALIDATE_WIDTH)
+    {
+        printf("             dont impulsions de largeur rejetée %llu  de cadence rejetée %llu\n",
+               (unsigned long long)width, (unsigned long long)rate);
+    }
+    if (lat_count > 0)
+    {
+        printf("Latence µs   p50 %lld  p90 %lld  p99 %lld  max %lld\n",
+               (long long)lat_percentile(0.50), (long long)lat_percentile(0.90),
+               (long long)lat_percentile(0.99), (long long)lat_max);
+    }
+    printf("Par heure    journal %.0f écritures (%.1f Ko) %.1f effacements  outbox %.0f écritures %.1f effacements\n",
+           sim_io.flash[1].writes * per_h, sim_io.flash[1].bytes * per_h / 1024, sim_io.flash[1].erases * per_h,
+           sim_io.flash[0].writes * per_h, sim_io.flash[0].erases * per_h);
+    printf("             NVS %.0f écritures %.0f commits  MQTT %.0f messages %.1f Ko utiles %.1f Ko sur le fil\n",
+           sim_io.nvs_sets * per_h, sim_io.nvs_commits * per_h, sim_io.mqtt_messages * per_h,
+           sim_io.mqtt_payload * per_h / 1024, sim_io.mqtt_wire * per_h / 1024);
+    printf("Démarrage    NVS %u écritures %u commits  journal %u écritures %u effacements\n\n",
+           boot_io.nvs_sets, boot_io.nvs_commits, boot_io.flash[1].writes, boot_io.flash[1].erases);
+    fflush(stdout);
+    return (missed || extra) ? 3 : 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: host_sim [scénario|all] [options]\n"
+            "  scénarios : steady, bursty, bouncy ; all les enchaîne (défaut)\n"
+            "  -t s       durée simulée (défaut : 600, ou la durée de la trace -f)\n"
+            "  -c n       nombre de compteurs (défaut : selon le scénario)\n"
+            "  -d µs      anti-rebond de tous les compteurs (défaut : selon le scénario)\n"
+            "  -b mode    publication off, json ou cbor (défaut : MQTT_BATCH_DEFAULT)\n"
+            "  -o s       broker injoignable pendant les s premières secondes (outbox)\n"
+            "  -s graine  graine des traces synthétiques (défaut 1)\n"
+            "  -f csv     rejoue une trace enregistrée t_us,channel,level[,truth]\n"
+            "  -w csv     enregistre la trace jouée\n"
+            "  -m s:cmd   commande MQTT reçue à l'instant s (ex : 30:read), jusqu'à 8 ;\n"
+            "             set fausse la comparaison à la vérité terrain\n"
+            "  -v         affiche les logs de lib/\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = "all";
+    opts = (sim_opts_t){ .batch = -1, .seed = 1 };
+
+    if (argc > 1 && argv[1][0] != '-')
+    {
+        name = argv[1];
+        optind = 2;
+    }
+    int opt;
+    while ((opt = getopt(argc, argv, "t:c:d:b:o:s:f:w:m:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': opts.seconds = atof(optarg); break;
+            case 'c': opts.channels = atoi(optarg); break;
+            case 'd': opts.debounce_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'b':
+                opts.batch = !strcmp(optarg, "json") ? MQTT_BATCH_JSON : !strcmp(optarg, "cbor") ? MQTT_BATCH_CBOR : MQTT_BATCH_OFF;
+                break;
+            case 'o': opts.offline_s = atof(optarg); break;
+            case 's': opts.seed = strtoull(optarg, NULL, 10); break;
+            case 'f': opts.csv_in = optarg; break;
+            case 'w': opts.csv_out = optarg; break;
+            case 'v': opts.verbose = true; break;
+            case 'm':
+                if (opts.cmd_count < 8) opts.cmds[opts.cmd_count++] = optarg;
+                break;
+            default: usage();
+        }
+    }
+    if (opts.seconds < 0) usage();
+
+    if (opts.csv_in) return run_scenario();
+    if (opts.seconds == 0) opts.seconds = 600;
+
+    int status = 0;
+    for (int k = 0; k < trace_scenario_count; k++)
+    {
+        bool all = !strcmp(name, "all");
+        if (!all && strcmp(name, trace_scenarios[k].name)) continue;
+        opts.scenario = &trace_scenarios[k];
+        if (!all) return run_scenario();
+
+        pid_t pid = fork();           // État global de lib/ : un processus par scénario
+        if (pid == 0) exit(run_scenario());
+        int st = 0;
+        waitpid(pid, &st, 0);
+        if (!WIFEXITED(st) || WEXITSTATUS(st) != 0) status = 1;
+    }
+    if (opts.scenario == NULL) usage();
+    return status;
+}
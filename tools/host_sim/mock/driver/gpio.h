@@ -0,0 +1,4 @@
+#ifndef SIM_DRIVER_GPIO_H
+#define SIM_DRIVER_GPIO_H
+#include "idf_mock.h" // Simulation hôte : voir idf_mock.h
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+#include "idf_mock.h" // Simulation hôte : voir idf_mock.h
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_FREERTOS_FREERTOS_H
+#define SIM_FREERTOS_FREERTOS_H
+#include "idf_mock.h" // Simulation hôte : voir idf_mock.h
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_HAL_GPIO_LL_H
+#define SIM_HAL_GPIO_LL_H
+#include "idf_mock.h" // Simulation hôte : voir idf_mock.h
+#endif
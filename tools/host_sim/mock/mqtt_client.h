@@ -0,0 +1,4 @@
+#ifndef SIM_MQTT_CLIENT_H
+#define SIM_MQTT_CLIENT_H
+#include "idf_mock.h" // Simulation hôte : voir idf_mock.h
+#endif
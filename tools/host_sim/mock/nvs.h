@@ -0,0 +1,4 @@
+#ifndef SIM_NVS_H
+#define SIM_NVS_H
+#include "idf_mock.h" // Simulation hôte : voir idf_mock.h
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_SOC_SOC_H
+#define SIM_SOC_SOC_H
+#include "idf_mock.h" // Simulation hôte : voir idf_mock.h
+#endif
@@ -0,0 +1,71 @@
+#ifndef SIM_H
+#define SIM_H
+
+/**
+ * @file sim.h
+ * @brief API interne du banc de simulation hôte : horloge simulée, événements, mesures.
+ *
+ * Le banc exécute le code de lib/ tel quel : les tâches FreeRTOS sont des coroutines
+ * coopératives ordonnancées sur une horloge simulée (µs). Les ISR et les callbacks
+ * esp_timer s'exécutent depuis la boucle d'événements, sans latence.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Accès à une partition flash.
+ */
+typedef struct {
+    uint32_t writes;          ///< esp_partition_write
+    uint64_t bytes;           ///< Octets programmés
+    uint32_t erases;          ///< Secteurs de 4 Ko effacés
+} sim_flash_stats_t;
+
+/**
+ * @brief Compteurs d'accès aux mémoires non volatiles et au broker.
+ */
+typedef struct {
+    uint32_t nvs_sets;        ///< nvs_set_* (toutes clés confondues)
+    uint32_t nvs_commits;     ///< nvs_commit
+    sim_flash_stats_t flash[2]; ///< Partitions "outbox" puis "journal"
+    uint32_t mqtt_messages;   ///< esp_mqtt_client_publish
+    uint64_t mqtt_payload;    ///< Octets de contenu publiés
+    uint64_t mqtt_wire;       ///< Estimation sur le fil (en-tête PUBLISH + topic + contenu + PUBACK)
+} sim_io_stats_t;
+
+extern sim_io_stats_t sim_io; // Compteurs d'accès, remis à zéro par le banc après le démarrage
+
+// --------------------- Horloge et événements ---------------------
+
+typedef void (*sim_event_fn)(void *arg);
+
+int64_t sim_now_us(void);
+
+/**
+ * @brief Programme un événement à l'instant t_us (ordre FIFO à instant égal).
+ */
+void sim_schedule(int64_t t_us, sim_event_fn fn, void *arg);
+
+/**
+ * @brief Exécute les tâches prêtes puis les événements jusqu'à end_us.
+ *
+ * after_step est appelé après chaque événement, une fois les tâches réveillées exécutées :
+ * le banc y compare les compteurs à la vérité terrain.
+ */
+void sim_run(int64_t end_us, void (*after_step)(int64_t now_us));
+
+/**
+ * @brief Lance les tâches créées avant la boucle (app_main simulé) jusqu'à ce qu'elles bloquent.
+ */
+void sim_run_ready(void);
+
+// --------------------- Périphériques ---------------------
+
+void sim_gpio_set(int pin, int level);
+void sim_mqtt_connect(void);
+void sim_mqtt_receive(int64_t t_us, const char *topic, const char *data); // Message du broker (MQTT_EVENT_DATA)
+void sim_log_enable(bool on);
+
+#endif // SIM_H
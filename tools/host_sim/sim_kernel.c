@@ -0,0 +1,507 @@
+/**
+ * @file sim_kernel.c
+ * @brief Noyau de simulation : horloge simulée, tâches FreeRTOS coopératives, esp_timer et gptimer.
+ *
+ * Les tâches sont des coroutines (ucontext) : une tâche s'exécute jusqu'à ce qu'elle bloque
+ * (notification, délai, mutex, groupe d'événements), la plus prioritaire des tâches prêtes
+ * reprend alors. Le temps n'avance qu'entre deux événements de la file (timers, fronts
+ * des traces, échéances de blocage) : le coût CPU réel du code simulé n'est pas modélisé,
+ * seules ses décisions et ses écritures le sont.
+ */
+
+#define _XOPEN_SOURCE 700           // ucontext sous glibc
+#include <stdlib.h>
+#include <ucontext.h>
+#include "idf_mock.h"
+#include "sim.h"
+
+#define SIM_STACK_SIZE (256 * 1024) // Pile hôte d'une tâche (les tailles ESP32 sont ignorées)
+
+// --------------------- File d'événements (tas binaire) ---------------------
+
+typedef struct {
+    int64_t t_us;       // Instant de l'événement
+    uint64_t seq;       // Ordre d'insertion (FIFO à instant égal)
+    sim_event_fn fn;    // Action
+    void *arg;
+    uint32_t gen;       // Génération attendue (événement annulé si *genp a changé)
+    uint32_t *genp;
+} sim_event_t;
+
+static sim_event_t *heap;
+static size_t heap_len, heap_cap;
+static uint64_t heap_seq;
+static int64_t now_us = 100000;     // app_main démarre environ 100 ms après la mise sous tension
+
+static bool event_before(const sim_event_t *a, const sim_event_t *b)
+{
+    return a->t_us < b->t_us || (a->t_us == b->t_us && a->seq < b->seq);
+}
+
+static void schedule_gen(int64_t t_us, sim_event_fn fn, void *arg, uint32_t *genp)
+{
+    if (heap_len == heap_cap)
+    {
+        heap_cap = heap_cap ? heap_cap * 2 : 1024;
+        heap = realloc(heap, heap_cap * sizeof(*heap));
+        if (heap == NULL) abort();
+    }
+    sim_event_t ev = { t_us < now_us ? now_us : t_us, heap_seq++, fn, arg, genp ? *genp : 0, genp };
+    size_t i = heap_len++;
+    while (i > 0 && event_before(&ev, &heap[(i - 1) / 2]))
+    {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = ev;
+}
+
+static sim_event_t heap_pop(void)
+{
+    sim_event_t top = heap[0];
+    sim_event_t last = heap[--heap_len];
+    size_t i = 0;
+    while (1)
+    {
+        size_t c = 2 * i + 1;
+        if (c >= heap_len) break;
+        if (c + 1 < heap_len && event_before(&heap[c + 1], &heap[c])) c++;
+        if (!event_before(&heap[c], &last)) break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    if (heap_len > 0) heap[i] = last;
+    return top;
+}
+
+int64_t sim_now_us(void)
+{
+    return now_us;
+}
+
+void sim_schedule(int64_t t_us, sim_event_fn fn, void *arg)
+{
+    schedule_gen(t_us, fn, arg, NULL);
+}
+
+// --------------------- Tâches ---------------------
+
+typedef enum { TASK_READY, TASK_BLOCKED, TASK_DEAD } task_state_t;
+
+struct sim_task {
+    ucontext_t ctx;
+    TaskFunction_t fn;
+    void *arg;
+    const char *name;
+    UBaseType_t prio;
+    task_state_t state;
+    uint32_t notify_value;  // Valeur de notification
+    bool notify_pending;    // Notification reçue et non consommée
+    const void *wait_obj;   // Objet attendu (NULL : notification ou délai)
+    uint32_t wake_gen;      // Annule l'échéance de blocage en cours
+    bool timed_out;
+    struct sim_task *next;
+};
+
+static struct sim_task *tasks;     // Toutes les tâches créées
+static struct sim_task *current;   // Tâche en cours (NULL : boucle d'événements, ISR, callbacks)
+static ucontext_t sched_ctx;
+
+static void task_trampoline(void)
+{
+    current->fn(current->arg);
+    current->state = TASK_DEAD;    // Retour de la fonction de tâche
+    swapcontext(&current->ctx, &sched_ctx);
+}
+
+static void task_wake(struct sim_task *t)
+{
+    if (t->state != TASK_BLOCKED) return;
+    t->state = TASK_READY;
+    t->wake_gen++;                 // L'échéance éventuelle devient caduque
+}
+
+static void task_timeout(void *arg)
+{
+    struct sim_task *t = arg;
+    t->timed_out = true;
+    task_wake(t);
+}
+
+/**
+ * @brief Bloque la tâche courante jusqu'à un réveil explicite ou l'échéance.
+ *
+ * @return false si l'échéance est atteinte
+ */
+static bool task_block(const void *obj, TickType_t ticks)
+{
+    struct sim_task *t = current;
+    if (t == NULL)
+    {
+        fprintf(stderr, "host_sim: appel bloquant hors d'une tâche\n");
+        abort();
+    }
+    t->state = TASK_BLOCKED;
+    t->wait_obj = obj;
+    t->timed_out = false;
+    t->wake_gen++;
+    if (ticks != portMAX_DELAY)
+    {
+        schedule_gen(now_us + (int64_t)ticks * 1000, task_timeout, t, &t->wake_gen);
+    }
+    swapcontext(&t->ctx, &sched_ctx);
+    t->wait_obj = NULL;
+    return !t->timed_out;
+}
+
+static void wake_waiters(const void *obj)
+{
+    for (struct sim_task *t = tasks; t != NULL; t = t->next)
+    {
+        if (t->state == TASK_BLOCKED && t->wait_obj == obj) task_wake(t);
+    }
+}
+
+void sim_run_ready(void)
+{
+    while (1)
+    {
+        struct sim_task *best = NULL;
+        for (struct sim_task *t = tasks; t != NULL; t = t->next)
+        {
+            if (t->state == TASK_READY && (best == NULL || t->prio > best->prio)) best = t;
+        }
+        if (best == NULL) return;
+        current = best;
+        swapcontext(&sched_ctx, &best->ctx);
+        current = NULL;
+    }
+}
+
+void sim_run(int64_t end_us, void (*after_step)(int64_t now_us))
+{
+    sim_run_ready();
+    while (heap_len > 0 && heap[0].t_us <= end_us)
+    {
+        sim_event_t ev = heap_pop();
+        if (ev.genp != NULL && *ev.genp != ev.gen) continue; // Annulé
+        now_us = ev.t_us;
+        ev.fn(ev.arg);
+        sim_run_ready();
+        if (after_step) after_step(now_us);
+    }
+    now_us = end_us;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *out)
+{
+    (void)stack;
+    struct sim_task *t = calloc(1, sizeof(*t));
+    if (t == NULL) return pdFALSE;
+    t->fn = fn;
+    t->arg = arg;
+    t->name = name;
+    t->prio = prio;
+    t->state = TASK_READY;
+    getcontext(&t->ctx);
+    t->ctx.uc_stack.ss_sp = malloc(SIM_STACK_SIZE);
+    t->ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+    t->ctx.uc_link = NULL;
+    makecontext(&t->ctx, task_trampoline, 0);
+    t->next = tasks;
+    tasks = t;
+    if (out) *out = t;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *out, BaseType_t core)
+{
+    (void)core;                    // Un seul cœur simulé
+    return xTaskCreate(fn, name, stack, arg, prio, out);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0)
+    {
+        current->state = TASK_READY; // Simple passage de main
+        swapcontext(&current->ctx, &sched_ctx);
+        return;
+    }
+    static const char delay_obj;   // Attente pure : une notification ne réveille pas la tâche (comme FreeRTOS)
+    task_block(&delay_obj, ticks);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    struct sim_task *t = task ? task : current;
+    t->state = TASK_DEAD;
+    if (t == current) swapcontext(&t->ctx, &sched_ctx);
+}
+
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t value, eNotifyAction action)
+{
+    switch (action)
+    {
+        case eSetBits: t->notify_value |= value; break;
+        case eIncrement: t->notify_value++; break;
+        case eSetValueWithOverwrite: t->notify_value = value; break;
+        case eSetValueWithoutOverwrite:
+            if (t->notify_pending) return pdFALSE;
+            t->notify_value = value;
+            break;
+        case eNoAction: break;
+    }
+    t->notify_pending = true;
+    if (t->state == TASK_BLOCKED && t->wait_obj == NULL) task_wake(t);
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t value, eNotifyAction action, BaseType_t *woken)
+{
+    if (woken) *woken = pdTRUE;
+    return xTaskNotify(t, value, action);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+    return xTaskNotify(t, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken)
+{
+    xTaskNotifyFromISR(t, 0, eIncrement, woken);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    struct sim_task *t = current;
+    if (t->notify_value == 0 && ticks != 0) task_block(NULL, ticks);
+    uint32_t value = t->notify_value;
+    if (value != 0) t->notify_value = clear ? 0 : value - 1;
+    t->notify_pending = false;
+    return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_entry, uint32_t clear_exit, uint32_t *value, TickType_t ticks)
+{
+    struct sim_task *t = current;
+    if (!t->notify_pending)
+    {
+        t->notify_value &= ~clear_entry;
+        if (ticks != 0) task_block(NULL, ticks);
+    }
+    if (value) *value = t->notify_value;
+    if (!t->notify_pending) return pdFALSE;
+    t->notify_value &= ~clear_exit;
+    t->notify_pending = false;
+    return pdTRUE;
+}
+
+// --------------------- Mutex et groupes d'événements ---------------------
+
+struct sim_sem { struct sim_task *owner; bool taken; };
+struct sim_event_group { EventBits_t bits; };
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return calloc(1, sizeof(struct sim_sem));
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    while (sem->taken)
+    {
+        if (ticks == 0 || !task_block(sem, ticks)) return pdFALSE;
+    }
+    sem->taken = true;
+    sem->owner = current;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    sem->taken = false;
+    sem->owner = NULL;
+    wake_waiters(sem);
+    return pdTRUE;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(struct sim_event_group));
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    group->bits |= bits;
+    wake_waiters(group);
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t ticks)
+{
+    while (1)
+    {
+        EventBits_t cur = group->bits;
+        bool ok = all ? (cur & bits) == bits : (cur & bits) != 0;
+        if (ok)
+        {
+            if (clear) group->bits &= ~bits;
+            return cur;
+        }
+        if (ticks == 0 || !task_block(group, ticks)) return group->bits;
+    }
+}
+
+// --------------------- esp_timer et gptimer ---------------------
+
+struct sim_timer {
+    esp_timer_cb_t callback;        // esp_timer
+    void *arg;
+    gptimer_alarm_cb_t on_alarm;    // gptimer
+    void *alarm_ctx;
+    uint32_t resolution_hz;
+    uint64_t alarm_count;
+    bool auto_reload;
+    int64_t period_us;              // 0 : coup unique
+    int64_t expiry_us;
+    bool active;
+    uint32_t gen;                   // Annule l'échéance programmée
+};
+
+static void timer_fire(void *arg)
+{
+    struct sim_timer *t = arg;
+    if (t->period_us > 0)           // Périodique : prochaine échéance avant le callback
+    {
+        t->expiry_us += t->period_us;
+        schedule_gen(t->expiry_us, timer_fire, t, &t->gen);
+    }
+    else
+    {
+        t->active = false;
+    }
+
+    if (t->on_alarm)
+    {
+        gptimer_alarm_event_data_t edata = { .count_value = t->alarm_count, .alarm_value = t->alarm_count };
+        t->on_alarm(t, &edata, t->alarm_ctx);
+    }
+    else
+    {
+        t->callback(t->arg);
+    }
+}
+
+static void timer_arm(struct sim_timer *t, int64_t delay_us, int64_t period_us)
+{
+    t->active = true;
+    t->period_us = period_us;
+    t->expiry_us = now_us + delay_us;
+    t->gen++;
+    schedule_gen(t->expiry_us, timer_fire, t, &t->gen);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    struct sim_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) return ESP_ERR_NO_MEM;
+    t->callback = args->callback;
+    t->arg = args->arg;
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us)
+{
+    if (t->active) return ESP_ERR_INVALID_STATE;
+    timer_arm(t, (int64_t)timeout_us, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t period_us)
+{
+    if (t->active) return ESP_ERR_INVALID_STATE;
+    timer_arm(t, (int64_t)period_us, (int64_t)period_us);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t)
+{
+    if (!t->active) return ESP_ERR_INVALID_STATE;
+    t->active = false;
+    t->gen++;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t t)
+{
+    if (t->active) return ESP_ERR_INVALID_STATE;
+    free(t);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t t)
+{
+    return t->active;
+}
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *cfg, gptimer_handle_t *out)
+{
+    struct sim_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) return ESP_ERR_NO_MEM;
+    t->resolution_hz = cfg->resolution_hz;
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t t, const gptimer_event_callbacks_t *cbs, void *ctx)
+{
+    t->on_alarm = cbs->on_alarm;
+    t->alarm_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t t, const gptimer_alarm_config_t *cfg)
+{
+    t->alarm_count = cfg->alarm_count;
+    t->auto_reload = cfg->flags.auto_reload_on_alarm;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t t)
+{
+    (void)t;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_start(gptimer_handle_t t)
+{
+    if (t->resolution_hz == 0 || t->alarm_count == 0) return ESP_ERR_INVALID_STATE;
+    int64_t period_us = (int64_t)(t->alarm_count * 1000000ULL / t->resolution_hz);
+    timer_arm(t, period_us, t->auto_reload ? period_us : 0);
+    return ESP_OK;
+}
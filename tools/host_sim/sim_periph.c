@@ -0,0 +1,538 @@
+/**
+ * @file sim_periph.c
+ * @brief Périphériques simulés : GPIO et interruptions, NVS en mémoire, partitions flash,
+ *        client MQTT, logs et fonctions système.
+ *
+ * Chaque accès qui use la flash ou occupe le réseau est compté dans sim_io : c'est ce que
+ * le banc rapporte par heure de fonctionnement.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include "idf_mock.h"
+#include "sim.h"
+
+sim_io_stats_t sim_io;          // Compteurs d'accès
+gpio_dev_t GPIO;                // Cible de gpio_ll_set_intr_type
+esp_event_base_t IP_EVENT = "IP_EVENT";
+
+// --------------------- Logs et système ---------------------
+
+static bool log_on;             // Logs de lib/ muets par défaut (-v pour les afficher)
+
+void sim_log_enable(bool on)
+{
+    log_on = on;
+}
+
+void sim_log(esp_log_level_t level, const char *tag, const char *fmt, ...)
+{
+    static const char letters[] = "NEWIDV";
+    if (!log_on) return;
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(sim_now_us() / 1000), tag);
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    (void)level;
+}
+
+const char *esp_err_to_name(esp_err_t err)
+{
+    switch (err)
+    {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        default: return "ESP_ERR_?";
+    }
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return ESP_RST_POWERON;
+}
+
+void esp_restart(void)
+{
+    fprintf(stderr, "host_sim: esp_restart() à t=%lld ms\n", (long long)(sim_now_us() / 1000));
+    exit(2);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// --------------------- GPIO ---------------------
+
+typedef struct {
+    int level;
+    gpio_int_type_t intr;
+    gpio_isr_t handler;
+    void *arg;
+} sim_pin_t;
+
+static sim_pin_t pins[GPIO_NUM_MAX];
+static bool isr_service;
+
+/**
+ * @brief Déclenche l'ISR d'une pin en interruption de niveau si son niveau correspond.
+ *
+ * Appelée comme événement après chaque changement de type : une ISR qui réarme le niveau
+ * courant est rappelée, comme sur le matériel.
+ */
+static void level_check(void *arg)
+{
+    sim_pin_t *p = &pins[(intptr_t)arg];
+    if (p->handler == NULL) return;
+    if ((p->intr == GPIO_INTR_HIGH_LEVEL && p->level == 1) ||
+        (p->intr == GPIO_INTR_LOW_LEVEL && p->level == 0))
+    {
+        p->handler(p->arg);
+    }
+}
+
+static void set_intr(int pin, gpio_int_type_t type)
+{
+    pins[pin].intr = type;
+    if (type == GPIO_INTR_HIGH_LEVEL || type == GPIO_INTR_LOW_LEVEL)
+    {
+        sim_schedule(sim_now_us(), level_check, (void *)(intptr_t)pin);
+    }
+}
+
+void sim_gpio_set(int pin, int level)
+{
+    sim_pin_t *p = &pins[pin];
+    if (p->level == level) return;
+    p->level = level;
+    if (p->handler == NULL) return;
+
+    switch (p->intr)
+    {
+        case GPIO_INTR_POSEDGE: if (level) p->handler(p->arg); break;
+        case GPIO_INTR_NEGEDGE: if (!level) p->handler(p->arg); break;
+        case GPIO_INTR_ANYEDGE: p->handler(p->arg); break;
+        case GPIO_INTR_HIGH_LEVEL:
+        case GPIO_INTR_LOW_LEVEL: level_check((void *)(intptr_t)pin); break;
+        default: break;
+    }
+}
+
+uint32_t sim_reg_read(uint32_t reg)
+{
+    uint32_t v = 0;
+    int base = (reg == GPIO_IN1_REG) ? 32 : 0;
+    int n = (reg == GPIO_IN1_REG) ? GPIO_NUM_MAX - 32 : 32;
+    for (int i = 0; i < n; i++)
+    {
+        if (pins[base + i].level) v |= 1u << i;
+    }
+    return v;
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++)
+    {
+        if (cfg->pin_bit_mask & (1ULL << pin)) set_intr(pin, cfg->intr_type);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    return pins[gpio].level;
+}
+
+esp_err_t gpio_install_isr_service(int flags)
+{
+    (void)flags;
+    if (isr_service) return ESP_ERR_INVALID_STATE;
+    isr_service = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg)
+{
+    if (!isr_service) return ESP_ERR_INVALID_STATE;
+    pins[gpio].handler = handler;
+    pins[gpio].arg = arg;
+    set_intr(gpio, pins[gpio].intr); // Niveau déjà actif : ISR immédiate
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio, gpio_int_type_t type)
+{
+    set_intr(gpio, type);
+    return ESP_OK;
+}
+
+void gpio_ll_set_intr_type(gpio_dev_t *hw, uint32_t gpio, gpio_int_type_t type)
+{
+    (void)hw;
+    set_intr((int)gpio, type);
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio, gpio_pull_mode_t mode)
+{
+    (void)gpio;
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio, gpio_int_type_t type)
+{
+    (void)gpio;
+    (void)type;
+    return ESP_OK;
+}
+
+// --------------------- NVS ---------------------
+
+#define NVS_MAX_ENTRIES 256
+#define NVS_MAX_NS      16
+
+typedef struct {
+    int ns;             // Index de l'espace de noms
+    char key[16];
+    void *data;
+    size_t len;
+    bool str;
+} nvs_entry_t;
+
+static char nvs_ns[NVS_MAX_NS][16];
+static int nvs_ns_count;
+static nvs_entry_t nvs_entries[NVS_MAX_ENTRIES];
+static int nvs_entry_count;
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    for (int i = 0; i < nvs_entry_count; i++) free(nvs_entries[i].data);
+    nvs_entry_count = 0;
+    nvs_ns_count = 0;
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *out)
+{
+    for (int i = 0; i < nvs_ns_count; i++)
+    {
+        if (strcmp(nvs_ns[i], ns) == 0)
+        {
+            *out = (nvs_handle_t)i + 1;
+            return ESP_OK;
+        }
+    }
+    if (mode == NVS_READONLY) return ESP_ERR_NVS_NOT_FOUND; // Espace de noms jamais écrit
+    if (nvs_ns_count == NVS_MAX_NS) return ESP_ERR_NVS_NO_FREE_PAGES;
+    snprintf(nvs_ns[nvs_ns_count], sizeof(nvs_ns[0]), "%s", ns);
+    *out = (nvs_handle_t)++nvs_ns_count;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    sim_io.nvs_commits++;
+    return ESP_OK;
+}
+
+static nvs_entry_t *nvs_find(nvs_handle_t handle, const char *key)
+{
+    for (int i = 0; i < nvs_entry_count; i++)
+    {
+        if (nvs_entries[i].ns == (int)handle && strcmp(nvs_entries[i].key, key) == 0) return &nvs_entries[i];
+    }
+    return NULL;
+}
+
+static esp_err_t nvs_put(nvs_handle_t handle, const char *key, const void *data, size_t len, bool str)
+{
+    sim_io.nvs_sets++;
+    nvs_entry_t *e = nvs_find(handle, key);
+    if (e == NULL)
+    {
+        if (nvs_entry_count == NVS_MAX_ENTRIES) return ESP_ERR_NVS_NO_FREE_PAGES;
+        e = &nvs_entries[nvs_entry_count++];
+        e->ns = (int)handle;
+        snprintf(e->key, sizeof(e->key), "%s", key);
+        e->data = NULL;
+    }
+    free(e->data);
+    e->data = malloc(len ? len : 1);
+    memcpy(e->data, data, len);
+    e->len = len;
+    e->str = str;
+    return ESP_OK;
+}
+
+static esp_err_t nvs_fetch(nvs_handle_t handle, const char *key, void *out, size_t *len, bool var)
+{
+    nvs_entry_t *e = nvs_find(handle, key);
+    if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+    if (!var)                   // Entier : taille fixe
+    {
+        if (*len != e->len) return ESP_ERR_NVS_NOT_FOUND;
+        memcpy(out, e->data, e->len);
+        return ESP_OK;
+    }
+    if (out == NULL)            // Interrogation de la taille
+    {
+        *len = e->len;
+        return ESP_OK;
+    }
+    if (*len < e->len) return ESP_ERR_NVS_INVALID_LENGTH;
+    memcpy(out, e->data, e->len);
+    *len = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    nvs_entry_t *e = nvs_find(handle, key);
+    if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+    free(e->data);
+    *e = nvs_entries[--nvs_entry_count];
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t h, const char *key, uint8_t *out) { size_t n = 1; return nvs_fetch(h, key, out, &n, false); }
+esp_err_t nvs_get_u32(nvs_handle_t h, const char *key, uint32_t *out) { size_t n = 4; return nvs_fetch(h, key, out, &n, false); }
+esp_err_t nvs_get_str(nvs_handle_t h, const char *key, char *out, size_t *len) { return nvs_fetch(h, key, out, len, true); }
+esp_err_t nvs_get_blob(nvs_handle_t h, const char *key, void *out, size_t *len) { return nvs_fetch(h, key, out, len, true); }
+esp_err_t nvs_set_u8(nvs_handle_t h, const char *key, uint8_t v) { return nvs_put(h, key, &v, 1, false); }
+esp_err_t nvs_set_u32(nvs_handle_t h, const char *key, uint32_t v) { return nvs_put(h, key, &v, 4, false); }
+esp_err_t nvs_set_str(nvs_handle_t h, const char *key, const char *v) { return nvs_put(h, key, v, strlen(v) + 1, true); }
+esp_err_t nvs_set_blob(nvs_handle_t h, const char *key, const void *v, size_t len) { return nvs_put(h, key, v, len, false); }
+
+// --------------------- Partitions flash (partitions.csv) ---------------------
+
+#define SIM_SECTOR 4096
+
+typedef struct {
+    esp_partition_t part;
+    uint8_t *mem;
+    sim_flash_stats_t *stats;
+} sim_partition_t;
+
+static sim_partition_t partitions[] = {
+    { { ESP_PARTITION_TYPE_DATA, 0x80, 0x3A0000, 0x20000, "outbox" }, NULL, &sim_io.flash[0] },
+    { { ESP_PARTITION_TYPE_DATA, 0x80, 0x3C0000, 0x40000, "journal" }, NULL, &sim_io.flash[1] },
+};
+
+static sim_partition_t *part_of(const esp_partition_t *part)
+{
+    sim_partition_t *p = (sim_partition_t *)part; // part est le premier membre
+    if (p->mem == NULL)
+    {
+        p->mem = malloc(p->part.size);
+        memset(p->mem, 0xFF, p->part.size);      // Flash neuve : effacée
+    }
+    return p;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    (void)subtype;
+    for (size_t i = 0; i < sizeof(partitions) / sizeof(partitions[0]); i++)
+    {
+        if (partitions[i].part.type == type && (label == NULL || strcmp(partitions[i].part.label, label) == 0))
+        {
+            return &partitions[i].part;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t len)
+{
+    sim_partition_t *p = part_of(part);
+    if (offset + len > p->part.size) return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, p->mem + offset, len);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t len)
+{
+    sim_partition_t *p = part_of(part);
+    if (offset + len > p->part.size) return ESP_ERR_INVALID_SIZE;
+    const uint8_t *s = src;
+    for (size_t i = 0; i < len; i++) p->mem[offset + i] &= s[i]; // NOR : les bits ne passent que de 1 à 0
+    p->stats->writes++;
+    p->stats->bytes += len;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t len)
+{
+    sim_partition_t *p = part_of(part);
+    if (offset % SIM_SECTOR || len % SIM_SECTOR) return ESP_ERR_INVALID_ARG;
+    if (offset + len > p->part.size) return ESP_ERR_INVALID_SIZE;
+    memset(p->mem + offset, 0xFF, len);
+    p->stats->erases += len / SIM_SECTOR;
+    return ESP_OK;
+}
+
+// --------------------- Événements réseau ---------------------
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg)
+{
+    (void)base;
+    (void)id;
+    (void)handler;
+    (void)arg;
+    return ESP_OK;
+}
+
+// --------------------- Client MQTT ---------------------
+
+struct sim_mqtt {
+    esp_event_handler_t handler;
+    void *arg;
+    bool started;
+    int msg_id;
+};
+
+static struct sim_mqtt mqtt_client;
+
+static void mqtt_dispatch(esp_mqtt_event_id_t id)
+{
+    esp_mqtt_event_t ev = { .event_id = id, .client = &mqtt_client };
+    if (mqtt_client.handler) mqtt_client.handler(mqtt_client.arg, "MQTT_EVENTS", id, &ev);
+}
+
+static void mqtt_connected_evt(void *arg)
+{
+    (void)arg;
+    mqtt_dispatch(MQTT_EVENT_CONNECTED);
+}
+
+void sim_mqtt_connect(void)
+{
+    sim_schedule(sim_now_us(), mqtt_connected_evt, NULL);
+}
+
+/**
+ * @brief Message reçu du broker (MQTT_EVENT_DATA), libéré après sa remise.
+ */
+typedef struct {
+    char *topic;
+    char *data;
+} sim_mqtt_msg_t;
+
+static void mqtt_data_evt(void *arg)
+{
+    sim_mqtt_msg_t *msg = arg;
+    esp_mqtt_event_t ev = {
+        .event_id = MQTT_EVENT_DATA, .client = &mqtt_client,
+        .topic = msg->topic, .topic_len = (int)strlen(msg->topic),
+        .data = msg->data, .data_len = (int)strlen(msg->data),
+    };
+    if (mqtt_client.handler) mqtt_client.handler(mqtt_client.arg, "MQTT_EVENTS", MQTT_EVENT_DATA, &ev);
+    free(msg->topic);
+    free(msg->data);
+    free(msg);
+}
+
+void sim_mqtt_receive(int64_t t_us, const char *topic, const char *data)
+{
+    sim_mqtt_msg_t *msg = malloc(sizeof(*msg));
+    msg->topic = strdup(topic);
+    msg->data = strdup(data);
+    sim_schedule(t_us, mqtt_data_evt, msg);
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *cfg)
+{
+    (void)cfg;
+    return &mqtt_client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, int32_t id, esp_event_handler_t handler, void *arg)
+{
+    (void)id;
+    client->handler = handler;
+    client->arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+    client->started = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client)
+{
+    (void)client;
+    return ESP_OK;
+}
+
+/**
+ * @brief Taille d'un champ de longueur restante MQTT (1 à 4 octets).
+ */
+static int mqtt_varint_len(size_t n)
+{
+    int bytes = 1;
+    while (n >= 128)
+    {
+        n >>= 7;
+        bytes++;
+    }
+    return bytes;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos, int retain)
+{
+    (void)retain;
+    size_t payload = (len > 0) ? (size_t)len : strlen(data);
+    size_t remaining = 2 + strlen(topic) + (qos > 0 ? 2 : 0) + payload; // Topic, identifiant, contenu
+
+    sim_io.mqtt_messages++;
+    sim_io.mqtt_payload += payload;
+    sim_io.mqtt_wire += 1 + mqtt_varint_len(remaining) + remaining + (qos > 0 ? 4 : 0); // En-tête fixe, PUBACK
+    return ++client->msg_id;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos)
+{
+    (void)topic;
+    (void)qos;
+    return ++client->msg_id;
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client)
+{
+    (void)client;
+    return 0;                   // Accusés immédiats : rien en vol
+}
@@ -0,0 +1,202 @@
+/**
+ * @file sim_trace.c
+ * @brief Générateurs de traces synthétiques et lecture des traces CSV.
+ *
+ * Les traces synthétiques sont produites à la demande, une période d'impulsion à la fois :
+ * la durée simulée n'est pas limitée par la mémoire.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_trace.h"
+#include "config.h"                 // MAX_CHANNELS, DEBOUNCE_US, DEFAULT_CHANNEL_COUNT
+
+#define TRACE_RING 64               // Changements en attente par compteur (une période au plus)
+
+const trace_scenario_t trace_scenarios[] = {
+    { "steady", "100 Hz, impulsions propres de 4 ms, sur tous les compteurs", 2000, MAX_CHANNELS },
+    { "bursty", "rafales de 5 à 50 impulsions S0 (30 ms, 10 Hz) séparées de 5 s en moyenne", DEBOUNCE_US, DEFAULT_CHANNEL_COUNT },
+    { "bouncy", "5 Hz, contacts rebondissants (jusqu'à 5 rebonds par front) et parasites de 0,1 à 2 ms", DEBOUNCE_US, DEFAULT_CHANNEL_COUNT },
+};
+const int trace_scenario_count = sizeof(trace_scenarios) / sizeof(trace_scenarios[0]);
+
+typedef enum { GEN_STEADY, GEN_BURSTY, GEN_BOUNCY, GEN_CSV } gen_kind_t;
+
+typedef struct {
+    trace_edge_t ring[TRACE_RING];  // Changements générés, pas encore consommés
+    int head, count;
+    int64_t cycle_us;               // Début de la prochaine période générée
+    uint64_t rng;                   // État xorshift64
+    int burst_left;                 // Impulsions restantes dans la rafale en cours
+    trace_edge_t *csv;              // Trace enregistrée
+    size_t csv_len, csv_pos;
+} trace_chan_t;
+
+static gen_kind_t kind;
+static trace_chan_t chans[MAX_CHANNELS];
+
+static uint64_t rng_next(trace_chan_t *c)
+{
+    c->rng ^= c->rng << 13;
+    c->rng ^= c->rng >> 7;
+    c->rng ^= c->rng << 17;
+    return c->rng;
+}
+
+/**
+ * @brief Entier uniforme dans [lo, hi].
+ */
+static int64_t rng_range(trace_chan_t *c, int64_t lo, int64_t hi)
+{
+    return lo + (int64_t)(rng_next(c) % (uint64_t)(hi - lo + 1));
+}
+
+static void push(trace_chan_t *c, int64_t t_us, int level, bool truth)
+{
+    c->ring[(c->head + c->count++) % TRACE_RING] = (trace_edge_t){ t_us, (uint8_t)level, truth };
+}
+
+/**
+ * @brief Ajoute des rebonds après un front : allers-retours de 50 à 800 µs.
+ *
+ * @return Instant du dernier changement
+ */
+static int64_t bounce(trace_chan_t *c, int64_t t_us, int level)
+{
+    int n = (int)rng_range(c, 0, 5);
+    for (int k = 0; k < n; k++)
+    {
+        t_us += rng_range(c, 50, 800);
+        push(c, t_us, !level, false);
+        t_us += rng_range(c, 50, 800);
+        push(c, t_us, level, false);
+    }
+    return t_us;
+}
+
+/**
+ * @brief Génère une période d'impulsion du compteur.
+ */
+static void generate(trace_chan_t *c)
+{
+    int64_t t = c->cycle_us;
+    switch (kind)
+    {
+        case GEN_STEADY:
+            push(c, t, 1, true);
+            push(c, t + 4000, 0, false);
+            c->cycle_us = t + 10000;
+            break;
+
+        case GEN_BURSTY:
+            if (c->burst_left == 0)         // Fin de rafale : silence de durée exponentielle (moyenne 5 s)
+            {
+                double u = (double)((rng_next(c) >> 11) + 1) / (double)(1ULL << 53);
+                t += (int64_t)(-log(u) * 5e6);
+                c->burst_left = (int)rng_range(c, 5, 50);
+            }
+            push(c, t, 1, true);
+            push(c, t + 30000, 0, false);
+            c->burst_left--;
+            c->cycle_us = t + 100000;
+            break;
+
+        case GEN_BOUNCY:
+            push(c, t, 1, true);
+            bounce(c, t, 1);
+            push(c, t + 50000, 0, false);
+            bounce(c, t + 50000, 0);
+            if (rng_range(c, 0, 9) == 0)    // Une période sur dix : parasite pendant le niveau bas
+            {
+                int64_t g = t + rng_range(c, 100000, 180000);
+                push(c, g, 1, false);
+                push(c, g + rng_range(c, 100, 2000), 0, false);
+            }
+            c->cycle_us = t + 200000;
+            break;
+
+        case GEN_CSV:
+            break;
+    }
+}
+
+void trace_init_synthetic(const trace_scenario_t *sc, int channels, uint64_t seed)
+{
+    kind = (gen_kind_t)(sc - trace_scenarios);
+    for (int i = 0; i < channels; i++)
+    {
+        trace_chan_t *c = &chans[i];
+        memset(c, 0, sizeof(*c));
+        c->rng = seed * 0x9E3779B97F4A7C15ULL + (uint64_t)i + 1; // Jamais nul
+        rng_next(c);
+        c->cycle_us = 1000000 + rng_range(c, 0, 10000); // Après le démarrage, phases décalées
+        c->burst_left = (kind == GEN_BURSTY) ? 0 : -1;
+    }
+}
+
+int trace_load_csv(const char *path, uint32_t debounce_us, int64_t *last_us)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return 0;
+
+    kind = GEN_CSV;
+    memset(chans, 0, sizeof(chans));
+    size_t cap[MAX_CHANNELS] = { 0 };
+    bool marked = false;            // 4e colonne présente
+    int channels = 0;
+    char line[128];
+    *last_us = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        long long t;
+        int ch, level, truth = 0;
+        int n = sscanf(line, "%lld,%d,%d,%d", &t, &ch, &level, &truth);
+        if (n < 3 || ch < 0 || ch >= MAX_CHANNELS) continue; // En-tête ou commentaire
+        if (n == 4) marked = true;
+
+        trace_chan_t *c = &chans[ch];
+        if (c->csv_len == cap[ch])
+        {
+            cap[ch] = cap[ch] ? cap[ch] * 2 : 1024;
+            c->csv = realloc(c->csv, cap[ch] * sizeof(*c->csv));
+        }
+        c->csv[c->csv_len++] = (trace_edge_t){ t, (uint8_t)(level != 0), truth != 0 };
+        if (ch + 1 > channels) channels = ch + 1;
+        if (t > *last_us) *last_us = t;
+    }
+    fclose(f);
+
+    if (!marked)                    // Vraies impulsions : niveau haut tenu au moins l'anti-rebond
+    {
+        for (int ch = 0; ch < channels; ch++)
+        {
+            trace_chan_t *c = &chans[ch];
+            for (size_t k = 0; k < c->csv_len; k++)
+            {
+                if (!c->csv[k].level || (k > 0 && c->csv[k - 1].level)) continue;
+                int64_t end = (k + 1 < c->csv_len) ? c->csv[k + 1].t_us : INT64_MAX;
+                c->csv[k].truth = end - c->csv[k].t_us >= (int64_t)debounce_us;
+            }
+        }
+    }
+    return channels;
+}
+
+bool trace_next(int ch, trace_edge_t *out)
+{
+    trace_chan_t *c = &chans[ch];
+    if (kind == GEN_CSV)
+    {
+        if (c->csv_pos >= c->csv_len) return false;
+        *out = c->csv[c->csv_pos++];
+        return true;
+    }
+    if (c->count == 0) generate(c);
+    *out = c->ring[c->head];
+    c->head = (c->head + 1) % TRACE_RING;
+    c->count--;
+    return true;
+}
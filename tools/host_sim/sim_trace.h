@@ -0,0 +1,69 @@
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+/**
+ * @file sim_trace.h
+ * @brief Traces d'impulsions du banc : scénarios synthétiques et traces enregistrées (CSV).
+ *
+ * Une trace fournit, pour chaque compteur, la suite de ses changements de niveau.
+ * Les fronts montants qui correspondent à une vraie impulsion sont marqués (truth) :
+ * c'est la vérité terrain à laquelle le banc compare les compteurs.
+ *
+ * Format CSV (une ligne par changement de niveau, triée par instant pour chaque compteur) :
+ *   t_us,channel,level[,truth]
+ * Sans 4e colonne, un front montant est une vraie impulsion si le niveau reste haut
+ * au moins la durée d'anti-rebond (le comportement spécifié de l'anti-rebond).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Changement de niveau d'une entrée.
+ */
+typedef struct {
+    int64_t t_us;   ///< Instant du changement
+    uint8_t level;  ///< Nouveau niveau
+    bool truth;     ///< Front montant d'une vraie impulsion
+} trace_edge_t;
+
+/**
+ * @brief Scénario de trace.
+ */
+typedef struct {
+    const char *name;         ///< Nom sur la ligne de commande
+    const char *desc;         ///< Description pour le rapport
+    uint32_t debounce_us;     ///< Anti-rebond par défaut du scénario
+    int channels;             ///< Nombre de compteurs par défaut
+} trace_scenario_t;
+
+extern const trace_scenario_t trace_scenarios[]; // Scénarios synthétiques
+extern const int trace_scenario_count;
+
+/**
+ * @brief Prépare un scénario synthétique.
+ *
+ * @param sc       Scénario
+ * @param channels Nombre de compteurs
+ * @param seed     Graine du générateur (traces reproductibles)
+ */
+void trace_init_synthetic(const trace_scenario_t *sc, int channels, uint64_t seed);
+
+/**
+ * @brief Charge une trace CSV enregistrée.
+ *
+ * @param path        Fichier CSV
+ * @param debounce_us Anti-rebond servant à marquer les vraies impulsions sans 4e colonne
+ * @param last_us     Instant du dernier changement de la trace (sortie)
+ * @return Nombre de compteurs de la trace (0 : fichier illisible ou vide)
+ */
+int trace_load_csv(const char *path, uint32_t debounce_us, int64_t *last_us);
+
+/**
+ * @brief Donne le prochain changement de niveau d'un compteur.
+ *
+ * @return false si la trace du compteur est terminée
+ */
+bool trace_next(int ch, trace_edge_t *out);
+
+#endif // SIM_TRACE_H
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Compresse lib/webui/www/index.html et génère lib/webui/webui_assets.h.
+
+À relancer après chaque modification de la page :
+    python3 tools/webui/embed.py
+
+La compression est reproductible (mtime à 0) : même page, même en-tête, même ETag.
+"""
+
+import gzip
+import pathlib
+import zlib
+
+ROOT = pathlib.Path(__file__).resolve().parents[2]
+SRC = ROOT / "lib" / "webui" / "www" / "index.html"
+DST = ROOT / "lib" / "webui" / "webui_assets.h"
+
+
+def main():
+    html = SRC.read_bytes()
+    gz = gzip.compress(html, compresslevel=9, mtime=0)
+    etag = "%08x" % zlib.crc32(gz)
+    rows = []
+    for i in range(0, len(gz), 16):
+        rows.append("    " + ", ".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+    DST.write_text(
+        "#ifndef WEBUI_ASSETS_H\n"
+        "#define WEBUI_ASSETS_H\n"
+        "\n"
+        "/**\n"
+        " * @file webui_assets.h\n"
+        " * @brief Page de l'interface web, compressée gzip (généré par tools/webui/embed.py, ne pas modifier).\n"
+        " *\n"
+        " * Source : lib/webui/www/index.html (%d octets, %d compressés).\n"
+        " */\n"
+        "\n"
+        "#include <stdint.h>   // Pour uint8_t\n"
+        "\n"
+        "#define WEBUI_INDEX_ETAG \"\\\"%s\\\"\" // CRC32 de la page compressée\n"
+        "\n"
+        "static const uint8_t webui_index_gz[] = {\n"
+        "%s\n"
+        "};\n"
+        "\n"
+        "#endif // WEBUI_ASSETS_H\n" % (len(html), len(gz), etag, "\n".join(rows))
+    )
+    print("%s : %d -> %d octets, ETag %s" % (DST.relative_to(ROOT), len(html), len(gz), etag))
+
+
+if __name__ == "__main__":
+    main()